@@ -0,0 +1,347 @@
+#include <main.h>
+
+/*
+ * Must match the layout in 'src/include/xboot/dtree.h'
+ */
+#define DTREE_BLOB_MAGIC		(0x42544458)	/* "XDTB" */
+#define DTREE_BLOB_VERSION		(3)
+#define DTREE_BLOB_INDEX_WIDTH(len)	(((len) > 0xffff) ? 4 : 2)
+
+struct dtree_blob_header_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t nnode;
+	uint32_t node;
+	uint32_t string;
+	uint32_t nstring;
+	uint32_t reserved;
+};
+
+struct buffer_t {
+	unsigned char * buf;
+	uint32_t len;
+	uint32_t size;
+};
+
+struct intern_t {
+	const char * str;
+	uint32_t count;
+	uint32_t offset;
+	struct intern_t * next;
+};
+
+static struct buffer_t strtab;
+static struct buffer_t data;
+static struct intern_t * itab[4096];
+static struct intern_t ** ilist;
+static uint32_t icount;
+
+static void buffer_put(struct buffer_t * b, const void * buf, uint32_t len)
+{
+	while(b->len + len > b->size)
+	{
+		b->size = b->size ? b->size * 2 : 4096;
+		b->buf = realloc(b->buf, b->size);
+		if(!b->buf)
+		{
+			printf("Out of memory\r\n");
+			exit(-1);
+		}
+	}
+	memcpy(b->buf + b->len, buf, len);
+	b->len += len;
+}
+
+static void buffer_byte(struct buffer_t * b, unsigned char c)
+{
+	buffer_put(b, &c, 1);
+}
+
+static void buffer_varint(struct buffer_t * b, uint64_t v)
+{
+	while(v >= 0x80)
+	{
+		buffer_byte(b, (v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	buffer_byte(b, v);
+}
+
+static uint32_t shash(const char * s)
+{
+	uint32_t v = 5381;
+
+	while(*s)
+		v = (v << 5) + v + (unsigned char)(*s++);
+	return v;
+}
+
+static struct intern_t * intern(const char * s)
+{
+	struct intern_t ** head = &itab[shash(s) % (sizeof(itab) / sizeof(itab[0]))];
+	struct intern_t * i;
+
+	for(i = *head; i; i = i->next)
+	{
+		if(strcmp(i->str, s) == 0)
+			return i;
+	}
+	i = malloc(sizeof(struct intern_t));
+	i->str = s;
+	i->count = 0;
+	i->offset = 0;
+	i->next = *head;
+	*head = i;
+	ilist = realloc(ilist, sizeof(struct intern_t *) * (icount + 1));
+	ilist[icount++] = i;
+	return i;
+}
+
+static void intern_value(struct json_value_t * v)
+{
+	int i;
+
+	switch(v->type)
+	{
+	case JSON_OBJECT:
+		for(i = 0; i < v->u.object.length; i++)
+		{
+			intern(v->u.object.values[i].name)->count++;
+			intern_value(v->u.object.values[i].value);
+		}
+		break;
+	case JSON_ARRAY:
+		for(i = 0; i < v->u.array.length; i++)
+			intern_value(v->u.array.values[i]);
+		break;
+	case JSON_STRING:
+		intern(v->u.string.ptr)->count++;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * The most used strings go first, so their offsets fit in a one byte varint
+ */
+static int intern_compare(const void * a, const void * b)
+{
+	const struct intern_t * x = *(const struct intern_t **)a;
+	const struct intern_t * y = *(const struct intern_t **)b;
+
+	if(x->count != y->count)
+		return (x->count > y->count) ? -1 : 1;
+	return strcmp(x->str, y->str);
+}
+
+static void intern_layout(void)
+{
+	uint32_t i;
+
+	qsort(ilist, icount, sizeof(struct intern_t *), intern_compare);
+	for(i = 0; i < icount; i++)
+	{
+		ilist[i]->offset = strtab.len;
+		buffer_put(&strtab, ilist[i]->str, strlen(ilist[i]->str) + 1);
+	}
+}
+
+static struct json_object_entry_t * sort_entries;
+
+static int member_compare(const void * a, const void * b)
+{
+	int x = *(const int *)a, y = *(const int *)b;
+	int c = strcmp(sort_entries[x].name, sort_entries[y].name);
+
+	return c ? c : (x - y);
+}
+
+static void emit_value(struct buffer_t * b, struct json_value_t * v)
+{
+	struct buffer_t sub, tab;
+	uint64_t z;
+	uint32_t * off;
+	int * idx;
+	int i, w;
+
+	buffer_byte(b, v->type);
+	switch(v->type)
+	{
+	case JSON_OBJECT:
+		idx = malloc(sizeof(int) * (v->u.object.length + 1));
+		off = malloc(sizeof(uint32_t) * (v->u.object.length + 1));
+		for(i = 0; i < v->u.object.length; i++)
+			idx[i] = i;
+		sort_entries = v->u.object.values;
+		qsort(idx, v->u.object.length, sizeof(int), member_compare);
+		memset(&sub, 0, sizeof(struct buffer_t));
+		for(i = 0; i < v->u.object.length; i++)
+		{
+			off[i] = sub.len;
+			buffer_varint(&sub, intern(v->u.object.values[idx[i]].name)->offset);
+			emit_value(&sub, v->u.object.values[idx[i]].value);
+		}
+		/*
+		 * The member offset table, so keys can be binary searched
+		 */
+		memset(&tab, 0, sizeof(struct buffer_t));
+		w = DTREE_BLOB_INDEX_WIDTH(sub.len);
+		for(i = 0; i < v->u.object.length; i++)
+		{
+			buffer_byte(&tab, (off[i] >> 0) & 0xff);
+			buffer_byte(&tab, (off[i] >> 8) & 0xff);
+			if(w == 4)
+			{
+				buffer_byte(&tab, (off[i] >> 16) & 0xff);
+				buffer_byte(&tab, (off[i] >> 24) & 0xff);
+			}
+		}
+		buffer_varint(b, v->u.object.length);
+		buffer_varint(b, sub.len);
+		buffer_put(b, tab.buf, tab.len);
+		buffer_put(b, sub.buf, sub.len);
+		free(tab.buf);
+		free(sub.buf);
+		free(off);
+		free(idx);
+		break;
+	case JSON_ARRAY:
+		memset(&sub, 0, sizeof(struct buffer_t));
+		for(i = 0; i < v->u.array.length; i++)
+			emit_value(&sub, v->u.array.values[i]);
+		buffer_varint(b, v->u.array.length);
+		buffer_varint(b, sub.len);
+		buffer_put(b, sub.buf, sub.len);
+		free(sub.buf);
+		break;
+	case JSON_INTEGER:
+		z = ((uint64_t)v->u.integer << 1) ^ (uint64_t)(v->u.integer >> 63);
+		buffer_varint(b, z);
+		break;
+	case JSON_DOUBLE:
+		buffer_put(b, &v->u.dbl, sizeof(double));
+		break;
+	case JSON_STRING:
+		buffer_varint(b, intern(v->u.string.ptr)->offset);
+		break;
+	case JSON_BOOLEAN:
+		buffer_byte(b, v->u.boolean ? 1 : 0);
+		break;
+	default:
+		break;
+	}
+}
+
+static char * read_file(const char * path, size_t * len)
+{
+	FILE * fp;
+	char * buf;
+	long l;
+
+	fp = fopen(path, "rb");
+	if(!fp)
+		return NULL;
+	fseek(fp, 0L, SEEK_END);
+	l = ftell(fp);
+	fseek(fp, 0L, SEEK_SET);
+	buf = malloc(l + 1);
+	if(buf && (fread(buf, 1, l, fp) != l))
+	{
+		free(buf);
+		buf = NULL;
+	}
+	fclose(fp);
+	if(buf)
+	{
+		buf[l] = '\0';
+		*len = l;
+	}
+	return buf;
+}
+
+static void usage(void)
+{
+	printf("usage:\r\n");
+	printf("    mkdtree <machine.json> <machine.dtb>\r\n");
+}
+
+int main(int argc, char * argv[])
+{
+	struct dtree_blob_header_t h;
+	struct json_value_t * v;
+	char errbuf[256];
+	char * json, ** names, * p;
+	uint64_t * addrs;
+	size_t len;
+	FILE * fp;
+	int i;
+
+	if(argc != 3)
+	{
+		usage();
+		return -1;
+	}
+
+	json = read_file(argv[1], &len);
+	if(!json)
+	{
+		printf("Can not read '%s'\r\n", argv[1]);
+		return -1;
+	}
+	v = json_parse(json, len, errbuf);
+	if(!v || (v->type != JSON_OBJECT))
+	{
+		printf("%s: %s\r\n", argv[1], v ? "not a json object" : errbuf);
+		return -1;
+	}
+
+	names = calloc(v->u.object.length + 1, sizeof(char *));
+	addrs = calloc(v->u.object.length + 1, sizeof(uint64_t));
+	for(i = 0; i < v->u.object.length; i++)
+	{
+		names[i] = strdup(v->u.object.values[i].name);
+		if((p = strchr(names[i], '@')))
+			*p++ = '\0';
+		addrs[i] = p ? strtoull(p, NULL, 0) : 0;
+		intern(names[i])->count++;
+		intern_value(v->u.object.values[i].value);
+	}
+	intern_layout();
+
+	for(i = 0; i < v->u.object.length; i++)
+	{
+		buffer_varint(&data, intern(names[i])->offset);
+		buffer_varint(&data, addrs[i]);
+		emit_value(&data, v->u.object.values[i].value);
+	}
+
+	memset(&h, 0, sizeof(struct dtree_blob_header_t));
+	h.magic = DTREE_BLOB_MAGIC;
+	h.version = DTREE_BLOB_VERSION;
+	h.nnode = v->u.object.length;
+	h.string = sizeof(struct dtree_blob_header_t);
+	h.nstring = strtab.len;
+	h.node = h.string + h.nstring;
+	h.size = h.node + data.len;
+
+	fp = fopen(argv[2], "wb");
+	if(!fp)
+	{
+		printf("Can not write '%s'\r\n", argv[2]);
+		return -1;
+	}
+	fwrite(&h, sizeof(struct dtree_blob_header_t), 1, fp);
+	fwrite(strtab.buf, 1, strtab.len, fp);
+	fwrite(data.buf, 1, data.len, fp);
+	fclose(fp);
+
+	for(i = 0; i < v->u.object.length; i++)
+		free(names[i]);
+	free(names);
+	free(addrs);
+	json_free(v);
+	free(json);
+	return 0;
+}
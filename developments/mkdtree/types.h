@@ -0,0 +1,18 @@
+#ifndef __TYPES_H__
+#define __TYPES_H__
+
+/*
+ * Host side replacement of the xboot types, enough to build the library json
+ * parser from 'src/lib/libx/json.c'
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+typedef signed int bool_t;
+
+enum {
+	FALSE = 0,
+	TRUE = 1,
+};
+
+#endif /* __TYPES_H__ */
@@ -0,0 +1,226 @@
+#include <main.h>
+
+/*
+ * Must match the layout in 'src/driver/block/blk-romdisk.c'
+ */
+#define ROMDISK_LZ4_MAGIC		(0x345a5258)	/* "XRZ4" */
+#define ROMDISK_LZ4_VERSION		(1)
+
+struct romdisk_lz4_header_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t chksz;
+	uint32_t nchunk;
+	uint64_t size;
+	uint32_t reserved[2];
+};
+
+#define ROMDISK_RAW_MAX			(16)
+
+static void usage(void)
+{
+	printf("usage:\r\n");
+	printf("    mkromdisk [-c chunk-size] [-l level] [-r suffix]... <romdisk> <zromdisk>\r\n");
+}
+
+static uint32_t cpio_hex(const char * p)
+{
+	char tmp[9];
+
+	memcpy(tmp, p, 8);
+	tmp[8] = '\0';
+	return (uint32_t)strtoul(tmp, NULL, 16);
+}
+
+/*
+ * Mark the chunks holding regular files of a newc cpio whose names end with
+ * one of the suffixes, so that those files can be mapped in place
+ */
+static void cpio_mark_raw(const char * buf, long len, uint32_t chksz, char ** suffix, int nsuffix, char * raw)
+{
+	const char * name;
+	long pos = 0, start, end, c;
+	uint32_t mode, filesize, namesize;
+	int i, l, n;
+
+	while(pos + 110 <= len)
+	{
+		if(memcmp(&buf[pos], "070701", 6) && memcmp(&buf[pos], "070702", 6))
+			break;
+		mode = cpio_hex(&buf[pos + 14]);
+		filesize = cpio_hex(&buf[pos + 54]);
+		namesize = cpio_hex(&buf[pos + 94]);
+		name = &buf[pos + 110];
+		start = (pos + 110 + namesize + 3) & ~3;
+		end = start + filesize;
+		if((namesize < 1) || (end > len) || !strncmp(name, "TRAILER!!!", namesize))
+			break;
+		if(((mode & 0170000) == 0100000) && (filesize > 0))
+		{
+			l = namesize - 1;
+			for(i = 0; i < nsuffix; i++)
+			{
+				n = strlen(suffix[i]);
+				if((l >= n) && !memcmp(&name[l - n], suffix[i], n))
+				{
+					for(c = start / chksz; c <= (end - 1) / chksz; c++)
+						raw[c] = 1;
+					break;
+				}
+			}
+		}
+		pos = (end + 3) & ~3;
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	struct romdisk_lz4_header_t hdr;
+	FILE * fp;
+	char * ibuf, * obuf, * rawchk;
+	char * ipath = NULL, * opath = NULL;
+	char * suffix[ROMDISK_RAW_MAX];
+	uint32_t * offset;
+	uint32_t chksz = 32768;
+	uint32_t nchunk, nraw = 0, pos;
+	int level = 12;
+	long ilen;
+	int clen, len, raw;
+	int i, nsuffix = 0, index = 0;
+
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-c") && (argc > i + 1))
+		{
+			chksz = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+			i++;
+		}
+		else if(!strcmp(argv[i], "-l") && (argc > i + 1))
+		{
+			level = (int)strtol(argv[i + 1], NULL, 0);
+			i++;
+		}
+		else if(!strcmp(argv[i], "-r") && (argc > i + 1) && (nsuffix < ROMDISK_RAW_MAX))
+		{
+			suffix[nsuffix++] = argv[i + 1];
+			i++;
+		}
+		else if(*argv[i] == '-')
+		{
+			usage();
+			return -1;
+		}
+		else
+		{
+			if(index == 0)
+				ipath = argv[i];
+			else if(index == 1)
+				opath = argv[i];
+			else
+			{
+				usage();
+				return -1;
+			}
+			index++;
+		}
+	}
+
+	if(!ipath || !opath || (chksz < 4096) || (chksz & (chksz - 1)))
+	{
+		usage();
+		return -1;
+	}
+
+	fp = fopen(ipath, "rb");
+	if(!fp)
+	{
+		printf("Open romdisk error.\r\n");
+		return -1;
+	}
+	fseek(fp, 0L, SEEK_END);
+	ilen = ftell(fp);
+	fseek(fp, 0L, SEEK_SET);
+	ibuf = malloc(ilen + 1);
+	if(!ibuf || (fread(ibuf, 1, ilen, fp) != ilen))
+	{
+		printf("Can't read romdisk.\r\n");
+		free(ibuf);
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+
+	nchunk = (ilen + chksz - 1) / chksz;
+	len = LZ4_compressBound(chksz);
+	offset = malloc((nchunk + 1) * sizeof(uint32_t));
+	obuf = malloc(sizeof(struct romdisk_lz4_header_t) + (nchunk + 1) * sizeof(uint32_t) + (size_t)nchunk * len);
+	rawchk = calloc(nchunk + 1, 1);
+	if(!offset || !obuf || !rawchk)
+	{
+		printf("Out of memory.\r\n");
+		free(rawchk);
+		free(offset);
+		free(obuf);
+		free(ibuf);
+		return -1;
+	}
+	cpio_mark_raw(ibuf, ilen, chksz, suffix, nsuffix, rawchk);
+
+	/*
+	 * Chunks are compressed independently, one that does not shrink or that
+	 * holds a file to be mapped in place is stored as is
+	 */
+	pos = sizeof(struct romdisk_lz4_header_t) + (nchunk + 1) * sizeof(uint32_t);
+	for(i = 0; i < nchunk; i++)
+	{
+		raw = ((ilen - (long)i * chksz) < chksz) ? (int)(ilen - (long)i * chksz) : (int)chksz;
+		offset[i] = pos;
+		clen = rawchk[i] ? 0 : LZ4_compress_HC(&ibuf[(long)i * chksz], &obuf[pos], raw, len, level);
+		if((clen <= 0) || (clen >= raw))
+		{
+			memcpy(&obuf[pos], &ibuf[(long)i * chksz], raw);
+			clen = raw;
+			nraw++;
+		}
+		pos += clen;
+	}
+	offset[nchunk] = pos;
+
+	memset(&hdr, 0, sizeof(struct romdisk_lz4_header_t));
+	hdr.magic = ROMDISK_LZ4_MAGIC;
+	hdr.version = ROMDISK_LZ4_VERSION;
+	hdr.chksz = chksz;
+	hdr.nchunk = nchunk;
+	hdr.size = ilen;
+	memcpy(&obuf[0], &hdr, sizeof(struct romdisk_lz4_header_t));
+	memcpy(&obuf[sizeof(struct romdisk_lz4_header_t)], offset, (nchunk + 1) * sizeof(uint32_t));
+
+	fp = fopen(opath, "wb");
+	if(!fp)
+	{
+		printf("Open zromdisk error.\r\n");
+		free(rawchk);
+		free(offset);
+		free(obuf);
+		free(ibuf);
+		return -1;
+	}
+	if(fwrite(obuf, 1, pos, fp) != pos)
+	{
+		printf("Write zromdisk error.\r\n");
+		fclose(fp);
+		free(rawchk);
+		free(offset);
+		free(obuf);
+		free(ibuf);
+		return -1;
+	}
+	fclose(fp);
+
+	printf("Compressed %ld bytes into %u bytes ==> %f%% [%u x %u, %u stored]\r\n", ilen, pos, pos * 100.0 / (ilen ? ilen : 1), nchunk, chksz, nraw);
+	free(rawchk);
+	free(offset);
+	free(obuf);
+	free(ibuf);
+	return 0;
+}
@@ -64,7 +64,8 @@ NS_STDLIB	:=	-Dabs=xboot_abs -Datof=xboot_atof \
 				-Dlldiv=xboot_lldiv -Dqsort=xboot_qsort \
 				-Drand=xboot_rand -Dsrand=xboot_srand \
 				-Dstrntoimax=xboot_strntoimax -Dstrntoumax=xboot_strntoumax \
-				-Dstrtod=xboot_strtod -Dstrtoimax=xboot_strtoimax \
+				-Dstrtod=xboot_strtod -Dstrtof=xboot_strtof \
+				-Dstrtoimax=xboot_strtoimax \
 				-Dstrtol=xboot_strtol -Dstrtoll=xboot_strtoll \
 				-Dstrtoul=xboot_strtoul -Dstrtoull=xboot_strtoull \
 				-Dstrtoumax=xboot_strtoumax
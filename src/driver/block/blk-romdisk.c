@@ -27,12 +27,46 @@
  */
 
 #include <xboot.h>
+#include <lz4.h>
 #include <block/block.h>
 
+/*
+ * Compressed romdisk, built by 'developments/mkromdisk'. The image is split
+ * into chunks compressed independently with lz4, followed by an index of
+ * (nchunk + 1) offsets. A chunk that does not shrink, or that holds a file
+ * packed with the "-r" option to be mapped in place, is stored as is.
+ */
+#define ROMDISK_LZ4_MAGIC		(0x345a5258)	/* "XRZ4" */
+#define ROMDISK_LZ4_VERSION		(1)
+
+struct romdisk_lz4_header_t {
+	u32_t magic;
+	u32_t version;
+	u32_t chksz;
+	u32_t nchunk;
+	u64_t size;
+	u32_t reserved[2];
+};
+
+struct romdisk_chunk_t {
+	struct list_head entry;
+	int index;
+	u8_t * buf;
+};
+
 struct blk_romdisk_pdata_t
 {
 	virtual_addr_t addr;
 	virtual_size_t size;
+
+	const u32_t * offset;
+	u32_t chksz;
+	u32_t nchunk;
+	u64_t length;
+	struct romdisk_chunk_t * chunk;
+	int nchunk_cached;
+	struct list_head lru;
+	struct mutex_t lock;
 };
 
 static u64_t blk_romdisk_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
@@ -44,6 +78,93 @@ static u64_t blk_romdisk_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64
 	return blkcnt;
 }
 
+static inline u32_t romdisk_chunk_length(struct blk_romdisk_pdata_t * pdat, u32_t index)
+{
+	u64_t pos = (u64_t)index * pdat->chksz;
+	return (pdat->length - pos < pdat->chksz) ? (u32_t)(pdat->length - pos) : pdat->chksz;
+}
+
+static bool_t romdisk_chunk_decompress(struct blk_romdisk_pdata_t * pdat, u32_t index, u8_t * buf)
+{
+	const char * src = (const char *)(pdat->addr + pdat->offset[index]);
+	int clen = pdat->offset[index + 1] - pdat->offset[index];
+	int len = romdisk_chunk_length(pdat, index);
+
+	if(clen == len)
+	{
+		memcpy(buf, src, len);
+		return TRUE;
+	}
+	return (LZ4_decompress_safe(src, (char *)buf, clen, len) == len) ? TRUE : FALSE;
+}
+
+static struct romdisk_chunk_t * romdisk_chunk_get(struct blk_romdisk_pdata_t * pdat, u32_t index)
+{
+	struct romdisk_chunk_t * c;
+
+	list_for_each_entry(c, &pdat->lru, entry)
+	{
+		if(c->index == index)
+		{
+			list_move(&c->entry, &pdat->lru);
+			return c;
+		}
+	}
+	c = list_last_entry(&pdat->lru, struct romdisk_chunk_t, entry);
+	c->index = -1;
+	if(!romdisk_chunk_decompress(pdat, index, c->buf))
+		return NULL;
+	c->index = index;
+	list_move(&c->entry, &pdat->lru);
+	return c;
+}
+
+static u64_t blk_romdisk_lz4_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct blk_romdisk_pdata_t * pdat = (struct blk_romdisk_pdata_t *)(blk->priv);
+	struct romdisk_chunk_t * c;
+	u64_t pos = block_offset(blk, blkno);
+	u64_t end = pos + block_size(blk) * blkcnt;
+	u64_t start = pos;
+	u32_t index, o, len, n;
+
+	while(pos < end)
+	{
+		if(pos >= pdat->length)
+		{
+			memset(buf, 0, end - pos);
+			break;
+		}
+		index = pos / pdat->chksz;
+		o = pos % pdat->chksz;
+		len = romdisk_chunk_length(pdat, index);
+		n = (end - pos < len - o) ? (u32_t)(end - pos) : len - o;
+
+		if(pdat->offset[index + 1] - pdat->offset[index] == len)
+		{
+			memcpy(buf, (const void *)(pdat->addr + pdat->offset[index] + o), n);
+		}
+		else if((o == 0) && (n == len))
+		{
+			if(!romdisk_chunk_decompress(pdat, index, buf))
+				break;
+		}
+		else
+		{
+			mutex_lock(&pdat->lock);
+			c = romdisk_chunk_get(pdat, index);
+			if(c)
+				memcpy(buf, c->buf + o, n);
+			mutex_unlock(&pdat->lock);
+			if(!c)
+				break;
+		}
+		buf += n;
+		pos += n;
+	}
+	return (pos - start) / block_size(blk);
+}
+
 static u64_t blk_romdisk_write(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
 {
 	return 0;
@@ -53,14 +174,52 @@ static void blk_romdisk_sync(struct block_t * blk)
 {
 }
 
+static void * blk_romdisk_mmap(struct block_t * blk, u64_t offset, u64_t count)
+{
+	struct blk_romdisk_pdata_t * pdat = (struct blk_romdisk_pdata_t *)(blk->priv);
+	u32_t index, o, i;
+
+	if(!pdat->chunk)
+		return (void *)(pdat->addr + offset);
+
+	/*
+	 * Only a range over chunks stored as is can be addressed directly, such
+	 * chunks follow each other in the image without a gap
+	 */
+	if(offset + count > pdat->length)
+		return NULL;
+	index = offset / pdat->chksz;
+	o = offset % pdat->chksz;
+	for(i = index; (u64_t)i * pdat->chksz < offset + count; i++)
+	{
+		if(pdat->offset[i + 1] - pdat->offset[i] != romdisk_chunk_length(pdat, i))
+			return NULL;
+	}
+	return (void *)(pdat->addr + pdat->offset[index] + o);
+}
+
+static void romdisk_chunk_free(struct blk_romdisk_pdata_t * pdat)
+{
+	int i;
+
+	if(pdat->chunk)
+	{
+		for(i = 0; i < pdat->nchunk_cached; i++)
+			free(pdat->chunk[i].buf);
+		free(pdat->chunk);
+	}
+}
+
 static struct device_t * blk_romdisk_probe(struct driver_t * drv, struct dtnode_t * n)
 {
 	struct blk_romdisk_pdata_t * pdat;
+	struct romdisk_lz4_header_t * hdr;
 	struct block_t * blk;
 	struct device_t * dev;
 	u64_t blkcnt, blksz = SZ_512;
 	virtual_addr_t addr = dt_read_long(n, "address", 0);
 	virtual_size_t size = dt_read_long(n, "size", 0);
+	int i;
 
 	if(size <= 0)
 		return NULL;
@@ -69,6 +228,7 @@ static struct device_t * blk_romdisk_probe(struct driver_t * drv, struct dtnode_
 	pdat = malloc(sizeof(struct blk_romdisk_pdata_t));
 	if(!pdat)
 		return NULL;
+	memset(pdat, 0, sizeof(struct blk_romdisk_pdata_t));
 
 	blk = malloc(sizeof(struct block_t));
 	if(!blk)
@@ -80,16 +240,56 @@ static struct device_t * blk_romdisk_probe(struct driver_t * drv, struct dtnode_
 	pdat->addr = addr;
 	pdat->size = blkcnt * blksz;
 
+	hdr = (struct romdisk_lz4_header_t *)addr;
+	if((size > sizeof(struct romdisk_lz4_header_t)) && (hdr->magic == ROMDISK_LZ4_MAGIC) && (hdr->version == ROMDISK_LZ4_VERSION))
+	{
+		pdat->offset = (const u32_t *)(addr + sizeof(struct romdisk_lz4_header_t));
+		pdat->chksz = hdr->chksz;
+		pdat->nchunk = hdr->nchunk;
+		pdat->length = hdr->size;
+		pdat->nchunk_cached = dt_read_int(n, "cache-chunks", 4);
+		if(pdat->nchunk_cached < 1)
+			pdat->nchunk_cached = 1;
+		pdat->chunk = malloc(sizeof(struct romdisk_chunk_t) * pdat->nchunk_cached);
+		if(!pdat->chunk)
+		{
+			free(blk);
+			free(pdat);
+			return NULL;
+		}
+		init_list_head(&pdat->lru);
+		for(i = 0; i < pdat->nchunk_cached; i++)
+		{
+			pdat->chunk[i].index = -1;
+			pdat->chunk[i].buf = malloc(pdat->chksz);
+			if(!pdat->chunk[i].buf)
+			{
+				while(--i >= 0)
+					free(pdat->chunk[i].buf);
+				free(pdat->chunk);
+				free(blk);
+				free(pdat);
+				return NULL;
+			}
+			list_add_tail(&pdat->chunk[i].entry, &pdat->lru);
+		}
+		mutex_init(&pdat->lock);
+		blkcnt = (pdat->length + blksz - 1) / blksz;
+		pdat->size = blkcnt * blksz;
+	}
+
 	blk->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
 	blk->blksz	= blksz;
 	blk->blkcnt	= blkcnt;
-	blk->read = blk_romdisk_read;
+	blk->read = pdat->chunk ? blk_romdisk_lz4_read : blk_romdisk_read;
 	blk->write = blk_romdisk_write;
 	blk->sync = blk_romdisk_sync;
+	blk->mmap = blk_romdisk_mmap;
 	blk->priv = pdat;
 
 	if(!(dev = register_block(blk, drv)))
 	{
+		romdisk_chunk_free(pdat);
 		free_device_name(blk->name);
 		free(blk->priv);
 		free(blk);
@@ -105,6 +305,7 @@ static void blk_romdisk_remove(struct device_t * dev)
 	if(blk)
 	{
 		unregister_block(blk);
+		romdisk_chunk_free((struct blk_romdisk_pdata_t *)(blk->priv));
 		free_device_name(blk->name);
 		free(blk->priv);
 		free(blk);
@@ -46,6 +46,13 @@ enum {
 };
 #define SFDP_MAX_NPH	(6)
 
+/*
+ * Logical block size exposed to the block layer, partial writes of an erase
+ * sector are merged in the sector cache
+ */
+#define SPINOR_BLOCK_SIZE	(512)
+#define SPINOR_PAGE_SIZE	(256)
+
 struct sfdp_header_t {
 	u8_t sign[4];
 	u8_t minor;
@@ -95,6 +102,19 @@ struct spinor_info_t {
 struct blk_spinor_pdata_t {
 	struct spi_device_t * dev;
 	struct spinor_info_t info;
+	struct mutex_t lock;
+
+	/*
+	 * One erase sector, as written and as on the chip
+	 */
+	u8_t * cache;
+	u8_t * flash;
+	u32_t caddr;
+	int cvalid;
+	int cdirty;
+
+	u64_t erase_count;
+	u64_t program_count;
 };
 
 static bool_t blk_spinor_read_sfdp(struct spi_device_t * dev, struct sfdp_t * sfdp)
@@ -596,102 +616,170 @@ static void blk_spinor_init(struct blk_spinor_pdata_t * pdat)
 	}
 }
 
-static u64_t blk_spinor_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+static void blk_spinor_sector_erase(struct blk_spinor_pdata_t * pdat, u32_t addr)
+{
+	blk_spinor_wait_for_busy(pdat);
+	blk_spinor_write_enable(pdat);
+	switch(pdat->info.blksz)
+	{
+	case 4096:
+		blk_spinor_sector_erase_4k(pdat, addr);
+		break;
+	case 32768:
+		blk_spinor_sector_erase_32k(pdat, addr);
+		break;
+	case 65536:
+		blk_spinor_sector_erase_64k(pdat, addr);
+		break;
+	case 262144:
+		blk_spinor_sector_erase_256k(pdat, addr);
+		break;
+	default:
+		break;
+	}
+	blk_spinor_wait_for_busy(pdat);
+	pdat->erase_count++;
+}
+
+static void blk_spinor_read_flash(struct blk_spinor_pdata_t * pdat, u32_t addr, u8_t * buf, u32_t count)
 {
-	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)blk->priv;
-	u64_t addr = blkno * blk->blksz;
-	s64_t cnt = blkcnt * blk->blksz;
-	u8_t * pbuf = buf;
 	u32_t len;
 
-	if(pdat->info.read_granularity == 1)
-		len = (cnt < 0x7fffffff) ? cnt : 0x7fffffff;
-	else
-		len = pdat->info.read_granularity;
-	while(cnt > 0)
+	blk_spinor_wait_for_busy(pdat);
+	while(count > 0)
 	{
-		blk_spinor_wait_for_busy(pdat);
-		blk_spinor_read_bytes(pdat, addr, pbuf, len);
+		if(pdat->info.read_granularity > 1)
+			len = min(count, pdat->info.read_granularity);
+		else
+			len = count;
+		blk_spinor_read_bytes(pdat, addr, buf, len);
 		addr += len;
-		pbuf += len;
-		cnt -= len;
+		buf += len;
+		count -= len;
 	}
+}
 
-	return blkcnt;
+static void blk_spinor_program_flash(struct blk_spinor_pdata_t * pdat, u32_t addr, u8_t * buf, u32_t count)
+{
+	blk_spinor_wait_for_busy(pdat);
+	blk_spinor_write_enable(pdat);
+	blk_spinor_write_bytes(pdat, addr, buf, count);
+	blk_spinor_wait_for_busy(pdat);
+	pdat->program_count++;
 }
 
-static u64_t blk_spinor_write(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+/*
+ * Write back the cached sector. Programming can only clear bits, so the
+ * sector is erased only when some bit has to go from 0 to 1, and then only
+ * the pages that differ from the chip are programmed
+ */
+static void blk_spinor_cache_flush(struct blk_spinor_pdata_t * pdat)
 {
-	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)blk->priv;
-	u64_t addr, baddr = blkno * blk->blksz;
-	s64_t cnt, count = blkcnt * blk->blksz;
-	u32_t len;
-	u8_t * pbuf;
+	u32_t esz = pdat->info.blksz;
+	u32_t psz, i;
 
-	addr = baddr;
-	cnt = count;
-	blk_spinor_wait_for_busy(pdat);
-	while(cnt > 0)
+	if(!pdat->cvalid || !pdat->cdirty)
+		return;
+
+	for(i = 0; i < esz; i++)
 	{
-		if((pdat->info.opcode_erase_256k != 0) && ((addr & 0x3ffff) == 0) && (cnt >= 262144))
-		{
-			len = 262144;
-			blk_spinor_write_enable(pdat);
-			blk_spinor_sector_erase_256k(pdat, addr);
-			blk_spinor_wait_for_busy(pdat);
-		}
-		else if((pdat->info.opcode_erase_64k != 0) && ((addr & 0xffff) == 0) && (cnt >= 65536))
-		{
-			len = 65536;
-			blk_spinor_write_enable(pdat);
-			blk_spinor_sector_erase_64k(pdat, addr);
-			blk_spinor_wait_for_busy(pdat);
-		}
-		else if((pdat->info.opcode_erase_32k != 0) && ((addr & 0x7fff) == 0) && (cnt >= 32768))
-		{
-			len = 32768;
-			blk_spinor_write_enable(pdat);
-			blk_spinor_sector_erase_32k(pdat, addr);
-			blk_spinor_wait_for_busy(pdat);
-		}
-		else if((pdat->info.opcode_erase_4k != 0) && ((addr & 0xfff) == 0) && (cnt >= 4096))
+		if((pdat->flash[i] & pdat->cache[i]) != pdat->cache[i])
 		{
-			len = 4096;
-			blk_spinor_write_enable(pdat);
-			blk_spinor_sector_erase_4k(pdat, addr);
-			blk_spinor_wait_for_busy(pdat);
+			blk_spinor_sector_erase(pdat, pdat->caddr);
+			memset(pdat->flash, 0xff, esz);
+			break;
 		}
-		else
+	}
+
+	psz = (pdat->info.write_granularity > 1) ? pdat->info.write_granularity : SPINOR_PAGE_SIZE;
+	for(i = 0; i < esz; i += psz)
+	{
+		if(memcmp(&pdat->cache[i], &pdat->flash[i], psz) != 0)
 		{
-			return 0;
+			blk_spinor_program_flash(pdat, pdat->caddr + i, &pdat->cache[i], psz);
+			memcpy(&pdat->flash[i], &pdat->cache[i], psz);
 		}
-		addr += len;
-		cnt -= len;
 	}
+	pdat->cdirty = 0;
+}
 
-	addr = baddr;
-	cnt = count;
-	pbuf = buf;
-	if(pdat->info.write_granularity == 1)
-		len = (cnt < 0x7fffffff) ? cnt : 0x7fffffff;
-	else
-		len = pdat->info.write_granularity;
-	blk_spinor_wait_for_busy(pdat);
+static void blk_spinor_cache_load(struct blk_spinor_pdata_t * pdat, u32_t addr)
+{
+	if(pdat->cvalid && (pdat->caddr == addr))
+		return;
+	blk_spinor_cache_flush(pdat);
+	blk_spinor_read_flash(pdat, addr, pdat->flash, pdat->info.blksz);
+	memcpy(pdat->cache, pdat->flash, pdat->info.blksz);
+	pdat->caddr = addr;
+	pdat->cvalid = 1;
+	pdat->cdirty = 0;
+}
+
+static ssize_t blk_spinor_read_erase(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)kobj->priv;
+	return sprintf(buf, "%lld", pdat->erase_count);
+}
+
+static ssize_t blk_spinor_read_program(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)kobj->priv;
+	return sprintf(buf, "%lld", pdat->program_count);
+}
+
+static u64_t blk_spinor_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)blk->priv;
+	u32_t addr = blkno * blk->blksz;
+	u32_t cnt = blkcnt * blk->blksz;
+	u32_t s, e;
+
+	mutex_lock(&pdat->lock);
+	blk_spinor_read_flash(pdat, addr, buf, cnt);
+	if(pdat->cvalid && pdat->cdirty)
+	{
+		s = max(addr, pdat->caddr);
+		e = min(addr + cnt, pdat->caddr + pdat->info.blksz);
+		if(s < e)
+			memcpy(&buf[s - addr], &pdat->cache[s - pdat->caddr], e - s);
+	}
+	mutex_unlock(&pdat->lock);
+
+	return blkcnt;
+}
+
+static u64_t blk_spinor_write(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)blk->priv;
+	u32_t addr = blkno * blk->blksz;
+	u32_t cnt = blkcnt * blk->blksz;
+	u32_t esz = pdat->info.blksz;
+	u32_t o, len;
+
+	mutex_lock(&pdat->lock);
 	while(cnt > 0)
 	{
-		blk_spinor_write_enable(pdat);
-		blk_spinor_write_bytes(pdat, addr, pbuf, len);
-		blk_spinor_wait_for_busy(pdat);
+		o = addr & (esz - 1);
+		len = min(cnt, esz - o);
+		blk_spinor_cache_load(pdat, addr - o);
+		memcpy(&pdat->cache[o], buf, len);
+		pdat->cdirty = 1;
 		addr += len;
-		pbuf += len;
+		buf += len;
 		cnt -= len;
 	}
+	mutex_unlock(&pdat->lock);
 
 	return blkcnt;
 }
 
 static void blk_spinor_sync(struct block_t * blk)
 {
+	struct blk_spinor_pdata_t * pdat = (struct blk_spinor_pdata_t *)blk->priv;
+
+	mutex_lock(&pdat->lock);
+	blk_spinor_cache_flush(pdat);
+	mutex_unlock(&pdat->lock);
 }
 
 static struct device_t * blk_spinor_probe(struct driver_t * drv, struct dtnode_t * n)
@@ -729,15 +817,34 @@ static struct device_t * blk_spinor_probe(struct driver_t * drv, struct dtnode_t
 		return NULL;
 	}
 
+	pdat->cache = malloc(info.blksz);
+	pdat->flash = malloc(info.blksz);
+	if(!pdat->cache || !pdat->flash)
+	{
+		spi_device_free(spidev);
+		free(pdat->cache);
+		free(pdat->flash);
+		free(pdat);
+		free(blk);
+		return NULL;
+	}
+
 	pdat->dev = spidev;
 	memcpy(&pdat->info, &info, sizeof(struct spinor_info_t));
+	mutex_init(&pdat->lock);
+	pdat->caddr = 0;
+	pdat->cvalid = 0;
+	pdat->cdirty = 0;
+	pdat->erase_count = 0;
+	pdat->program_count = 0;
 
 	blk->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
-	blk->blksz = pdat->info.blksz;
-	blk->blkcnt = pdat->info.capacity / pdat->info.blksz;
+	blk->blksz = SPINOR_BLOCK_SIZE;
+	blk->blkcnt = pdat->info.capacity / SPINOR_BLOCK_SIZE;
 	blk->read = blk_spinor_read;
 	blk->write = blk_spinor_write;
 	blk->sync = blk_spinor_sync;
+	blk->mmap = NULL;
 	blk->priv = pdat;
 	blk_spinor_init(pdat);
 
@@ -745,10 +852,14 @@ static struct device_t * blk_spinor_probe(struct driver_t * drv, struct dtnode_t
 	{
 		spi_device_free(pdat->dev);
 		free_device_name(blk->name);
+		free(pdat->cache);
+		free(pdat->flash);
 		free(blk->priv);
 		free(blk);
 		return NULL;
 	}
+	kobj_add_regular(dev->kobj, "erase", blk_spinor_read_erase, NULL, pdat);
+	kobj_add_regular(dev->kobj, "program", blk_spinor_read_program, NULL, pdat);
 	if((npart = dt_read_array_length(n, "partition")) > 0)
 	{
 		char nbuf[64];
@@ -795,8 +906,11 @@ static void blk_spinor_remove(struct device_t * dev)
 	{
 		unregister_sub_block(blk);
 		unregister_block(blk);
+		blk_spinor_cache_flush(pdat);
 		spi_device_free(pdat->dev);
 		free_device_name(blk->name);
+		free(pdat->cache);
+		free(pdat->flash);
 		free(blk->priv);
 		free(blk);
 	}
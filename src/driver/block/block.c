@@ -52,168 +52,445 @@ static ssize_t block_read_capacity(struct kobj_t * kobj, void * buf, size_t size
 	return sprintf(buf, "%lld", block_capacity(blk));
 }
 
-static u64_t sub_block_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+/*
+ * Request queue, one per block device. Submitted bios are merged into requests
+ * of adjacent blocks and dispatched in one way elevator order, either by a worker
+ * task or by whoever waits on them. A request never passes an older one that
+ * overlaps it unless both are reads.
+ */
+struct block_request_t {
+	struct list_head entry;
+	struct list_head bios;
+	int rw;
+	int nseg;
+	u64_t blkno;
+	u64_t blkcnt;
+	u64_t seq;
+};
+
+struct block_queue_t {
+	struct list_head head;
+	spinlock_t lock;
+	int worker;
+	int busy;
+	u64_t seq;
+	u64_t pos;
+	u64_t maxcnt;
+	u64_t submit;
+	u64_t merge;
+	u64_t dispatch;
+	u8_t * scratch;
+	int scratch_busy;
+};
+
+static inline u64_t block_driver_xfer(struct block_t * blk, int rw, u8_t * buf, u64_t blkno, u64_t blkcnt)
 {
-	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
-	struct block_t * pblk = pdat->pblk;
-	return (pblk->read(pblk, buf, blkno + pdat->blkno, blkcnt));
+	if(rw == BIO_WRITE)
+		return blk->write(blk, buf, blkno, blkcnt);
+	return blk->read(blk, buf, blkno, blkcnt);
 }
 
-static u64_t sub_block_write(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+static inline int block_request_conflict(struct block_request_t * req, int rw, u64_t blkno, u64_t blkcnt)
 {
-	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
-	struct block_t * pblk = pdat->pblk;
-	return (pblk->write(pblk, buf, blkno + pdat->blkno, blkcnt));
+	if((req->rw == BIO_READ) && (rw == BIO_READ))
+		return 0;
+	return (req->blkno < blkno + blkcnt) && (blkno < req->blkno + req->blkcnt);
 }
 
-static void sub_block_sync(struct block_t * blk)
+static u64_t block_bio_transfer(struct block_t * blk, struct bio_t * bio)
 {
-	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
-	struct block_t * pblk = pdat->pblk;
-	pblk->sync(pblk);
+	u64_t ret, total = 0;
+	int i;
+
+	for(i = 0; i < bio->nvec; i++)
+	{
+		if(bio->vec[i].blkcnt == 0)
+			continue;
+		ret = block_driver_xfer(blk, bio->rw, bio->vec[i].buf, bio->blkno + total, bio->vec[i].blkcnt);
+		total += ret;
+		if(ret != bio->vec[i].blkcnt)
+			break;
+	}
+	return total;
 }
 
-struct block_t * search_block(const char * name)
+static void block_bio_copy(struct bio_t * bio, u8_t * p, u64_t blksz, int gather)
 {
-	struct device_t * dev;
+	u64_t count = gather ? bio->blkcnt : bio->done;
+	u64_t len;
+	int i;
 
-	dev = search_device(name, DEVICE_TYPE_BLOCK);
-	if(!dev)
-		return NULL;
-	return (struct block_t *)dev->priv;
+	for(i = 0; (i < bio->nvec) && (count > 0); i++)
+	{
+		len = (bio->vec[i].blkcnt < count) ? bio->vec[i].blkcnt : count;
+		if(gather)
+			memcpy(p, bio->vec[i].buf, len * blksz);
+		else
+			memcpy(bio->vec[i].buf, p, len * blksz);
+		p += len * blksz;
+		count -= len;
+	}
 }
 
-struct device_t * register_block(struct block_t * blk, struct driver_t * drv)
+/*
+ * Requests of several segments go through a bounce buffer with one driver call
+ */
+static void block_request_transfer(struct block_t * blk, struct block_request_t * req)
 {
-	struct device_t * dev;
+	struct bio_t * bio;
+	u64_t blksz = block_size(blk);
+	u64_t total, off = 0;
+	u8_t * p = NULL;
+
+	if(req->nseg > 1)
+		p = malloc(blksz * req->blkcnt);
+	if(p)
+	{
+		if(req->rw == BIO_WRITE)
+		{
+			list_for_each_entry(bio, &req->bios, entry)
+			{
+				block_bio_copy(bio, &p[blksz * off], blksz, 1);
+				off += bio->blkcnt;
+			}
+			off = 0;
+		}
+		total = block_driver_xfer(blk, req->rw, p, req->blkno, req->blkcnt);
+		list_for_each_entry(bio, &req->bios, entry)
+		{
+			if(total > off)
+				bio->done = (total - off < bio->blkcnt) ? total - off : bio->blkcnt;
+			if(req->rw == BIO_READ)
+				block_bio_copy(bio, &p[blksz * off], blksz, 0);
+			off += bio->blkcnt;
+		}
+		free(p);
+	}
+	else
+	{
+		list_for_each_entry(bio, &req->bios, entry)
+		{
+			bio->done = block_bio_transfer(blk, bio);
+			if(bio->done != bio->blkcnt)
+				break;
+		}
+	}
+}
 
-	if(!blk || !blk->name)
-		return NULL;
+static void block_bio_complete(struct bio_t * bio)
+{
+	bio->complete = 1;
+	if(bio->end)
+		bio->end(bio);
+}
 
-	if(!blk->read || !blk->write || !blk->sync)
-		return NULL;
+static struct block_request_t * block_queue_next(struct block_queue_t * q)
+{
+	struct block_request_t * pos, * prev, * first = NULL;
+	int blocked;
 
-	dev = malloc(sizeof(struct device_t));
-	if(!dev)
-		return NULL;
+	list_for_each_entry(pos, &q->head, entry)
+	{
+		blocked = 0;
+		list_for_each_entry(prev, &q->head, entry)
+		{
+			if((prev->seq < pos->seq) && block_request_conflict(prev, pos->rw, pos->blkno, pos->blkcnt))
+			{
+				blocked = 1;
+				break;
+			}
+		}
+		if(blocked)
+			continue;
+		if(pos->blkno >= q->pos)
+			return pos;
+		if(!first)
+			first = pos;
+	}
+	return first;
+}
 
-	dev->name = strdup(blk->name);
-	dev->type = DEVICE_TYPE_BLOCK;
-	dev->driver = drv;
-	dev->priv = blk;
-	dev->kobj = kobj_alloc_directory(dev->name);
-	kobj_add_regular(dev->kobj, "size", block_read_size, NULL, blk);
-	kobj_add_regular(dev->kobj, "count", block_read_count, NULL, blk);
-	kobj_add_regular(dev->kobj, "capacity", block_read_capacity, NULL, blk);
+static void block_queue_insert(struct block_queue_t * q, struct block_request_t * req)
+{
+	struct block_request_t * pos;
 
-	if(!register_device(dev))
+	list_for_each_entry(pos, &q->head, entry)
 	{
-		kobj_remove_self(dev->kobj);
-		free(dev->name);
-		free(dev);
-		return NULL;
+		if(pos->blkno > req->blkno)
+			break;
 	}
-	return dev;
+	list_add_tail(&req->entry, &pos->entry);
 }
 
-void unregister_block(struct block_t * blk)
+/*
+ * Join two requests of adjacent blocks, the merged one keeps the older sequence
+ * so it must not pass a request in between that conflicts with the newer one
+ */
+static int block_queue_join(struct block_queue_t * q, struct block_request_t * a, struct block_request_t * b)
 {
-	struct device_t * dev;
+	struct block_request_t * older = (a->seq < b->seq) ? a : b;
+	struct block_request_t * newer = (a->seq < b->seq) ? b : a;
+	struct block_request_t * pos;
 
-	if(blk && blk->name)
+	if((a->rw != b->rw) || (a->blkno + a->blkcnt != b->blkno) || (a->blkcnt + b->blkcnt > q->maxcnt))
+		return 0;
+	list_for_each_entry(pos, &q->head, entry)
 	{
-		dev = search_device(blk->name, DEVICE_TYPE_BLOCK);
-		if(dev && unregister_device(dev))
+		if((pos->seq > older->seq) && (pos->seq < newer->seq) && block_request_conflict(pos, newer->rw, newer->blkno, newer->blkcnt))
+			return 0;
+	}
+	list_splice_tail_init(&b->bios, &a->bios);
+	a->blkcnt += b->blkcnt;
+	a->nseg += b->nseg;
+	a->seq = older->seq;
+	list_del(&b->entry);
+	free(b);
+	q->merge++;
+	return 1;
+}
+
+static void block_queue_merge(struct block_queue_t * q, struct block_request_t * req)
+{
+	struct block_request_t * pos;
+	int merged;
+
+	do {
+		merged = 0;
+		list_for_each_entry(pos, &q->head, entry)
 		{
-			kobj_remove_self(dev->kobj);
-			free(dev->name);
-			free(dev);
+			if(pos == req)
+				continue;
+			if((pos->blkno + pos->blkcnt == req->blkno) && block_queue_join(q, pos, req))
+			{
+				req = pos;
+				merged = 1;
+				break;
+			}
+			if((req->blkno + req->blkcnt == pos->blkno) && block_queue_join(q, req, pos))
+			{
+				merged = 1;
+				break;
+			}
 		}
-	}
+	} while(merged);
 }
 
-struct device_t * register_sub_block(struct block_t * pblk, u64_t offset, u64_t length, const char * name)
+/*
+ * Dispatch one request, return zero if the queue is empty or another task is
+ * already talking to the driver
+ */
+static int block_queue_dispatch(struct block_t * blk)
 {
-	struct device_t * dev;
-	struct block_t * blk;
-	struct sub_block_pdata_t * pdat;
-	u64_t blksz, blkno, blkcnt, tmp;
-	char buffer[256];
+	struct block_queue_t * q = (struct block_queue_t *)blk->queue;
+	struct block_request_t * req;
+	struct bio_t * bio, * n;
 
-	if(!name)
-		return NULL;
+	spin_lock(&q->lock);
+	if(q->busy || list_empty(&q->head))
+	{
+		spin_unlock(&q->lock);
+		return 0;
+	}
+	req = block_queue_next(q);
+	list_del(&req->entry);
+	q->busy = 1;
+	q->pos = req->blkno + req->blkcnt;
+	q->dispatch++;
+	spin_unlock(&q->lock);
 
-	if(!pblk || !pblk->name)
-		return NULL;
+	block_request_transfer(blk, req);
 
-	blksz = block_size(pblk);
-	blkno = offset / blksz;
-	tmp = offset % blksz;
-	if(tmp > 0)
-		blkno++;
-	tmp = length / blksz;
-	blkcnt = block_available_count(pblk, blkno, tmp);
-	if(blkcnt <= 0)
-		return NULL;
+	spin_lock(&q->lock);
+	q->busy = 0;
+	spin_unlock(&q->lock);
 
-	blk = malloc(sizeof(struct block_t));
-	pdat = malloc(sizeof(struct sub_block_pdata_t));
-	if(!blk || !pdat)
+	list_for_each_entry_safe(bio, n, &req->bios, entry)
 	{
-		free(blk);
-		free(pdat);
-		return NULL;
+		list_del_init(&bio->entry);
+		block_bio_complete(bio);
 	}
+	free(req);
+	return 1;
+}
 
-	snprintf(buffer, sizeof(buffer), "%s.%s", pblk->name, name);
-	pdat->blkno = blkno;
-	pdat->pblk = pblk;
+static void block_queue_task(struct task_t * task, void * data)
+{
+	struct block_t * blk = (struct block_t *)data;
+	struct block_queue_t * q = (struct block_queue_t *)blk->queue;
 
-	blk->name = strdup(buffer);
-	blk->blksz = blksz;
-	blk->blkcnt = blkcnt;
-	blk->read = sub_block_read;
-	blk->write = sub_block_write;
-	blk->sync = sub_block_sync;
-	blk->priv = pdat;
+	while(1)
+	{
+		if(block_queue_dispatch(blk))
+			continue;
+		spin_lock(&q->lock);
+		if(list_empty(&q->head))
+		{
+			q->worker = 0;
+			spin_unlock(&q->lock);
+			break;
+		}
+		spin_unlock(&q->lock);
+		task_yield();
+	}
+}
 
-	if(!(dev = register_block(blk, NULL)))
+/*
+ * Queue a bio, an asynchronous submit also makes sure a worker task will
+ * dispatch it, so bios submitted in a burst get merged before it runs
+ */
+static bool_t block_queue_submit(struct block_t * blk, struct bio_t * bio, int async)
+{
+	struct block_queue_t * q = (struct block_queue_t *)blk->queue;
+	struct block_request_t * req;
+	struct task_t * task;
+	int spawn = 0;
+
+	bio->blk = blk;
+	bio->done = 0;
+	bio->complete = 0;
+	init_list_head(&bio->entry);
+
+	req = malloc(sizeof(struct block_request_t));
+	if(!req)
+		return FALSE;
+	init_list_head(&req->bios);
+	list_add_tail(&bio->entry, &req->bios);
+	req->rw = bio->rw;
+	req->nseg = bio->nvec;
+	req->blkno = bio->blkno;
+	req->blkcnt = bio->blkcnt;
+
+	spin_lock(&q->lock);
+	q->submit++;
+	req->seq = q->seq++;
+	block_queue_insert(q, req);
+	block_queue_merge(q, req);
+	if(async && !q->worker && task_self())
 	{
-		free(blk->priv);
-		free(blk->name);
-		free(blk);
-		return NULL;
+		q->worker = 1;
+		spawn = 1;
 	}
-	return dev;
+	spin_unlock(&q->lock);
+
+	if(spawn)
+	{
+		task = task_create(NULL, blk->name, block_queue_task, blk, 0, 0);
+		if(task)
+			task_resume(task);
+		else
+		{
+			spin_lock(&q->lock);
+			q->worker = 0;
+			spin_unlock(&q->lock);
+		}
+	}
+	if(async && !q->worker)
+		block_unplug(blk);
+	return TRUE;
 }
 
-void unregister_sub_block(struct block_t * pblk)
+/*
+ * The synchronous path used by block core, a single segment bio on the stack
+ */
+static u64_t block_queue_xfer(struct block_t * blk, int rw, u8_t * buf, u64_t blkno, u64_t blkcnt)
 {
-	struct device_t * pos, * n;
-	struct block_t * blk;
-	int len;
+	struct bio_vec_t vec;
+	struct bio_t bio;
 
-	if(pblk && pblk->name && search_block(pblk->name))
+	if(blk->queue)
 	{
-		len = strlen(pblk->name);
-		list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_BLOCK], head)
+		vec.buf = buf;
+		vec.blkcnt = blkcnt;
+		bio_init(&bio, rw, blkno, &vec, 1, NULL, NULL);
+		if(block_queue_submit(blk, &bio, 0))
 		{
-			if((strncmp(pos->name, pblk->name, len) == 0) && (strlen(pos->name) > len))
-			{
-				blk = (struct block_t *)pos->priv;
-				if(blk)
-				{
-					unregister_block(blk);
-					free(blk->priv);
-					free(blk->name);
-					free(blk);
-				}
-			}
+			bio_wait(&bio);
+			return bio.done;
 		}
+		block_unplug(blk);
 	}
+	return block_driver_xfer(blk, rw, buf, blkno, blkcnt);
 }
 
-u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
+static ssize_t block_read_queue(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct block_t * blk = (struct block_t *)kobj->priv;
+	struct block_queue_t * q = (struct block_queue_t *)blk->queue;
+
+	if(!q)
+		return 0;
+	return sprintf(buf, "submit: %lld\r\nmerge: %lld\r\ndispatch: %lld", q->submit, q->merge, q->dispatch);
+}
+
+/*
+ * Sub blocks have no cache of their own, they go through the cache of the
+ * parent device, so both views of the same blocks stay coherent
+ */
+static u64_t sub_block_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
+	struct block_t * pblk = pdat->pblk;
+	return block_read(pblk, buf, block_offset(pblk, blkno + pdat->blkno), blkcnt * block_size(pblk)) / block_size(pblk);
+}
+
+static u64_t sub_block_write(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
+	struct block_t * pblk = pdat->pblk;
+	return block_write(pblk, buf, block_offset(pblk, blkno + pdat->blkno), blkcnt * block_size(pblk)) / block_size(pblk);
+}
+
+static void sub_block_sync(struct block_t * blk)
+{
+	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
+	struct block_t * pblk = pdat->pblk;
+	block_sync(pblk);
+}
+
+static void * sub_block_mmap(struct block_t * blk, u64_t offset, u64_t count)
+{
+	struct sub_block_pdata_t * pdat = (struct sub_block_pdata_t *)(blk->priv);
+	struct block_t * pblk = pdat->pblk;
+	return block_mmap(pblk, block_offset(pblk, pdat->blkno) + offset, count);
+}
+
+/*
+ * One block of scratch per device for the partial blocks of direct transfers,
+ * a nested transfer on the same device while it is in use gets its own
+ */
+static u8_t * block_scratch_get(struct block_t * blk)
+{
+	struct block_queue_t * q = (struct block_queue_t *)blk->queue;
+	u8_t * p = NULL;
+
+	if(q)
+	{
+		spin_lock(&q->lock);
+		if(q->scratch && !q->scratch_busy)
+		{
+			q->scratch_busy = 1;
+			p = q->scratch;
+		}
+		spin_unlock(&q->lock);
+	}
+	return p ? p : malloc(block_size(blk));
+}
+
+static void block_scratch_put(struct block_t * blk, u8_t * p)
+{
+	struct block_queue_t * q = (struct block_queue_t *)blk->queue;
+
+	if(q && (p == q->scratch))
+	{
+		spin_lock(&q->lock);
+		q->scratch_busy = 0;
+		spin_unlock(&q->lock);
+	}
+	else
+		free(p);
+}
+
+static u64_t block_direct_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 {
 	u64_t blkno, blksz, blkcnt, capacity;
 	u64_t len, tmp;
@@ -236,7 +513,7 @@ u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 	if(count > tmp)
 		count = tmp;
 
-	p = malloc(blksz);
+	p = block_scratch_get(blk);
 	if(!p)
 		return 0;
 
@@ -248,9 +525,9 @@ u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 		if(count < len)
 			len = count;
 
-		if(blk->read(blk, p, blkno, 1) != 1)
+		if(block_queue_xfer(blk, BIO_READ, p, blkno, 1) != 1)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
@@ -266,9 +543,9 @@ u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 	{
 		len = tmp * blksz;
 
-		if(blk->read(blk, buf, blkno, tmp) != tmp)
+		if(block_queue_xfer(blk, BIO_READ, buf, blkno, tmp) != tmp)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
@@ -282,9 +559,9 @@ u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 	{
 		len = count;
 
-		if(blk->read(blk, p, blkno, 1) != 1)
+		if(block_queue_xfer(blk, BIO_READ, p, blkno, 1) != 1)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
@@ -292,11 +569,11 @@ u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 		ret += len;
 	}
 
-	free(p);
+	block_scratch_put(blk, p);
 	return ret;
 }
 
-u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
+static u64_t block_direct_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 {
 	u64_t blkno, blksz, blkcnt, capacity;
 	u64_t len, tmp;
@@ -319,7 +596,7 @@ u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 	if(count > tmp)
 		count = tmp;
 
-	p = malloc(blksz);
+	p = block_scratch_get(blk);
 	if(!p)
 		return 0;
 
@@ -331,17 +608,17 @@ u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 		if(count < len)
 			len = count;
 
-		if(blk->read(blk, p, blkno, 1) != 1)
+		if(block_queue_xfer(blk, BIO_READ, p, blkno, 1) != 1)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
 		memcpy((void *)(&p[tmp]), (const void *)buf, len);
 
-		if(blk->write(blk, p, blkno, 1) != 1)
+		if(block_queue_xfer(blk, BIO_WRITE, p, blkno, 1) != 1)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
@@ -356,9 +633,9 @@ u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 	{
 		len = tmp * blksz;
 
-		if(blk->write(blk, buf, blkno, tmp) != tmp)
+		if(block_queue_xfer(blk, BIO_WRITE, buf, blkno, tmp) != tmp)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
@@ -372,29 +649,1025 @@ u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
 	{
 		len = count;
 
-		if(blk->read(blk, p, blkno, 1) != 1)
+		if(block_queue_xfer(blk, BIO_READ, p, blkno, 1) != 1)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
 		memcpy((void *)(&p[0]), (const void *)buf, len);
 
-		if(blk->write(blk, p, blkno, 1) != 1)
+		if(block_queue_xfer(blk, BIO_WRITE, p, blkno, 1) != 1)
 		{
-			free(p);
+			block_scratch_put(blk, p);
 			return ret;
 		}
 
 		ret += len;
 	}
 
-	free(p);
+	block_scratch_put(blk, p);
 	return ret;
 }
 
-void block_sync(struct block_t * blk)
+/*
+ * Buffer cache shared by all block devices and keyed by (device, block number).
+ * Cached blocks sit on one lru list under a global memory budget, dirty blocks
+ * also sit on a dirty list in the order they were dirtied. They are written
+ * back by block_sync, by the background flusher through block_writeback, or
+ * when they are evicted.
+ */
+struct block_cache_t {
+	struct hlist_node node;
+	struct list_head entry;
+	struct list_head wb;
+	struct block_t * blk;
+	u64_t blkno;
+	int dirty;
+	ktime_t stamp;
+	u8_t * buf;
+};
+
+struct block_stat_t {
+	u64_t hit;
+	u64_t miss;
+	u64_t readahead;
+	u64_t writeback;
+	u64_t dirty;
+	u64_t ra_next;
+	u64_t ra_count;
+	int unsynced;
+};
+
+static struct hlist_head __block_cache_hash[CONFIG_BLOCK_CACHE_HASH_SIZE];
+static struct list_head __block_cache_lru = {
+	.next = &__block_cache_lru,
+	.prev = &__block_cache_lru,
+};
+static struct list_head __block_cache_wb = {
+	.next = &__block_cache_wb,
+	.prev = &__block_cache_wb,
+};
+static struct mutex_t __block_cache_lock;
+static struct block_stat_t __block_cache_stat;
+static u64_t __block_cache_budget = CONFIG_BLOCK_CACHE_SIZE;
+static u64_t __block_cache_used = 0;
+static u64_t __block_cache_dirty = 0;
+static u8_t * __block_cache_scratch = NULL;
+static u64_t __block_cache_scratch_size = 0;
+
+static inline struct hlist_head * block_cache_hash(struct block_t * blk, u64_t blkno)
+{
+	return &__block_cache_hash[((((unsigned long)blk) >> 4) ^ blkno) % CONFIG_BLOCK_CACHE_HASH_SIZE];
+}
+
+static inline u64_t block_cache_ra_max(struct block_t * blk)
+{
+	u64_t n = CONFIG_BLOCK_READAHEAD_SIZE / block_size(blk);
+	return (n > 0) ? n : 1;
+}
+
+static struct block_cache_t * block_cache_search(struct block_t * blk, u64_t blkno)
+{
+	struct block_cache_t * pos;
+
+	hlist_for_each_entry(pos, block_cache_hash(blk, blkno), node)
+	{
+		if((pos->blk == blk) && (pos->blkno == blkno))
+			return pos;
+	}
+	return NULL;
+}
+
+static u8_t * block_cache_scratch(u64_t size)
+{
+	u8_t * p;
+
+	if(size > __block_cache_scratch_size)
+	{
+		p = malloc(size);
+		if(!p)
+			return NULL;
+		free(__block_cache_scratch);
+		__block_cache_scratch = p;
+		__block_cache_scratch_size = size;
+	}
+	return __block_cache_scratch;
+}
+
+static inline void block_cache_dirty(struct block_cache_t * c, int dirty)
+{
+	struct block_stat_t * st = (struct block_stat_t *)c->blk->cache;
+
+	if(c->dirty != dirty)
+	{
+		c->dirty = dirty;
+		if(dirty)
+		{
+			c->stamp = ktime_get();
+			list_add_tail(&c->wb, &__block_cache_wb);
+			st->dirty++;
+			__block_cache_dirty += block_size(c->blk);
+		}
+		else
+		{
+			list_del_init(&c->wb);
+			st->dirty--;
+			__block_cache_dirty -= block_size(c->blk);
+		}
+	}
+}
+
+/*
+ * A dirty block is written back first, if that fails it stays cached and dirty
+ */
+static int block_cache_release(struct block_cache_t * c)
+{
+	struct block_t * blk = c->blk;
+	struct block_stat_t * st = (struct block_stat_t *)blk->cache;
+
+	if(c->dirty)
+	{
+		if(block_queue_xfer(blk, BIO_WRITE, c->buf, c->blkno, 1) != 1)
+			return 0;
+		block_cache_dirty(c, 0);
+		st->writeback++;
+		__block_cache_stat.writeback++;
+	}
+	hlist_del(&c->node);
+	list_del(&c->entry);
+	__block_cache_used -= block_size(blk);
+	free(c);
+	return 1;
+}
+
+static int block_cache_shrink(u64_t need)
+{
+	struct block_cache_t * pos, * n;
+
+	list_for_each_entry_safe_reverse(pos, n, &__block_cache_lru, entry)
+	{
+		if(__block_cache_used + need <= __block_cache_budget)
+			break;
+		block_cache_release(pos);
+	}
+	return (__block_cache_used + need <= __block_cache_budget) ? 1 : 0;
+}
+
+static struct block_cache_t * block_cache_alloc(struct block_t * blk, u64_t blkno)
+{
+	struct block_cache_t * c;
+	u64_t blksz = block_size(blk);
+
+	if(!block_cache_shrink(blksz))
+		return NULL;
+	c = malloc(sizeof(struct block_cache_t) + blksz);
+	if(!c)
+		return NULL;
+	c->blk = blk;
+	c->blkno = blkno;
+	c->dirty = 0;
+	c->buf = (u8_t *)(c + 1);
+	init_list_head(&c->wb);
+	init_hlist_node(&c->node);
+	hlist_add_head(&c->node, block_cache_hash(blk, blkno));
+	list_add(&c->entry, &__block_cache_lru);
+	__block_cache_used += blksz;
+	return c;
+}
+
+/*
+ * Read a run of uncached blocks with a single driver call and insert them
+ */
+static u64_t block_cache_fill(struct block_t * blk, u64_t blkno, u64_t blkcnt)
+{
+	struct block_cache_t * c;
+	u64_t blksz = block_size(blk);
+	u64_t i;
+	u8_t * p;
+
+	p = block_cache_scratch(blksz * blkcnt);
+	if(!p || (block_queue_xfer(blk, BIO_READ, p, blkno, blkcnt) != blkcnt))
+		return 0;
+	for(i = 0; i < blkcnt; i++)
+	{
+		c = block_cache_alloc(blk, blkno + i);
+		if(!c)
+			break;
+		memcpy(c->buf, &p[blksz * i], blksz);
+	}
+	return i;
+}
+
+static int block_cache_cmp(const void * a, const void * b)
+{
+	u64_t x = (*(struct block_cache_t **)a)->blkno;
+	u64_t y = (*(struct block_cache_t **)b)->blkno;
+	return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/*
+ * Write back the dirty blocks of a device in block order, merging adjacent
+ * blocks into one driver call
+ */
+static void block_cache_flush(struct block_t * blk)
+{
+	struct block_stat_t * st = (struct block_stat_t *)blk->cache;
+	struct block_cache_t ** array;
+	struct block_cache_t * pos, * n;
+	u64_t blksz = block_size(blk);
+	u64_t ra = block_cache_ra_max(blk);
+	int count, i, j, k;
+	u8_t * p;
+
+	count = st->dirty;
+	if(count == 0)
+		return;
+
+	array = malloc(sizeof(struct block_cache_t *) * count);
+	if(!array)
+	{
+		list_for_each_entry_safe(pos, n, &__block_cache_wb, wb)
+		{
+			if((pos->blk == blk) && (block_queue_xfer(blk, BIO_WRITE, pos->buf, pos->blkno, 1) == 1))
+			{
+				block_cache_dirty(pos, 0);
+				st->writeback++;
+				__block_cache_stat.writeback++;
+			}
+		}
+		return;
+	}
+	i = 0;
+	list_for_each_entry(pos, &__block_cache_wb, wb)
+	{
+		if(pos->blk == blk)
+			array[i++] = pos;
+	}
+	qsort(array, count, sizeof(struct block_cache_t *), block_cache_cmp);
+
+	for(i = 0; i < count; i = j)
+	{
+		for(j = i + 1; (j < count) && (j - i < ra) && (array[j]->blkno == array[j - 1]->blkno + 1); j++);
+		p = (j - i > 1) ? block_cache_scratch(blksz * (j - i)) : NULL;
+		if(p)
+		{
+			for(k = i; k < j; k++)
+				memcpy(&p[blksz * (k - i)], array[k]->buf, blksz);
+			if(block_queue_xfer(blk, BIO_WRITE, p, array[i]->blkno, j - i) != j - i)
+				continue;
+		}
+		else
+		{
+			for(k = i; k < j; k++)
+			{
+				if(block_queue_xfer(blk, BIO_WRITE, array[k]->buf, array[k]->blkno, 1) != 1)
+					break;
+			}
+			if(k < j)
+				continue;
+		}
+		for(k = i; k < j; k++)
+			block_cache_dirty(array[k], 0);
+		st->writeback += j - i;
+		__block_cache_stat.writeback += j - i;
+	}
+	free(array);
+}
+
+static void block_cache_drop(struct block_t * blk)
+{
+	struct block_cache_t * pos, * n;
+
+	mutex_lock(&__block_cache_lock);
+	block_cache_flush(blk);
+	list_for_each_entry_safe(pos, n, &__block_cache_lru, entry)
+	{
+		if(pos->blk == blk)
+		{
+			block_cache_dirty(pos, 0);
+			block_cache_release(pos);
+		}
+	}
+	mutex_unlock(&__block_cache_lock);
+}
+
+/*
+ * Keep the cache coherent with a bio that bypasses it, dirty blocks under a read
+ * are written back first and blocks under a write are dropped
+ */
+static void block_cache_bio(struct block_t * blk, struct bio_t * bio)
+{
+	struct block_stat_t * st = (struct block_stat_t *)blk->cache;
+	struct block_cache_t * pos, * n;
+
+	if((bio->rw == BIO_READ) && (st->dirty == 0))
+		return;
+
+	mutex_lock(&__block_cache_lock);
+	list_for_each_entry_safe(pos, n, &__block_cache_lru, entry)
+	{
+		if((pos->blk != blk) || (pos->blkno < bio->blkno) || (pos->blkno >= bio->blkno + bio->blkcnt))
+			continue;
+		if(bio->rw == BIO_WRITE)
+		{
+			block_cache_dirty(pos, 0);
+			block_cache_release(pos);
+		}
+		else if(pos->dirty && (block_queue_xfer(blk, BIO_WRITE, pos->buf, pos->blkno, 1) == 1))
+		{
+			block_cache_dirty(pos, 0);
+			st->writeback++;
+			__block_cache_stat.writeback++;
+		}
+	}
+	mutex_unlock(&__block_cache_lock);
+}
+
+static u64_t block_cache_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
+{
+	struct block_stat_t * st = (struct block_stat_t *)blk->cache;
+	struct block_cache_t * c;
+	u64_t blksz = block_size(blk);
+	u64_t blkno = offset / blksz;
+	u64_t o = offset % blksz;
+	u64_t ramax = block_cache_ra_max(blk);
+	u64_t len, need, n, k, ra, ret = 0;
+
+	mutex_lock(&__block_cache_lock);
+	while(count > 0)
+	{
+		len = blksz - o;
+		if(count < len)
+			len = count;
+
+		c = block_cache_search(blk, blkno);
+		if(c)
+		{
+			st->hit++;
+			__block_cache_stat.hit++;
+		}
+		else
+		{
+			st->miss++;
+			__block_cache_stat.miss++;
+
+			need = (o + count + blksz - 1) / blksz;
+			for(n = 1; (n < need) && !block_cache_search(blk, blkno + n); n++);
+
+			/*
+			 * Large aligned transfers go straight to the caller buffer
+			 */
+			if((o == 0) && (n * blksz <= count) && (n >= ramax))
+			{
+				if(block_queue_xfer(blk, BIO_READ, buf, blkno, n) != n)
+					break;
+				len = n * blksz;
+				st->ra_next = blkno + n;
+				buf += len;
+				count -= len;
+				ret += len;
+				blkno += n;
+				continue;
+			}
+
+			/*
+			 * Grow the read-ahead window while the access stays sequential
+			 */
+			if(blkno == st->ra_next)
+				st->ra_count = (st->ra_count > 0) ? st->ra_count * 2 : 4;
+			else
+				st->ra_count = 0;
+			if(st->ra_count > ramax)
+				st->ra_count = ramax;
+			ra = (st->ra_count > n) ? st->ra_count : n;
+			if(ra > __block_cache_budget / blksz / 2)
+				ra = __block_cache_budget / blksz / 2;
+			if(ra > block_count(blk) - blkno)
+				ra = block_count(blk) - blkno;
+			for(k = 1; (k < ra) && !block_cache_search(blk, blkno + k); k++);
+
+			k = block_cache_fill(blk, blkno, k);
+			if(k > 0)
+			{
+				if(k > n)
+				{
+					st->readahead += k - n;
+					__block_cache_stat.readahead += k - n;
+				}
+				c = block_cache_search(blk, blkno);
+			}
+		}
+
+		if(c)
+		{
+			memcpy(buf, &c->buf[o], len);
+			list_move(&c->entry, &__block_cache_lru);
+		}
+		else if(block_direct_read(blk, buf, blkno * blksz + o, len) != len)
+		{
+			break;
+		}
+		st->ra_next = blkno + 1;
+		buf += len;
+		count -= len;
+		ret += len;
+		blkno++;
+		o = 0;
+	}
+	mutex_unlock(&__block_cache_lock);
+
+	return ret;
+}
+
+static u64_t block_cache_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
+{
+	struct block_stat_t * st = (struct block_stat_t *)blk->cache;
+	struct block_cache_t * c;
+	u64_t blksz = block_size(blk);
+	u64_t blkno = offset / blksz;
+	u64_t o = offset % blksz;
+	u64_t ramax = block_cache_ra_max(blk);
+	u64_t len, need, n, ret = 0;
+
+	mutex_lock(&__block_cache_lock);
+	while(count > 0)
+	{
+		len = blksz - o;
+		if(count < len)
+			len = count;
+
+		c = block_cache_search(blk, blkno);
+		if(c)
+		{
+			st->hit++;
+			__block_cache_stat.hit++;
+		}
+		else
+		{
+			st->miss++;
+			__block_cache_stat.miss++;
+
+			need = (o + count + blksz - 1) / blksz;
+			for(n = 1; (n < need) && !block_cache_search(blk, blkno + n); n++);
+
+			/*
+			 * Large aligned transfers are written through
+			 */
+			if((o == 0) && (n * blksz <= count) && (n >= ramax))
+			{
+				if(block_queue_xfer(blk, BIO_WRITE, buf, blkno, n) != n)
+					break;
+				len = n * blksz;
+				buf += len;
+				count -= len;
+				ret += len;
+				blkno += n;
+				continue;
+			}
+
+			if(len == blksz)
+				c = block_cache_alloc(blk, blkno);
+			else if(block_cache_fill(blk, blkno, 1) > 0)
+				c = block_cache_search(blk, blkno);
+		}
+
+		if(c)
+		{
+			memcpy(&c->buf[o], buf, len);
+			block_cache_dirty(c, 1);
+			list_move(&c->entry, &__block_cache_lru);
+		}
+		else if(block_direct_write(blk, buf, blkno * blksz + o, len) != len)
+		{
+			break;
+		}
+		buf += len;
+		count -= len;
+		ret += len;
+		blkno++;
+		o = 0;
+	}
+	mutex_unlock(&__block_cache_lock);
+
+	return ret;
+}
+
+static ssize_t block_read_cache(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct block_t * blk = (struct block_t *)kobj->priv;
+	struct block_stat_t * st = (struct block_stat_t *)blk->cache;
+
+	if(!st)
+		return 0;
+	return sprintf(buf, "hit: %lld\r\nmiss: %lld\r\nreadahead: %lld\r\nwriteback: %lld\r\ndirty: %lld", st->hit, st->miss, st->readahead, st->writeback, st->dirty);
+}
+
+struct block_t * search_block(const char * name)
+{
+	struct device_t * dev;
+
+	dev = search_device(name, DEVICE_TYPE_BLOCK);
+	if(!dev)
+		return NULL;
+	return (struct block_t *)dev->priv;
+}
+
+struct device_t * register_block(struct block_t * blk, struct driver_t * drv)
+{
+	struct block_queue_t * q;
+	struct device_t * dev;
+
+	if(!blk || !blk->name)
+		return NULL;
+
+	if(!blk->read || !blk->write || !blk->sync || !blk->blksz)
+		return NULL;
+
+	dev = malloc(sizeof(struct device_t));
+	if(!dev)
+		return NULL;
+
+	dev->name = strdup(blk->name);
+	dev->type = DEVICE_TYPE_BLOCK;
+	dev->driver = drv;
+	dev->priv = blk;
+	dev->kobj = kobj_alloc_directory(dev->name);
+	kobj_add_regular(dev->kobj, "size", block_read_size, NULL, blk);
+	kobj_add_regular(dev->kobj, "count", block_read_count, NULL, blk);
+	kobj_add_regular(dev->kobj, "capacity", block_read_capacity, NULL, blk);
+	kobj_add_regular(dev->kobj, "cache", block_read_cache, NULL, blk);
+	kobj_add_regular(dev->kobj, "queue", block_read_queue, NULL, blk);
+
+	blk->cache = (blk->read != sub_block_read) ? malloc(sizeof(struct block_stat_t)) : NULL;
+	if(blk->cache)
+		memset(blk->cache, 0, sizeof(struct block_stat_t));
+
+	q = malloc(sizeof(struct block_queue_t));
+	if(q)
+	{
+		memset(q, 0, sizeof(struct block_queue_t));
+		init_list_head(&q->head);
+		spin_lock_init(&q->lock);
+		q->maxcnt = CONFIG_BLOCK_QUEUE_MERGE_SIZE / block_size(blk);
+		if(q->maxcnt < 1)
+			q->maxcnt = 1;
+		q->scratch = malloc(block_size(blk));
+	}
+	blk->queue = q;
+
+	if(!register_device(dev))
+	{
+		free(blk->cache);
+		blk->cache = NULL;
+		if(q)
+			free(q->scratch);
+		free(blk->queue);
+		blk->queue = NULL;
+		kobj_remove_self(dev->kobj);
+		free(dev->name);
+		free(dev);
+		return NULL;
+	}
+	return dev;
+}
+
+void unregister_block(struct block_t * blk)
+{
+	struct device_t * dev;
+
+	if(blk && blk->name)
+	{
+		dev = search_device(blk->name, DEVICE_TYPE_BLOCK);
+		if(dev && blk->cache)
+			block_cache_drop(blk);
+		if(dev && blk->queue)
+			block_unplug(blk);
+		if(dev && unregister_device(dev))
+		{
+			free(blk->cache);
+			blk->cache = NULL;
+			if(blk->queue)
+				free(((struct block_queue_t *)blk->queue)->scratch);
+			free(blk->queue);
+			blk->queue = NULL;
+			kobj_remove_self(dev->kobj);
+			free(dev->name);
+			free(dev);
+		}
+	}
+}
+
+struct device_t * register_sub_block(struct block_t * pblk, u64_t offset, u64_t length, const char * name)
+{
+	struct device_t * dev;
+	struct block_t * blk;
+	struct sub_block_pdata_t * pdat;
+	u64_t blksz, blkno, blkcnt, tmp;
+	char buffer[256];
+
+	if(!name)
+		return NULL;
+
+	if(!pblk || !pblk->name)
+		return NULL;
+
+	blksz = block_size(pblk);
+	blkno = offset / blksz;
+	tmp = offset % blksz;
+	if(tmp > 0)
+		blkno++;
+	tmp = length / blksz;
+	blkcnt = block_available_count(pblk, blkno, tmp);
+	if(blkcnt <= 0)
+		return NULL;
+
+	blk = malloc(sizeof(struct block_t));
+	pdat = malloc(sizeof(struct sub_block_pdata_t));
+	if(!blk || !pdat)
+	{
+		free(blk);
+		free(pdat);
+		return NULL;
+	}
+
+	snprintf(buffer, sizeof(buffer), "%s.%s", pblk->name, name);
+	pdat->blkno = blkno;
+	pdat->pblk = pblk;
+
+	blk->name = strdup(buffer);
+	blk->blksz = blksz;
+	blk->blkcnt = blkcnt;
+	blk->read = sub_block_read;
+	blk->write = sub_block_write;
+	blk->sync = sub_block_sync;
+	blk->mmap = pblk->mmap ? sub_block_mmap : NULL;
+	blk->priv = pdat;
+
+	if(!(dev = register_block(blk, NULL)))
+	{
+		free(blk->priv);
+		free(blk->name);
+		free(blk);
+		return NULL;
+	}
+	return dev;
+}
+
+void unregister_sub_block(struct block_t * pblk)
+{
+	struct device_t * pos, * n;
+	struct block_t * blk;
+	int len;
+
+	if(pblk && pblk->name && search_block(pblk->name))
+	{
+		len = strlen(pblk->name);
+		list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_BLOCK], head)
+		{
+			if((strncmp(pos->name, pblk->name, len) == 0) && (strlen(pos->name) > len))
+			{
+				blk = (struct block_t *)pos->priv;
+				if(blk)
+				{
+					unregister_block(blk);
+					free(blk->priv);
+					free(blk->name);
+					free(blk);
+				}
+			}
+		}
+	}
+}
+
+u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
+{
+	u64_t capacity;
+
+	if(!blk || !buf || !count)
+		return 0;
+
+	if(!block_size(blk) || !block_count(blk))
+		return 0;
+
+	capacity = block_capacity(blk);
+	if(offset >= capacity)
+		return 0;
+	if(count > capacity - offset)
+		count = capacity - offset;
+
+	if(blk->cache)
+		return block_cache_read(blk, buf, offset, count);
+	return block_direct_read(blk, buf, offset, count);
+}
+
+u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count)
+{
+	u64_t capacity;
+
+	if(!blk || !buf || !count)
+		return 0;
+
+	if(!block_size(blk) || !block_count(blk))
+		return 0;
+
+	capacity = block_capacity(blk);
+	if(offset >= capacity)
+		return 0;
+	if(count > capacity - offset)
+		count = capacity - offset;
+
+	if(blk->cache)
+		return block_cache_write(blk, buf, offset, count);
+	return block_direct_write(blk, buf, offset, count);
+}
+
+void block_sync(struct block_t * blk)
+{
+	if(blk)
+	{
+		if(blk->cache)
+		{
+			mutex_lock(&__block_cache_lock);
+			block_cache_flush(blk);
+			mutex_unlock(&__block_cache_lock);
+		}
+		if(blk->sync)
+			blk->sync(blk);
+		if(blk->cache)
+			((struct block_stat_t *)blk->cache)->unsynced = 0;
+	}
+}
+
+/*
+ * Write back at most count of the oldest dirty blocks, as long as they were
+ * dirtied before expire or the dirty blocks take more than ratio percent of
+ * the cache budget. Adjacent dirty blocks go along in the same driver call.
+ * The blocks are copied out and queued under the lock, which is dropped while
+ * the transfer runs, later requests on them are kept behind it by the queue.
+ */
+u64_t block_writeback(ktime_t expire, int ratio, u64_t count)
+{
+	struct block_cache_t * pos, * c;
+	struct block_stat_t * st;
+	struct block_t * blk;
+	struct bio_vec_t vec;
+	struct bio_t bio;
+	u64_t blksz, first, limit, run, size = 0, n, i, ret = 0;
+	u8_t * buf = NULL, * p;
+	int queued;
+
+	while(ret < count)
+	{
+		mutex_lock(&__block_cache_lock);
+		limit = __block_cache_budget / 100 * ratio;
+		c = list_empty(&__block_cache_wb) ? NULL : list_first_entry(&__block_cache_wb, struct block_cache_t, wb);
+		if(!c || (!ktime_before(c->stamp, expire) && (__block_cache_dirty <= limit)))
+		{
+			mutex_unlock(&__block_cache_lock);
+			break;
+		}
+
+		blk = c->blk;
+		st = (struct block_stat_t *)blk->cache;
+		blksz = block_size(blk);
+		run = min(block_cache_ra_max(blk), count - ret);
+		for(first = c->blkno, n = 1; (first > 0) && (n < run) && (pos = block_cache_search(blk, first - 1)) && pos->dirty; first--, n++);
+		for(; (n < run) && (pos = block_cache_search(blk, first + n)) && pos->dirty; n++);
+		if(blksz * n > size)
+		{
+			p = malloc(blksz * n);
+			if(p)
+			{
+				free(buf);
+				buf = p;
+				size = blksz * n;
+			}
+			else
+			{
+				first = c->blkno;
+				n = (size >= blksz) ? 1 : 0;
+			}
+		}
+		if(n == 0)
+		{
+			mutex_unlock(&__block_cache_lock);
+			break;
+		}
+		for(i = 0; i < n; i++)
+		{
+			pos = block_cache_search(blk, first + i);
+			memcpy(&buf[blksz * i], pos->buf, blksz);
+			block_cache_dirty(pos, 0);
+		}
+		vec.buf = buf;
+		vec.blkcnt = n;
+		bio_init(&bio, BIO_WRITE, first, &vec, 1, NULL, NULL);
+		queued = blk->queue && block_queue_submit(blk, &bio, 0);
+		if(!queued)
+			bio.done = block_queue_xfer(blk, BIO_WRITE, buf, first, n);
+		mutex_unlock(&__block_cache_lock);
+
+		if(queued)
+			bio_wait(&bio);
+
+		/*
+		 * Blocks not written are dirtied again, unless they were rewritten meanwhile
+		 */
+		mutex_lock(&__block_cache_lock);
+		for(i = bio.done; i < n; i++)
+		{
+			pos = block_cache_search(blk, first + i);
+			if(pos && !pos->dirty)
+			{
+				memcpy(pos->buf, &buf[blksz * i], blksz);
+				block_cache_dirty(pos, 1);
+			}
+		}
+		st->writeback += bio.done;
+		st->unsynced = 1;
+		__block_cache_stat.writeback += bio.done;
+		mutex_unlock(&__block_cache_lock);
+		ret += bio.done;
+		if(bio.done != n)
+			break;
+	}
+	free(buf);
+	return ret;
+}
+
+/*
+ * Let the drivers of devices written by block_writeback flush their own
+ * caches, returns the number of devices synced
+ */
+int block_writeback_sync(void)
+{
+	struct device_t * pos, * n;
+	struct block_stat_t * st;
+	struct block_t * blk;
+	int count = 0;
+
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_BLOCK], head)
+	{
+		blk = (struct block_t *)pos->priv;
+		st = blk ? (struct block_stat_t *)blk->cache : NULL;
+		if(st && st->unsynced)
+		{
+			st->unsynced = 0;
+			if(blk->sync)
+				blk->sync(blk);
+			count++;
+		}
+	}
+	return count;
+}
+
+void * block_mmap(struct block_t * blk, u64_t offset, u64_t count)
+{
+	u64_t capacity;
+
+	if(!blk || !blk->mmap || !count)
+		return NULL;
+
+	capacity = block_capacity(blk);
+	if((offset >= capacity) || (count > capacity - offset))
+		return NULL;
+
+	if(blk->cache && ((struct block_stat_t *)blk->cache)->dirty)
+	{
+		mutex_lock(&__block_cache_lock);
+		block_cache_flush(blk);
+		mutex_unlock(&__block_cache_lock);
+	}
+	return blk->mmap(blk, offset, count);
+}
+
+void bio_init(struct bio_t * bio, int rw, u64_t blkno, struct bio_vec_t * vec, int nvec, void (*end)(struct bio_t *), void * priv)
+{
+	int i;
+
+	if(bio)
+	{
+		init_list_head(&bio->entry);
+		bio->blk = NULL;
+		bio->rw = rw;
+		bio->blkno = blkno;
+		bio->blkcnt = 0;
+		bio->vec = vec;
+		bio->nvec = nvec;
+		bio->done = 0;
+		bio->complete = 0;
+		bio->end = end;
+		bio->priv = priv;
+		for(i = 0; i < nvec; i++)
+			bio->blkcnt += vec[i].blkcnt;
+	}
+}
+
+/*
+ * Submit a bio and return at once, the completion callback is called once the
+ * transfer finished. A device without queue completes the bio before return.
+ */
+bool_t bio_submit(struct block_t * blk, struct bio_t * bio)
+{
+	if(!blk || !bio || !bio->vec || (bio->nvec <= 0) || (bio->blkcnt == 0))
+		return FALSE;
+
+	if((bio->blkno >= block_count(blk)) || (bio->blkcnt > block_count(blk) - bio->blkno))
+		return FALSE;
+
+	if(blk->cache)
+		block_cache_bio(blk, bio);
+
+	if(blk->queue)
+	{
+		if(block_queue_submit(blk, bio, 1))
+			return TRUE;
+		block_unplug(blk);
+	}
+
+	bio->blk = blk;
+	bio->done = block_bio_transfer(blk, bio);
+	block_bio_complete(bio);
+	return TRUE;
+}
+
+void bio_wait(struct bio_t * bio)
+{
+	if(bio && bio->blk)
+	{
+		while(!bio->complete)
+		{
+			if(!block_queue_dispatch(bio->blk) && task_self())
+				task_yield();
+		}
+	}
+}
+
+/*
+ * Dispatch everything queued on the device before return
+ */
+void block_unplug(struct block_t * blk)
+{
+	struct block_queue_t * q;
+	int idle;
+
+	if(blk && (q = (struct block_queue_t *)blk->queue))
+	{
+		while(1)
+		{
+			if(block_queue_dispatch(blk))
+				continue;
+			spin_lock(&q->lock);
+			idle = list_empty(&q->head) && !q->busy && !q->worker;
+			spin_unlock(&q->lock);
+			if(idle)
+				break;
+			if(task_self())
+				task_yield();
+		}
+	}
+}
+
+static ssize_t block_cache_read_budget(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%lld", __block_cache_budget);
+}
+
+static ssize_t block_cache_write_budget(struct kobj_t * kobj, void * buf, size_t size)
+{
+	mutex_lock(&__block_cache_lock);
+	__block_cache_budget = strtoull(buf, NULL, 0);
+	block_cache_shrink(0);
+	mutex_unlock(&__block_cache_lock);
+	return size;
+}
+
+static ssize_t block_cache_read_used(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%lld", __block_cache_used);
+}
+
+static ssize_t block_cache_read_dirty(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%lld", __block_cache_dirty);
+}
+
+static ssize_t block_cache_read_stat(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct block_stat_t * st = &__block_cache_stat;
+	return sprintf(buf, "hit: %lld\r\nmiss: %lld\r\nreadahead: %lld\r\nwriteback: %lld", st->hit, st->miss, st->readahead, st->writeback);
+}
+
+static __init void block_cache_pure_init(void)
 {
-	if(blk && blk->sync)
-		blk->sync(blk);
+	struct kobj_t * kclass = kobj_search_directory_with_create(kobj_get_root(), "class");
+	struct kobj_t * kcache = kobj_search_directory_with_create(kclass, "blkcache");
+
+	mutex_init(&__block_cache_lock);
+	kobj_add_regular(kcache, "budget", block_cache_read_budget, block_cache_write_budget, NULL);
+	kobj_add_regular(kcache, "used", block_cache_read_used, NULL, NULL);
+	kobj_add_regular(kcache, "dirty", block_cache_read_dirty, NULL, NULL);
+	kobj_add_regular(kcache, "stat", block_cache_read_stat, NULL, NULL);
 }
+pure_initcall(block_cache_pure_init);
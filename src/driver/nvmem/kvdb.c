@@ -194,7 +194,12 @@ void kvdb_set(struct kvdb_t * db, const char * key, const char * value)
 		{
 			r->key = strdup(key);
 			r->value = strdup(value);
-			kvdb_add_record(db, r);
+			if(!kvdb_add_record(db, r))
+			{
+				free(r->key);
+				free(r->value);
+				free(r);
+			}
 		}
 	}
 }
@@ -250,6 +255,19 @@ char * kvdb_to_string(struct kvdb_t * db)
 	return str;
 }
 
+void kvdb_walk(struct kvdb_t * db, void (*walk)(struct kvdb_t * db, const char * key, const char * value, void * data), void * data)
+{
+	struct record_t * pos, * n;
+
+	if(!db || !walk)
+		return;
+
+	list_for_each_entry_safe(pos, n, &db->list, head)
+	{
+		walk(db, pos->key, pos->value, data);
+	}
+}
+
 int kvdb_summary(struct kvdb_t * db, void * buf)
 {
 	struct record_t * pos, * n;
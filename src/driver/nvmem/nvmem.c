@@ -61,55 +61,305 @@ struct nvmem_t * search_first_nvmem(void)
 	return (struct nvmem_t *)dev->priv;
 }
 
+/*
+ * The key value pairs live in an append only record log in one half of the
+ * nvmem. When the log is full, the live records are copied compacted into
+ * the other half, whose header is written last with the next sequence, so
+ * the valid header with the newest sequence names the active half.
+ *
+ * A record has a 16 bit key and value length, a crc over the half sequence,
+ * both lengths, key and value, then the key and value. A value length of
+ * 0xffff deletes the key. A zero key length ends the log, and it is written
+ * past a record before the record itself, so a torn write never exposes what
+ * an older pass left behind.
+ */
+#define NVMEM_LOG_MAGIC		(0x474c564b)
+#define NVMEM_LOG_HEADER	(12)
+#define NVMEM_LOG_RECORD	(8)
+#define NVMEM_LOG_DELETE	(0xffff)
+
+struct nvmem_log_walk_t {
+	struct nvmem_t * m;
+	u32_t seq;
+	int offset;
+	int end;
+	bool_t ok;
+};
+
+static inline void nvmem_put_le16(u8_t * p, u16_t v)
+{
+	p[0] = (v >> 0) & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+static inline void nvmem_put_le32(u8_t * p, u32_t v)
+{
+	p[0] = (v >>  0) & 0xff;
+	p[1] = (v >>  8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+static inline u16_t nvmem_get_le16(const u8_t * p)
+{
+	return (p[1] << 8) | (p[0] << 0);
+}
+
+static inline u32_t nvmem_get_le32(const u8_t * p)
+{
+	return ((u32_t)p[3] << 24) | (p[2] << 16) | (p[1] << 8) | (p[0] << 0);
+}
+
+static u32_t nvmem_log_crc(u32_t seq, const u8_t * h, const char * key, int klen, const char * value, int vlen)
+{
+	u8_t s[4];
+	u32_t crc = 0;
+
+	nvmem_put_le32(s, seq);
+	crc = crc32_sum(crc, s, 4);
+	crc = crc32_sum(crc, h, 4);
+	crc = crc32_sum(crc, (const uint8_t *)key, klen);
+	if(vlen > 0)
+		crc = crc32_sum(crc, (const uint8_t *)value, vlen);
+	return crc;
+}
+
+static inline int nvmem_log_length(const char * key, const char * value)
+{
+	return NVMEM_LOG_RECORD + strlen(key) + (value ? strlen(value) : 0);
+}
+
+static bool_t nvmem_log_write(struct nvmem_t * m, u32_t seq, int offset, int end, const char * key, const char * value)
+{
+	u8_t z[2] = { 0, 0 };
+	int klen = strlen(key);
+	int vlen = value ? strlen(value) : 0;
+	int len = NVMEM_LOG_RECORD + klen + vlen;
+	u8_t * r;
+	bool_t ret;
+
+	if((klen <= 0) || (klen >= NVMEM_LOG_DELETE) || (vlen >= NVMEM_LOG_DELETE) || (offset + len > end))
+		return FALSE;
+
+	r = malloc(len);
+	if(!r)
+		return FALSE;
+	nvmem_put_le16(&r[0], klen);
+	nvmem_put_le16(&r[2], value ? vlen : NVMEM_LOG_DELETE);
+	nvmem_put_le32(&r[4], nvmem_log_crc(seq, r, key, klen, value, vlen));
+	memcpy(&r[NVMEM_LOG_RECORD], key, klen);
+	if(vlen > 0)
+		memcpy(&r[NVMEM_LOG_RECORD + klen], value, vlen);
+
+	if((offset + len + NVMEM_LOG_RECORD <= end) && (nvmem_write(m, z, offset + len, 2) != 2))
+		ret = FALSE;
+	else
+		ret = (nvmem_write(m, r, offset, len) == len) ? TRUE : FALSE;
+	free(r);
+	return ret;
+}
+
+static bool_t nvmem_log_read_header(struct nvmem_t * m, int base, u32_t * seq)
+{
+	u8_t h[NVMEM_LOG_HEADER];
+
+	if(nvmem_read(m, h, base, NVMEM_LOG_HEADER) != NVMEM_LOG_HEADER)
+		return FALSE;
+	if(nvmem_get_le32(&h[0]) != NVMEM_LOG_MAGIC)
+		return FALSE;
+	if(nvmem_get_le32(&h[8]) != crc32_sum(0, h, 8))
+		return FALSE;
+	*seq = nvmem_get_le32(&h[4]);
+	return TRUE;
+}
+
+static int nvmem_log_replay(struct nvmem_t * m)
+{
+	int offset = m->log_base + NVMEM_LOG_HEADER;
+	int end = m->log_base + m->log_size;
+	int klen, vlen, len;
+	u8_t h[NVMEM_LOG_RECORD];
+	char * k, * v;
+
+	while(offset + NVMEM_LOG_RECORD <= end)
+	{
+		if(nvmem_read(m, h, offset, NVMEM_LOG_RECORD) != NVMEM_LOG_RECORD)
+			break;
+		klen = nvmem_get_le16(&h[0]);
+		vlen = nvmem_get_le16(&h[2]);
+		if((klen == 0) || (klen == 0xffff))
+			break;
+		len = NVMEM_LOG_RECORD + klen + ((vlen == NVMEM_LOG_DELETE) ? 0 : vlen);
+		if(offset + len > end)
+			break;
+		k = malloc(len - NVMEM_LOG_RECORD + 2);
+		if(!k)
+			break;
+		v = &k[klen + 1];
+		if(vlen == NVMEM_LOG_DELETE)
+			vlen = 0;
+		if((nvmem_read(m, k, offset + NVMEM_LOG_RECORD, klen) != klen) || (nvmem_read(m, v, offset + NVMEM_LOG_RECORD + klen, vlen) != vlen)
+			|| (nvmem_log_crc(m->log_seq, h, k, klen, v, vlen) != nvmem_get_le32(&h[4])))
+		{
+			free(k);
+			break;
+		}
+		k[klen] = 0;
+		v[vlen] = 0;
+		kvdb_set(m->db, k, (nvmem_get_le16(&h[2]) == NVMEM_LOG_DELETE) ? NULL : v);
+		free(k);
+		offset += len;
+	}
+	return offset;
+}
+
+static void nvmem_log_walk(struct kvdb_t * db, const char * key, const char * value, void * data)
+{
+	struct nvmem_log_walk_t * w = (struct nvmem_log_walk_t *)data;
+
+	if(w->ok)
+	{
+		w->ok = nvmem_log_write(w->m, w->seq, w->offset, w->end, key, value);
+		w->offset += nvmem_log_length(key, value);
+	}
+}
+
+/*
+ * Copy the live records into the other half, the old half stays active until
+ * the new header is in place
+ */
+static bool_t nvmem_log_compact(struct nvmem_t * m)
+{
+	struct nvmem_log_walk_t w;
+	u8_t h[NVMEM_LOG_HEADER];
+	u8_t z[2] = { 0, 0 };
+	int base;
+
+	base = (m->log_base == 0) ? m->log_size : 0;
+	w.m = m;
+	w.seq = m->log_seq + 1;
+	w.offset = base + NVMEM_LOG_HEADER;
+	w.end = base + m->log_size;
+	w.ok = TRUE;
+	if(nvmem_write(m, z, w.offset, 2) != 2)
+		return FALSE;
+	kvdb_walk(m->db, nvmem_log_walk, &w);
+	if(!w.ok)
+		return FALSE;
+
+	nvmem_put_le32(&h[0], NVMEM_LOG_MAGIC);
+	nvmem_put_le32(&h[4], w.seq);
+	nvmem_put_le32(&h[8], crc32_sum(0, h, 8));
+	if(nvmem_write(m, h, base, NVMEM_LOG_HEADER) != NVMEM_LOG_HEADER)
+		return FALSE;
+	m->log_base = base;
+	m->log_tail = w.offset;
+	m->log_seq = w.seq;
+	return TRUE;
+}
+
+/*
+ * The single string image of older releases, crc and length then the
+ * serialized pairs. The log is compacted into the second half, so the image
+ * is only migrated when it ends before that half and all of its pairs fit,
+ * otherwise FALSE is returned and the image is left in place.
+ */
+static bool_t nvmem_load_legacy(struct nvmem_t * m, int size)
+{
+	u8_t h[8];
+	u32_t c, l;
+	char * s, * p, * r, * k, * v;
+	int dropped = 0;
+	bool_t ret = TRUE;
+
+	if(nvmem_read(m, h, 0, 8) != 8)
+		return TRUE;
+	c = nvmem_get_le32(&h[0]);
+	l = nvmem_get_le32(&h[4]);
+	if((l == 0) || (l >= (u32_t)size - 8))
+		return TRUE;
+
+	/* Without a buffer the image can not be told apart from garbage */
+	s = malloc(l);
+	if(!s)
+		return TRUE;
+	if((nvmem_read(m, s, 8, l) == l) && (crc32_sum(crc32_sum(0, &h[4], 4), (const uint8_t *)s, l) == c))
+	{
+		s[l - 1] = 0;
+		p = s;
+		while((r = strsep(&p, ",;\r\n")) != NULL)
+		{
+			if(strchr(r, '='))
+			{
+				k = strim(strsep(&r, "="));
+				v = strim(r);
+				if(k && v && (strcmp(k, "") != 0) && (strcmp(v, "") != 0))
+				{
+					kvdb_set(m->db, k, v);
+					if(!kvdb_get(m->db, k, NULL))
+					{
+						LOG("nvmem '%s' drops legacy pair '%s'", m->name, k);
+						dropped++;
+					}
+				}
+			}
+		}
+		if(l + 8 > (u32_t)m->log_size)
+		{
+			LOG("nvmem '%s' legacy image overlaps the second half, not migrated", m->name);
+			ret = FALSE;
+		}
+		else if(dropped > 0)
+		{
+			LOG("nvmem '%s' legacy image does not fit, not migrated", m->name);
+			ret = FALSE;
+		}
+	}
+	free(s);
+	return ret;
+}
+
 static bool_t nvmem_init_kvdb(struct nvmem_t * m)
 {
-	uint32_t c, crc = 0;
-	char h[8];
-	char * s;
-	int l, size;
+	u32_t s0, s1;
+	bool_t v0, v1;
+	int size;
 
 	if(!m)
 		return FALSE;
 	m->db = NULL;
 
 	size = nvmem_capacity(m);
-	if(size < (8 + 1))
+	if(size < (NVMEM_LOG_HEADER + NVMEM_LOG_RECORD + 2) * 2)
 		return FALSE;
 
-	if(nvmem_read(m, h, 0, 8) != 8)
+	m->db = kvdb_alloc(size / 2);
+	if(!m->db)
 		return FALSE;
-	c = (h[3] << 24) | (h[2] << 16) | (h[1] << 8) | (h[0] << 0);
-	l = (h[7] << 24) | (h[6] << 16) | (h[5] << 8) | (h[4] << 0);
+	m->log_size = size / 2;
+	m->log_base = 0;
+	m->log_seq = 0;
 
-	m->db = kvdb_alloc(size);
-	if(m->db)
+	v0 = nvmem_log_read_header(m, 0, &s0);
+	v1 = nvmem_log_read_header(m, m->log_size, &s1);
+	if(v0 || v1)
 	{
-		if((l > 0) && (l + 8 < size))
+		if(v1 && (!v0 || ((s32_t)(s1 - s0) > 0)))
 		{
-			s = malloc(l);
-			if(!s)
-			{
-				kvdb_free(m->db);
-				return FALSE;
-			}
-			if(nvmem_read(m, s, 8, l) != l)
-			{
-				kvdb_free(m->db);
-				free(s);
-				return FALSE;
-			}
-			crc = crc32_sum(crc, (const uint8_t *)(&h[4]), 4);
-			crc = crc32_sum(crc, (const uint8_t *)s, l);
-			if(crc == c)
-				kvdb_from_string(m->db, s);
-			else
-				nvmem_sync(m);
-			free(s);
+			m->log_base = m->log_size;
+			m->log_seq = s1;
 		}
 		else
 		{
-			nvmem_sync(m);
+			m->log_seq = s0;
 		}
+		m->log_tail = nvmem_log_replay(m);
+	}
+	else if(!nvmem_load_legacy(m, size) || !nvmem_log_compact(m))
+	{
+		/* A negative tail keeps the log, and whatever it would overwrite, read only */
+		LOG("nvmem '%s' is read only", m->name);
+		m->log_tail = -1;
 	}
 	return TRUE;
 }
@@ -216,8 +466,31 @@ int nvmem_write(struct nvmem_t * m, void * buf, int offset, int count)
 
 void nvmem_set(struct nvmem_t * m, const char * key, const char * value)
 {
-	if(m && m->db)
+	char * old;
+
+	if(!m || !m->db || !key || (m->log_tail < 0))
+		return;
+
+	old = kvdb_get(m->db, key, NULL);
+	if((!old && !value) || (old && value && (strcmp(old, value) == 0)))
+		return;
+
+	if(m->log_tail + nvmem_log_length(key, value) <= m->log_base + m->log_size)
+	{
+		if(nvmem_log_write(m, m->log_seq, m->log_tail, m->log_base + m->log_size, key, value))
+		{
+			m->log_tail += nvmem_log_length(key, value);
+			kvdb_set(m->db, key, value);
+		}
+	}
+	else
+	{
+		old = old ? strdup(old) : NULL;
 		kvdb_set(m->db, key, value);
+		if(!nvmem_log_compact(m))
+			kvdb_set(m->db, key, old);
+		free(old);
+	}
 }
 
 char * nvmem_get(struct nvmem_t * m, const char * key, const char * def)
@@ -229,36 +502,16 @@ char * nvmem_get(struct nvmem_t * m, const char * key, const char * def)
 
 void nvmem_clear(struct nvmem_t * m)
 {
-	if(m && m->db)
-		return kvdb_clear(m->db);
+	if(m && m->db && (m->log_tail >= 0))
+	{
+		kvdb_clear(m->db);
+		nvmem_log_compact(m);
+	}
 }
 
 void nvmem_sync(struct nvmem_t * m)
 {
-	uint32_t c = 0;
-	char h[8];
-	char * s;
-	int l;
-
-	if(m && m->db)
-	{
-		s = kvdb_to_string(m->db);
-		if(s)
-		{
-			l = strlen(s) + 1;
-			h[4] = (l >>  0) & 0xff;
-			h[5] = (l >>  8) & 0xff;
-			h[6] = (l >> 16) & 0xff;
-			h[7] = (l >> 24) & 0xff;
-			c = crc32_sum(c, (const uint8_t *)(&h[4]), 4);
-			c = crc32_sum(c, (const uint8_t *)s, l);
-			h[0] = (c >>  0) & 0xff;
-			h[1] = (c >>  8) & 0xff;
-			h[2] = (c >> 16) & 0xff;
-			h[3] = (c >> 24) & 0xff;
-			nvmem_write(m, h, 0, 8);
-			nvmem_write(m, s, 8, l);
-			free(s);
-		}
-	}
+	/*
+	 * Every change is appended to the log when it is set, nothing is pending
+	 */
 }
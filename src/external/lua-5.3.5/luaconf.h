@@ -435,8 +435,12 @@
 
 #define l_floor(x)		(l_mathop(floor)(x))
 
+#if LUA_FLOAT_TYPE == LUA_FLOAT_DOUBLE
+#define lua_number2str(s,sz,n)	dtostr((s), sz, (double)(n))
+#else
 #define lua_number2str(s,sz,n)  \
 	l_sprintf((s), sz, LUA_NUMBER_FMT, (LUAI_UACNUMBER)(n))
+#endif
 
 /*
 @@ lua_numbertointeger converts a float number to an integer, or
@@ -52,7 +52,7 @@ static int application_detect(struct lapplication_t * app, const char * path, co
 			json = malloc(len + 1);
 			if(json && (len = xfs_read(file, json, len)) > 0)
 			{
-				v = json_parse(json, len, NULL);
+				v = json_parse_insitu(json, len, NULL);
 				if(v && (v->type == JSON_OBJECT))
 				{
 					for(i = 0; i < v->u.object.length; i++)
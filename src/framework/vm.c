@@ -187,34 +187,51 @@ static int l_loadfile(lua_State * L)
 	struct xfs_context_t * ctx = ((struct vmctx_t *)luahelper_vmctx(L))->xfs;
 	const char * filename = luaL_optstring(L, 1, NULL);
 	struct reader_data_t * rd;
+	struct xfs_file_t * file;
+	s64_t len;
+	void * buf;
+	int err;
 
-	rd = malloc(sizeof(struct reader_data_t));
-	if(!rd)
+	file = xfs_open_read(ctx, filename);
+	if(!file)
 	{
 		lua_pushnil(L);
-		lua_pushfstring(L, "cannot malloc memory", filename);
+		lua_pushfstring(L, "cannot open %s", filename);
 		return 2;
 	}
 
-	rd->file = xfs_open_read(ctx, filename);
-	if(!rd->file)
+	/*
+	 * Parse straight from a mapping of the chunk, stream it only when that fails
+	 */
+	len = xfs_length(file);
+	buf = xfs_mmap(file, 0, len);
+	if(buf)
+	{
+		err = luaL_loadbufferx(L, buf, len, filename, NULL);
+		xfs_munmap(file, buf);
+	}
+	else
 	{
+		rd = malloc(sizeof(struct reader_data_t));
+		if(!rd)
+		{
+			xfs_close(file);
+			lua_pushnil(L);
+			lua_pushfstring(L, "cannot malloc memory", filename);
+			return 2;
+		}
+		rd->file = file;
+		err = lua_load(L, reader, rd, filename, NULL);
 		free(rd);
-		lua_pushnil(L);
-		lua_pushfstring(L, "cannot open %s", filename);
-		return 2;
 	}
+	xfs_close(file);
 
-	if(lua_load(L, reader, rd, filename, NULL))
+	if(err)
 	{
-		free(rd);
 		lua_pushnil(L);
 		lua_pushfstring(L, "cannot read %s", filename);
 		return 2;
 	}
-
-	xfs_close(rd->file);
-	free(rd);
 	return 1;
 }
 
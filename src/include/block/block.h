@@ -7,6 +7,50 @@ extern "C" {
 
 #include <xboot.h>
 
+enum {
+	BIO_READ	= 0,
+	BIO_WRITE	= 1,
+};
+
+struct bio_vec_t
+{
+	/* The memory of segment */
+	u8_t * buf;
+
+	/* The block counts of segment */
+	u64_t blkcnt;
+};
+
+struct bio_t
+{
+	/* Link in the request of queue */
+	struct list_head entry;
+
+	/* The block device, filled by submit */
+	struct block_t * blk;
+
+	/* BIO_READ or BIO_WRITE */
+	int rw;
+
+	/* The first block and total counts of block */
+	u64_t blkno;
+	u64_t blkcnt;
+
+	/* Scatter gather vector, the segments are contiguous on device */
+	struct bio_vec_t * vec;
+	int nvec;
+
+	/* The block counts transferred and completion flag */
+	u64_t done;
+	int complete;
+
+	/* Completion callback, called once without any lock held */
+	void (*end)(struct bio_t * bio);
+
+	/* Private data for callback */
+	void * priv;
+};
+
 struct block_t
 {
 	/* The block name */
@@ -27,6 +71,15 @@ struct block_t
 	/* Sync cache to block device */
 	void (*sync)(struct block_t * blk);
 
+	/* Map a range of block device into memory, return NULL if not directly addressable */
+	void * (*mmap)(struct block_t * blk, u64_t offset, u64_t count);
+
+	/* Buffer cache state, managed by block core */
+	void * cache;
+
+	/* Request queue state, managed by block core */
+	void * queue;
+
 	/* Private data */
 	void * priv;
 };
@@ -78,6 +131,14 @@ void unregister_sub_block(struct block_t * pblk);
 u64_t block_read(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count);
 u64_t block_write(struct block_t * blk, u8_t * buf, u64_t offset, u64_t count);
 void block_sync(struct block_t * blk);
+u64_t block_writeback(ktime_t expire, int ratio, u64_t count);
+int block_writeback_sync(void);
+void * block_mmap(struct block_t * blk, u64_t offset, u64_t count);
+
+void bio_init(struct bio_t * bio, int rw, u64_t blkno, struct bio_vec_t * vec, int nvec, void (*end)(struct bio_t *), void * priv);
+bool_t bio_submit(struct block_t * blk, struct bio_t * bio);
+void bio_wait(struct bio_t * bio);
+void block_unplug(struct block_t * blk);
 
 #ifdef __cplusplus
 }
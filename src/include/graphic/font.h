@@ -6,12 +6,38 @@ extern "C" {
 #endif
 
 #include <types.h>
+#include <list.h>
 #include <hmap.h>
 #include <xfs/xfs.h>
+#include <graphic/matrix.h>
+
+struct font_glyph_t {
+	struct hlist_node node;
+	struct list_head entry;
+	void * face;
+	int size;
+	int glyph;
+	int subpixel;
+	long xx, xy, yx, yy;
+
+	int hadvance;
+	int vadvance;
+	int hbearingx;
+	int hbearingy;
+	int ax, ay;
+	int left, top;
+	int width, height;
+	u8_t * bitmap;
+};
 
 struct font_context_t {
 	void * library;
 	struct hmap_t * map;
+	struct hmap_t * lookup;
+	struct hlist_head * hash;
+	struct list_head lru;
+	size_t budget;
+	size_t used;
 };
 
 struct font_context_t * font_context_alloc(void);
@@ -20,6 +46,8 @@ void font_install(struct font_context_t * ctx, const char * family, const char *
 void font_install_from_xfs(struct font_context_t * ctx, struct xfs_context_t * xfs, const char * family, const char * path);
 void font_uninstall(struct font_context_t * ctx, const char * family);
 int search_glyph(struct font_context_t * ctx, const char * family, u32_t code, void ** face);
+struct font_glyph_t * font_glyph_metrics(struct font_context_t * ctx, void * face, int size, int glyph);
+struct font_glyph_t * font_glyph_render(struct font_context_t * ctx, void * face, int size, int glyph, struct matrix_t * m, int fx, int fy);
 
 #ifdef __cplusplus
 }
@@ -59,6 +59,21 @@ struct json_object_entry_t {
 	struct json_value_t * value;
 };
 
+struct json_sax_t {
+	int (*null)(void * ctx);
+	int (*boolean)(void * ctx, int b);
+	int (*integer)(void * ctx, int64_t v);
+	int (*dbl)(void * ctx, double d);
+	int (*string)(void * ctx, const char * s, size_t len);
+	int (*key)(void * ctx, const char * s, size_t len);
+	int (*start_object)(void * ctx);
+	int (*end_object)(void * ctx);
+	int (*start_array)(void * ctx);
+	int (*end_array)(void * ctx);
+};
+
+bool_t json_sax_parse(const char * json, size_t length, const struct json_sax_t * sax, void * ctx, char * errbuf);
+struct json_value_t * json_parse_insitu(char * json, size_t length, char * errbuf);
 struct json_value_t * json_parse(const char * json, size_t length, char * errbuf);
 void json_free(struct json_value_t * value);
 
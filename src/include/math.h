@@ -113,6 +113,7 @@ do {														\
 #define	islessequal(x, y)		__builtin_islessequal((x), (y))
 #define	islessgreater(x, y)		__builtin_islessgreater((x), (y))
 #define	isunordered(x, y)		__builtin_isunordered((x), (y))
+#define	signbit(x)				__builtin_signbit(x)
 
 static __inline unsigned __FLOAT_BITS(float __f)
 {
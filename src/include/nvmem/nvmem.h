@@ -12,6 +12,10 @@ struct nvmem_t
 {
 	char * name;
 	struct kvdb_t * db;
+	int log_size;
+	int log_base;
+	int log_tail;
+	u32_t log_seq;
 	int (*capacity)(struct nvmem_t * m);
 	int (*read)(struct nvmem_t * m, void * buf, int offset, int count);
 	int (*write)(struct nvmem_t * m, void * buf, int offset, int count);
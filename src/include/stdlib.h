@@ -11,6 +11,7 @@ extern "C" {
 #include <environ.h>
 
 #define RAND_MAX (0x7fffffff)
+#define DTOA_BUFSZ (800)
 
 typedef struct { int quot, rem; } div_t;
 typedef struct { long quot, rem; } ldiv_t;
@@ -37,12 +38,16 @@ long long strtoll(const char * nptr, char ** endptr, int base);
 unsigned long strtoul(const char * nptr, char ** endptr, int base);
 unsigned long long strtoull(const char * nptr, char ** endptr, int base);
 double strtod(const char * nptr, char ** endptr);
+float strtof(const char * nptr, char ** endptr);
 
 intmax_t strtoimax(const char * nptr, char ** endptr, int base);
 uintmax_t strtoumax(const char * nptr, char ** endptr, int base);
 intmax_t strntoimax(const char * nptr, char ** endptr, int base, size_t n);
 uintmax_t strntoumax(const char * nptr, char ** endptr, int base, size_t n);
 
+int __dtoa(double v, int mode, int ndigits, char * buf, int * decpt);
+int dtostr(char * buf, size_t size, double v);
+
 void * bsearch(const void * key, const void * base, size_t nmemb, size_t size,
 		int (*compar)(const void *, const void *));
 void qsort(void * aa, size_t n, size_t es, int (*cmp)(const void *, const void *));
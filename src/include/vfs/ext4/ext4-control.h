@@ -50,6 +50,7 @@ struct ext4fs_control_t {
 
 	u32_t group_count;
 	u32_t group_table_blkno;
+	u32_t desc_size;
 	struct ext4fs_group_t * groups;
 };
 
@@ -59,9 +60,11 @@ int ext4fs_devwrite(struct ext4fs_control_t * ctrl, u32_t blkno, u32_t blkoff, u
 int ext4fs_control_read_inode(struct ext4fs_control_t * ctrl, u32_t inode_no, struct ext2_inode_t * inode);
 int ext4fs_control_write_inode(struct ext4fs_control_t * ctrl, u32_t inode_no, struct ext2_inode_t * inode);
 int ext4fs_control_alloc_block(struct ext4fs_control_t * ctrl, u32_t inode_no, u32_t * blkno);
+int ext4fs_control_claim_block(struct ext4fs_control_t * ctrl, u32_t blkno);
 int ext4fs_control_free_block(struct ext4fs_control_t * ctrl, u32_t blkno);
 int ext4fs_control_alloc_inode(struct ext4fs_control_t * ctrl, u32_t parent_inode_no, u32_t * inode_no);
 int ext4fs_control_free_inode(struct ext4fs_control_t * ctrl, u32_t inode_no);
+int ext4fs_control_count_dir(struct ext4fs_control_t * ctrl, u32_t inode_no, s32_t count);
 int ext4fs_control_sync(struct ext4fs_control_t * ctrl);
 int ext4fs_control_init(struct ext4fs_control_t * ctrl, struct block_t * bdev);
 int ext4fs_control_exit(struct ext4fs_control_t * ctrl);
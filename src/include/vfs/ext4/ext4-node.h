@@ -8,6 +8,14 @@ extern "C" {
 #include <vfs/ext4/ext4.h>
 
 #define EXT4_NODE_LOOKUP_SIZE	(4)
+#define EXT4_NODE_EXTENT_SIZE	(4)
+
+/* A run of logical blocks on contiguous physical blocks, a hole if pblk is zero */
+struct ext4fs_extent_t {
+	u32_t lblk;
+	u32_t pblk;
+	u32_t len;
+};
 
 /* Information for accessing a ext4fs file/directory */
 struct ext4fs_node_t {
@@ -49,6 +57,18 @@ struct ext4fs_node_t {
 	u32_t dindir2_blkno;
 	bool_t dindir2_dirty;
 
+	/*
+	 * Extent tree block of the last lookup
+	 * Allocated on demand. Must be freed in vput()
+	 */
+	u8_t * extent_block;
+	u32_t extent_blkno;
+
+	/* Recently used extents */
+	struct ext4fs_extent_t extent[EXT4_NODE_EXTENT_SIZE];
+	u32_t extent_count;
+	u32_t extent_victim;
+
 	/* Child directory entry lookup table */
 	u32_t lookup_victim;
 	char lookup_name[EXT4_NODE_LOOKUP_SIZE][VFS_MAX_NAME];
@@ -68,10 +88,12 @@ int ext4fs_node_truncate(struct ext4fs_node_t * node, u64_t pos);
 int ext4fs_node_load(struct ext4fs_control_t * ctrl, u32_t inode_no, struct ext4fs_node_t * node);
 int ext4fs_node_init(struct ext4fs_node_t * node);
 int ext4fs_node_exit(struct ext4fs_node_t * node);
+u32_t ext4fs_dx_hash(struct ext4fs_control_t * ctrl, int version, const char * name, int len);
 int ext4fs_node_read_dirent(struct ext4fs_node_t * dnode, s64_t off, struct vfs_dirent_t * d);
 int ext4fs_node_find_dirent(struct ext4fs_node_t * dnode, const char * name, struct ext2_dirent_t * dent);
 int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_t inode_no, u8_t type);
 int ext4fs_node_del_dirent(struct ext4fs_node_t * dnode, const char * name);
+int ext4fs_node_set_parent(struct ext4fs_node_t * dnode, u32_t inode_no);
 
 #ifdef __cplusplus
 }
@@ -74,13 +74,23 @@ struct ext2_sblock_t {
 	u32_t hash_seed[4];
 	u8_t def_hash_version;
 	u8_t jnl_backup_type;
-	u16_t reserved_word_pad;
+	u16_t desc_size;
 	u32_t default_mount_opts;
 	u32_t first_meta_bg;
 	u32_t mkfs_time;
 	u32_t jnl_blocks[17];
+	u32_t total_blocks_hi;
+	u32_t reserved_blocks_hi;
+	u32_t free_blocks_hi;
+	u16_t min_extra_isize;
+	u16_t want_extra_isize;
+	u32_t flags;
 } __attribute__ ((packed));
 
+/* Superblock Flags */
+#define EXT2_FLAGS_SIGNED_HASH			0x0001 /* Legacy, half md4 and tea hash names as signed chars */
+#define EXT2_FLAGS_UNSIGNED_HASH		0x0002 /* Legacy, half md4 and tea hash names as unsigned chars */
+
 /* FS States */
 #define EXT2_VALID_FS					1 /* Unmounted cleanly */
 #define EXT2_ERROR_FS					2 /* Errors detected */
@@ -115,11 +125,19 @@ struct ext2_sblock_t {
 #define EXT3_FEAT_INCOMPAT_RECOVER		0x0004
 #define EXT3_FEAT_INCOMPAT_JOURNAL_DEV	0x0008	 
 #define EXT2_FEAT_INCOMPAT_META_BG		0x0010
+#define EXT4_FEAT_INCOMPAT_EXTENTS		0x0040 /* Files use extent trees */
+#define EXT4_FEAT_INCOMPAT_64BIT		0x0080 /* Group descriptors of desc_size bytes */
+#define EXT4_FEAT_INCOMPAT_FLEX_BG		0x0200 /* Group metadata may live in other groups */
 
 /* Feature Read-Only Compatibility */
 #define EXT2_FEAT_RO_COMPAT_SPARS_SUPER	0x0001 /* Sparse Superblock */
 #define EXT2_FEAT_RO_COMPAT_LARGE_FILE	0x0002 /* Large file support, 64-bit file size */
 #define EXT2_FEAT_RO_COMPAT_BTREE_DIR	0x0004 /* Binary tree sorted directory files */
+#define EXT4_FEAT_RO_COMPAT_HUGE_FILE	0x0008 /* Block counts in units of file system blocks */
+#define EXT4_FEAT_RO_COMPAT_GDT_CSUM	0x0010 /* Group descriptor checksums */
+#define EXT4_FEAT_RO_COMPAT_DIR_NLINK	0x0020 /* More than 65000 subdirectories */
+#define EXT4_FEAT_RO_COMPAT_EXTRA_ISIZE	0x0040 /* Large inodes */
+#define EXT4_FEAT_RO_COMPAT_METADATA_CSUM	0x0400 /* Checksums on all metadata */
 
 /* Compression Algo Bitmap */
 #define EXT2_LZV1_ALG					0 /* Binary value of 0x00000001 */
@@ -142,6 +160,10 @@ struct ext2_block_group_t {
 	u16_t bg_checksum;		/* crc16(s_uuid+grouo_num+group_desc)*/
 } __attribute__ ((packed));
 
+/* Block group flags */
+#define EXT4_BG_INODE_UNINIT			0x0001 /* Inode table and bitmap not initialized */
+#define EXT4_BG_BLOCK_UNINIT			0x0002 /* Block bitmap not initialized */
+
 /* The ext2 inode */
 struct ext2_inode_t {
 	u16_t mode;
@@ -215,8 +237,69 @@ struct ext2_inode_t {
 #define EXT2_INDEX_FL					0x00001000 /* hash indexed directory */
 #define EXT2_IMAGIC_FL					0x00002000 /* AFS directory */
 #define EXT3_JOURNAL_DATA_FL			0x00004000 /* journal file data */
+#define EXT4_EXTENTS_FL					0x00080000 /* inode uses extents */
 #define EXT2_RESERVED_FL				0x80000000 /* reserved for ext2 library */
 
+/* Magic value of an extent tree node header */
+#define EXT4_EXT_MAGIC					0xF30A
+
+/* Longest initialized extent, longer ones are uninitialized and read as zeros */
+#define EXT4_EXT_INIT_MAX_LEN			32768
+
+/* The ext4 extent tree node header, in the inode block array or a tree block */
+struct ext4_extent_header_t {
+	u16_t magic;
+	u16_t entries;
+	u16_t max;
+	u16_t depth;
+	u32_t generation;
+} __attribute__ ((packed));
+
+/* The ext4 extent, a leaf entry */
+struct ext4_extent_t {
+	u32_t block;	/* First logical block */
+	u16_t len;		/* Number of blocks */
+	u16_t start_hi;	/* Physical block, high 16 bits */
+	u32_t start_lo;	/* Physical block, low 32 bits */
+} __attribute__ ((packed));
+
+/* The ext4 extent index, an internal entry */
+struct ext4_extent_idx_t {
+	u32_t block;	/* Logical blocks from here on are in this subtree */
+	u32_t leaf_lo;	/* Physical block of the subtree, low 32 bits */
+	u16_t leaf_hi;	/* Physical block of the subtree, high 16 bits */
+	u16_t unused;
+} __attribute__ ((packed));
+
+/* Directory hash versions */
+#define EXT2_HASH_LEGACY				0
+#define EXT2_HASH_HALF_MD4				1
+#define EXT2_HASH_TEA					2
+#define EXT2_HASH_LEGACY_UNSIGNED		3
+#define EXT2_HASH_HALF_MD4_UNSIGNED		4
+#define EXT2_HASH_TEA_UNSIGNED			5
+
+/* The htree root, behind the "." and ".." entries in the first directory block */
+struct ext2_dx_root_info_t {
+	u32_t reserved_zero;
+	u8_t hash_version;
+	u8_t info_length;
+	u8_t indirect_levels;
+	u8_t unused_flags;
+} __attribute__ ((packed));
+
+/* Header of an htree index array, overlays the hash of its first entry */
+struct ext2_dx_countlimit_t {
+	u16_t limit;
+	u16_t count;
+} __attribute__ ((packed));
+
+/* The htree index entry, hashes from here on are in this block */
+struct ext2_dx_entry_t {
+	u32_t hash;
+	u32_t block;
+} __attribute__ ((packed));
+
 /* The ext2 directory entry. */
 struct ext2_dirent_t {
 	u32_t inode;
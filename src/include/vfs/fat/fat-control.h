@@ -7,7 +7,19 @@ extern "C" {
 
 #include <vfs/fat/fat.h>
 
-#define FAT_TABLE_CACHE_SIZE	(32)
+#define FAT_TABLE_CACHE_SIZE	(64)
+#define FAT_TABLE_CACHE_HASH	(16)
+
+/*
+ * One cached sector of the first FAT copy
+ */
+struct fat_cache_sector_t {
+	struct list_head hentry;
+	struct list_head lentry;
+	u32_t num;
+	bool_t dirty;
+	u8_t * buf;
+};
 
 /*
  * Information about a "mounted" FAT filesystem
@@ -42,12 +54,17 @@ struct fatfs_control_t {
 	/* FAT type */
 	enum fat_type_t type;
 
-	/* FAT sector cache */
+	/* FAT sector cache, hashed by sector number with lru replacement */
 	struct mutex_t fat_cache_lock;
-	u32_t fat_cache_victim;
-	bool_t fat_cache_dirty[FAT_TABLE_CACHE_SIZE];
-	u32_t fat_cache_num[FAT_TABLE_CACHE_SIZE];
+	struct list_head fat_cache_hash[FAT_TABLE_CACHE_HASH];
+	struct list_head fat_cache_lru;
+	struct fat_cache_sector_t fat_cache[FAT_TABLE_CACHE_SIZE];
 	u8_t * fat_cache_buf;
+
+	/* Free cluster bitmap, built on the first allocation */
+	u32_t * free_bitmap;
+	u32_t free_count;
+	u32_t free_hint;
 };
 
 u32_t fatfs_pack_timestamp(u32_t year, u32_t mon, u32_t day, u32_t hour, u32_t min, u32_t sec);
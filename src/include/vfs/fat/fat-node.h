@@ -7,6 +7,16 @@ extern "C" {
 
 #include <vfs/fat/fat.h>
 
+#define FAT_NODE_EXTENT_CACHE_SIZE	(8)
+
+/*
+ * A run of contiguous clusters, from file cluster index to device cluster
+ */
+struct fatfs_extent_t {
+	u32_t fcl;
+	u32_t dcl;
+	u32_t len;
+};
 
 /*
  * Information for accessing a FAT file/directory
@@ -25,9 +35,10 @@ struct fatfs_node_t {
 	/* First cluster */
 	u32_t first_cluster;
 
-	/* Current cluster */
-	u32_t cur_cluster;
-	u32_t cur_pos;
+	/* Cluster chain extent cache */
+	struct fatfs_extent_t extent[FAT_NODE_EXTENT_CACHE_SIZE];
+	u32_t extent_count;
+	u32_t extent_victim;
 
 	/* Cached clusters */
 	u8_t *cached_data;
@@ -15,6 +15,7 @@ extern "C" {
 #include <spinlock.h>
 #include <xboot/kobj.h>
 #include <xboot/mutex.h>
+#include <xboot/task.h>
 #include <xboot/initcall.h>
 
 #define VFS_MAX_PATH		(1024)
@@ -112,6 +113,11 @@ struct vfs_dirent_t {
 	char d_name[VFS_MAX_NAME];
 };
 
+struct vfs_iovec_t {
+	void * iov_base;
+	u64_t iov_len;
+};
+
 enum vfs_node_flag_t {
 	VNF_NONE,
 	VNF_ROOT,
@@ -145,9 +151,10 @@ struct vfs_node_t {
 };
 
 enum {
-	MOUNT_RW	= (0x0 << 0),
-	MOUNT_RO	= (0x1 << 0),
-	MOUNT_MASK	= (0x1 << 0),
+	MOUNT_RW		= (0x0 << 0),
+	MOUNT_RO		= (0x1 << 0),
+	MOUNT_MASK		= (0x1 << 0),
+	MOUNT_NOCACHE	= (0x1 << 1),
 };
 
 struct vfs_mount_t {
@@ -186,6 +193,8 @@ struct filesystem_t {
 	int (*mkdir)(struct vfs_node_t *, const char *, u32_t);
 	int (*rmdir)(struct vfs_node_t *, struct vfs_node_t *, const char *);
 	int (*chmod)(struct vfs_node_t *, u32_t);
+	u64_t (*copy)(struct vfs_node_t *, s64_t, struct vfs_node_t *, s64_t, u64_t);
+	void * (*mmap)(struct vfs_node_t *, s64_t, u64_t);
 };
 
 extern struct list_head __filesystem_list;
@@ -198,12 +207,21 @@ void vfs_force_unmount(struct vfs_mount_t * m);
 int vfs_mount(const char * dev, const char * dir, const char * fsname, u32_t flags);
 int vfs_unmount(const char * path);
 int vfs_sync(void);
+void vfs_flusher_task(struct task_t * task, void * data);
 struct vfs_mount_t * vfs_mount_get(int index);
 int vfs_mount_count(void);
 int vfs_open(const char * path, u32_t flags, u32_t mode);
 int vfs_close(int fd);
 u64_t vfs_read(int fd, void * buf, u64_t len);
 u64_t vfs_write(int fd, void * buf, u64_t len);
+u64_t vfs_pread(int fd, void * buf, u64_t len, s64_t off);
+u64_t vfs_pwrite(int fd, void * buf, u64_t len, s64_t off);
+u64_t vfs_readv(int fd, struct vfs_iovec_t * iov, int iovcnt);
+u64_t vfs_writev(int fd, struct vfs_iovec_t * iov, int iovcnt);
+u64_t vfs_copy_file_range(int fdin, s64_t * offin, int fdout, s64_t * offout, u64_t len);
+void * vfs_mmap(int fd, s64_t off, u64_t len);
+void * vfs_mmap_direct(int fd, s64_t off, u64_t len);
+int vfs_munmap(void * addr);
 s64_t vfs_lseek(int fd, s64_t off, int whence);
 int vfs_fsync(int fd);
 int vfs_fchmod(int fd, u32_t mode);
@@ -0,0 +1,29 @@
+#ifndef __BOOTTIME_H__
+#define __BOOTTIME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <types.h>
+#include <list.h>
+#include <xboot/ktime.h>
+
+struct boottime_t
+{
+	struct list_head list;
+	const char * type;
+	char * name;
+	ktime_t begin;
+	ktime_t end;
+};
+
+void boottime_record(const char * type, const char * name, ktime_t begin, ktime_t end);
+void boottime_done(void);
+void boottime_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOTTIME_H__ */
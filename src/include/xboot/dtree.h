@@ -10,12 +10,60 @@ extern "C" {
 #include <string.h>
 #include <json.h>
 
+/*
+ * Binary device tree, compiled from the machine json by 'mkdtree'.
+ *
+ * A header, a string table and a stream of nodes. Keys and string values are
+ * interned into the string table and referenced by their offset in it. Each
+ * node is the name offset and the address, both varints, followed by its
+ * object. A value is a type byte and its payload, a zigzag varint integer,
+ * eight raw bytes of double, one byte of boolean or a string offset. Objects
+ * and arrays carry a varint count and a varint byte length, so they can be
+ * skipped, object members are a key offset and a value, sorted by key. An
+ * object puts a table of member offsets between its length and its members,
+ * so keys can be binary searched. The offsets are relative to the first
+ * member, two bytes wide, or four when the members take more than 64K.
+ * Varints are little endian base 128, numbers are in native byte order.
+ */
+#define DTREE_BLOB_MAGIC		(0x42544458)	/* "XDTB" */
+#define DTREE_BLOB_VERSION		(3)
+#define DTREE_BLOB_INDEX_WIDTH(len)	(((len) > 0xffff) ? 4 : 2)
+
+struct dtree_blob_header_t {
+	u32_t magic;
+	u32_t version;
+	u32_t size;
+	u32_t nnode;
+	u32_t node;
+	u32_t string;
+	u32_t nstring;
+	u32_t reserved;
+};
+
+struct dtree_blob_value_t {
+	int type;
+	int length;
+	union {
+		s64_t integer;
+		double dbl;
+		int boolean;
+		const char * string;
+		const u8_t * data;
+	} u;
+};
+
 struct dtnode_t {
 	const char * name;
 	physical_addr_t addr;
 	struct json_value_t * value;
+	const void * blob;
+	const u8_t * bvalue;
 };
 
+int dtree_blob_check(const void * blob, int length);
+const u8_t * dtree_blob_decode(const void * blob, const u8_t * p, struct dtree_blob_value_t * v);
+const u8_t * dtree_blob_member(const void * blob, const u8_t * p, const char ** key);
+const u8_t * dtree_blob_node(const void * blob, const u8_t * p, const char ** name, u64_t * addr);
 const char * dt_read_name(struct dtnode_t * n);
 int dt_read_id(struct dtnode_t * n);
 physical_addr_t dt_read_address(struct dtnode_t * n);
@@ -8,12 +8,17 @@ extern "C" {
 typedef void (*initcall_t)(void);
 typedef void (*exitcall_t)(void);
 
+struct initcall_entry_t {
+	initcall_t fn;
+	const char * name;
+};
+
 #define __init __attribute__ ((__section__ (".init.text")))
 #define __exit __attribute__ ((__section__ (".exit.text")))
 
 #define __define_initcall(level, fn, id) \
-	static const initcall_t __initcall_##fn##id \
-	__attribute__((__used__, __section__(".initcall_" level ".text"))) = fn
+	static const struct initcall_entry_t __initcall_##fn##id \
+	__attribute__((__used__, __section__(".initcall_" level ".text"))) = { fn, #fn }
 
 #define __define_exitcall(level, fn, id) \
 	static const exitcall_t __exitcall_##fn##id \
@@ -75,6 +75,7 @@ void task_suspend(struct task_t * task);
 void task_resume(struct task_t * task);
 void task_yield(void);
 
+void scheduler_smpboot(void);
 void scheduler_loop(void);
 void do_init_sched(void);
 
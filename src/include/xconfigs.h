@@ -27,6 +27,14 @@ extern "C" {
 #define CONFIG_DEVICE_HASH_SIZE				(257)
 #endif
 
+#if !defined(CONFIG_DRIVER_PARALLEL_PROBE)
+#define CONFIG_DRIVER_PARALLEL_PROBE		(0)
+#endif
+
+#if !defined(CONFIG_BOOTTIME_MAX_RECORDS)
+#define CONFIG_BOOTTIME_MAX_RECORDS			(512)
+#endif
+
 #if !defined(CONFIG_PROFILER_HASH_SIZE)
 #define CONFIG_PROFILER_HASH_SIZE			(257)
 #endif
@@ -43,10 +51,70 @@ extern "C" {
 #define CONFIG_EVENT_FIFO_SIZE				(8)
 #endif
 
+#if !defined(CONFIG_BLOCK_CACHE_SIZE)
+#define CONFIG_BLOCK_CACHE_SIZE				(SZ_1M)
+#endif
+
+#if !defined(CONFIG_BLOCK_CACHE_HASH_SIZE)
+#define CONFIG_BLOCK_CACHE_HASH_SIZE		(1031)
+#endif
+
+#if !defined(CONFIG_BLOCK_READAHEAD_SIZE)
+#define CONFIG_BLOCK_READAHEAD_SIZE			(SZ_64K)
+#endif
+
+#if !defined(CONFIG_BLOCK_QUEUE_MERGE_SIZE)
+#define CONFIG_BLOCK_QUEUE_MERGE_SIZE		(SZ_128K)
+#endif
+
+#if !defined(CONFIG_VFS_DENTRY_CACHE_SIZE)
+#define CONFIG_VFS_DENTRY_CACHE_SIZE		(512)
+#endif
+
+#if !defined(CONFIG_VFS_DENTRY_HASH_SIZE)
+#define CONFIG_VFS_DENTRY_HASH_SIZE			(257)
+#endif
+
+#if !defined(CONFIG_RAMFS_PAGE_SIZE)
+#define CONFIG_RAMFS_PAGE_SIZE				(SZ_4K)
+#endif
+
 #if !defined(CONFIG_MOUNT_PRIVATE_DEVICE)
 #define CONFIG_MOUNT_PRIVATE_DEVICE			""
 #endif
 
+#if !defined(CONFIG_FLUSHER_TASK)
+#define CONFIG_FLUSHER_TASK					(1)
+#endif
+
+#if !defined(CONFIG_FLUSHER_INTERVAL)
+#define CONFIG_FLUSHER_INTERVAL				(500)
+#endif
+
+#if !defined(CONFIG_FLUSHER_DIRTY_EXPIRE)
+#define CONFIG_FLUSHER_DIRTY_EXPIRE			(5000)
+#endif
+
+#if !defined(CONFIG_FLUSHER_DIRTY_RATIO)
+#define CONFIG_FLUSHER_DIRTY_RATIO			(50)
+#endif
+
+#if !defined(CONFIG_FLUSHER_BATCH)
+#define CONFIG_FLUSHER_BATCH				(16)
+#endif
+
+#if !defined(CONFIG_FONT_GLYPH_CACHE_SIZE)
+#define CONFIG_FONT_GLYPH_CACHE_SIZE		(SZ_512K)
+#endif
+
+#if !defined(CONFIG_FONT_GLYPH_HASH_SIZE)
+#define CONFIG_FONT_GLYPH_HASH_SIZE			(257)
+#endif
+
+#if !defined(CONFIG_FONT_LOOKUP_CACHE_SIZE)
+#define CONFIG_FONT_LOOKUP_CACHE_SIZE		(256)
+#endif
+
 #if !defined(CONFIG_SHELL_TASK)
 #define CONFIG_SHELL_TASK					(1)
 #endif
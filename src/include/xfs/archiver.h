@@ -45,6 +45,9 @@ struct xfs_archiver_t
 	s64_t (*tell)(void * f);
 	s64_t (*length)(void * f);
 	void (*close)(void * f);
+	void * (*mmap)(void * f, s64_t offset, s64_t size);
+	void * (*mmap_direct)(void * f, s64_t offset, s64_t size);
+	void (*munmap)(void * f, void * addr);
 };
 
 bool_t register_archiver(struct xfs_archiver_t * archiver);
@@ -39,13 +39,16 @@ void do_showlogo(void)
 	struct framebuffer_t * fb;
 	struct matrix_t m;
 	struct color_t c;
+	ktime_t begin;
 
 	if(!list_empty_careful(&__device_head[DEVICE_TYPE_FRAMEBUFFER]))
 	{
 		ctx = xfs_alloc("/framework", 0);
 		if(ctx)
 		{
+			begin = ktime_get();
 			logo = surface_alloc_from_xfs(ctx, "assets/images/logo.png");
+			boottime_record("logo", "assets/images/logo.png", begin, ktime_get());
 			if(logo)
 			{
 				list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_FRAMEBUFFER], head)
@@ -29,28 +29,35 @@
 #include <xboot.h>
 #include <init.h>
 
-void xboot_main(void)
+static void xboot_boot(void)
 {
-	/* Do initial memory */
-	do_init_mem();
-
-	/* Do initial scheduler */
-	do_init_sched();
-
-	/* Do initial vfs */
-	do_init_vfs();
+	ktime_t begin;
 
 	/* Do all initial calls */
+	begin = ktime_get();
 	do_initcalls();
+	boottime_record("stage", "initcalls", begin, ktime_get());
 
 	/* Do show logo */
+	begin = ktime_get();
 	do_showlogo();
+	boottime_record("stage", "showlogo", begin, ktime_get());
 
 	/* Do auto mount */
+	begin = ktime_get();
 	do_automount();
+	boottime_record("stage", "automount", begin, ktime_get());
 
 	/* Do auto boot */
+	begin = ktime_get();
 	do_autoboot();
+	boottime_record("stage", "autoboot", begin, ktime_get());
+	boottime_done();
+
+#if defined(CONFIG_FLUSHER_TASK) && (CONFIG_FLUSHER_TASK > 0)
+	/* Create and resume background write back task */
+	task_resume(task_create(scheduler_self(), "flusher", vfs_flusher_task, NULL, 0, 19));
+#endif
 
 #if defined(CONFIG_SHELL_TASK) && (CONFIG_SHELL_TASK > 0)
 	/* Create shell task */
@@ -59,6 +66,33 @@ void xboot_main(void)
 	/* Resume shell task */
 	task_resume(task);
 #endif
+}
+
+#if defined(CONFIG_DRIVER_PARALLEL_PROBE) && (CONFIG_DRIVER_PARALLEL_PROBE > 0)
+static void init_task(struct task_t * task, void * data)
+{
+	xboot_boot();
+}
+#endif
+
+void xboot_main(void)
+{
+	/* Do initial memory */
+	do_init_mem();
+
+	/* Do initial scheduler */
+	do_init_sched();
+
+	/* Do initial vfs */
+	do_init_vfs();
+
+#if defined(CONFIG_DRIVER_PARALLEL_PROBE) && (CONFIG_DRIVER_PARALLEL_PROBE > 0)
+	/* Boot in a task, so that devices can be probed by worker tasks */
+	task_resume(task_create(scheduler_self(), "init", init_task, NULL, 0, 0));
+#else
+	/* Boot */
+	xboot_boot();
+#endif
 
 	/* Scheduler loop */
 	scheduler_loop();
@@ -41,6 +41,7 @@ static int cat_file(const char * filename)
 	char fpath[VFS_MAX_PATH];
 	char * buf;
 	u64_t i, n;
+	s64_t off = 0;
 	int fd;
 
 	if(shell_realpath(filename, fpath) < 0)
@@ -76,8 +77,9 @@ static int cat_file(const char * filename)
 		return -1;
 	}
 
-	while((n = vfs_read(fd, buf, SZ_64K)) > 0)
+	while((n = vfs_pread(fd, buf, SZ_64K, off)) > 0)
 	{
+		off += n;
 		for(i = 0; i < n; i++)
 		{
 			if(isprint(buf[i]) || (buf[i] == '\r') || (buf[i] == '\n') || (buf[i] == '\t') || (buf[i] == '\f'))
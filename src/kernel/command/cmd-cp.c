@@ -78,10 +78,9 @@ out:
 static int copy_file(const char * src, const char * dst, int verbose)
 {
 	struct vfs_stat_t st;
-	char * buf;
 	int sfd, dfd;
 	int flags;
-	u64_t n;
+	u64_t len;
 
 	sfd = vfs_open(src, O_RDONLY, 0);
 	if(sfd < 0)
@@ -103,21 +102,13 @@ static int copy_file(const char * src, const char * dst, int verbose)
 		return -1;
 	}
 
-	if(!(buf = malloc(SZ_64K)))
-	{
-		vfs_close(sfd);
-		vfs_close(dfd);
-		return -1;
-	}
-
 	if(verbose)
 		printf("'%s' -> '%s'\r\n", src, dst);
-	while((n = vfs_read(sfd, buf, SZ_64K)) > 0)
-	{
-		vfs_write(dfd, buf, n);
-	}
+	len = (vfs_fstat(sfd, &st) >= 0) ? st.st_size : 0;
+	if(len < SZ_64K)
+		len = SZ_64K;
+	while(vfs_copy_file_range(sfd, NULL, dfd, NULL, len) > 0);
 
-	free(buf);
 	vfs_close(sfd);
 	vfs_close(dfd);
 
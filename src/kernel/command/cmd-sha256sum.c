@@ -44,6 +44,7 @@ static int sha256sum_file(const char * filename)
 	char fpath[VFS_MAX_PATH];
 	char * buf;
 	u64_t n;
+	s64_t off = 0;
 	int fd, i;
 
 	if(shell_realpath(filename, fpath) < 0)
@@ -80,9 +81,10 @@ static int sha256sum_file(const char * filename)
 	}
 
 	sha256_init(&ctx);
-	while((n = vfs_read(fd, buf, SZ_64K)) > 0)
+	while((n = vfs_pread(fd, buf, SZ_64K, off)) > 0)
 	{
 		sha256_update(&ctx, buf, n);
+		off += n;
 	}
 	digest = sha256_final(&ctx);
 	for(i = 0; i < SHA256_DIGEST_SIZE; i++)
@@ -0,0 +1,184 @@
+/*
+ * kernel/core/boottime.c
+ *
+ * Copyright(c) 2007-2020 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <xboot/boottime.h>
+
+static LIST_HEAD(__boottime_list);
+static spinlock_t __boottime_lock = SPIN_LOCK_INIT();
+static int __boottime_count = 0;
+static int __boottime_done = 0;
+
+static int boottime_cmp(const void * a, const void * b)
+{
+	struct boottime_t * ta = *((struct boottime_t **)a);
+	struct boottime_t * tb = *((struct boottime_t **)b);
+	s64_t da = ktime_to_ns(ktime_sub(ta->end, ta->begin));
+	s64_t db = ktime_to_ns(ktime_sub(tb->end, tb->begin));
+
+	if(da < db)
+		return 1;
+	else if(da > db)
+		return -1;
+	return ktime_compare(ta->begin, tb->begin);
+}
+
+/*
+ * Snapshot of all records, longest first. Caller frees the array.
+ */
+static struct boottime_t ** boottime_sorted(int * count)
+{
+	struct boottime_t ** array;
+	struct boottime_t * pos;
+	irq_flags_t flags;
+	int n = 0;
+
+	spin_lock_irqsave(&__boottime_lock, flags);
+	array = malloc(sizeof(struct boottime_t *) * (__boottime_count + 1));
+	if(array)
+	{
+		list_for_each_entry(pos, &__boottime_list, list)
+			array[n++] = pos;
+	}
+	spin_unlock_irqrestore(&__boottime_lock, flags);
+	if(array)
+		qsort(array, n, sizeof(struct boottime_t *), boottime_cmp);
+	*count = n;
+	return array;
+}
+
+static ssize_t boottime_read_report(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct boottime_t ** array;
+	struct boottime_t * t;
+	char * p = buf;
+	int len = 0;
+	int count, i;
+
+	array = boottime_sorted(&count);
+	if(!array)
+		return 0;
+	len += snprintf(p + len, size - len, "%12s %12s %-10s %s\r\n", "duration(us)", "begin(us)", "type", "name");
+	for(i = 0; i < count && len < size; i++)
+	{
+		t = array[i];
+		len += snprintf(p + len, size - len, "%12lld %12lld %-10s %s\r\n",
+			ktime_us_delta(t->end, t->begin), ktime_to_us(t->begin), t->type, t->name);
+	}
+	free(array);
+	return min(len, (int)size);
+}
+
+/*
+ * Trace event format, which can be loaded by chrome://tracing or perfetto.
+ */
+static ssize_t boottime_read_trace(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct boottime_t * pos;
+	irq_flags_t flags;
+	char * p = buf;
+	int len = 0;
+
+	len += snprintf(p + len, size - len, "{\"traceEvents\":[");
+	spin_lock_irqsave(&__boottime_lock, flags);
+	list_for_each_entry(pos, &__boottime_list, list)
+	{
+		if(len >= size)
+			break;
+		len += snprintf(p + len, size - len, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%lld,\"dur\":%lld}",
+			(pos->list.prev == &__boottime_list) ? "" : ",", pos->name, pos->type, ktime_to_us(pos->begin), ktime_us_delta(pos->end, pos->begin));
+	}
+	spin_unlock_irqrestore(&__boottime_lock, flags);
+	if(len < size)
+		len += snprintf(p + len, size - len, "]}\r\n");
+	return min(len, (int)size);
+}
+
+void boottime_record(const char * type, const char * name, ktime_t begin, ktime_t end)
+{
+	struct boottime_t * t;
+	irq_flags_t flags;
+
+	if(!type || !name || __boottime_done || (__boottime_count >= CONFIG_BOOTTIME_MAX_RECORDS))
+		return;
+
+	t = malloc(sizeof(struct boottime_t));
+	if(!t)
+		return;
+
+	t->type = type;
+	t->name = strdup(name);
+	t->begin = begin;
+	t->end = end;
+	if(!t->name)
+	{
+		free(t);
+		return;
+	}
+	spin_lock_irqsave(&__boottime_lock, flags);
+	list_add_tail(&t->list, &__boottime_list);
+	__boottime_count++;
+	spin_unlock_irqrestore(&__boottime_lock, flags);
+}
+
+/*
+ * Stop recording once boot has completed, so runtime mounts and probes of
+ * hotplugged devices do not grow the list for the life of the system
+ */
+void boottime_done(void)
+{
+	__boottime_done = 1;
+}
+
+void boottime_dump(void)
+{
+	struct boottime_t ** array;
+	struct boottime_t * t;
+	int count, i;
+
+	array = boottime_sorted(&count);
+	if(!array)
+		return;
+	printf("Boot time analysis:\r\n");
+	for(i = 0; i < count; i++)
+	{
+		t = array[i];
+		printf("[%s] %s, %lldus, [%lld ~ %lld]\r\n", t->type, t->name, ktime_us_delta(t->end, t->begin), ktime_to_us(t->begin), ktime_to_us(t->end));
+	}
+	free(array);
+}
+
+static __init void boottime_pure_init(void)
+{
+	struct kobj_t * kclass = kobj_search_directory_with_create(kobj_get_root(), "class");
+	struct kobj_t * kboot = kobj_search_directory_with_create(kclass, "boot");
+
+	kobj_add_regular(kboot, "report", boottime_read_report, NULL, NULL);
+	kobj_add_regular(kboot, "trace", boottime_read_trace, NULL, NULL);
+}
+pure_initcall(boottime_pure_init);
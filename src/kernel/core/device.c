@@ -40,19 +40,11 @@ static struct hlist_head * device_hash(const char * name)
 	return &__device_hash[shash(name) % ARRAY_SIZE(__device_hash)];
 }
 
-static struct kobj_t * search_device_kobj(struct device_t * dev)
+static const char * device_type_name(enum device_type_t type)
 {
-	struct kobj_t * kdevice;
 	char * name;
 
-	if(!dev || !dev->kobj)
-		return NULL;
-
-	kdevice = kobj_search_directory_with_create(kobj_get_root(), "device");
-	if(!kdevice)
-		return NULL;
-
-	switch(dev->type)
+	switch(type)
 	{
 	case DEVICE_TYPE_ADC:
 		name = "adc";
@@ -184,7 +176,26 @@ static struct kobj_t * search_device_kobj(struct device_t * dev)
 		return NULL;
 	}
 
-	return kobj_search_directory_with_create(kdevice, (const char *)name);
+	return name;
+}
+
+static struct kobj_t * search_device_kobj(struct device_t * dev)
+{
+	struct kobj_t * kdevice;
+	const char * name;
+
+	if(!dev || !dev->kobj)
+		return NULL;
+
+	kdevice = kobj_search_directory_with_create(kobj_get_root(), "device");
+	if(!kdevice)
+		return NULL;
+
+	name = device_type_name(dev->type);
+	if(!name)
+		return NULL;
+
+	return kobj_search_directory_with_create(kdevice, name);
 }
 
 static ssize_t device_write_suspend(struct kobj_t * kobj, void * buf, size_t size)
@@ -250,6 +261,14 @@ struct device_t * search_device(const char * name, enum device_type_t type)
 		if((pos->type == type) && (strcmp(pos->name, name) == 0))
 			return pos;
 	}
+	if(probe_deferred_device(name))
+	{
+		hlist_for_each_entry_safe(pos, n, device_hash(name), node)
+		{
+			if((pos->type == type) && (strcmp(pos->name, name) == 0))
+				return pos;
+		}
+	}
 	return NULL;
 }
 
@@ -257,6 +276,8 @@ struct device_t * search_first_device(enum device_type_t type)
 {
 	if((type < 0) || (type >= ARRAY_SIZE(__device_head)))
 		return NULL;
+	if(list_empty(&__device_head[type]))
+		probe_deferred_device(device_type_name(type));
 	return (struct device_t *)list_first_entry_or_null(&__device_head[type], struct device_t, head);
 }
 
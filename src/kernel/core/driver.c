@@ -62,6 +62,8 @@ static ssize_t driver_write_probe(struct kobj_t * kobj, void * buf, size_t size)
 				n.name = strsep(&p, "@");
 				n.addr = p ? strtoull(p, NULL, 0) : 0;
 				n.value = (struct json_value_t *)(v->u.object.values[i].value);
+				n.blob = NULL;
+				n.bvalue = NULL;
 
 				if(strcmp(drv->name, n.name) == 0)
 					drv->probe(drv, &n);
@@ -134,43 +136,618 @@ bool_t unregister_driver(struct driver_t * drv)
 	return TRUE;
 }
 
-void probe_device(const char * json, int length, const char * tips)
+static struct device_t * probe_dtnode(struct dtnode_t * n)
 {
 	struct driver_t * drv;
 	struct device_t * dev;
-	struct dtnode_t n;
+	ktime_t begin;
+
+	drv = search_driver(n->name);
+	begin = ktime_get();
+	if(drv && (dev = drv->probe(drv, n)))
+	{
+		boottime_record("probe", dev->name, begin, ktime_get());
+		LOG("Probe device '%s' with %s", dev->name, drv->name);
+		return dev;
+	}
+	boottime_record("probe", n->name, begin, ktime_get());
+	LOG("Fail to probe device with %s", n->name);
+	return NULL;
+}
+
+/*
+ * Deferred probe, the device tree is kept alive while any of its nodes is pending:
+ *
+ * - nodes with status 'lazy' are not probed at boot, but on the first search_device()
+ *   or the first /sys lookup of their device name or device type.
+ * - nodes whose probe failed, usually because a clock, gpio or regulator they rely
+ *   on isn't registered yet, are retried each time some other device was probed.
+ *   whatever still fails at late initcall is dropped.
+ */
+struct deferred_tree_t {
 	struct json_value_t * v;
+	void * blob;
+	const u8_t ** bnodes;
+	int count;
+	int refcnt;
+};
+
+struct deferred_node_t {
+	struct list_head list;
+	struct deferred_tree_t * tree;
+	struct dtnode_t n;
+	int lazy;
+};
+
+static LIST_HEAD(__deferred_list);
+static spinlock_t __deferred_lock = SPIN_LOCK_INIT();
+static int __deferred_final = 0;
+
+static void deferred_tree_get(struct deferred_tree_t * tree)
+{
+	irq_flags_t flags;
+
+	spin_lock_irqsave(&__deferred_lock, flags);
+	tree->refcnt++;
+	spin_unlock_irqrestore(&__deferred_lock, flags);
+}
+
+static void deferred_tree_put(struct deferred_tree_t * tree)
+{
+	irq_flags_t flags;
+	int refcnt;
+
+	spin_lock_irqsave(&__deferred_lock, flags);
+	refcnt = --tree->refcnt;
+	spin_unlock_irqrestore(&__deferred_lock, flags);
+	if(refcnt <= 0)
+	{
+		json_free(tree->v);
+		free(tree->bnodes);
+		free(tree->blob);
+		free(tree);
+	}
+}
+
+static struct deferred_tree_t * deferred_tree_alloc(const char * buf, int length, const char * tips)
+{
+	struct deferred_tree_t * tree;
+	struct dtree_blob_header_t * h = (struct dtree_blob_header_t *)buf;
+	struct dtree_blob_value_t bv;
+	const u8_t * p;
+	const char * name;
+	u64_t addr;
 	char errbuf[256];
-	char * p;
 	int i;
 
-	if(json && (length > 0))
+	tree = malloc(sizeof(struct deferred_tree_t));
+	if(!tree)
+		return NULL;
+	tree->v = NULL;
+	tree->blob = NULL;
+	tree->bnodes = NULL;
+	tree->refcnt = 1;
+
+	if((length >= sizeof(struct dtree_blob_header_t)) && (h->magic == DTREE_BLOB_MAGIC))
 	{
-		v = json_parse(json, length, errbuf);
-		if(v && (v->type == JSON_OBJECT))
+		if(dtree_blob_check(buf, length))
 		{
-			for(i = 0; i < v->u.object.length; i++)
+			tree->blob = malloc(h->size);
+			tree->bnodes = malloc(sizeof(const u8_t *) * (h->nnode + 1));
+			if(tree->blob && tree->bnodes)
 			{
-				p = (char *)(v->u.object.values[i].name);
-				n.name = strsep(&p, "@");
-				n.addr = p ? strtoull(p, NULL, 0) : 0;
-				n.value = (struct json_value_t *)(v->u.object.values[i].value);
-
-				if(strcmp(dt_read_string(&n, "status", "okay"), "disabled") != 0)
+				memcpy(tree->blob, buf, h->size);
+				p = (const u8_t *)tree->blob + h->node;
+				for(i = 0; i < h->nnode; i++)
 				{
-					drv = search_driver(n.name);
-					if(drv && (dev = drv->probe(drv, &n)))
-						LOG("Probe device '%s' with %s", dev->name, drv->name);
-					else
-						LOG("Fail to probe device with %s", n.name);
+					tree->bnodes[i] = p;
+					p = dtree_blob_decode(tree->blob, dtree_blob_node(tree->blob, p, &name, &addr), &bv);
 				}
+				tree->count = h->nnode;
+				return tree;
 			}
+			free(tree->bnodes);
+			free(tree->blob);
 		}
 		else
 		{
-			LOG("[%s]-%s", tips ? tips : "Json", errbuf);
+			LOG("[%s]-Invalid binary device tree", tips ? tips : "Blob");
 		}
-		json_free(v);
+	}
+	else
+	{
+		tree->v = json_parse(buf, length, errbuf);
+		if(tree->v && (tree->v->type == JSON_OBJECT))
+		{
+			tree->count = tree->v->u.object.length;
+			return tree;
+		}
+		LOG("[%s]-%s", tips ? tips : "Json", errbuf);
+		json_free(tree->v);
+	}
+	free(tree);
+	return NULL;
+}
+
+static void deferred_tree_node(struct deferred_tree_t * tree, int i, struct dtnode_t * n)
+{
+	const char * name;
+	u64_t addr;
+	char * p;
+
+	if(tree->blob)
+	{
+		n->bvalue = dtree_blob_node(tree->blob, tree->bnodes[i], &name, &addr);
+		n->name = (char *)name;
+		n->addr = addr;
+		n->value = NULL;
+		n->blob = tree->blob;
+	}
+	else
+	{
+		p = (char *)(tree->v->u.object.values[i].name);
+		n->name = strsep(&p, "@");
+		n->addr = p ? strtoull(p, NULL, 0) : 0;
+		n->value = (struct json_value_t *)(tree->v->u.object.values[i].value);
+		n->blob = NULL;
+		n->bvalue = NULL;
+	}
+}
+
+static void deferred_add(struct deferred_tree_t * tree, struct dtnode_t * n, int lazy)
+{
+	struct deferred_node_t * dn;
+	irq_flags_t flags;
+
+	if(!lazy && (__deferred_final || !search_driver(n->name)))
+		return;
+	dn = malloc(sizeof(struct deferred_node_t));
+	if(!dn)
+		return;
+	deferred_tree_get(tree);
+	dn->tree = tree;
+	memcpy(&dn->n, n, sizeof(struct dtnode_t));
+	dn->lazy = lazy;
+	spin_lock_irqsave(&__deferred_lock, flags);
+	list_add_tail(&dn->list, &__deferred_list);
+	spin_unlock_irqrestore(&__deferred_lock, flags);
+}
+
+static void deferred_del(struct deferred_node_t * dn)
+{
+	irq_flags_t flags;
+
+	spin_lock_irqsave(&__deferred_lock, flags);
+	list_del(&dn->list);
+	spin_unlock_irqrestore(&__deferred_lock, flags);
+	deferred_tree_put(dn->tree);
+	free(dn);
+}
+
+static void retry_deferred_devices(void)
+{
+	struct deferred_node_t * pos, * n;
+	struct list_head head;
+	irq_flags_t flags;
+	int progress;
+
+	do {
+		progress = 0;
+		init_list_head(&head);
+		spin_lock_irqsave(&__deferred_lock, flags);
+		list_for_each_entry_safe(pos, n, &__deferred_list, list)
+		{
+			if(!pos->lazy)
+				list_move_tail(&pos->list, &head);
+		}
+		spin_unlock_irqrestore(&__deferred_lock, flags);
+
+		list_for_each_entry_safe(pos, n, &head, list)
+		{
+			if(probe_dtnode(&pos->n))
+			{
+				deferred_del(pos);
+				progress++;
+			}
+			else
+			{
+				spin_lock_irqsave(&__deferred_lock, flags);
+				list_move_tail(&pos->list, &__deferred_list);
+				spin_unlock_irqrestore(&__deferred_lock, flags);
+			}
+		}
+	} while(progress > 0);
+}
+
+static int deferred_match(const char * drv, const char * name)
+{
+	const char * p = strrchr(name, '.');
+	int l = strlen(drv);
+
+	if(p && isdigit(*(p + 1)))
+		return ((p - name) == l) && (strncmp(drv, name, l) == 0);
+	l = strlen(name);
+	return (strncmp(drv, name, l) == 0) && (drv[l] == '-');
+}
+
+bool_t probe_deferred_device(const char * name)
+{
+	struct deferred_node_t * pos, * n;
+	struct list_head head;
+	irq_flags_t flags;
+	int progress = 0;
+
+	if(!name || list_empty(&__deferred_list))
+		return FALSE;
+
+	init_list_head(&head);
+	spin_lock_irqsave(&__deferred_lock, flags);
+	list_for_each_entry_safe(pos, n, &__deferred_list, list)
+	{
+		if(pos->lazy && deferred_match(pos->n.name, name))
+			list_move_tail(&pos->list, &head);
+	}
+	spin_unlock_irqrestore(&__deferred_lock, flags);
+	if(list_empty(&head))
+		return FALSE;
+
+	list_for_each_entry_safe(pos, n, &head, list)
+	{
+		if(probe_dtnode(&pos->n))
+		{
+			deferred_del(pos);
+			progress++;
+		}
+		else
+		{
+			spin_lock_irqsave(&__deferred_lock, flags);
+			list_move_tail(&pos->list, &__deferred_list);
+			spin_unlock_irqrestore(&__deferred_lock, flags);
+		}
+	}
+	if(progress > 0)
+		retry_deferred_devices();
+	return (progress > 0) ? TRUE : FALSE;
+}
+
+static ssize_t driver_read_deferred(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct deferred_node_t * pos;
+	irq_flags_t flags;
+	int len = 0;
+
+	spin_lock_irqsave(&__deferred_lock, flags);
+	list_for_each_entry(pos, &__deferred_list, list)
+	{
+		if(len >= size)
+			break;
+		len += snprintf((char *)buf + len, size - len, "%-24s %s\r\n", pos->n.name, pos->lazy ? "lazy" : "retry");
+	}
+	spin_unlock_irqrestore(&__deferred_lock, flags);
+	return (len < size) ? len : size;
+}
+
+#if defined(CONFIG_DRIVER_PARALLEL_PROBE) && (CONFIG_DRIVER_PARALLEL_PROBE > 0)
+/*
+ * Parallel probe, the device tree is turned into a dependency graph:
+ *
+ * - core providers (clocks, resets, interrupts, gpios, regulators, dmas, timers)
+ *   are referenced by number, so they act as a barrier and keep file order.
+ * - nodes of the same driver keep file order, which keeps device names stable.
+ * - any string value that matches an earlier provider's 'name', or an earlier
+ *   driver's device name such as 'i2c-v3s.0', becomes an explicit dependency.
+ *
+ * Everything else is probed by worker tasks spread over all cpus.
+ */
+enum probe_state_t {
+	PROBE_STATE_PENDING	= 0,
+	PROBE_STATE_RUNNING	= 1,
+	PROBE_STATE_DONE	= 2,
+};
+
+struct probe_node_t {
+	struct dtnode_t n;
+	enum probe_state_t state;
+	int barrier;
+	int ndeps;
+	int * deps;
+};
+
+struct probe_context_t {
+	struct deferred_tree_t * tree;
+	struct probe_node_t * nodes;
+	int count;
+	int prefix;
+	int remain;
+	int workers;
+	spinlock_t lock;
+};
+
+static const char * core_prefix[] = {
+	"clk-", "reset-", "irq-", "gpio-", "regulator-", "dma-", "cs-", "ce-",
+};
+
+static int probe_is_core(const char * name)
+{
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(core_prefix); i++)
+	{
+		if(strncmp(name, core_prefix[i], strlen(core_prefix[i])) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static void probe_node_add_dep(struct probe_node_t * pn, void * v)
+{
+	int idx = (int)((unsigned long)v) - 1;
+	int * deps;
+	int i;
+
+	if(idx < 0)
+		return;
+	for(i = 0; i < pn->ndeps; i++)
+	{
+		if(pn->deps[i] == idx)
+			return;
+	}
+	deps = realloc(pn->deps, sizeof(int) * (pn->ndeps + 1));
+	if(deps)
+	{
+		deps[pn->ndeps++] = idx;
+		pn->deps = deps;
+	}
+}
+
+static void probe_node_scan_string(struct probe_node_t * pn, const char * s, int len, struct hmap_t * names, struct hmap_t * drivers)
+{
+	char buf[256];
+	char * p;
+
+	probe_node_add_dep(pn, hmap_search(names, s));
+	if((len < sizeof(buf)) && (p = strrchr(s, '.')) && isdigit(*(p + 1)))
+	{
+		memcpy(buf, s, p - s);
+		buf[p - s] = '\0';
+		probe_node_add_dep(pn, hmap_search(drivers, buf));
+	}
+}
+
+static const u8_t * probe_node_scan_blob(struct probe_node_t * pn, const void * blob, const u8_t * p, struct hmap_t * names, struct hmap_t * drivers)
+{
+	struct dtree_blob_value_t v;
+	const u8_t * e, * next;
+	const char * key;
+	int i;
+
+	next = dtree_blob_decode(blob, p, &v);
+	switch(v.type)
+	{
+	case JSON_OBJECT:
+		for(i = 0, e = v.u.data; i < v.length; i++)
+			e = probe_node_scan_blob(pn, blob, dtree_blob_member(blob, e, &key), names, drivers);
+		break;
+	case JSON_ARRAY:
+		for(i = 0, e = v.u.data; i < v.length; i++)
+			e = probe_node_scan_blob(pn, blob, e, names, drivers);
+		break;
+	case JSON_STRING:
+		probe_node_scan_string(pn, v.u.string, strlen(v.u.string), names, drivers);
+		break;
+	default:
+		break;
+	}
+	return next;
+}
+
+static void probe_node_scan(struct probe_node_t * pn, struct json_value_t * v, struct hmap_t * names, struct hmap_t * drivers)
+{
+	int i;
+
+	if(!v)
+		return;
+
+	switch(v->type)
+	{
+	case JSON_OBJECT:
+		for(i = 0; i < v->u.object.length; i++)
+			probe_node_scan(pn, v->u.object.values[i].value, names, drivers);
+		break;
+	case JSON_ARRAY:
+		for(i = 0; i < v->u.array.length; i++)
+			probe_node_scan(pn, v->u.array.values[i], names, drivers);
+		break;
+	case JSON_STRING:
+		probe_node_scan_string(pn, v->u.string.ptr, v->u.string.length, names, drivers);
+		break;
+	default:
+		break;
+	}
+}
+
+static int probe_context_pick(struct probe_context_t * ctx)
+{
+	struct probe_node_t * pn;
+	irq_flags_t flags;
+	int i, j;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	while((ctx->prefix < ctx->count) && (ctx->nodes[ctx->prefix].state == PROBE_STATE_DONE))
+		ctx->prefix++;
+	for(i = ctx->prefix; i < ctx->count; i++)
+	{
+		pn = &ctx->nodes[i];
+		if(pn->state != PROBE_STATE_PENDING)
+			continue;
+		if(pn->barrier && (i != ctx->prefix))
+			continue;
+		for(j = 0; j < pn->ndeps; j++)
+		{
+			if(ctx->nodes[pn->deps[j]].state != PROBE_STATE_DONE)
+				break;
+		}
+		if(j == pn->ndeps)
+		{
+			pn->state = PROBE_STATE_RUNNING;
+			spin_unlock_irqrestore(&ctx->lock, flags);
+			return i;
+		}
+	}
+	spin_unlock_irqrestore(&ctx->lock, flags);
+	return -1;
+}
+
+static void probe_context_run(struct probe_context_t * ctx)
+{
+	irq_flags_t flags;
+	int i;
+
+	while(ctx->remain > 0)
+	{
+		i = probe_context_pick(ctx);
+		if(i < 0)
+		{
+			task_yield();
+			continue;
+		}
+		if(!probe_dtnode(&ctx->nodes[i].n))
+			deferred_add(ctx->tree, &ctx->nodes[i].n, 0);
+		spin_lock_irqsave(&ctx->lock, flags);
+		ctx->nodes[i].state = PROBE_STATE_DONE;
+		ctx->remain--;
+		spin_unlock_irqrestore(&ctx->lock, flags);
+	}
+}
+
+static void probe_worker_task(struct task_t * task, void * data)
+{
+	struct probe_context_t * ctx = (struct probe_context_t *)data;
+	irq_flags_t flags;
+
+	probe_context_run(ctx);
+	spin_lock_irqsave(&ctx->lock, flags);
+	ctx->workers--;
+	spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+static void probe_device_parallel(struct deferred_tree_t * tree)
+{
+	struct probe_context_t ctx;
+	struct probe_node_t * pn;
+	struct hmap_t * names, * drivers;
+	struct task_t * task;
+	char * p, * name;
+	int lastcore = -1;
+	int i;
+
+	ctx.nodes = calloc(tree->count, sizeof(struct probe_node_t));
+	names = hmap_alloc(0);
+	drivers = hmap_alloc(0);
+	if(!ctx.nodes || !names || !drivers)
+	{
+		free(ctx.nodes);
+		hmap_free(names);
+		hmap_free(drivers);
+		return;
+	}
+	ctx.tree = tree;
+	ctx.count = 0;
+	for(i = 0; i < tree->count; i++)
+	{
+		pn = &ctx.nodes[ctx.count];
+		deferred_tree_node(tree, i, &pn->n);
+		p = dt_read_string(&pn->n, "status", "okay");
+		if(strcmp(p, "disabled") == 0)
+			continue;
+		if(strcmp(p, "lazy") == 0)
+		{
+			deferred_add(tree, &pn->n, 1);
+			continue;
+		}
+
+		pn->state = PROBE_STATE_PENDING;
+		if(probe_is_core(pn->n.name))
+		{
+			pn->barrier = 1;
+			lastcore = ctx.count;
+		}
+		else
+		{
+			probe_node_add_dep(pn, (void *)(unsigned long)(lastcore + 1));
+			probe_node_add_dep(pn, hmap_search(drivers, pn->n.name));
+			if(pn->n.blob)
+				probe_node_scan_blob(pn, pn->n.blob, pn->n.bvalue, names, drivers);
+			else
+				probe_node_scan(pn, pn->n.value, names, drivers);
+		}
+		if((name = dt_read_string(&pn->n, "name", NULL)))
+			hmap_add(names, name, (void *)(unsigned long)(ctx.count + 1));
+		hmap_add(drivers, pn->n.name, (void *)(unsigned long)(ctx.count + 1));
+		ctx.count++;
+	}
+	hmap_free(names);
+	hmap_free(drivers);
+
+	ctx.prefix = 0;
+	ctx.remain = ctx.count;
+	ctx.workers = 0;
+	spin_lock_init(&ctx.lock);
+
+	scheduler_smpboot();
+	for(i = 0; i < CONFIG_DRIVER_PARALLEL_PROBE; i++)
+	{
+		if((task = task_create(NULL, "probe", probe_worker_task, &ctx, 0, 0)))
+		{
+			ctx.workers++;
+			task_resume(task);
+		}
+	}
+	probe_context_run(&ctx);
+	while(ctx.workers > 0)
+		task_yield();
+
+	for(i = 0; i < ctx.count; i++)
+		free(ctx.nodes[i].deps);
+	free(ctx.nodes);
+}
+#endif
+
+void probe_device(const char * json, int length, const char * tips)
+{
+	struct deferred_tree_t * tree;
+	struct dtnode_t n;
+	char * p;
+	int i;
+
+	if(json && (length > 0))
+	{
+		tree = deferred_tree_alloc(json, length, tips);
+		if(!tree)
+			return;
+#if defined(CONFIG_DRIVER_PARALLEL_PROBE) && (CONFIG_DRIVER_PARALLEL_PROBE > 0)
+		if(task_self())
+		{
+			probe_device_parallel(tree);
+			retry_deferred_devices();
+			deferred_tree_put(tree);
+			return;
+		}
+#endif
+		for(i = 0; i < tree->count; i++)
+		{
+			deferred_tree_node(tree, i, &n);
+			p = dt_read_string(&n, "status", "okay");
+			if(strcmp(p, "lazy") == 0)
+				deferred_add(tree, &n, 1);
+			else if(strcmp(p, "disabled") != 0)
+			{
+				if(!probe_dtnode(&n))
+					deferred_add(tree, &n, 0);
+			}
+		}
+		retry_deferred_devices();
+		deferred_tree_put(tree);
 	}
 }
 
@@ -188,3 +765,21 @@ static __init void driver_pure_init(void)
 		init_hlist_head(&__driver_hash[i]);
 }
 pure_initcall(driver_pure_init);
+
+static __init void driver_late_init(void)
+{
+	struct deferred_node_t * pos, * n;
+
+	kobj_add_regular(search_class_driver_kobj(), "deferred", driver_read_deferred, NULL, NULL);
+	retry_deferred_devices();
+	__deferred_final = 1;
+	list_for_each_entry_safe(pos, n, &__deferred_list, list)
+	{
+		if(!pos->lazy)
+		{
+			LOG("Give up probing device with %s", pos->n.name);
+			deferred_del(pos);
+		}
+	}
+}
+late_initcall(driver_late_init);
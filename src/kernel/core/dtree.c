@@ -29,6 +29,237 @@
 #include <xboot.h>
 #include <xboot/dtree.h>
 
+static inline const u8_t * dtree_varint(const u8_t * p, u64_t * v)
+{
+	u64_t r = 0;
+	int s = 0;
+
+	do {
+		r |= (u64_t)(*p & 0x7f) << s;
+		s += 7;
+	} while(*p++ & 0x80);
+	*v = r;
+	return p;
+}
+
+static inline u32_t dtree_index(const u8_t * t, int w, u64_t i)
+{
+	t += i * w;
+	if(w == 2)
+		return (t[1] << 8) | (t[0] << 0);
+	return ((u32_t)t[3] << 24) | (t[2] << 16) | (t[1] << 8) | (t[0] << 0);
+}
+
+static const u8_t * dtree_check_varint(const u8_t * p, const u8_t * e, u64_t * v)
+{
+	int i;
+
+	for(i = 0; (i < 10) && (p + i < e); i++)
+	{
+		if(!(p[i] & 0x80))
+			return dtree_varint(p, v);
+	}
+	return NULL;
+}
+
+static const u8_t * dtree_check_value(const struct dtree_blob_header_t * h, const u8_t * p, const u8_t * e, int depth)
+{
+	const u8_t * end, * t = NULL, * base;
+	const char * key, * prev = NULL;
+	u64_t count, len, x, i;
+	int type, w = 0;
+
+	if((p >= e) || (depth > 32))
+		return NULL;
+	type = *p++;
+	switch(type)
+	{
+	case JSON_OBJECT:
+	case JSON_ARRAY:
+		if(!(p = dtree_check_varint(p, e, &count)) || !(p = dtree_check_varint(p, e, &len)) || (len > (u64_t)(e - p)) || (count > len))
+			return NULL;
+		if(type == JSON_OBJECT)
+		{
+			w = DTREE_BLOB_INDEX_WIDTH(len);
+			if(count * w > (u64_t)(e - p) - len)
+				return NULL;
+			t = p;
+			p += count * w;
+		}
+		base = p;
+		end = p + len;
+		for(i = 0; i < count; i++)
+		{
+			if(type == JSON_OBJECT)
+			{
+				/* The offset table must point at each member, in key order */
+				if((dtree_index(t, w, i) != (u64_t)(p - base)) || !(p = dtree_check_varint(p, end, &x)) || (x >= h->nstring))
+					return NULL;
+				key = (const char *)h + h->string + x;
+				if(prev && (strcmp(prev, key) > 0))
+					return NULL;
+				prev = key;
+			}
+			if(!(p = dtree_check_value(h, p, end, depth + 1)))
+				return NULL;
+		}
+		return (p == end) ? end : NULL;
+	case JSON_INTEGER:
+		return dtree_check_varint(p, e, &x);
+	case JSON_DOUBLE:
+		return (e - p >= sizeof(double)) ? p + sizeof(double) : NULL;
+	case JSON_STRING:
+		if(!(p = dtree_check_varint(p, e, &x)) || (x >= h->nstring))
+			return NULL;
+		return p;
+	case JSON_BOOLEAN:
+		return (p < e) ? p + 1 : NULL;
+	case JSON_NONE:
+	case JSON_NULL:
+		return p;
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Walk the whole blob once with bounds checks, the readers below trust it
+ */
+int dtree_blob_check(const void * blob, int length)
+{
+	const struct dtree_blob_header_t * h = (const struct dtree_blob_header_t *)blob;
+	const u8_t * p, * e;
+	u64_t x;
+	u32_t i;
+
+	if(!blob || (length < (int)sizeof(struct dtree_blob_header_t)))
+		return 0;
+	if((h->magic != DTREE_BLOB_MAGIC) || (h->version != DTREE_BLOB_VERSION) || (h->size > (u32_t)length))
+		return 0;
+	if((h->string > h->size) || (h->nstring > h->size - h->string) || (h->node > h->size))
+		return 0;
+	if((h->nstring > 0) && (((const char *)blob)[h->string + h->nstring - 1] != '\0'))
+		return 0;
+	p = (const u8_t *)blob + h->node;
+	e = (const u8_t *)blob + h->size;
+	for(i = 0; i < h->nnode; i++)
+	{
+		if(!(p = dtree_check_varint(p, e, &x)) || (x >= h->nstring))
+			return 0;
+		if(!(p = dtree_check_varint(p, e, &x)))
+			return 0;
+		if(!(p = dtree_check_value(h, p, e, 0)))
+			return 0;
+	}
+	return 1;
+}
+
+const u8_t * dtree_blob_decode(const void * blob, const u8_t * p, struct dtree_blob_value_t * v)
+{
+	const struct dtree_blob_header_t * h = (const struct dtree_blob_header_t *)blob;
+	u64_t x, len;
+
+	v->type = *p++;
+	v->length = 0;
+	switch(v->type)
+	{
+	case JSON_OBJECT:
+	case JSON_ARRAY:
+		p = dtree_varint(p, &x);
+		p = dtree_varint(p, &len);
+		if(v->type == JSON_OBJECT)
+			p += x * DTREE_BLOB_INDEX_WIDTH(len);
+		v->length = x;
+		v->u.data = p;
+		return p + len;
+	case JSON_INTEGER:
+		p = dtree_varint(p, &x);
+		v->u.integer = (s64_t)(x >> 1) ^ -(s64_t)(x & 1);
+		return p;
+	case JSON_DOUBLE:
+		memcpy(&v->u.dbl, p, sizeof(double));
+		return p + sizeof(double);
+	case JSON_STRING:
+		p = dtree_varint(p, &x);
+		v->u.string = (const char *)blob + h->string + x;
+		return p;
+	case JSON_BOOLEAN:
+		v->u.boolean = *p;
+		return p + 1;
+	default:
+		return p;
+	}
+}
+
+const u8_t * dtree_blob_member(const void * blob, const u8_t * p, const char ** key)
+{
+	const struct dtree_blob_header_t * h = (const struct dtree_blob_header_t *)blob;
+	u64_t x;
+
+	p = dtree_varint(p, &x);
+	*key = (const char *)blob + h->string + x;
+	return p;
+}
+
+const u8_t * dtree_blob_node(const void * blob, const u8_t * p, const char ** name, u64_t * addr)
+{
+	p = dtree_blob_member(blob, p, name);
+	return dtree_varint(p, addr);
+}
+
+/*
+ * Members are sorted by key, binary search them through the offset table
+ */
+static const u8_t * dt_blob_search(struct dtnode_t * n, const char * name, struct dtree_blob_value_t * v)
+{
+	const u8_t * p, * t, * q;
+	const char * key;
+	u64_t count, len;
+	int lo, hi, mid, c, w;
+
+	if(!n->bvalue || !name || (*n->bvalue != JSON_OBJECT))
+		return NULL;
+	p = dtree_varint(n->bvalue + 1, &count);
+	p = dtree_varint(p, &len);
+	w = DTREE_BLOB_INDEX_WIDTH(len);
+	t = p;
+	p += count * w;
+	lo = 0;
+	hi = count;
+	while(lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		q = dtree_blob_member(n->blob, p + dtree_index(t, w, mid), &key);
+		c = strcmp(key, name);
+		if(c == 0)
+		{
+			dtree_blob_decode(n->blob, q, v);
+			return q;
+		}
+		else if(c < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+static const u8_t * dt_blob_array(struct dtnode_t * n, const char * name, int idx, struct dtree_blob_value_t * v)
+{
+	struct dtree_blob_value_t a;
+	const u8_t * p, * q = NULL;
+	int i;
+
+	if(!dt_blob_search(n, name, &a) || (a.type != JSON_ARRAY) || (idx < 0) || (idx >= a.length))
+		return NULL;
+	for(i = 0, p = a.u.data; i <= idx; i++)
+	{
+		q = p;
+		p = dtree_blob_decode(n->blob, p, v);
+	}
+	return q;
+}
+
 const char * dt_read_name(struct dtnode_t * n)
 {
 	return n ? n->name : NULL;
@@ -46,9 +277,17 @@ physical_addr_t dt_read_address(struct dtnode_t * n)
 
 int dt_read_bool(struct dtnode_t * n, const char * name, int def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_BOOLEAN))
+			return b.u.boolean ? 1 : 0;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -66,9 +305,17 @@ int dt_read_bool(struct dtnode_t * n, const char * name, int def)
 
 int dt_read_int(struct dtnode_t * n, const char * name, int def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_INTEGER))
+			return (int)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -86,9 +333,17 @@ int dt_read_int(struct dtnode_t * n, const char * name, int def)
 
 long long dt_read_long(struct dtnode_t * n, const char * name, long long def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_INTEGER))
+			return (long long)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -106,9 +361,17 @@ long long dt_read_long(struct dtnode_t * n, const char * name, long long def)
 
 double dt_read_double(struct dtnode_t * n, const char * name, double def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_DOUBLE))
+			return (double)b.u.dbl;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -126,9 +389,17 @@ double dt_read_double(struct dtnode_t * n, const char * name, double def)
 
 char * dt_read_string(struct dtnode_t * n, const char * name, char * def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_STRING))
+			return (char *)b.u.string;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -146,9 +417,17 @@ char * dt_read_string(struct dtnode_t * n, const char * name, char * def)
 
 u8_t dt_read_u8(struct dtnode_t * n, const char * name, u8_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_INTEGER))
+			return (u8_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -166,9 +445,17 @@ u8_t dt_read_u8(struct dtnode_t * n, const char * name, u8_t def)
 
 u16_t dt_read_u16(struct dtnode_t * n, const char * name, u16_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_INTEGER))
+			return (u16_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -186,9 +473,17 @@ u16_t dt_read_u16(struct dtnode_t * n, const char * name, u16_t def)
 
 u32_t dt_read_u32(struct dtnode_t * n, const char * name, u32_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_INTEGER))
+			return (u32_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -206,9 +501,17 @@ u32_t dt_read_u32(struct dtnode_t * n, const char * name, u32_t def)
 
 u64_t dt_read_u64(struct dtnode_t * n, const char * name, u64_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_INTEGER))
+			return (u64_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -226,9 +529,26 @@ u64_t dt_read_u64(struct dtnode_t * n, const char * name, u64_t def)
 
 struct dtnode_t * dt_read_object(struct dtnode_t * n, const char * name, struct dtnode_t * o)
 {
+	struct dtree_blob_value_t b;
+	const u8_t * p;
 	struct json_value_t * v;
 	int i;
 
+	if(o && n && n->blob)
+	{
+		p = dt_blob_search(n, name, &b);
+		if(p && (b.type == JSON_OBJECT))
+		{
+			o->name = name;
+			o->addr = 0;
+			o->value = NULL;
+			o->blob = n->blob;
+			o->bvalue = p;
+			return o;
+		}
+		return NULL;
+	}
+
 	if(o && n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -241,6 +561,8 @@ struct dtnode_t * dt_read_object(struct dtnode_t * n, const char * name, struct
 					o->name = name;
 					o->addr = 0;
 					o->value = v;
+					o->blob = NULL;
+					o->bvalue = NULL;
 					return o;
 				}
 			}
@@ -251,9 +573,17 @@ struct dtnode_t * dt_read_object(struct dtnode_t * n, const char * name, struct
 
 int dt_read_array_length(struct dtnode_t * n, const char * name)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_search(n, name, &b) && (b.type == JSON_ARRAY))
+			return b.length;
+		return 0;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -271,9 +601,17 @@ int dt_read_array_length(struct dtnode_t * n, const char * name)
 
 int dt_read_array_bool(struct dtnode_t * n, const char * name, int idx, int def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_BOOLEAN))
+			return b.u.boolean ? 1 : 0;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -298,9 +636,17 @@ int dt_read_array_bool(struct dtnode_t * n, const char * name, int idx, int def)
 
 int dt_read_array_int(struct dtnode_t * n, const char * name, int idx, int def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_INTEGER))
+			return (int)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -325,9 +671,17 @@ int dt_read_array_int(struct dtnode_t * n, const char * name, int idx, int def)
 
 long long dt_read_array_long(struct dtnode_t * n, const char * name, int idx, long long def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_INTEGER))
+			return (long long)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -352,9 +706,17 @@ long long dt_read_array_long(struct dtnode_t * n, const char * name, int idx, lo
 
 double dt_read_array_double(struct dtnode_t * n, const char * name, int idx, double def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_DOUBLE))
+			return (double)b.u.dbl;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -379,9 +741,17 @@ double dt_read_array_double(struct dtnode_t * n, const char * name, int idx, dou
 
 char * dt_read_array_string(struct dtnode_t * n, const char * name, int idx, char * def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_STRING))
+			return (char *)b.u.string;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -406,9 +776,17 @@ char * dt_read_array_string(struct dtnode_t * n, const char * name, int idx, cha
 
 u8_t dt_read_array_u8(struct dtnode_t * n, const char * name, int idx, u8_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_INTEGER))
+			return (u8_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -433,9 +811,17 @@ u8_t dt_read_array_u8(struct dtnode_t * n, const char * name, int idx, u8_t def)
 
 u16_t dt_read_array_u16(struct dtnode_t * n, const char * name, int idx, u16_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_INTEGER))
+			return (u16_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -460,9 +846,17 @@ u16_t dt_read_array_u16(struct dtnode_t * n, const char * name, int idx, u16_t d
 
 u32_t dt_read_array_u32(struct dtnode_t * n, const char * name, int idx, u32_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_INTEGER))
+			return (u32_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -487,9 +881,17 @@ u32_t dt_read_array_u32(struct dtnode_t * n, const char * name, int idx, u32_t d
 
 u64_t dt_read_array_u64(struct dtnode_t * n, const char * name, int idx, u64_t def)
 {
+	struct dtree_blob_value_t b;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(n && n->blob)
+	{
+		if(dt_blob_array(n, name, idx, &b) && (b.type == JSON_INTEGER))
+			return (u64_t)b.u.integer;
+		return def;
+	}
+
 	if(n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -514,9 +916,26 @@ u64_t dt_read_array_u64(struct dtnode_t * n, const char * name, int idx, u64_t d
 
 struct dtnode_t * dt_read_array_object(struct dtnode_t * n, const char * name, int idx, struct dtnode_t * o)
 {
+	struct dtree_blob_value_t b;
+	const u8_t * p;
 	struct json_value_t * v, * e;
 	int i;
 
+	if(o && n && n->blob)
+	{
+		p = dt_blob_array(n, name, idx, &b);
+		if(p && (b.type == JSON_OBJECT))
+		{
+			o->name = 0;
+			o->addr = 0;
+			o->value = NULL;
+			o->blob = n->blob;
+			o->bvalue = p;
+			return o;
+		}
+		return NULL;
+	}
+
 	if(o && n && n->value && (n->value->type == JSON_OBJECT))
 	{
 		for(i = 0; i < n->value->u.object.length; i++)
@@ -534,6 +953,8 @@ struct dtnode_t * dt_read_array_object(struct dtnode_t * n, const char * name, i
 							o->name = 0;
 							o->addr = 0;
 							o->value = e;
+							o->blob = NULL;
+							o->bvalue = NULL;
 							return o;
 						}
 					}
@@ -29,19 +29,22 @@
 #include <xboot.h>
 #include <xboot/initcall.h>
 
-extern initcall_t __initcall_start[];
-extern initcall_t __initcall_end[];
+extern struct initcall_entry_t __initcall_start[];
+extern struct initcall_entry_t __initcall_end[];
 extern exitcall_t __exitcall_start[];
 extern exitcall_t __exitcall_end[];
 
 void do_initcalls(void)
 {
-	initcall_t * call;
+	struct initcall_entry_t * call;
+	ktime_t begin;
 
 	call =  &(*__initcall_start);
 	while(call < &(*__initcall_end))
 	{
-		(*call)();
+		begin = ktime_get();
+		call->fn();
+		boottime_record("initcall", call->name, begin, ktime_get());
 		call++;
 	}
 }
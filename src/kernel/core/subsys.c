@@ -53,17 +53,19 @@ static void subsys_init_rootfs(void)
 
 static void subsys_init_dtree(void)
 {
+	const char * ext[] = { "dtb", "json" };
 	struct vfs_stat_t st;
 	char path[VFS_MAX_PATH];
 	char * json;
-	int fd, n, len = 0;
+	int fd, n, i, len = 0;
 
-	sprintf(path, "/boot/%s.json", get_machine()->name);
-	if(vfs_stat(path, &st) < 0)
-		return;
-	if(!S_ISREG(st.st_mode))
-		return;
-	if(st.st_size <= 0)
+	for(i = 0; i < ARRAY_SIZE(ext); i++)
+	{
+		sprintf(path, "/boot/%s.%s", get_machine()->name, ext[i]);
+		if((vfs_stat(path, &st) >= 0) && S_ISREG(st.st_mode) && (st.st_size > 0))
+			break;
+	}
+	if(i >= ARRAY_SIZE(ext))
 		return;
 
 	json = malloc(st.st_size + 1);
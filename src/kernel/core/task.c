@@ -421,9 +421,24 @@ static void smpboot_entry_func(void)
 	}
 }
 
+/*
+ * Boot secondary cpus once, as soon as the machine is known. This is normally
+ * done by scheduler_loop, but may be called earlier by boot code running in a task.
+ */
+void scheduler_smpboot(void)
+{
+	static int booted = 0;
+
+	if(!booted && get_machine())
+	{
+		booted = 1;
+		machine_smpboot(smpboot_entry_func);
+	}
+}
+
 void scheduler_loop(void)
 {
-	machine_smpboot(smpboot_entry_func);
+	scheduler_smpboot();
 
 	struct scheduler_t * sched = scheduler_self();
 	struct task_t * task = task_create(sched, "idle", idle_task, (void *)(unsigned long)smp_processor_id(), SZ_8K, 0);
@@ -26,6 +26,8 @@
  *
  */
 
+#include <xboot.h>
+#include <vfs/vfs.h>
 #include <graphic/font.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -42,15 +44,228 @@ static struct font_description_t fdesc[] = {
 	{"roboto-bold-italic",	"/framework/assets/fonts/Roboto-BoldItalic.ttf"},
 };
 
+/*
+ * Per family cache of codepoint to (face, glyph) lookups, direct mapped by
+ * codepoint. It is dropped whenever a family is installed or uninstalled.
+ */
+struct font_lookup_t {
+	u32_t code;
+	int glyph;
+	void * face;
+};
+
+static void lookup_free_callback(const char * key, void * value)
+{
+	free(value);
+}
+
+static void font_lookup_clear(struct font_context_t * ctx)
+{
+	hmap_walk(ctx->lookup, lookup_free_callback);
+	hmap_clear(ctx->lookup);
+}
+
+static struct font_lookup_t * font_lookup_slot(struct font_context_t * ctx, const char * family, u32_t code)
+{
+	struct font_lookup_t * l;
+	int i;
+
+	if(!ctx->lookup)
+		return NULL;
+	l = hmap_search(ctx->lookup, family);
+	if(!l)
+	{
+		l = malloc(sizeof(struct font_lookup_t) * CONFIG_FONT_LOOKUP_CACHE_SIZE);
+		if(!l)
+			return NULL;
+		for(i = 0; i < CONFIG_FONT_LOOKUP_CACHE_SIZE; i++)
+		{
+			l[i].code = 0xffffffff;
+			l[i].glyph = 0;
+			l[i].face = NULL;
+		}
+		hmap_add(ctx->lookup, family, l);
+	}
+	return &l[code % CONFIG_FONT_LOOKUP_CACHE_SIZE];
+}
+
+/*
+ * Rasterized glyphs keyed by (face, size, glyph index, transform, subpixel
+ * offset), each entry holds the metrics and the coverage bitmap in a single
+ * allocation. Entries sit on one lru list under a memory budget and a returned
+ * entry stays valid until the next lookup on the same context. Metrics only
+ * entries have a subpixel of -1 and no bitmap.
+ */
+static inline struct hlist_head * font_glyph_hash(struct font_context_t * ctx, struct font_glyph_t * key)
+{
+	unsigned long h = (((unsigned long)key->face) >> 4) ^ ((unsigned long)key->size << 16) ^ ((unsigned long)(key->subpixel + 1) << 24) ^ key->glyph ^ key->xx ^ key->yy;
+	return &ctx->hash[h % CONFIG_FONT_GLYPH_HASH_SIZE];
+}
+
+static struct font_glyph_t * font_glyph_search(struct font_context_t * ctx, struct font_glyph_t * key)
+{
+	struct font_glyph_t * pos;
+
+	hlist_for_each_entry(pos, font_glyph_hash(ctx, key), node)
+	{
+		if((pos->face == key->face) && (pos->size == key->size) && (pos->glyph == key->glyph) && (pos->subpixel == key->subpixel)
+			&& (pos->xx == key->xx) && (pos->xy == key->xy) && (pos->yx == key->yx) && (pos->yy == key->yy))
+		{
+			list_move(&pos->entry, &ctx->lru);
+			return pos;
+		}
+	}
+	return NULL;
+}
+
+static void font_glyph_release(struct font_context_t * ctx, struct font_glyph_t * g)
+{
+	hlist_del(&g->node);
+	list_del(&g->entry);
+	ctx->used -= sizeof(struct font_glyph_t) + g->width * g->height;
+	free(g);
+}
+
+static void font_glyph_purge(struct font_context_t * ctx, void * face)
+{
+	struct font_glyph_t * pos, * n;
+
+	list_for_each_entry_safe(pos, n, &ctx->lru, entry)
+	{
+		if(!face || (pos->face == face))
+			font_glyph_release(ctx, pos);
+	}
+}
+
+static struct font_glyph_t * font_glyph_alloc(struct font_context_t * ctx, struct font_glyph_t * key, FT_GlyphSlot slot, int width, int height)
+{
+	struct font_glyph_t * g;
+	size_t need = sizeof(struct font_glyph_t) + width * height;
+
+	while((ctx->used + need > ctx->budget) && !list_empty(&ctx->lru))
+		font_glyph_release(ctx, list_last_entry(&ctx->lru, struct font_glyph_t, entry));
+	g = malloc(need);
+	if(!g)
+		return NULL;
+	g->face = key->face;
+	g->size = key->size;
+	g->glyph = key->glyph;
+	g->subpixel = key->subpixel;
+	g->xx = key->xx;
+	g->xy = key->xy;
+	g->yx = key->yx;
+	g->yy = key->yy;
+	g->hadvance = slot->metrics.horiAdvance;
+	g->vadvance = slot->metrics.vertAdvance;
+	g->hbearingx = slot->metrics.horiBearingX;
+	g->hbearingy = slot->metrics.horiBearingY;
+	g->ax = slot->advance.x;
+	g->ay = slot->advance.y;
+	g->left = slot->bitmap_left;
+	g->top = slot->bitmap_top;
+	g->width = width;
+	g->height = height;
+	g->bitmap = (width * height > 0) ? (u8_t *)(g + 1) : NULL;
+	init_hlist_node(&g->node);
+	hlist_add_head(&g->node, font_glyph_hash(ctx, g));
+	list_add(&g->entry, &ctx->lru);
+	ctx->used += need;
+	return g;
+}
+
+struct font_glyph_t * font_glyph_metrics(struct font_context_t * ctx, void * face, int size, int glyph)
+{
+	struct font_glyph_t key, * g;
+	FT_Face f = (FT_Face)face;
+
+	if(!ctx || !face)
+		return NULL;
+
+	key.face = face;
+	key.size = size;
+	key.glyph = glyph;
+	key.subpixel = -1;
+	key.xx = key.xy = key.yx = key.yy = 0;
+	g = font_glyph_search(ctx, &key);
+	if(g)
+		return g;
+
+	FT_Set_Pixel_Sizes(f, size, size);
+	if(FT_Load_Glyph(f, glyph, FT_LOAD_BITMAP_METRICS_ONLY) != 0)
+		return NULL;
+	return font_glyph_alloc(ctx, &key, f->glyph, 0, 0);
+}
+
+/*
+ * The fraction of the pen position in 26.6 is rounded down to a quarter pixel
+ * in each direction, the bitmap is placed relative to the integer pen position
+ */
+struct font_glyph_t * font_glyph_render(struct font_context_t * ctx, void * face, int size, int glyph, struct matrix_t * m, int fx, int fy)
+{
+	struct font_glyph_t key, * g;
+	FT_Face f = (FT_Face)face;
+	FT_Bitmap * bitmap;
+	FT_Matrix matrix;
+	FT_Vector delta;
+	int i;
+
+	if(!ctx || !face)
+		return NULL;
+
+	key.face = face;
+	key.size = size;
+	key.glyph = glyph;
+	key.subpixel = ((fx & 0x3f) >> 4) | (((fy & 0x3f) >> 4) << 2);
+	key.xx = (FT_Fixed)(m->a * 65536.0);
+	key.xy = -((FT_Fixed)(m->c * 65536.0));
+	key.yx = -((FT_Fixed)(m->b * 65536.0));
+	key.yy = (FT_Fixed)(m->d * 65536.0);
+	g = font_glyph_search(ctx, &key);
+	if(g)
+		return g;
+
+	matrix.xx = key.xx;
+	matrix.xy = key.xy;
+	matrix.yx = key.yx;
+	matrix.yy = key.yy;
+	delta.x = (key.subpixel & 0x3) << 4;
+	delta.y = (key.subpixel >> 2) << 4;
+	FT_Set_Pixel_Sizes(f, size, size);
+	FT_Set_Transform(f, &matrix, &delta);
+	if(FT_Load_Glyph(f, glyph, FT_LOAD_RENDER) != 0)
+		return NULL;
+	bitmap = &f->glyph->bitmap;
+	g = font_glyph_alloc(ctx, &key, f->glyph, bitmap->width, bitmap->rows);
+	if(g && g->bitmap)
+	{
+		for(i = 0; i < g->height; i++)
+			memcpy(&g->bitmap[i * g->width], &bitmap->buffer[i * bitmap->pitch], g->width);
+	}
+	return g;
+}
+
 struct font_context_t * font_context_alloc(void)
 {
 	struct font_context_t * ctx;
+	int i;
 
 	ctx = malloc(sizeof(struct font_context_t));
 	if(!ctx)
 		return NULL;
+	ctx->hash = malloc(sizeof(struct hlist_head) * CONFIG_FONT_GLYPH_HASH_SIZE);
+	if(!ctx->hash)
+	{
+		free(ctx);
+		return NULL;
+	}
+	for(i = 0; i < CONFIG_FONT_GLYPH_HASH_SIZE; i++)
+		init_hlist_head(&ctx->hash[i]);
+	init_list_head(&ctx->lru);
+	ctx->budget = CONFIG_FONT_GLYPH_CACHE_SIZE;
+	ctx->used = 0;
 	FT_Init_FreeType((FT_Library *)&ctx->library);
 	ctx->map = hmap_alloc(0);
+	ctx->lookup = hmap_alloc(0);
 	return ctx;
 }
 
@@ -64,22 +279,67 @@ void font_context_free(struct font_context_t * ctx)
 {
 	if(ctx)
 	{
+		font_glyph_purge(ctx, NULL);
+		free(ctx->hash);
+		font_lookup_clear(ctx);
+		hmap_free(ctx->lookup);
 		hmap_walk(ctx->map, face_done_callback);
 		hmap_free(ctx->map);
 		FT_Done_FreeType((FT_Library)ctx->library);
 	}
 }
 
+static void ft_vfs_face_finalizer(void * object)
+{
+	FT_Face face = (FT_Face)object;
+
+	vfs_munmap(face->generic.data);
+}
+
+/*
+ * Faces on memory resident filesystems are used in place, the mapping lives
+ * as long as the face. Anything else is read through a stream, so the face
+ * doesn't hold a heap copy of the whole file.
+ */
+static FT_Error ft_new_vfs_face(FT_Library library, const char * pathname, FT_Long index, FT_Face * face)
+{
+	struct vfs_stat_t st;
+	FT_Error err;
+	void * addr = NULL;
+	int fd;
+
+	fd = vfs_open(pathname, O_RDONLY, 0);
+	if(fd >= 0)
+	{
+		if(vfs_fstat(fd, &st) >= 0)
+			addr = vfs_mmap_direct(fd, 0, st.st_size);
+		vfs_close(fd);
+	}
+	if(!addr)
+		return FT_New_Face(library, pathname, index, face);
+
+	err = FT_New_Memory_Face(library, addr, st.st_size, index, face);
+	if(err)
+	{
+		vfs_munmap(addr);
+		return err;
+	}
+	(*face)->generic.data = addr;
+	(*face)->generic.finalizer = ft_vfs_face_finalizer;
+	return 0;
+}
+
 void font_install(struct font_context_t * ctx, const char * family, const char * path)
 {
 	FT_Face face;
 
 	if(ctx && family && path && !hmap_search(ctx->map, family))
 	{
-		if(FT_New_Face((FT_Library)ctx->library, path, 0, &face) == 0)
+		if(ft_new_vfs_face((FT_Library)ctx->library, path, 0, &face) == 0)
 		{
 			FT_Select_Charmap(face, FT_ENCODING_UNICODE);
 			hmap_add(ctx->map, family, face);
+			font_lookup_clear(ctx);
 		}
 	}
 }
@@ -139,12 +399,53 @@ static FT_Stream ft_new_xfs_stream(struct xfs_context_t * xfs, const char * path
     return stream;
 }
 
+struct ft_xfs_map_t {
+	struct xfs_file_t * file;
+	void * addr;
+};
+
+static void ft_xfs_face_finalizer(void * object)
+{
+	FT_Face face = (FT_Face)object;
+	struct ft_xfs_map_t * map = (struct ft_xfs_map_t *)face->generic.data;
+
+	xfs_munmap(map->file, map->addr);
+	xfs_close(map->file);
+	free(map);
+}
+
 static FT_Error ft_new_xfs_face(struct xfs_context_t * xfs, FT_Library library, const char * pathname, FT_Long index, FT_Face * face)
 {
+	struct ft_xfs_map_t * map;
 	FT_Open_Args args;
+	s64_t len;
 
 	if(!pathname)
 		return -1;
+
+	map = malloc(sizeof(struct ft_xfs_map_t));
+	if(map)
+	{
+		map->file = xfs_open_read(xfs, pathname);
+		if(map->file)
+		{
+			len = xfs_length(map->file);
+			map->addr = xfs_mmap_direct(map->file, 0, len);
+			if(map->addr)
+			{
+				if(FT_New_Memory_Face(library, map->addr, len, index, face) == 0)
+				{
+					(*face)->generic.data = map;
+					(*face)->generic.finalizer = ft_xfs_face_finalizer;
+					return 0;
+				}
+				xfs_munmap(map->file, map->addr);
+			}
+			xfs_close(map->file);
+		}
+		free(map);
+	}
+
 	args.flags = FT_OPEN_STREAM;
 	args.pathname = (char *)pathname;
 	args.stream = ft_new_xfs_stream(xfs, pathname);
@@ -161,6 +462,7 @@ void font_install_from_xfs(struct font_context_t * ctx, struct xfs_context_t * x
 		{
 			FT_Select_Charmap(face, FT_ENCODING_UNICODE);
 			hmap_add(ctx->map, family, face);
+			font_lookup_clear(ctx);
 		}
 	}
 }
@@ -173,7 +475,12 @@ void font_uninstall(struct font_context_t * ctx, const char * family)
 	{
 		face = hmap_search(ctx->map, family);
 		if(face)
+		{
+			font_glyph_purge(ctx, face);
+			font_lookup_clear(ctx);
+			hmap_remove(ctx->map, family);
 			FT_Done_Face(face);
+		}
 	}
 }
 
@@ -189,7 +496,7 @@ static void * search_face(struct font_context_t * ctx, const char * family)
 	{
 		if(strcmp(family, fdesc[i].family) == 0)
 		{
-			if(FT_New_Face((FT_Library)ctx->library, fdesc[i].path, 0, &face) == 0)
+			if(ft_new_vfs_face((FT_Library)ctx->library, fdesc[i].path, 0, &face) == 0)
 			{
 				FT_Select_Charmap(face, FT_ENCODING_UNICODE);
 				hmap_add(ctx->map, family, face);
@@ -200,14 +507,14 @@ static void * search_face(struct font_context_t * ctx, const char * family)
 	return NULL;
 }
 
-int search_glyph(struct font_context_t * ctx, const char * family, u32_t code, void ** face)
+static int search_glyph_uncached(struct font_context_t * ctx, const char * family, u32_t code, void ** face)
 {
 	char buffer[SZ_512];
 	char * r, * p;
 	int glyph;
 	int i;
 
-	strlcpy(buffer, family ? family : "", sizeof(buffer));
+	strlcpy(buffer, family, sizeof(buffer));
 	p = buffer;
 	while((r = strsep(&p, ",;:|")) != NULL)
 	{
@@ -223,3 +530,26 @@ int search_glyph(struct font_context_t * ctx, const char * family, u32_t code, v
 	}
 	return 0;
 }
+
+int search_glyph(struct font_context_t * ctx, const char * family, u32_t code, void ** face)
+{
+	struct font_lookup_t * l;
+	int glyph;
+
+	if(!family)
+		family = "";
+	l = font_lookup_slot(ctx, family, code);
+	if(l && (l->code == code))
+	{
+		*face = l->face;
+		return l->glyph;
+	}
+	glyph = search_glyph_uncached(ctx, family, code, face);
+	if(l)
+	{
+		l->code = code;
+		l->glyph = glyph;
+		l->face = *face;
+	}
+	return glyph;
+}
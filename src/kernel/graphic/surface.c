@@ -531,6 +531,25 @@ static void png_xfs_read_data(png_structp png, png_bytep data, size_t length)
 		png_error(png, "Read Error");
 }
 
+struct png_mem_t {
+	const png_byte * buf;
+	size_t size;
+	size_t pos;
+};
+
+static void png_mem_read_data(png_structp png, png_bytep data, size_t length)
+{
+	struct png_mem_t * mem;
+
+	if(png == NULL)
+		return;
+	mem = (struct png_mem_t *)png->io_ptr;
+	if(length > mem->size - mem->pos)
+		png_error(png, "Read Error");
+	memcpy(data, mem->buf + mem->pos, length);
+	mem->pos += length;
+}
+
 static inline int multiply_alpha(int alpha, int color)
 {
 	int temp = (alpha * color) + 0x80;
@@ -597,13 +616,18 @@ static inline struct surface_t * surface_alloc_from_xfs_png(struct xfs_context_t
 	int depth, color_type, interlace, stride;
 	unsigned int i;
 	struct xfs_file_t * file;
+	struct png_mem_t mem;
 
 	if(!(file = xfs_open_read(ctx, filename)))
 		return NULL;
+	mem.size = xfs_length(file);
+	mem.buf = xfs_mmap(file, 0, mem.size);
+	mem.pos = 0;
 
 	png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if(!png)
 	{
+		xfs_munmap(file, (void *)mem.buf);
 		xfs_close(file);
 		return NULL;
 	}
@@ -611,17 +635,22 @@ static inline struct surface_t * surface_alloc_from_xfs_png(struct xfs_context_t
 	info = png_create_info_struct(png);
 	if(!info)
 	{
+		xfs_munmap(file, (void *)mem.buf);
 		xfs_close(file);
 		png_destroy_read_struct(&png, NULL, NULL);
 		return NULL;
 	}
 
-	png_set_read_fn(png, file, png_xfs_read_data);
+	if(mem.buf)
+		png_set_read_fn(png, &mem, png_mem_read_data);
+	else
+		png_set_read_fn(png, file, png_xfs_read_data);
 
 #ifdef PNG_SETJMP_SUPPORTED
 	if(setjmp(png_jmpbuf(png)))
 	{
 		png_destroy_read_struct(&png, &info, NULL);
+		xfs_munmap(file, (void *)mem.buf);
 		xfs_close(file);
 		return NULL;
 	}
@@ -658,6 +687,7 @@ static inline struct surface_t * surface_alloc_from_xfs_png(struct xfs_context_t
 	if(depth != 8 || !(color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_RGB_ALPHA))
 	{
 		png_destroy_read_struct(&png, &info, NULL);
+		xfs_munmap(file, (void *)mem.buf);
 		xfs_close(file);
 		return NULL;
 	}
@@ -687,6 +717,7 @@ static inline struct surface_t * surface_alloc_from_xfs_png(struct xfs_context_t
 	png_read_end(png, info);
 	free(row_pointers);
 	png_destroy_read_struct(&png, &info, NULL);
+	xfs_munmap(file, (void *)mem.buf);
 	xfs_close(file);
 
 	return s;
@@ -789,21 +820,28 @@ static inline struct surface_t * surface_alloc_from_xfs_jpeg(struct xfs_context_
 	struct surface_t * s;
 	struct xfs_file_t * file;
 	JSAMPARRAY buf;
-	unsigned char * p;
+	unsigned char * p, * map;
+	s64_t len;
 	int scanline, offset, i;
 
 	if(!(file = xfs_open_read(ctx, filename)))
 		return NULL;
+	len = xfs_length(file);
+	map = xfs_mmap(file, 0, len);
 	cinfo.err = jpeg_std_error(&jerr.pub);
 	jerr.pub.error_exit = my_error_exit;
 	if(setjmp(jerr.setjmp_buffer))
 	{
 		jpeg_destroy_decompress(&cinfo);
+		xfs_munmap(file, map);
 		xfs_close(file);
 		return 0;
 	}
 	jpeg_create_decompress(&cinfo);
-	jpeg_xfs_src(&cinfo, file);
+	if(map)
+		jpeg_mem_src(&cinfo, map, len);
+	else
+		jpeg_xfs_src(&cinfo, file);
 	jpeg_read_header(&cinfo, 1);
 	jpeg_start_decompress(&cinfo);
 	buf = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.output_width * cinfo.output_components, 1);
@@ -824,6 +862,7 @@ static inline struct surface_t * surface_alloc_from_xfs_jpeg(struct xfs_context_
 	}
 	jpeg_finish_decompress(&cinfo);
 	jpeg_destroy_decompress(&cinfo);
+	xfs_munmap(file, map);
 	xfs_close(file);
 
 	return s;
@@ -38,30 +38,32 @@
 
 static void calc_text_extent(struct text_t * txt)
 {
+	struct font_glyph_t * g;
 	const char * p;
 	u32_t code;
 	int glyph;
-	FT_Face face;
+	void * face;
 	int x = 0, y = 0, w = 0, h = 0;
 	int flag = 0;
 
 	for(p = txt->utf8; utf8_to_ucs4(&code, 1, p, -1, &p) > 0;)
 	{
-		glyph = search_glyph(txt->fctx, txt->family, code, (void **)(&face));
+		glyph = search_glyph(txt->fctx, txt->family, code, &face);
 		if(glyph == 0)
-			glyph = search_glyph(txt->fctx, "roboto", 0xfffd, (void **)(&face));
-		FT_Set_Pixel_Sizes(face, txt->size, txt->size);
-		FT_Load_Glyph(face, glyph, FT_LOAD_BITMAP_METRICS_ONLY);
-		w += face->glyph->metrics.horiAdvance;
-		if(face->glyph->metrics.vertAdvance > h)
-			h = face->glyph->metrics.vertAdvance;
+			glyph = search_glyph(txt->fctx, "roboto", 0xfffd, &face);
+		g = font_glyph_metrics(txt->fctx, face, txt->size, glyph);
+		if(!g)
+			continue;
+		w += g->hadvance;
+		if(g->vadvance > h)
+			h = g->vadvance;
 		if(!flag)
 		{
-			x = face->glyph->metrics.horiBearingX;
+			x = g->hbearingx;
 			flag = 1;
 		}
-		if(face->glyph->metrics.horiBearingY > y)
-			y = face->glyph->metrics.horiBearingY;
+		if(g->hbearingy > y)
+			y = g->hbearingy;
 	}
 	region_init(&txt->e, (x >> 6) + 4, (y >> 6) + 4, (w >> 6) + 8, (h >> 6) + 8);
 }
@@ -130,7 +132,7 @@ void text_set_font_family(struct text_t * txt, const char * family)
 	{
 		if(txt->family)
 			free(txt->family);
-		txt->utf8 = strdup(family ? family : "roboto");
+		txt->family = strdup(family ? family : "roboto");
 		calc_text_extent(txt);
 	}
 }
@@ -144,7 +146,7 @@ void text_set_font_size(struct text_t * txt, int size)
 	}
 }
 
-static inline void draw_font_bitmap(struct surface_t * s, struct region_t * clip, struct color_t * c, int x, int y, FT_Bitmap * bitmap)
+static inline void draw_font_bitmap(struct surface_t * s, struct region_t * clip, struct color_t * c, int x, int y, struct font_glyph_t * g)
 {
 	struct region_t r, region;
 	uint32_t * dp, dv;
@@ -163,7 +165,7 @@ static inline void draw_font_bitmap(struct surface_t * s, struct region_t * clip
 		if(!region_intersect(&r, &r, clip))
 			return;
 	}
-	region_init(&region, x, y, bitmap->width, bitmap->rows);
+	region_init(&region, x, y, g->width, g->height);
 	if(!region_intersect(&r, &r, &region))
 		return;
 
@@ -174,9 +176,9 @@ static inline void draw_font_bitmap(struct surface_t * s, struct region_t * clip
 	sx = r.x - x;
 	sy = r.y - y;
 	dskip = s->width - dw;
-	sskip = bitmap->pitch - dw;
+	sskip = g->width - dw;
 	dp = (uint32_t *)s->pixels + dy * s->width + dx;
-	sp = (uint8_t *)bitmap->buffer + sy * bitmap->pitch + sx;
+	sp = g->bitmap + sy * g->width + sx;
 
 	for(j = 0; j < dh; j++)
 	{
@@ -218,32 +220,29 @@ static inline void draw_font_bitmap(struct surface_t * s, struct region_t * clip
 
 void render_default_text(struct surface_t * s, struct region_t * clip, struct matrix_t * m, struct text_t * txt)
 {
+	struct font_glyph_t * g;
 	const char * p;
 	u32_t code;
 	int glyph;
-	FT_Face face;
-	FT_Matrix matrix;
+	void * face;
 	FT_Vector pen;
 	int tx = txt->e.x;
 	int ty = txt->e.y;
 
-	matrix.xx = (FT_Fixed)(m->a * 65536.0);
-	matrix.xy = -((FT_Fixed)(m->c * 65536.0));
-	matrix.yx = -((FT_Fixed)(m->b * 65536.0));
-	matrix.yy = (FT_Fixed)(m->d * 65536.0);
 	pen.x = (FT_Pos)((m->tx + m->a * tx + m->c * ty) * 64);
 	pen.y = (FT_Pos)((s->height - (m->ty + m->b * tx + m->d * ty)) * 64);
 
 	for(p = txt->utf8; utf8_to_ucs4(&code, 1, p, -1, &p) > 0;)
 	{
-		glyph = search_glyph(txt->fctx, txt->family, code, (void **)(&face));
+		glyph = search_glyph(txt->fctx, txt->family, code, &face);
 		if(glyph == 0)
-			glyph = search_glyph(txt->fctx, "roboto", 0xfffd, (void **)(&face));
-		FT_Set_Pixel_Sizes(face, txt->size, txt->size);
-		FT_Set_Transform(face, &matrix, &pen);
-		FT_Load_Glyph(face, glyph, FT_LOAD_RENDER);
-		draw_font_bitmap(s, clip, &txt->c, face->glyph->bitmap_left, s->height - face->glyph->bitmap_top, &face->glyph->bitmap);
-		pen.x += face->glyph->advance.x;
-		pen.y += face->glyph->advance.y;
+			glyph = search_glyph(txt->fctx, "roboto", 0xfffd, &face);
+		g = font_glyph_render(txt->fctx, face, txt->size, glyph, m, pen.x, pen.y);
+		if(!g)
+			continue;
+		if(g->bitmap)
+			draw_font_bitmap(s, clip, &txt->c, (pen.x >> 6) + g->left, s->height - ((pen.y >> 6) + g->top), g);
+		pen.x += g->ax;
+		pen.y += g->ay;
 	}
 }
@@ -46,80 +46,218 @@ struct cpio_newc_header_t {
 	u8_t c_check[8];
 } __attribute__ ((packed));
 
-static bool_t get_next_token(const char * path, const char * prefix, char * result)
-{
-	const char * p, * q;
-	int l;
+struct cpio_entry_t {
+	struct list_head head;
+	struct hlist_node node;
+	struct cpio_entry_t * parent;
+	struct cpio_entry_t ** child;
+	int nchild;
+	char * path;
+	char * name;
+	u64_t offset;
+	u64_t size;
+	u32_t mode;
+	u32_t mtime;
+};
 
-	if(!path || !prefix || !result)
-		return FALSE;
+struct cpio_archive_t {
+	struct cpio_entry_t root;
+	struct list_head list;
+	struct hlist_head * hash;
+	int hsize;
+};
 
-	if(*path == '/')
-		path++;
+static inline u32_t cpio_hex(const u8_t * s)
+{
+	char buf[9];
 
-	if(*prefix == '/')
-		prefix++;
+	memcpy(buf, s, 8);
+	buf[8] = '\0';
+	return strtoul(buf, NULL, 16);
+}
 
-	l = strlen(prefix);
-	if(strncmp(path, prefix, l) != 0)
-		return FALSE;
+static struct hlist_head * cpio_hash(struct cpio_archive_t * a, const char * path)
+{
+	return &a->hash[shash(path) % a->hsize];
+}
 
-	p = &path[l];
-	if(*p == '\0')
-		return FALSE;
-	if(*p == '/')
-		p++;
-	if(*p == '\0')
-		return FALSE;
+static struct cpio_entry_t * cpio_search(struct cpio_archive_t * a, const char * path)
+{
+	struct cpio_entry_t * pos;
 
-	q = strchr(p, '/');
-	if(q)
+	hlist_for_each_entry(pos, cpio_hash(a, path), node)
 	{
-		if (*(q + 1) != '\0')
-			return FALSE;
-		l = q - p;
+		if(strcmp(pos->path, path) == 0)
+			return pos;
 	}
-	else
+	return NULL;
+}
+
+static void cpio_archive_free(struct cpio_archive_t * a)
+{
+	struct cpio_entry_t * pos, * n;
+
+	if(a)
 	{
-		l = strlen(p);
+		list_for_each_entry_safe(pos, n, &a->list, head)
+		{
+			free(pos->child);
+			free(pos);
+		}
+		free(a->root.child);
+		free(a->hash);
+		free(a);
 	}
-	memcpy(result, p, l);
-	result[l] = '\0';
-
-	return TRUE;
 }
 
-static bool_t check_path(const char * path, const char * prefix, const char * name)
+/*
+ * Walk the archive once, hash every path and attach each entry to the child
+ * list of its parent directory, lookup and readdir never rescan the headers.
+ */
+static struct cpio_archive_t * cpio_archive_alloc(struct block_t * dev)
 {
-	int l;
+	struct cpio_newc_header_t header;
+	struct cpio_archive_t * a;
+	struct cpio_entry_t * e, * pos, * n;
+	char path[VFS_MAX_PATH];
+	u32_t size, name_size, mode;
+	u64_t off = 0, data;
+	int count = 0;
+	int i, l;
+	char * p;
+
+	a = malloc(sizeof(struct cpio_archive_t));
+	if(!a)
+		return NULL;
+	memset(a, 0, sizeof(struct cpio_archive_t));
+	init_list_head(&a->list);
+	a->root.path = a->root.name = "";
+	a->root.mode = 0040000;
 
-	if(!path || !prefix || !name)
-		return FALSE;
+	while(1)
+	{
+		if(block_read(dev, (u8_t *)&header, off, sizeof(struct cpio_newc_header_t)) != sizeof(struct cpio_newc_header_t))
+			break;
 
-	if(path[0] == '/')
-		path++;
+		if(strncmp((const char *)header.c_magic, "070701", 6) != 0)
+			break;
 
-	if(prefix[0] == '/')
-		prefix++;
+		size = cpio_hex(header.c_filesize);
+		name_size = cpio_hex(header.c_namesize);
+		mode = cpio_hex(header.c_mode);
+		if((name_size == 0) || (name_size > sizeof(path)))
+			break;
 
-	l = strlen(prefix);
-	if(l && (strncmp(path, prefix, l) != 0))
-		return FALSE;
+		if(block_read(dev, (u8_t *)path, off + sizeof(struct cpio_newc_header_t), name_size) != name_size)
+			break;
+		path[name_size - 1] = '\0';
 
-	path += l;
+		if((size == 0) && (mode == 0) && (strcmp(path, "TRAILER!!!") == 0))
+			break;
+
+		data = off + sizeof(struct cpio_newc_header_t) + (((name_size + 1) & ~3) + 2);
+		off = (data + size + 3) & ~0x3;
+
+		for(p = path; (*p == '/') || ((p[0] == '.') && (p[1] == '/')); p += (*p == '/') ? 1 : 2);
+		for(l = strlen(p); (l > 0) && (p[l - 1] == '/'); l--)
+			p[l - 1] = '\0';
+		if((l == 0) || (strcmp(p, ".") == 0) || (strcmp(p, "..") == 0))
+			continue;
+
+		e = malloc(sizeof(struct cpio_entry_t) + l + 1);
+		if(!e)
+		{
+			cpio_archive_free(a);
+			return NULL;
+		}
+		memset(e, 0, sizeof(struct cpio_entry_t));
+		e->path = (char *)(e + 1);
+		memcpy(e->path, p, l + 1);
+		e->name = strrchr(e->path, '/');
+		e->name = e->name ? e->name + 1 : e->path;
+		e->offset = data;
+		e->size = size;
+		e->mode = mode;
+		e->mtime = cpio_hex(header.c_mtime);
+		list_add_tail(&e->head, &a->list);
+		count++;
+	}
+
+	a->hsize = count * 2 + 1;
+	a->hash = malloc(sizeof(struct hlist_head) * a->hsize);
+	if(!a->hash)
+	{
+		cpio_archive_free(a);
+		return NULL;
+	}
+	for(i = 0; i < a->hsize; i++)
+		init_hlist_head(&a->hash[i]);
+
+	list_for_each_entry_safe(pos, n, &a->list, head)
+	{
+		if(cpio_search(a, pos->path))
+		{
+			list_del(&pos->head);
+			free(pos);
+			continue;
+		}
+		init_hlist_node(&pos->node);
+		hlist_add_head(&pos->node, cpio_hash(a, pos->path));
+	}
 
-	if(path[0] == '/')
-		path++;
+	list_for_each_entry(pos, &a->list, head)
+	{
+		if(pos->name == pos->path)
+		{
+			pos->parent = &a->root;
+		}
+		else
+		{
+			l = pos->name - pos->path - 1;
+			memcpy(path, pos->path, l);
+			path[l] = '\0';
+			pos->parent = cpio_search(a, path);
+		}
+		if(pos->parent)
+			pos->parent->nchild++;
+	}
 
-	if(strcmp(path, name) != 0)
-		return FALSE;
+	if(a->root.nchild > 0)
+	{
+		a->root.child = malloc(sizeof(struct cpio_entry_t *) * a->root.nchild);
+		if(!a->root.child)
+		{
+			cpio_archive_free(a);
+			return NULL;
+		}
+		a->root.nchild = 0;
+	}
+	list_for_each_entry(pos, &a->list, head)
+	{
+		if(pos->nchild > 0)
+		{
+			pos->child = malloc(sizeof(struct cpio_entry_t *) * pos->nchild);
+			if(!pos->child)
+			{
+				cpio_archive_free(a);
+				return NULL;
+			}
+			pos->nchild = 0;
+		}
+	}
+	list_for_each_entry(pos, &a->list, head)
+	{
+		if(pos->parent)
+			pos->parent->child[pos->parent->nchild++] = pos;
+	}
 
-	return TRUE;
+	return a;
 }
 
 static int cpio_mount(struct vfs_mount_t * m, const char * dev)
 {
 	struct cpio_newc_header_t header;
+	struct cpio_archive_t * a;
 	u64_t rd;
 
 	if(dev == NULL)
@@ -135,15 +273,20 @@ static int cpio_mount(struct vfs_mount_t * m, const char * dev)
 	if(strncmp((const char *)header.c_magic, "070701", 6) != 0)
 		return -1;
 
+	a = cpio_archive_alloc(m->m_dev);
+	if(!a)
+		return -1;
+
 	m->m_flags |= MOUNT_RO;
-	m->m_root->v_data = NULL;
-	m->m_data = NULL;
+	m->m_root->v_data = &a->root;
+	m->m_data = a;
 
 	return 0;
 }
 
 static int cpio_unmount(struct vfs_mount_t * m)
 {
+	cpio_archive_free(m->m_data);
 	m->m_data = NULL;
 	return 0;
 }
@@ -165,8 +308,9 @@ static int cpio_vput(struct vfs_mount_t * m, struct vfs_node_t * n)
 
 static u64_t cpio_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 {
-	u64_t toff;
+	struct cpio_entry_t * e = (struct cpio_entry_t *)(n->v_data);
 	u64_t sz = 0;
+	void * p;
 
 	if(n->v_type != VNT_REG)
 		return 0;
@@ -178,8 +322,11 @@ static u64_t cpio_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 	if((n->v_size - off) < sz)
 		sz = n->v_size - off;
 
-	toff = (u64_t)((unsigned long)(n->v_data));
-	sz = block_read(n->v_mount->m_dev, (u8_t *)buf, (toff + off), sz);
+	p = block_mmap(n->v_mount->m_dev, e->offset + off, sz);
+	if(p)
+		memcpy(buf, p, sz);
+	else
+		sz = block_read(n->v_mount->m_dev, (u8_t *)buf, e->offset + off, sz);
 
 	return sz;
 }
@@ -201,57 +348,12 @@ static int cpio_sync(struct vfs_node_t * n)
 
 static int cpio_readdir(struct vfs_node_t * dn, s64_t off, struct vfs_dirent_t * d)
 {
-	struct cpio_newc_header_t header;
-	char path[VFS_MAX_PATH];
-	char name[VFS_MAX_NAME];
-	u32_t size, name_size, mode;
-	u64_t toff = 0, rd;
-	char buf[9];
-	int i = 0;
+	struct cpio_entry_t * de = (struct cpio_entry_t *)(dn->v_data);
+	u32_t mode;
 
-	while(1)
-	{
-		rd = block_read(dn->v_mount->m_dev, (u8_t *)&header, toff, sizeof(struct cpio_newc_header_t));
-		if(rd != sizeof(struct cpio_newc_header_t))
-			return -1;
-
-		if(strncmp((const char *)&header.c_magic, "070701", 6) != 0)
-			return -1;
-
-		buf[8] = '\0';
-
-		memcpy(buf, &header.c_filesize, 8);
-		size = strtoul((const char *)buf, NULL, 16);
-
-		memcpy(buf, &header.c_namesize, 8);
-		name_size = strtoul((const char *)buf, NULL, 16);
-
-		memcpy(buf, &header.c_mode, 8);
-		mode = strtoul((const char *)buf, NULL, 16);
-
-		rd = block_read(dn->v_mount->m_dev, (u8_t *)path, toff + sizeof(struct cpio_newc_header_t), name_size);
-		if(!rd)
-			return -1;
-
-		if((size == 0) && (mode == 0) && (name_size == 11) && (strncmp(path, "TRAILER!!!", 10) == 0))
-			return -1;
-
-		toff += sizeof(struct cpio_newc_header_t);
-		toff += (((name_size + 1) & ~3) + 2) + size;
-		toff = (toff + 3) & ~3;
-
-		if(path[0] == '.')
-			continue;
-
-		if(!get_next_token(path, dn->v_path, name))
-			continue;
-
-		if(i++ == off)
-		{
-			toff = 0;
-			break;
-		}
-	}
+	if((off < 0) || (off >= de->nchild))
+		return -1;
+	mode = de->child[off]->mode;
 
 	if((mode & 00170000) == 0140000)
 	{
@@ -286,7 +388,7 @@ static int cpio_readdir(struct vfs_node_t * dn, s64_t off, struct vfs_dirent_t *
 		d->d_type = VDT_REG;
 	}
 
-	strlcpy(d->d_name, name, sizeof(d->d_name));
+	strlcpy(d->d_name, de->child[off]->name, sizeof(d->d_name));
 	d->d_off = off;
 	d->d_reclen = 1;
 
@@ -295,53 +397,24 @@ static int cpio_readdir(struct vfs_node_t * dn, s64_t off, struct vfs_dirent_t *
 
 static int cpio_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node_t * n)
 {
-	struct cpio_newc_header_t header;
+	struct cpio_archive_t * a = (struct cpio_archive_t *)(dn->v_mount->m_data);
+	struct cpio_entry_t * de = (struct cpio_entry_t *)(dn->v_data);
+	struct cpio_entry_t * e;
 	char path[VFS_MAX_PATH];
-	u64_t off = 0, rd;
-	u32_t size, name_size, mode, mtime;
-	u8_t buf[9];
-
-	while(1)
-	{
-		rd = block_read(dn->v_mount->m_dev, (u8_t *)&header, off, sizeof(struct cpio_newc_header_t));
-		if(rd != sizeof(struct cpio_newc_header_t))
-			return -1;
-
-		if(strncmp((const char *)header.c_magic, "070701", 6) != 0)
-			return -1;
-
-		buf[8] = '\0';
-
-		memcpy(buf, &header.c_filesize, 8);
-		size = strtoul((const char *)buf, NULL, 16);
-
-		memcpy(buf, &header.c_namesize, 8);
-		name_size = strtoul((const char *)buf, NULL, 16);
-
-		memcpy(buf, &header.c_mode, 8);
-		mode = strtoul((const char *)buf, NULL, 16);
+	u32_t mode;
 
-		memcpy(buf, &header.c_mtime, 8);
-		mtime = strtoul((const char *)buf, NULL, 16);
-
-		rd = block_read(dn->v_mount->m_dev, (u8_t *)path, off + sizeof(struct cpio_newc_header_t), name_size);
-		if(!rd)
-			return -1;
-
-		if((size == 0) && (mode == 0) && (name_size == 11) && (strncmp(path, "TRAILER!!!", 10) == 0))
-			return -1;
-
-		if((path[0] != '.') && check_path(path, dn->v_path, name))
-			break;
-
-		off += sizeof(struct cpio_newc_header_t);
-		off += (((name_size + 1) & ~3) + 2) + size;
-		off = (off + 3) & ~0x3;
-	}
-
-	n->v_atime = mtime;
-	n->v_mtime = mtime;
-	n->v_ctime = mtime;
+	if(de == &a->root)
+		strlcpy(path, name, sizeof(path));
+	else
+		snprintf(path, sizeof(path), "%s/%s", de->path, name);
+	e = cpio_search(a, path);
+	if(!e)
+		return ENOENT;
+	mode = e->mode;
+
+	n->v_atime = e->mtime;
+	n->v_mtime = e->mtime;
+	n->v_ctime = e->mtime;
 	n->v_mode = 0;
 
 	if((mode & 00170000) == 0140000)
@@ -393,11 +466,8 @@ static int cpio_lookup(struct vfs_node_t * dn, const char * name, struct vfs_nod
 	n->v_mode |= (mode & 00004) ? S_IROTH : 0;
 	n->v_mode |= (mode & 00002) ? S_IWOTH : 0;
 	n->v_mode |= (mode & 00001) ? S_IXOTH : 0;
-	n->v_size = size;
-
-	off += sizeof(struct cpio_newc_header_t);
-	off += (((name_size + 1) & ~3) + 2);
-	n->v_data = (void *)((unsigned long)off);
+	n->v_size = e->size;
+	n->v_data = e;
 
 	return 0;
 }
@@ -432,6 +502,15 @@ static int cpio_chmod(struct vfs_node_t * n, u32_t mode)
 	return -1;
 }
 
+static void * cpio_mmap(struct vfs_node_t * n, s64_t off, u64_t len)
+{
+	struct cpio_entry_t * e = (struct cpio_entry_t *)(n->v_data);
+
+	if(n->v_type != VNT_REG)
+		return NULL;
+	return block_mmap(n->v_mount->m_dev, e->offset + off, len);
+}
+
 static struct filesystem_t cpio = {
 	.name		= "cpio",
 
@@ -453,6 +532,7 @@ static struct filesystem_t cpio = {
 	.mkdir		= cpio_mkdir,
 	.rmdir		= cpio_rmdir,
 	.chmod		= cpio_chmod,
+	.mmap		= cpio_mmap,
 };
 
 static __init void filesystem_cpio_init(void)
@@ -148,7 +148,7 @@ int ext4fs_control_alloc_block(struct ext4fs_control_t * ctrl, u32_t inode_no, u
 		group = &ctrl->groups[g];
 
 		mutex_lock(&group->grp_lock);
-		if(le16_to_cpu(group->grp.free_blocks))
+		if(le16_to_cpu(group->grp.free_blocks) && !(le16_to_cpu(group->grp.bg_flags) & EXT4_BG_BLOCK_UNINIT))
 		{
 			for(b = 0; b < blocks_per_group; b++)
 			{
@@ -197,6 +197,49 @@ int ext4fs_control_alloc_block(struct ext4fs_control_t * ctrl, u32_t inode_no, u
 	return 0;
 }
 
+/*
+ * Allocate the given block if it is free, used to keep files contiguous
+ */
+int ext4fs_control_claim_block(struct ext4fs_control_t * ctrl, u32_t blkno)
+{
+	u32_t g, b;
+	struct ext4fs_group_t * group;
+
+	if(blkno < le32_to_cpu(ctrl->sblock.first_data_block))
+	{
+		return -1;
+	}
+	b = blkno - le32_to_cpu(ctrl->sblock.first_data_block);
+
+	/* determine block group */
+	g = udiv32(b, le32_to_cpu(ctrl->sblock.blocks_per_group));
+	if((g >= ctrl->group_count) || (blkno >= le32_to_cpu(ctrl->sblock.total_blocks)))
+	{
+		return -1;
+	}
+	group = &ctrl->groups[g];
+	b = umod32(b, le32_to_cpu(ctrl->sblock.blocks_per_group));
+
+	mutex_lock(&group->grp_lock);
+	if(!le16_to_cpu(group->grp.free_blocks) || (le16_to_cpu(group->grp.bg_flags) & EXT4_BG_BLOCK_UNINIT) || (group->block_bmap[b >> 3] & (1 << (b & 0x7))))
+	{
+		mutex_unlock(&group->grp_lock);
+		return -1;
+	}
+	group->grp.free_blocks = le16_to_cpu((le16_to_cpu(group->grp.free_blocks) - 1));
+	group->block_bmap[b >> 3] |= (1 << (b & 0x7));
+	group->grp_dirty = TRUE;
+	mutex_unlock(&group->grp_lock);
+
+	/* update superblock */
+	mutex_lock(&ctrl->sblock_lock);
+	ctrl->sblock.free_blocks = le32_to_cpu((le32_to_cpu(ctrl->sblock.free_blocks) - 1));
+	ctrl->sblock_dirty = TRUE;
+	mutex_unlock(&ctrl->sblock_lock);
+
+	return 0;
+}
+
 int ext4fs_control_free_block(struct ext4fs_control_t * ctrl, u32_t blkno)
 {
 	u32_t g, b;
@@ -256,7 +299,7 @@ int ext4fs_control_alloc_inode(struct ext4fs_control_t * ctrl, u32_t parent_inod
 		group = &ctrl->groups[g];
 
 		mutex_lock(&group->grp_lock);
-		if(le16_to_cpu(group->grp.free_inodes))
+		if(le16_to_cpu(group->grp.free_inodes) && !(le16_to_cpu(group->grp.bg_flags) & EXT4_BG_INODE_UNINIT))
 		{
 			for(i = 0; i < inodes_per_group; i++)
 			{
@@ -307,8 +350,24 @@ int ext4fs_control_alloc_inode(struct ext4fs_control_t * ctrl, u32_t parent_inod
 
 int ext4fs_control_free_inode(struct ext4fs_control_t * ctrl, u32_t inode_no)
 {
+	struct ext2_inode_t inode;
 	u32_t g, i;
 	struct ext4fs_group_t * group;
+	int rc;
+
+	/* An inode with links and no deletion time is still in use for fsck */
+	rc = ext4fs_control_read_inode(ctrl, inode_no, &inode);
+	if(rc)
+	{
+		return rc;
+	}
+	inode.nlinks = 0;
+	inode.dtime = le32_to_cpu(ext4fs_current_timestamp());
+	rc = ext4fs_control_write_inode(ctrl, inode_no, &inode);
+	if(rc)
+	{
+		return rc;
+	}
 
 	/* inodes are addressed from 1 onwards */
 	inode_no--;
@@ -338,6 +397,31 @@ int ext4fs_control_free_inode(struct ext4fs_control_t * ctrl, u32_t inode_no)
 	return 0;
 }
 
+int ext4fs_control_count_dir(struct ext4fs_control_t * ctrl, u32_t inode_no, s32_t count)
+{
+	u32_t g;
+	struct ext4fs_group_t * group;
+
+	/* inodes are addressed from 1 onwards */
+	inode_no--;
+
+	/* determine block group */
+	g = udiv32(inode_no, le32_to_cpu(ctrl->sblock.inodes_per_group));
+	if(g >= ctrl->group_count)
+	{
+		return -1;
+	}
+	group = &ctrl->groups[g];
+
+	/* update directories count of block group descriptor */
+	mutex_lock(&group->grp_lock);
+	group->grp.used_dir_cnt = le16_to_cpu((le16_to_cpu(group->grp.used_dir_cnt) + count));
+	group->grp_dirty = TRUE;
+	mutex_unlock(&group->grp_lock);
+
+	return 0;
+}
+
 int ext4fs_control_sync(struct ext4fs_control_t * ctrl)
 {
 	int rc;
@@ -364,7 +448,7 @@ int ext4fs_control_sync(struct ext4fs_control_t * ctrl)
 	/* Unlock sblock */
 	mutex_unlock(&ctrl->sblock_lock);
 
-	desc_per_blk = udiv32(ctrl->block_size, sizeof(struct ext2_block_group_t));
+	desc_per_blk = udiv32(ctrl->block_size, ctrl->desc_size);
 	for(g = 0; g < ctrl->group_count; g++)
 	{
 		/* Lock group */
@@ -379,7 +463,7 @@ int ext4fs_control_sync(struct ext4fs_control_t * ctrl)
 
 		/* Write group descriptor to block device */
 		blkno = ctrl->group_table_blkno + udiv32(g, desc_per_blk);
-		blkoff = umod32(g, desc_per_blk) * sizeof(struct ext2_block_group_t);
+		blkoff = umod32(g, desc_per_blk) * ctrl->desc_size;
 		rc = ext4fs_devwrite(ctrl, blkno, blkoff, sizeof(struct ext2_block_group_t), (char *)&ctrl->groups[g].grp);
 		if(rc)
 		{
@@ -450,13 +534,6 @@ int ext4fs_control_init(struct ext4fs_control_t * ctrl, struct block_t * bdev)
 		goto fail;
 	}
 
-	/* Directory indexing not supported so throw warning */
-	if(le32_to_cpu(ctrl->sblock.feature_compatibility) &
-	EXT2_FEAT_COMPAT_DIR_INDEX)
-	{
-		LOG("ext4: directory indexing is not available");
-	}
-
 	/* Pre-compute frequently required values */
 	ctrl->log2_block_size = le32_to_cpu((ctrl)->sblock.log2_block_size) + 1;
 	ctrl->block_size = 1 << (ctrl->log2_block_size + EXT2_SECTOR_BITS);
@@ -473,6 +550,13 @@ int ext4fs_control_init(struct ext4fs_control_t * ctrl, struct block_t * bdev)
 	}
 	ctrl->inodes_per_block = udiv32(ctrl->block_size, ctrl->inode_size);
 
+	/* With 64bit feature the descriptors grow, only the low half is used */
+	ctrl->desc_size = sizeof(struct ext2_block_group_t);
+	if((le32_to_cpu(ctrl->sblock.feature_incompat) & EXT4_FEAT_INCOMPAT_64BIT) && (le16_to_cpu(ctrl->sblock.desc_size) > ctrl->desc_size))
+	{
+		ctrl->desc_size = le16_to_cpu(ctrl->sblock.desc_size);
+	}
+
 	/* Setup block groups */
 	ctrl->group_count = udiv32(le32_to_cpu(ctrl->sblock.total_blocks), le32_to_cpu(ctrl->sblock.blocks_per_group));
 	if(umod32(le32_to_cpu(ctrl->sblock.total_blocks), le32_to_cpu(ctrl->sblock.blocks_per_group)))
@@ -486,7 +570,7 @@ int ext4fs_control_init(struct ext4fs_control_t * ctrl, struct block_t * bdev)
 		rc = -1;
 		goto fail;
 	}
-	desc_per_blk = udiv32(ctrl->block_size, sizeof(struct ext2_block_group_t));
+	desc_per_blk = udiv32(ctrl->block_size, ctrl->desc_size);
 	for(g = 0; g < ctrl->group_count; g++)
 	{
 		/* Init group lock */
@@ -494,7 +578,7 @@ int ext4fs_control_init(struct ext4fs_control_t * ctrl, struct block_t * bdev)
 
 		/* Load descriptor */
 		blkno = ctrl->group_table_blkno + udiv32(g, desc_per_blk);
-		blkoff = umod32(g, desc_per_blk) * sizeof(struct ext2_block_group_t);
+		blkoff = umod32(g, desc_per_blk) * ctrl->desc_size;
 		rc = ext4fs_devread(ctrl, blkno, blkoff, sizeof(struct ext2_block_group_t), (char *)&ctrl->groups[g].grp);
 		if(rc)
 		{
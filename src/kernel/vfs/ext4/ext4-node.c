@@ -47,7 +47,16 @@ void ext4fs_node_set_size(struct ext4fs_node_t * node, u64_t size)
 	{
 		node->inode.dir_acl = le32_to_cpu((u32_t )(size >> 32));
 	}
-	node->inode.blockcnt = le32_to_cpu((u32_t)(size >> EXT2_SECTOR_BITS));
+	node->inode_dirty = TRUE;
+}
+
+/* Account allocated or freed blocks in 512 bytes sectors */
+static void ext4fs_node_add_blockcnt(struct ext4fs_node_t * node, s32_t count)
+{
+	u32_t blockcnt = le32_to_cpu(node->inode.blockcnt);
+
+	blockcnt += count * (s32_t)(node->ctrl->block_size >> EXT2_SECTOR_BITS);
+	node->inode.blockcnt = le32_to_cpu(blockcnt);
 	node->inode_dirty = TRUE;
 }
 
@@ -147,8 +156,8 @@ int ext4fs_node_write_blk(struct ext4fs_node_t * node, u32_t blkno, u32_t blkoff
 			{
 				return rc;
 			}
-			node->cached_blkno = blkno;
 		}
+		node->cached_blkno = blkno;
 	}
 
 	memcpy(&node->cached_block[blkoff], buf, blklen);
@@ -215,14 +224,338 @@ int ext4fs_node_sync(struct ext4fs_node_t * node)
 	return 0;
 }
 
+static void ext4fs_node_extent_reset(struct ext4fs_node_t * node)
+{
+	node->extent_count = 0;
+	node->extent_victim = 0;
+}
+
+static void ext4fs_node_extent_add(struct ext4fs_node_t * node, struct ext4fs_extent_t * ext)
+{
+	u32_t idx;
+
+	if(node->extent_count < EXT4_NODE_EXTENT_SIZE)
+	{
+		idx = node->extent_count++;
+	}
+	else
+	{
+		idx = node->extent_victim;
+		node->extent_victim++;
+		if(node->extent_victim == EXT4_NODE_EXTENT_SIZE)
+		{
+			node->extent_victim = 0;
+		}
+	}
+	memcpy(&node->extent[idx], ext, sizeof(*ext));
+}
+
+static bool_t ext4fs_node_has_extents(struct ext4fs_node_t * node)
+{
+	return (le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL) ? TRUE : FALSE;
+}
+
+static bool_t ext4fs_node_extent_valid(struct ext4_extent_header_t * hdr, u32_t size)
+{
+	if(le16_to_cpu(hdr->magic) != EXT4_EXT_MAGIC)
+	{
+		return FALSE;
+	}
+	if(le16_to_cpu(hdr->entries) > le16_to_cpu(hdr->max))
+	{
+		return FALSE;
+	}
+	if((le16_to_cpu(hdr->max) + 1) * sizeof(struct ext4_extent_t) > size)
+	{
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Find the extent holding a logical block, walking the tree from the inode
+ * down to a leaf. A block in no extent, or in an uninitialized one, gives a
+ * hole up to the next mapped block.
+ */
+static int ext4fs_node_extent_find(struct ext4fs_node_t * node, u32_t blkpos, struct ext4fs_extent_t * ext)
+{
+	int rc;
+	u32_t i, entries, depth, size, blkno, len, limit;
+	struct ext4_extent_header_t *hdr;
+	struct ext4_extent_idx_t *idx;
+	struct ext4_extent_t *ex;
+	struct ext4fs_control_t *ctrl = node->ctrl;
+
+	/* Try to find in extent cache */
+	for(i = 0; i < node->extent_count; i++)
+	{
+		if((blkpos >= node->extent[i].lblk) && (blkpos - node->extent[i].lblk < node->extent[i].len))
+		{
+			memcpy(ext, &node->extent[i], sizeof(*ext));
+			return 0;
+		}
+	}
+
+	hdr = (struct ext4_extent_header_t *)&node->inode.b;
+	size = sizeof(node->inode.b);
+	depth = 0xFFFF;
+	limit = 0xFFFFFFFF;
+	while(1)
+	{
+		if(!ext4fs_node_extent_valid(hdr, size) || (le16_to_cpu(hdr->depth) >= depth))
+		{
+			return -1;
+		}
+		depth = le16_to_cpu(hdr->depth);
+		entries = le16_to_cpu(hdr->entries);
+		if(!depth)
+		{
+			break;
+		}
+
+		/* Last index starting at or before the block */
+		idx = (struct ext4_extent_idx_t *)(hdr + 1);
+		for(i = 0; (i < entries) && (le32_to_cpu(idx[i].block) <= blkpos); i++);
+		if(!i || le16_to_cpu(idx[i - 1].leaf_hi))
+		{
+			return -1;
+		}
+		if(i < entries)
+		{
+			limit = le32_to_cpu(idx[i].block);
+		}
+		blkno = le32_to_cpu(idx[i - 1].leaf_lo);
+
+		if(!node->extent_block)
+		{
+			node->extent_block = malloc(ctrl->block_size);
+			if(!node->extent_block)
+			{
+				return -1;
+			}
+			node->extent_blkno = 0;
+		}
+		if(node->extent_blkno != blkno)
+		{
+			node->extent_blkno = 0;
+			rc = ext4fs_devread(ctrl, blkno, 0, ctrl->block_size, (char *)node->extent_block);
+			if(rc)
+			{
+				return rc;
+			}
+			node->extent_blkno = blkno;
+		}
+		hdr = (struct ext4_extent_header_t *)node->extent_block;
+		size = ctrl->block_size;
+	}
+
+	/* Last extent starting at or before the block */
+	ex = (struct ext4_extent_t *)(hdr + 1);
+	for(i = 0; (i < entries) && (le32_to_cpu(ex[i].block) <= blkpos); i++);
+	if(i < entries)
+	{
+		limit = le32_to_cpu(ex[i].block);
+	}
+
+	ext->lblk = blkpos;
+	ext->pblk = 0;
+	ext->len = limit - blkpos;
+	if(i)
+	{
+		ex = &ex[i - 1];
+		len = le16_to_cpu(ex->len);
+		if(len > EXT4_EXT_INIT_MAX_LEN)
+		{
+			len -= EXT4_EXT_INIT_MAX_LEN;
+		}
+		else if(le16_to_cpu(ex->start_hi))
+		{
+			return -1;
+		}
+		if(blkpos - le32_to_cpu(ex->block) < len)
+		{
+			ext->lblk = le32_to_cpu(ex->block);
+			ext->len = len;
+			if(le16_to_cpu(ex->len) <= EXT4_EXT_INIT_MAX_LEN)
+			{
+				ext->pblk = le32_to_cpu(ex->start_lo);
+			}
+		}
+	}
+
+	/* Add extent to cache */
+	ext4fs_node_extent_add(node, ext);
+
+	return 0;
+}
+
+/*
+ * Map or unmap one logical block in an extent tree held in the inode. Deeper
+ * trees are only read.
+ */
+static int ext4fs_node_extent_set(struct ext4fs_node_t * node, u32_t blkpos, u32_t blkno)
+{
+	u32_t i, n, start, len, pblk, uninit;
+	struct ext4_extent_header_t *hdr;
+	struct ext4_extent_t *ex, *e;
+
+	hdr = (struct ext4_extent_header_t *)&node->inode.b;
+	if(!ext4fs_node_extent_valid(hdr, sizeof(node->inode.b)) || le16_to_cpu(hdr->depth))
+	{
+		return -1;
+	}
+	ex = (struct ext4_extent_t *)(hdr + 1);
+	n = le16_to_cpu(hdr->entries);
+
+	/* First extent after the block */
+	for(i = 0; (i < n) && (le32_to_cpu(ex[i].block) <= blkpos); i++);
+
+	if(i)
+	{
+		e = &ex[i - 1];
+		start = le32_to_cpu(e->block);
+		len = le16_to_cpu(e->len);
+		uninit = (len > EXT4_EXT_INIT_MAX_LEN) ? EXT4_EXT_INIT_MAX_LEN : 0;
+		len -= uninit;
+		pblk = le32_to_cpu(e->start_lo);
+
+		if(blkpos - start < len)
+		{
+			if(blkno)
+			{
+				return -1;
+			}
+
+			if(len == 1)
+			{
+				/* Drop the extent */
+				memmove(e, e + 1, (n - i) * sizeof(struct ext4_extent_t));
+				n--;
+			}
+			else if(blkpos == start + len - 1)
+			{
+				/* Trim the tail */
+				e->len = le16_to_cpu(len - 1 + uninit);
+			}
+			else if(blkpos == start)
+			{
+				/* Trim the head */
+				e->block = le32_to_cpu(start + 1);
+				e->start_lo = le32_to_cpu(pblk + 1);
+				e->len = le16_to_cpu(len - 1 + uninit);
+			}
+			else
+			{
+				/* Split in two around the block */
+				if(n >= le16_to_cpu(hdr->max))
+				{
+					return -1;
+				}
+				memmove(e + 2, e + 1, (n - i) * sizeof(struct ext4_extent_t));
+				e[1].block = le32_to_cpu(blkpos + 1);
+				e[1].start_hi = 0;
+				e[1].start_lo = le32_to_cpu(pblk + blkpos + 1 - start);
+				e[1].len = le16_to_cpu(start + len - blkpos - 1 + uninit);
+				e->len = le16_to_cpu(blkpos - start + uninit);
+				n++;
+			}
+			goto done;
+		}
+
+		if(!blkno)
+		{
+			return 0;
+		}
+
+		/* Grow the extent in front when the block follows it on disk */
+		if(!uninit && (blkpos == start + len) && (pblk + len == blkno) && (len < EXT4_EXT_INIT_MAX_LEN))
+		{
+			e->len = le16_to_cpu(len + 1);
+			goto done;
+		}
+	}
+	else if(!blkno)
+	{
+		return 0;
+	}
+
+	/* Insert a new extent */
+	if(n >= le16_to_cpu(hdr->max))
+	{
+		return -1;
+	}
+	memmove(&ex[i + 1], &ex[i], (n - i) * sizeof(struct ext4_extent_t));
+	ex[i].block = le32_to_cpu(blkpos);
+	ex[i].len = le16_to_cpu(1);
+	ex[i].start_hi = 0;
+	ex[i].start_lo = le32_to_cpu(blkno);
+	n++;
+
+done:
+	hdr->entries = le16_to_cpu(n);
+	node->inode_dirty = TRUE;
+	ext4fs_node_extent_reset(node);
+
+	return 0;
+}
+
+/*
+ * Map a logical block and count how many blocks from there, up to max, follow
+ * contiguously on disk, or are all holes. Returns zero on failure.
+ */
+static u32_t ext4fs_node_read_blkrun(struct ext4fs_node_t * node, u32_t blkpos, u32_t max, u32_t * blkno)
+{
+	struct ext4fs_extent_t ext;
+	u32_t n, next;
+
+	if(ext4fs_node_has_extents(node))
+	{
+		if(ext4fs_node_extent_find(node, blkpos, &ext))
+		{
+			return 0;
+		}
+		*blkno = ext.pblk ? ext.pblk + (blkpos - ext.lblk) : 0;
+		n = ext.len - (blkpos - ext.lblk);
+		return (n < max) ? n : max;
+	}
+
+	if(ext4fs_node_read_blkno(node, blkpos, blkno))
+	{
+		return 0;
+	}
+	for(n = 1; n < max; n++)
+	{
+		if(ext4fs_node_read_blkno(node, blkpos + n, &next))
+		{
+			break;
+		}
+		if(*blkno ? (next != *blkno + n) : (next != 0))
+		{
+			break;
+		}
+	}
+	return n;
+}
+
 int ext4fs_node_read_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t *blkno)
 {
 	int rc;
 	u32_t dindir2_blkno;
+	struct ext4fs_extent_t ext;
 	struct ext2_inode_t *inode = &node->inode;
 	struct ext4fs_control_t *ctrl = node->ctrl;
 
-	if(blkpos < ctrl->dir_blklast)
+	if(ext4fs_node_has_extents(node))
+	{
+		/* Extent tree.  */
+		rc = ext4fs_node_extent_find(node, blkpos, &ext);
+		if(rc)
+		{
+			return rc;
+		}
+		*blkno = ext.pblk ? ext.pblk + (blkpos - ext.lblk) : 0;
+	}
+	else if(blkpos < ctrl->dir_blklast)
 	{
 		/* Direct blocks.  */
 		*blkno = le32_to_cpu(inode->b.blocks.dir_blocks[blkpos]);
@@ -232,6 +565,11 @@ int ext4fs_node_read_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t *blk
 		/* Indirect.  */
 		u32_t indir_blkpos = blkpos - ctrl->dir_blklast;
 
+		if(!node->indir_blkno)
+		{
+			*blkno = 0;
+			return 0;
+		}
 		if(!node->indir_block)
 		{
 			node->indir_block = malloc(ctrl->block_size);
@@ -255,6 +593,11 @@ int ext4fs_node_read_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t *blk
 		u32_t dindir1_blkpos = udiv32(t, ctrl->block_size / 4);
 		u32_t dindir2_blkpos = t - dindir1_blkpos * (ctrl->block_size / 4);
 
+		if(!node->dindir1_blkno)
+		{
+			*blkno = 0;
+			return 0;
+		}
 		if(!node->dindir1_block)
 		{
 			node->dindir1_block = malloc(ctrl->block_size);
@@ -270,6 +613,11 @@ int ext4fs_node_read_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t *blk
 		}
 
 		dindir2_blkno = le32_to_cpu(node->dindir1_block[dindir1_blkpos]);
+		if(!dindir2_blkno)
+		{
+			*blkno = 0;
+			return 0;
+		}
 
 		if(!node->dindir2_block)
 		{
@@ -317,7 +665,12 @@ int ext4fs_node_write_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t blk
 	struct ext2_inode_t *inode = &node->inode;
 	struct ext4fs_control_t *ctrl = node->ctrl;
 
-	if(blkpos < ctrl->dir_blklast)
+	if(ext4fs_node_has_extents(node))
+	{
+		/* Extent tree.  */
+		return ext4fs_node_extent_set(node, blkpos, blkno);
+	}
+	else if(blkpos < ctrl->dir_blklast)
 	{
 		/* Direct blocks.  */
 		inode->b.blocks.dir_blocks[blkpos] = le32_to_cpu(blkno);
@@ -335,11 +688,25 @@ int ext4fs_node_write_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t blk
 			{
 				return -1;
 			}
-			rc = ext4fs_devread(ctrl, node->indir_blkno, 0, ctrl->block_size, (char *)node->indir_block);
+			if(node->indir_blkno)
+			{
+				rc = ext4fs_devread(ctrl, node->indir_blkno, 0, ctrl->block_size, (char *)node->indir_block);
+				if(rc)
+				{
+					return rc;
+				}
+			}
+		}
+		if(!node->indir_blkno)
+		{
+			rc = ext4fs_control_alloc_block(ctrl, node->inode_no, &node->indir_blkno);
 			if(rc)
 			{
 				return rc;
 			}
+			memset(node->indir_block, 0, ctrl->block_size);
+			inode->b.blocks.indir_block = le32_to_cpu(node->indir_blkno);
+			ext4fs_node_add_blockcnt(node, 1);
 		}
 
 		node->indir_block[indir_blkpos] = le32_to_cpu(blkno);
@@ -359,11 +726,25 @@ int ext4fs_node_write_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t blk
 			{
 				return -1;
 			}
-			rc = ext4fs_devread(ctrl, node->dindir1_blkno, 0, ctrl->block_size, (char *)node->dindir1_block);
+			if(node->dindir1_blkno)
+			{
+				rc = ext4fs_devread(ctrl, node->dindir1_blkno, 0, ctrl->block_size, (char *)node->dindir1_block);
+				if(rc)
+				{
+					return rc;
+				}
+			}
+		}
+		if(!node->dindir1_blkno)
+		{
+			rc = ext4fs_control_alloc_block(ctrl, node->inode_no, &node->dindir1_blkno);
 			if(rc)
 			{
 				return rc;
 			}
+			memset(node->dindir1_block, 0, ctrl->block_size);
+			inode->b.blocks.double_indir_block = le32_to_cpu(node->dindir1_blkno);
+			ext4fs_node_add_blockcnt(node, 1);
 		}
 
 		dindir2_blkno = le32_to_cpu(node->dindir1_block[dindir1_blkpos]);
@@ -377,7 +758,7 @@ int ext4fs_node_write_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t blk
 			}
 			node->dindir2_blkno = 0;
 		}
-		if(dindir2_blkno != node->dindir2_blkno)
+		if(dindir2_blkno != node->dindir2_blkno || !dindir2_blkno)
 		{
 			if(node->dindir2_dirty)
 			{
@@ -398,6 +779,7 @@ int ext4fs_node_write_blkno(struct ext4fs_node_t * node, u32_t blkpos, u32_t blk
 				node->dindir1_block[dindir1_blkpos] = le32_to_cpu(dindir2_blkno);
 				node->dindir1_dirty = TRUE;
 				memset(node->dindir2_block, 0, ctrl->block_size);
+				ext4fs_node_add_blockcnt(node, 1);
 			}
 			else
 			{
@@ -427,9 +809,7 @@ u32_t ext4fs_node_read(struct ext4fs_node_t * node, u64_t pos, u32_t len, char *
 {
 	int rc;
 	u64_t filesize = ext4fs_node_get_size(node);
-	u32_t i, rlen, blkno, blkoff, blklen;
-	u32_t last_blkpos, last_blklen;
-	u32_t first_blkpos, first_blkoff, first_blklen;
+	u32_t i, rlen, blkno, blkoff, blklen, blkcnt;
 	struct ext4fs_control_t *ctrl = node->ctrl;
 
 	if(filesize <= pos)
@@ -442,57 +822,71 @@ u32_t ext4fs_node_read(struct ext4fs_node_t * node, u64_t pos, u32_t len, char *
 	}
 
 	/* Note: div result < 32-bit */
-	first_blkpos = udiv64(pos, ctrl->block_size);
-	first_blkoff = pos - (first_blkpos * ctrl->block_size);
-	first_blklen = ctrl->block_size - first_blkoff;
-	if(len < first_blklen)
-	{
-		first_blklen = len;
-	}
-
-	/* Note: div result < 32-bit */
-	last_blkpos = udiv64((len + pos), ctrl->block_size);
-	last_blklen = (len + pos) - (last_blkpos * ctrl->block_size);
+	i = udiv64(pos, ctrl->block_size);
+	blkoff = pos - ((u64_t)i * ctrl->block_size);
 
 	rlen = len;
-	i = first_blkpos;
 	while(rlen)
 	{
-		rc = ext4fs_node_read_blkno(node, i, &blkno);
-		if(rc)
+		if(!blkoff && (rlen >= ctrl->block_size))
 		{
-			goto done;
-		}
+			/* Whole blocks, read each contiguous run at once */
+			blkcnt = ext4fs_node_read_blkrun(node, i, udiv32(rlen, ctrl->block_size), &blkno);
+			if(!blkcnt)
+			{
+				goto done;
+			}
+			blklen = blkcnt * ctrl->block_size;
 
-		if(i == first_blkpos)
-		{
-			/* First block.  */
-			blkoff = first_blkoff;
-			blklen = first_blklen;
-		}
-		else if(i == last_blkpos)
-		{
-			/* Last block.  */
-			blkoff = 0;
-			blklen = last_blklen;
+			if(!blkno)
+			{
+				memset(buf, 0, blklen);
+			}
+			else
+			{
+				/* The cached block may be newer than the disk */
+				if(node->cached_dirty && (node->cached_blkno >= blkno) && (node->cached_blkno - blkno < blkcnt))
+				{
+					rc = ext4fs_devwrite(ctrl, node->cached_blkno, 0, ctrl->block_size, (char *)node->cached_block);
+					if(rc)
+					{
+						goto done;
+					}
+					node->cached_dirty = FALSE;
+				}
+				rc = ext4fs_devread(ctrl, blkno, 0, blklen, buf);
+				if(rc)
+				{
+					goto done;
+				}
+			}
 		}
 		else
 		{
-			/* Middle block. */
-			blkoff = 0;
-			blklen = ctrl->block_size;
-		}
+			rc = ext4fs_node_read_blkno(node, i, &blkno);
+			if(rc)
+			{
+				goto done;
+			}
+			blkcnt = 1;
+			blklen = ctrl->block_size - blkoff;
+			if(rlen < blklen)
+			{
+				blklen = rlen;
+			}
 
-		/* Read cached block */
-		rc = ext4fs_node_read_blk(node, blkno, blkoff, blklen, buf);
-		if(rc)
-		{
-			goto done;
+			/* Read cached block */
+			rc = ext4fs_node_read_blk(node, blkno, blkoff, blklen, buf);
+			if(rc)
+			{
+				goto done;
+			}
 		}
 
 		buf += blklen;
 		rlen -= blklen;
-		i++;
+		blkoff = 0;
+		i += blkcnt;
 	}
 
 	done: return len - rlen;
@@ -526,18 +920,28 @@ u32_t ext4fs_node_write(struct ext4fs_node_t * node, u64_t pos, u32_t len, char
 
 		if(!blkno)
 		{
-			rc = ext4fs_control_alloc_block(ctrl, node->inode_no, &blkno);
-			if(rc)
+			/* Prefer the block after the previous one to keep the file contiguous */
+			if(!blkpos || ext4fs_node_read_blkno(node, blkpos - 1, &blkno) || !blkno || ext4fs_control_claim_block(ctrl, blkno + 1))
 			{
-				goto done;
+				rc = ext4fs_control_alloc_block(ctrl, node->inode_no, &blkno);
+				if(rc)
+				{
+					goto done;
+				}
+			}
+			else
+			{
+				blkno++;
 			}
 
 			rc = ext4fs_node_write_blkno(node, blkpos, blkno);
 			if(rc)
 			{
-				return rc;
+				ext4fs_control_free_block(ctrl, blkno);
+				goto done;
 			}
 
+			ext4fs_node_add_blockcnt(node, 1);
 			alloc_newblock = TRUE;
 		}
 		else
@@ -552,21 +956,19 @@ u32_t ext4fs_node_write(struct ext4fs_node_t * node, u64_t pos, u32_t len, char
 			{
 				ext4fs_control_free_block(ctrl, blkno);
 				ext4fs_node_write_blkno(node, blkpos, 0);
+				ext4fs_node_add_blockcnt(node, -1);
 			}
 			goto done;
 		}
 
-		if(wpos >= filesize)
-		{
-			update_nodesize = TRUE;
-		}
-
 		wpos += blklen;
 		buf += blklen;
 		wlen -= blklen;
-		if(update_nodesize)
+		if(wpos > filesize)
 		{
-			filesize += blklen;
+			/* The write may start past the end, leaving a hole behind */
+			filesize = wpos;
+			update_nodesize = TRUE;
 		}
 	}
 
@@ -585,6 +987,91 @@ u32_t ext4fs_node_write(struct ext4fs_node_t * node, u64_t pos, u32_t len, char
 	return len - wlen;
 }
 
+/* Free the indirect map blocks which map nothing below blkpos any more */
+static int ext4fs_node_free_indir(struct ext4fs_node_t * node, u32_t blkpos)
+{
+	int rc;
+	u32_t i, dindir2_blkno;
+	struct ext4fs_control_t *ctrl = node->ctrl;
+
+	/* Nothing allocated, the map may as well hold a fast symlink */
+	if(!le32_to_cpu(node->inode.blockcnt))
+	{
+		return 0;
+	}
+
+	if(node->dindir1_blkno)
+	{
+		if(!node->dindir1_block)
+		{
+			node->dindir1_block = malloc(ctrl->block_size);
+			if(!node->dindir1_block)
+			{
+				return -1;
+			}
+			rc = ext4fs_devread(ctrl, node->dindir1_blkno, 0, ctrl->block_size, (char *)node->dindir1_block);
+			if(rc)
+			{
+				free(node->dindir1_block);
+				node->dindir1_block = NULL;
+				return rc;
+			}
+		}
+
+		/* First level entry from which on nothing is mapped */
+		i = (blkpos > ctrl->indir_blklast) ? udiv32(blkpos - ctrl->indir_blklast + ctrl->block_size / 4 - 1, ctrl->block_size / 4) : 0;
+		for(; i < ctrl->block_size / 4; i++)
+		{
+			dindir2_blkno = le32_to_cpu(node->dindir1_block[i]);
+			if(!dindir2_blkno)
+			{
+				continue;
+			}
+			rc = ext4fs_control_free_block(ctrl, dindir2_blkno);
+			if(rc)
+			{
+				return rc;
+			}
+			if(node->dindir2_blkno == dindir2_blkno)
+			{
+				node->dindir2_blkno = 0;
+				node->dindir2_dirty = FALSE;
+			}
+			node->dindir1_block[i] = 0;
+			node->dindir1_dirty = TRUE;
+			ext4fs_node_add_blockcnt(node, -1);
+		}
+
+		if(blkpos <= ctrl->indir_blklast)
+		{
+			rc = ext4fs_control_free_block(ctrl, node->dindir1_blkno);
+			if(rc)
+			{
+				return rc;
+			}
+			node->dindir1_blkno = 0;
+			node->dindir1_dirty = FALSE;
+			node->inode.b.blocks.double_indir_block = 0;
+			ext4fs_node_add_blockcnt(node, -1);
+		}
+	}
+
+	if(node->indir_blkno && (blkpos <= ctrl->dir_blklast))
+	{
+		rc = ext4fs_control_free_block(ctrl, node->indir_blkno);
+		if(rc)
+		{
+			return rc;
+		}
+		node->indir_blkno = 0;
+		node->indir_dirty = FALSE;
+		node->inode.b.blocks.indir_block = 0;
+		ext4fs_node_add_blockcnt(node, -1);
+	}
+
+	return 0;
+}
+
 int ext4fs_node_truncate(struct ext4fs_node_t * node, u64_t pos)
 {
 	int rc;
@@ -595,6 +1082,13 @@ int ext4fs_node_truncate(struct ext4fs_node_t * node, u64_t pos)
 
 	if(filesize <= pos)
 	{
+		if(filesize < pos)
+		{
+			/* Growing only moves the end, the new range reads back as a hole */
+			node->inode.mtime = le32_to_cpu(ext4fs_current_timestamp());
+			node->inode_dirty = TRUE;
+			ext4fs_node_set_size(node, pos);
+		}
 		return 0;
 	}
 
@@ -621,31 +1115,50 @@ int ext4fs_node_truncate(struct ext4fs_node_t * node, u64_t pos)
 		blkpos = first_blkpos;
 	}
 
-	/* Free node blocks */
-	while(blkpos < blkcnt)
+	/* Free node blocks from the end so extents only ever shrink */
+	while(blkcnt > blkpos)
 	{
-		rc = ext4fs_node_read_blkno(node, blkpos, &blkno);
+		blkcnt--;
+		rc = ext4fs_node_read_blkno(node, blkcnt, &blkno);
 		if(rc)
 		{
 			return rc;
 		}
+		if(!blkno)
+		{
+			continue;
+		}
 
-		rc = ext4fs_control_free_block(ctrl, blkno);
+		rc = ext4fs_node_write_blkno(node, blkcnt, 0);
 		if(rc)
 		{
 			return rc;
 		}
 
-		rc = ext4fs_node_write_blkno(node, blkpos, 0);
+		rc = ext4fs_control_free_block(ctrl, blkno);
 		if(rc)
 		{
 			return rc;
 		}
+		ext4fs_node_add_blockcnt(node, -1);
 
-		blkpos++;
+		if(node->cached_blkno == blkno)
+		{
+			node->cached_blkno = 0;
+			node->cached_dirty = FALSE;
+		}
 	}
 
 	/* Free indirect & double indirect blocks */
+	if(!ext4fs_node_has_extents(node))
+	{
+		rc = ext4fs_node_free_indir(node, blkpos);
+		if(rc)
+		{
+			return rc;
+		}
+	}
+
 	if(pos != filesize)
 	{
 		/* Update node mtime */
@@ -688,6 +1201,10 @@ int ext4fs_node_load(struct ext4fs_control_t * ctrl, u32_t inode_no, struct ext4
 	node->dindir2_blkno = 0;
 	node->dindir2_dirty = FALSE;
 
+	node->extent_block = NULL;
+	node->extent_blkno = 0;
+	ext4fs_node_extent_reset(node);
+
 	return 0;
 }
 
@@ -714,6 +1231,10 @@ int ext4fs_node_init(struct ext4fs_node_t * node)
 	node->dindir2_blkno = 0;
 	node->dindir2_dirty = FALSE;
 
+	node->extent_block = NULL;
+	node->extent_blkno = 0;
+	ext4fs_node_extent_reset(node);
+
 	node->lookup_victim = 0;
 	for(idx = 0; idx < EXT4_NODE_LOOKUP_SIZE; idx++)
 	{
@@ -745,9 +1266,323 @@ int ext4fs_node_exit(struct ext4fs_node_t * node)
 		free(node->dindir2_block);
 	}
 
+	if(node->extent_block)
+	{
+		free(node->extent_block);
+	}
+
 	return 0;
 }
 
+/* Directory hashes, as computed by mke2fs and the linux kernel */
+#define EXT4_DX_ROL(x, s)		(((x) << (s)) | ((x) >> (32 - (s))))
+#define EXT4_DX_F(x, y, z)		((z) ^ ((x) & ((y) ^ (z))))
+#define EXT4_DX_G(x, y, z)		(((x) & (y)) + (((x) ^ (y)) & (z)))
+#define EXT4_DX_H(x, y, z)		((x) ^ (y) ^ (z))
+#define EXT4_DX_ROUND(f, a, b, c, d, x, s)	(a += f(b, c, d) + (x), a = EXT4_DX_ROL(a, s))
+#define EXT4_DX_K2				(0x5a827999)
+#define EXT4_DX_K3				(0x6ed9eba1)
+#define EXT4_DX_MAX_LEVELS		(3)
+
+static void ext4fs_dx_half_md4(u32_t * buf, u32_t * in)
+{
+	u32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	EXT4_DX_ROUND(EXT4_DX_F, a, b, c, d, in[0], 3);
+	EXT4_DX_ROUND(EXT4_DX_F, d, a, b, c, in[1], 7);
+	EXT4_DX_ROUND(EXT4_DX_F, c, d, a, b, in[2], 11);
+	EXT4_DX_ROUND(EXT4_DX_F, b, c, d, a, in[3], 19);
+	EXT4_DX_ROUND(EXT4_DX_F, a, b, c, d, in[4], 3);
+	EXT4_DX_ROUND(EXT4_DX_F, d, a, b, c, in[5], 7);
+	EXT4_DX_ROUND(EXT4_DX_F, c, d, a, b, in[6], 11);
+	EXT4_DX_ROUND(EXT4_DX_F, b, c, d, a, in[7], 19);
+
+	EXT4_DX_ROUND(EXT4_DX_G, a, b, c, d, in[1] + EXT4_DX_K2, 3);
+	EXT4_DX_ROUND(EXT4_DX_G, d, a, b, c, in[3] + EXT4_DX_K2, 5);
+	EXT4_DX_ROUND(EXT4_DX_G, c, d, a, b, in[5] + EXT4_DX_K2, 9);
+	EXT4_DX_ROUND(EXT4_DX_G, b, c, d, a, in[7] + EXT4_DX_K2, 13);
+	EXT4_DX_ROUND(EXT4_DX_G, a, b, c, d, in[0] + EXT4_DX_K2, 3);
+	EXT4_DX_ROUND(EXT4_DX_G, d, a, b, c, in[2] + EXT4_DX_K2, 5);
+	EXT4_DX_ROUND(EXT4_DX_G, c, d, a, b, in[4] + EXT4_DX_K2, 9);
+	EXT4_DX_ROUND(EXT4_DX_G, b, c, d, a, in[6] + EXT4_DX_K2, 13);
+
+	EXT4_DX_ROUND(EXT4_DX_H, a, b, c, d, in[3] + EXT4_DX_K3, 3);
+	EXT4_DX_ROUND(EXT4_DX_H, d, a, b, c, in[7] + EXT4_DX_K3, 9);
+	EXT4_DX_ROUND(EXT4_DX_H, c, d, a, b, in[2] + EXT4_DX_K3, 11);
+	EXT4_DX_ROUND(EXT4_DX_H, b, c, d, a, in[6] + EXT4_DX_K3, 15);
+	EXT4_DX_ROUND(EXT4_DX_H, a, b, c, d, in[1] + EXT4_DX_K3, 3);
+	EXT4_DX_ROUND(EXT4_DX_H, d, a, b, c, in[5] + EXT4_DX_K3, 9);
+	EXT4_DX_ROUND(EXT4_DX_H, c, d, a, b, in[0] + EXT4_DX_K3, 11);
+	EXT4_DX_ROUND(EXT4_DX_H, b, c, d, a, in[4] + EXT4_DX_K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+static void ext4fs_dx_tea(u32_t * buf, u32_t * in)
+{
+	u32_t sum = 0;
+	u32_t b0 = buf[0], b1 = buf[1];
+	int n;
+
+	for(n = 0; n < 16; n++)
+	{
+		sum += 0x9e3779b9;
+		b0 += ((b1 << 4) + in[0]) ^ (b1 + sum) ^ ((b1 >> 5) + in[1]);
+		b1 += ((b0 << 4) + in[2]) ^ (b0 + sum) ^ ((b0 >> 5) + in[3]);
+	}
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+static u32_t ext4fs_dx_legacy(const char * name, int len, bool_t unsign)
+{
+	u32_t hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+	int c;
+
+	while(len--)
+	{
+		c = unsign ? (int)(u8_t)*name++ : (int)(s8_t)*name++;
+		hash = hash1 + (hash0 ^ (u32_t)(c * 7152373));
+		if(hash & 0x80000000)
+			hash -= 0x7fffffff;
+		hash1 = hash0;
+		hash0 = hash;
+	}
+	return hash0 << 1;
+}
+
+/* Pack up to num words of the name, padded with its length */
+static void ext4fs_dx_str2hashbuf(const char * name, int len, u32_t * buf, int num, bool_t unsign)
+{
+	u32_t pad, val;
+	int i, c;
+
+	pad = (u32_t)len | ((u32_t)len << 8);
+	pad |= pad << 16;
+	val = pad;
+	if(len > num * 4)
+		len = num * 4;
+	for(i = 0; i < len; i++)
+	{
+		c = unsign ? (int)(u8_t)name[i] : (int)(s8_t)name[i];
+		val = (u32_t)c + (val << 8);
+		if((i % 4) == 3)
+		{
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if(--num >= 0)
+		*buf++ = val;
+	while(--num >= 0)
+		*buf++ = pad;
+}
+
+u32_t ext4fs_dx_hash(struct ext4fs_control_t * ctrl, int version, const char * name, int len)
+{
+	u32_t buf[4], in[8];
+	u32_t hash;
+	bool_t unsign = (version >= EXT2_HASH_LEGACY_UNSIGNED) ? TRUE : FALSE;
+	int i;
+
+	buf[0] = 0x67452301;
+	buf[1] = 0xefcdab89;
+	buf[2] = 0x98badcfe;
+	buf[3] = 0x10325476;
+	for(i = 0; i < 4; i++)
+	{
+		if(ctrl->sblock.hash_seed[i])
+		{
+			for(i = 0; i < 4; i++)
+				buf[i] = le32_to_cpu(ctrl->sblock.hash_seed[i]);
+			break;
+		}
+	}
+
+	switch(version)
+	{
+	case EXT2_HASH_HALF_MD4:
+	case EXT2_HASH_HALF_MD4_UNSIGNED:
+		for(; len > 0; len -= 32, name += 32)
+		{
+			ext4fs_dx_str2hashbuf(name, len, in, 8, unsign);
+			ext4fs_dx_half_md4(buf, in);
+		}
+		hash = buf[1];
+		break;
+	case EXT2_HASH_TEA:
+	case EXT2_HASH_TEA_UNSIGNED:
+		for(; len > 0; len -= 16, name += 16)
+		{
+			ext4fs_dx_str2hashbuf(name, len, in, 4, unsign);
+			ext4fs_dx_tea(buf, in);
+		}
+		hash = buf[0];
+		break;
+	default:
+		hash = ext4fs_dx_legacy(name, len, unsign);
+		break;
+	}
+
+	/* The lowest bit marks hash collisions in index entries, and ~0 is end of directory */
+	hash &= ~1;
+	if(hash == (0x7fffffffU << 1))
+		hash = (0x7fffffffU - 1) << 1;
+	return hash;
+}
+
+/* Find name in one directory block, TRUE if found */
+static bool_t ext4fs_node_dx_find_leaf(struct ext4fs_node_t * dnode, const char * buf, const char * name, int len, struct ext2_dirent_t * dent)
+{
+	struct ext2_dirent_t * d;
+	u32_t off, reclen;
+
+	for(off = 0; off + sizeof(struct ext2_dirent_t) <= dnode->ctrl->block_size; off += reclen)
+	{
+		d = (struct ext2_dirent_t *)&buf[off];
+		reclen = le16_to_cpu(d->direntlen);
+		if((reclen < sizeof(struct ext2_dirent_t)) || (off + reclen > dnode->ctrl->block_size))
+			break;
+		if(d->inode && (d->namelen == len) && (sizeof(struct ext2_dirent_t) + len <= reclen) && !memcmp(&buf[off + sizeof(struct ext2_dirent_t)], name, len))
+		{
+			memcpy(dent, d, sizeof(struct ext2_dirent_t));
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * Look up name through the htree index of a hashed directory, only the leaf
+ * block the hash points to is searched, plus the following ones while their
+ * index entries carry the same hash with the collision bit set. indexed is set
+ * once a leaf has been searched, it stays FALSE on a damaged index or a failed
+ * read so the caller falls back to the linear scan.
+ */
+static int ext4fs_node_dx_find_dirent(struct ext4fs_node_t * dnode, const char * name, struct ext2_dirent_t * dent, bool_t * indexed)
+{
+	struct ext4fs_control_t * ctrl = dnode->ctrl;
+	struct ext2_dx_root_info_t * info;
+	struct ext2_dx_countlimit_t * cl;
+	struct ext2_dx_entry_t * entries;
+	u32_t blkcnt, blk, hash, key, next, count, limit, lo, hi, mid;
+	int version, levels, level, len = strlen(name);
+	char * buf;
+	int rc = -1;
+
+	*indexed = FALSE;
+	if(!(le32_to_cpu(ctrl->sblock.feature_compatibility) & EXT2_FEAT_COMPAT_DIR_INDEX) || !(le32_to_cpu(dnode->inode.flags) & EXT2_INDEX_FL))
+	{
+		return -1;
+	}
+
+	buf = malloc(ctrl->block_size);
+	if(!buf)
+	{
+		return -1;
+	}
+	blkcnt = udiv64(ext4fs_node_get_size(dnode), ctrl->block_size);
+
+	/* The root info follows the "." and ".." entries, each with a four bytes name field */
+	info = (struct ext2_dx_root_info_t *)&buf[2 * (sizeof(struct ext2_dirent_t) + 4)];
+	if(ext4fs_node_read(dnode, 0, ctrl->block_size, buf) != ctrl->block_size)
+	{
+		goto fail;
+	}
+	if(info->reserved_zero || (info->hash_version > EXT2_HASH_TEA) || (info->info_length != sizeof(struct ext2_dx_root_info_t)) || (info->indirect_levels >= EXT4_DX_MAX_LEVELS) || (info->unused_flags & 0x1))
+	{
+		goto fail;
+	}
+	version = info->hash_version;
+	if(le32_to_cpu(ctrl->sblock.flags) & EXT2_FLAGS_UNSIGNED_HASH)
+	{
+		version += EXT2_HASH_LEGACY_UNSIGNED;
+	}
+	levels = info->indirect_levels;
+	hash = ext4fs_dx_hash(ctrl, version, name, len);
+
+	key = hash;
+	do
+	{
+		/* Walk down the index to the leaf covering key */
+		if(ext4fs_node_read(dnode, 0, ctrl->block_size, buf) != ctrl->block_size)
+		{
+			goto fail;
+		}
+		entries = (struct ext2_dx_entry_t *)((char *)info + info->info_length);
+		next = 0;
+		for(level = 0; ; level++)
+		{
+			cl = (struct ext2_dx_countlimit_t *)entries;
+			count = le16_to_cpu(cl->count);
+			limit = le16_to_cpu(cl->limit);
+			if(!count || (count > limit) || ((char *)&entries[limit] > &buf[ctrl->block_size]))
+			{
+				goto fail;
+			}
+
+			/* Last entry not above key, the first one has no hash and covers from zero */
+			lo = 1;
+			hi = count;
+			while(lo < hi)
+			{
+				mid = (lo + hi) / 2;
+				if(le32_to_cpu(entries[mid].hash) > key)
+					hi = mid;
+				else
+					lo = mid + 1;
+			}
+			if(lo < count)
+			{
+				next = le32_to_cpu(entries[lo].hash);
+			}
+			blk = le32_to_cpu(entries[lo - 1].block) & 0x0fffffff;
+			if(blk >= blkcnt)
+			{
+				goto fail;
+			}
+
+			if(ext4fs_node_read(dnode, (u64_t)blk * ctrl->block_size, ctrl->block_size, buf) != ctrl->block_size)
+			{
+				goto fail;
+			}
+			if(level == levels)
+			{
+				break;
+			}
+
+			/* Index blocks start with an empty entry spanning the block */
+			entries = (struct ext2_dx_entry_t *)&buf[sizeof(struct ext2_dirent_t)];
+		}
+
+		*indexed = TRUE;
+		if(ext4fs_node_dx_find_leaf(dnode, buf, name, len, dent))
+		{
+			rc = 0;
+			break;
+		}
+
+		/* Names with the same hash may continue in the next leaf */
+		if(!(next & 0x1) || ((next & ~1) != hash) || (next <= key))
+		{
+			break;
+		}
+		key = next;
+	} while(1);
+
+	free(buf);
+	return rc;
+
+fail:
+	*indexed = FALSE;
+	free(buf);
+	return -1;
+}
+
 static int ext4fs_node_find_lookup_dirent(struct ext4fs_node_t * dnode, const char * name, struct ext2_dirent_t * dent)
 {
 	int idx;
@@ -859,11 +1694,20 @@ int ext4fs_node_read_dirent(struct ext4fs_node_t * dnode, s64_t off, struct vfs_
 		}
 		d->d_name[dent.namelen] = '\0';
 
+		if(!le16_to_cpu(dent.direntlen))
+		{
+			return -1;
+		}
 		d->d_reclen += le16_to_cpu(dent.direntlen);
 		fileoff += le16_to_cpu(dent.direntlen);
 
-		if((strcmp(d->d_name, ".") == 0) || (strcmp(d->d_name, "..") == 0))
+		/* Skip unused entries, like the ones spanning htree index blocks */
+		if(!dent.inode || (strcmp(d->d_name, ".") == 0) || (strcmp(d->d_name, "..") == 0))
 		{
+			if(filesize < (sizeof(struct ext2_dirent_t) + fileoff))
+			{
+				return -1;
+			}
 			continue;
 		}
 		else
@@ -910,7 +1754,7 @@ int ext4fs_node_read_dirent(struct ext4fs_node_t * dnode, s64_t off, struct vfs_
 
 int ext4fs_node_find_dirent(struct ext4fs_node_t * dnode, const char * name, struct ext2_dirent_t * dent)
 {
-	bool_t found;
+	bool_t found, indexed;
 	u32_t rlen;
 	char filename[VFS_MAX_NAME];
 	u64_t off, filesize = ext4fs_node_get_size(dnode);
@@ -921,6 +1765,17 @@ int ext4fs_node_find_dirent(struct ext4fs_node_t * dnode, const char * name, str
 		return 0;
 	}
 
+	/* Try the hash index of large directories */
+	if((ext4fs_node_dx_find_dirent(dnode, name, dent, &indexed) == 0) && indexed)
+	{
+		ext4fs_node_add_lookup_dirent(dnode, name, dent);
+		return 0;
+	}
+	else if(indexed)
+	{
+		return ENOENT;
+	}
+
 	/* Find desired directoy entry such that we ignore
 	 * "." and ".." in search process
 	 */
@@ -945,7 +1800,7 @@ int ext4fs_node_find_dirent(struct ext4fs_node_t * dnode, const char * name, str
 		}
 		filename[dent->namelen] = '\0';
 
-		if((strcmp(filename, ".") != 0) && (strcmp(filename, "..") != 0))
+		if(dent->inode && (strcmp(filename, ".") != 0) && (strcmp(filename, "..") != 0))
 		{
 			if(strcmp(filename, name) == 0)
 			{
@@ -954,12 +1809,16 @@ int ext4fs_node_find_dirent(struct ext4fs_node_t * dnode, const char * name, str
 			}
 		}
 
+		if(!le16_to_cpu(dent->direntlen))
+		{
+			return -1;
+		}
 		off += le16_to_cpu(dent->direntlen);
 	}
 
 	if(!found)
 	{
-		return -1;
+		return ENOENT;
 	}
 
 	/* Add dent to lookup table */
@@ -971,7 +1830,7 @@ int ext4fs_node_find_dirent(struct ext4fs_node_t * dnode, const char * name, str
 int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_t inode_no, u8_t type)
 {
 	bool_t found;
-	u16_t direntlen;
+	u16_t direntlen, used = 0;
 	u32_t rlen, wlen;
 	char filename[VFS_MAX_NAME];
 	struct ext2_dirent_t dent;
@@ -984,10 +1843,10 @@ int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_
 		return -1;
 	}
 
-	/* Compute size of directory entry required */
-	direntlen = sizeof(struct ext2_dirent_t) + strlen(name);
+	/* Compute size of directory entry required, entries are 4 bytes aligned */
+	direntlen = (sizeof(struct ext2_dirent_t) + strlen(name) + 3) & ~3;
 
-	/* Find directory entry to split */
+	/* Find directory entry to split or unused entry to take over */
 	off = 0;
 	found = FALSE;
 	while(off < filesize)
@@ -997,8 +1856,13 @@ int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_
 		{
 			return -1;
 		}
+		if(!le16_to_cpu(dent.direntlen))
+		{
+			return -1;
+		}
 
-		if(direntlen < (le16_to_cpu(dent.direntlen) - dent.namelen - sizeof(struct ext2_dirent_t)))
+		used = dent.inode ? ((sizeof(struct ext2_dirent_t) + dent.namelen + 3) & ~3) : 0;
+		if(direntlen + used <= le16_to_cpu(dent.direntlen))
 		{
 			found = TRUE;
 			break;
@@ -1007,6 +1871,13 @@ int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_
 		off += le16_to_cpu(dent.direntlen);
 	}
 
+	/* New entries go wherever there is room, which breaks the hash order of an index */
+	if(le32_to_cpu(dnode->inode.flags) & EXT2_INDEX_FL)
+	{
+		dnode->inode.flags = le32_to_cpu(le32_to_cpu(dnode->inode.flags) & ~EXT2_INDEX_FL);
+		dnode->inode_dirty = TRUE;
+	}
+
 	if(!found)
 	{
 		/* Add space at end of directory to make space for
@@ -1036,13 +1907,18 @@ int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_
 
 		direntlen = ctrl->block_size;
 	}
+	else if(!used)
+	{
+		/* Take over the whole unused entry */
+		direntlen = le16_to_cpu(dent.direntlen);
+	}
 	else
 	{
 		/* Split existing directory entry to make space for 
 		 * new directory entry
 		 */
-		direntlen = (le16_to_cpu(dent.direntlen) - dent.namelen - sizeof(struct ext2_dirent_t));
-		dent.direntlen = le16_to_cpu(le16_to_cpu(dent.direntlen) - direntlen);
+		direntlen = le16_to_cpu(dent.direntlen) - used;
+		dent.direntlen = le16_to_cpu(used);
 
 		wlen = ext4fs_node_write(dnode, off, sizeof(struct ext2_dirent_t), (char *)&dent);
 		if(wlen != sizeof(struct ext2_dirent_t))
@@ -1076,19 +1952,45 @@ int ext4fs_node_add_dirent(struct ext4fs_node_t * dnode, const char * name, u32_
 		return -1;
 	}
 
-	/* Increment nlinks field of inode */
-	dnode->inode.nlinks = le16_to_cpu(le16_to_cpu(dnode->inode.nlinks) + 1);
-	dnode->inode_dirty = TRUE;
-
 	return 0;
 }
 
+int ext4fs_node_set_parent(struct ext4fs_node_t * dnode, u32_t inode_no)
+{
+	u32_t len;
+	struct ext2_dirent_t dent;
+
+	/* The '..' entry always follows '.' at the start of the first block */
+	len = ext4fs_node_read(dnode, 0, sizeof(struct ext2_dirent_t), (char *)&dent);
+	if((len != sizeof(struct ext2_dirent_t)) || (dent.namelen != 1))
+	{
+		return -1;
+	}
+	len = le16_to_cpu(dent.direntlen);
+	if(ext4fs_node_read(dnode, len, sizeof(struct ext2_dirent_t), (char *)&dent) != sizeof(struct ext2_dirent_t))
+	{
+		return -1;
+	}
+	if(dent.namelen != 2)
+	{
+		return -1;
+	}
+	dent.inode = le32_to_cpu(inode_no);
+	if(ext4fs_node_write(dnode, len, sizeof(struct ext2_dirent_t), (char *)&dent) != sizeof(struct ext2_dirent_t))
+	{
+		return -1;
+	}
+
+	return ext4fs_node_sync(dnode);
+}
+
 int ext4fs_node_del_dirent(struct ext4fs_node_t * dnode, const char * name)
 {
 	bool_t found;
 	u32_t rlen, wlen;
 	char filename[VFS_MAX_NAME];
 	struct ext2_dirent_t pdent, dent;
+	struct ext4fs_control_t *ctrl = dnode->ctrl;
 	u64_t poff, off, filesize = ext4fs_node_get_size(dnode);
 
 	/* Sanity check */
@@ -1126,7 +2028,7 @@ int ext4fs_node_del_dirent(struct ext4fs_node_t * dnode, const char * name)
 		}
 		filename[dent.namelen] = '\0';
 
-		if((strcmp(filename, ".") != 0) && (strcmp(filename, "..") != 0))
+		if(dent.inode && (strcmp(filename, ".") != 0) && (strcmp(filename, "..") != 0))
 		{
 			if(strcmp(filename, name) == 0)
 			{
@@ -1134,6 +2036,10 @@ int ext4fs_node_del_dirent(struct ext4fs_node_t * dnode, const char * name)
 				break;
 			}
 		}
+		if(!le16_to_cpu(dent.direntlen))
+		{
+			return -1;
+		}
 
 		poff = off;
 		memcpy(&pdent, &dent, sizeof(pdent));
@@ -1141,23 +2047,27 @@ int ext4fs_node_del_dirent(struct ext4fs_node_t * dnode, const char * name)
 		off += le16_to_cpu(dent.direntlen);
 	}
 
-	if(!found || !poff)
+	if(!found)
 	{
 		return -1;
 	}
 
-	/* Stretch previous directory entry to delete directory entry */
-	/* Handle overflow in below 16-bit addition */
-	pdent.direntlen = le16_to_cpu(le16_to_cpu(pdent.direntlen) + le16_to_cpu(dent.direntlen));
-	wlen = ext4fs_node_write(dnode, poff, sizeof(struct ext2_dirent_t), (char *)&pdent);
+	if(!umod64(off, ctrl->block_size))
+	{
+		/* Entries never span blocks, so the first one of a block is just marked unused */
+		dent.inode = 0;
+		wlen = ext4fs_node_write(dnode, off, sizeof(struct ext2_dirent_t), (char *)&dent);
+	}
+	else
+	{
+		/* Stretch previous directory entry to delete directory entry */
+		pdent.direntlen = le16_to_cpu(le16_to_cpu(pdent.direntlen) + le16_to_cpu(dent.direntlen));
+		wlen = ext4fs_node_write(dnode, poff, sizeof(struct ext2_dirent_t), (char *)&pdent);
+	}
 	if(wlen != sizeof(struct ext2_dirent_t))
 	{
 		return -1;
 	}
 
-	/* Decrement nlinks field of inode */
-	dnode->inode.nlinks = le16_to_cpu(le16_to_cpu(dnode->inode.nlinks) - 1);
-	dnode->inode_dirty = TRUE;
-
 	return 0;
 }
@@ -53,6 +53,13 @@ int ext4fs_mount(struct vfs_mount_t * m, const char * dev)
 		goto fail;
 	}
 
+	/* Checksums are not updated on writes, such volumes are mounted read only */
+	if(!(m->m_flags & MOUNT_RO) && (le32_to_cpu(ctrl->sblock.feature_ro_compat) & (EXT4_FEAT_RO_COMPAT_GDT_CSUM | EXT4_FEAT_RO_COMPAT_METADATA_CSUM)))
+	{
+		LOG("ext4 '%s' has metadata checksums, mounted read only", dev);
+		m->m_flags |= MOUNT_RO;
+	}
+
 	/* Setup root node */
 	root = m->m_root->v_data;
 	rc = ext4fs_node_init(root);
@@ -234,15 +241,8 @@ static int ext4fs_truncate(struct vfs_node_t * n, loff_t off)
 {
 	int rc;
 	struct ext4fs_node_t *node = n->v_data;
-	u64_t fileoff = off;
-	u64_t filesize = ext4fs_node_get_size(node);
 
-	if(filesize <= fileoff)
-	{
-		return -1;
-	}
-
-	rc = ext4fs_node_truncate(node, fileoff);
+	rc = ext4fs_node_truncate(node, off);
 	if(rc)
 	{
 		return rc;
@@ -362,7 +362,7 @@ static int ext4fs_create(struct vfs_node_t * dn, const char *name, u32_t mode)
 	struct ext4fs_node_t *dnode = dn->v_data;
 
 	rc = ext4fs_node_find_dirent(dnode, name, &dent);
-	if(rc != -1)
+	if(rc != ENOENT)
 	{
 		if(!rc)
 		{
@@ -457,7 +457,7 @@ static int ext4fs_rename(struct vfs_node_t * sv, const char * sname, struct vfs_
 	struct ext4fs_node_t *dnode = dn->v_data;
 
 	rc = ext4fs_node_find_dirent(dnode, dname, &dent);
-	if(rc != -1)
+	if(rc != ENOENT)
 	{
 		if(!rc)
 		{
@@ -487,6 +487,20 @@ static int ext4fs_rename(struct vfs_node_t * sv, const char * sname, struct vfs_
 		return rc;
 	}
 
+	/* A moved directory takes its '..' and the link of it along */
+	if((n->v_type == VNT_DIR) && (snode != dnode))
+	{
+		rc = ext4fs_node_set_parent(n->v_data, dnode->inode_no);
+		if(rc)
+		{
+			return rc;
+		}
+		snode->inode.nlinks = le16_to_cpu(le16_to_cpu(snode->inode.nlinks) - 1);
+		snode->inode_dirty = TRUE;
+		dnode->inode.nlinks = le16_to_cpu(le16_to_cpu(dnode->inode.nlinks) + 1);
+		dnode->inode_dirty = TRUE;
+	}
+
 	return 0;
 }
 
@@ -502,7 +516,7 @@ static int ext4fs_mkdir(struct vfs_node_t * dn, const char *name, u32_t mode)
 	struct ext4fs_control_t *ctrl = dnode->ctrl;
 
 	rc = ext4fs_node_find_dirent(dnode, name, &dent);
-	if(rc != -1)
+	if(rc != ENOENT)
 	{
 		if(!rc)
 		{
@@ -522,7 +536,8 @@ static int ext4fs_mkdir(struct vfs_node_t * dn, const char *name, u32_t mode)
 
 	memset(&inode, 0, sizeof(inode));
 
-	inode.nlinks = le16_to_cpu(1);
+	/* Linked from the parent and from its own '.' */
+	inode.nlinks = le16_to_cpu(2);
 
 	filemode = EXT2_S_IFDIR;
 	filemode |= (mode & S_IRUSR) ? EXT2_S_IRUSR : 0;
@@ -559,11 +574,11 @@ static int ext4fs_mkdir(struct vfs_node_t * dn, const char *name, u32_t mode)
 	dent.inode = le32_to_cpu(inode_no);
 	dent.filetype = 0;
 	dent.namelen = 1;
-	dent.direntlen = le16_to_cpu(sizeof(dent) + 1);
+	dent.direntlen = le16_to_cpu(sizeof(dent) + 4);
 	memcpy(&buf[i], &dent, sizeof(dent));
 	i += sizeof(dent);
 	memcpy(&buf[i], ".", 1);
-	i += 1;
+	i += 4;
 	dent.inode = le32_to_cpu(dnode->inode_no);
 	dent.filetype = 0;
 	dent.namelen = 2;
@@ -595,6 +610,11 @@ static int ext4fs_mkdir(struct vfs_node_t * dn, const char *name, u32_t mode)
 		goto failed2;
 	}
 
+	/* The '..' of the new directory links the parent */
+	dnode->inode.nlinks = le16_to_cpu(le16_to_cpu(dnode->inode.nlinks) + 1);
+	dnode->inode_dirty = TRUE;
+	ext4fs_control_count_dir(ctrl, inode_no, 1);
+
 	return 0;
 
 failed2:
@@ -628,17 +648,27 @@ static int ext4fs_rmdir(struct vfs_node_t * dn, struct vfs_node_t * n, const cha
 		return rc;
 	}
 
+	/* Written now, a later sync must not bring the freed inode back */
+	rc = ext4fs_node_sync(node);
+	if(rc)
+	{
+		return rc;
+	}
+
 	rc = ext4fs_node_del_dirent(dnode, name);
 	if(rc)
 	{
 		return rc;
 	}
+	dnode->inode.nlinks = le16_to_cpu(le16_to_cpu(dnode->inode.nlinks) - 1);
+	dnode->inode_dirty = TRUE;
 
 	rc = ext4fs_control_free_inode(dnode->ctrl, node->inode_no);
 	if(rc)
 	{
 		return rc;
 	}
+	ext4fs_control_count_dir(dnode->ctrl, node->inode_no, -1);
 
 	return 0;
 }
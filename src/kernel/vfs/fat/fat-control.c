@@ -28,152 +28,124 @@
 
 #include <vfs/fat/fat-control.h>
 
-static int __fatfs_control_flush_fat_cache(struct fatfs_control_t * ctrl, u32_t index)
+static int __fatfs_control_flush_fat_cache(struct fatfs_control_t * ctrl, struct fat_cache_sector_t * cs)
 {
-	u32_t i, sect_num;
+	u32_t i;
 	u64_t fat_base, len;
 
-	if(!ctrl->fat_cache_dirty[index])
+	if(!cs->dirty)
 		return 0;
 
 	for(i = 0; i < ctrl->number_of_fat; i++)
 	{
 		fat_base = ((u64_t)ctrl->first_fat_sector + (i * ctrl->sectors_per_fat)) * ctrl->bytes_per_sector;
-		sect_num = ctrl->fat_cache_num[index];
-		len = block_write(ctrl->bdev, &ctrl->fat_cache_buf[index * ctrl->bytes_per_sector], fat_base + sect_num * ctrl->bytes_per_sector,
-		        ctrl->bytes_per_sector);
+		len = block_write(ctrl->bdev, cs->buf, fat_base + (u64_t)cs->num * ctrl->bytes_per_sector, ctrl->bytes_per_sector);
 		if(len != ctrl->bytes_per_sector)
 			return -1;
 	}
-	ctrl->fat_cache_dirty[index] = FALSE;
+	cs->dirty = FALSE;
 
 	return 0;
 }
 
-static int __fatfs_control_find_fat_cache(struct fatfs_control_t * ctrl, u32_t sect_num)
+static struct fat_cache_sector_t * __fatfs_control_load_fat_cache(struct fatfs_control_t * ctrl, u32_t sect_num)
 {
-	int index;
+	struct list_head * head = &ctrl->fat_cache_hash[sect_num % FAT_TABLE_CACHE_HASH];
+	struct fat_cache_sector_t * cs;
+	u64_t fat_base, len;
 
-	for(index = 0; index < FAT_TABLE_CACHE_SIZE; index++)
+	list_for_each_entry(cs, head, hentry)
 	{
-		if(ctrl->fat_cache_num[index] == sect_num)
-			return index;
+		if(cs->num == sect_num)
+		{
+			list_move(&cs->lentry, &ctrl->fat_cache_lru);
+			return cs;
+		}
 	}
-	return -1;
-}
 
-static int __fatfs_control_load_fat_cache(struct fatfs_control_t * ctrl, u32_t sect_num)
-{
-	int rc;
-	u32_t index;
-	u64_t fat_base, len;
-
-	if(-1 < __fatfs_control_find_fat_cache(ctrl, sect_num))
-		return 0;
-
-	index = ctrl->fat_cache_victim;
-	ctrl->fat_cache_victim++;
-	if(ctrl->fat_cache_victim == FAT_TABLE_CACHE_SIZE)
-		ctrl->fat_cache_victim = 0;
+	cs = list_last_entry(&ctrl->fat_cache_lru, struct fat_cache_sector_t, lentry);
+	if(__fatfs_control_flush_fat_cache(ctrl, cs))
+		return NULL;
+	list_del_init(&cs->hentry);
+	cs->num = ~0;
 
-	rc = __fatfs_control_flush_fat_cache(ctrl, index);
-	if(rc)
-		return rc;
-
-	fat_base = (u64_t) ctrl->first_fat_sector * ctrl->bytes_per_sector;
-	len = block_read(ctrl->bdev, &ctrl->fat_cache_buf[index * ctrl->bytes_per_sector], fat_base + sect_num * ctrl->bytes_per_sector, ctrl->bytes_per_sector);
+	fat_base = (u64_t)ctrl->first_fat_sector * ctrl->bytes_per_sector;
+	len = block_read(ctrl->bdev, cs->buf, fat_base + (u64_t)sect_num * ctrl->bytes_per_sector, ctrl->bytes_per_sector);
 	if(len != ctrl->bytes_per_sector)
-		return -1;
-	ctrl->fat_cache_num[index] = sect_num;
+		return NULL;
+	cs->num = sect_num;
+	list_add(&cs->hentry, head);
+	list_move(&cs->lentry, &ctrl->fat_cache_lru);
 
-	return 0;
+	return cs;
 }
 
-static u32_t __fatfs_control_read_fat_cache(struct fatfs_control_t * ctrl, u8_t * buf, u32_t pos)
+/*
+ * Byte wise access, a FAT12 entry may straddle two sectors
+ */
+static u8_t * __fatfs_control_fat_cache_byte(struct fatfs_control_t * ctrl, u32_t pos, bool_t dirty)
 {
-	int rc, index;
-	u32_t ret, sect_num, sect_off;
+	struct fat_cache_sector_t * cs;
+	u32_t sect_num;
 
 	if((ctrl->sectors_per_fat * ctrl->bytes_per_sector) <= pos)
-		return 0;
+		return NULL;
 
 	sect_num = udiv32(pos, ctrl->bytes_per_sector);
-	sect_off = pos - (sect_num * ctrl->bytes_per_sector);
-
-	rc = __fatfs_control_load_fat_cache(ctrl, sect_num);
-	if(rc)
-		return 0;
-
-	index = __fatfs_control_find_fat_cache(ctrl, sect_num);
-	if(index < 0)
-		return 0;
+	cs = __fatfs_control_load_fat_cache(ctrl, sect_num);
+	if(!cs)
+		return NULL;
+	if(dirty)
+		cs->dirty = TRUE;
 
-	index = (index * ctrl->bytes_per_sector) + sect_off;
+	return &cs->buf[pos - (sect_num * ctrl->bytes_per_sector)];
+}
 
+static u32_t __fatfs_control_fat_entry_size(struct fatfs_control_t * ctrl)
+{
 	switch(ctrl->type)
 	{
 	case FAT_TYPE_12:
 	case FAT_TYPE_16:
-		ret = 2;
-		buf[0] = ctrl->fat_cache_buf[index + 0];
-		buf[1] = ctrl->fat_cache_buf[index + 1];
-		break;
+		return 2;
 	case FAT_TYPE_32:
-		ret = 4;
-		buf[0] = ctrl->fat_cache_buf[index + 0];
-		buf[1] = ctrl->fat_cache_buf[index + 1];
-		buf[2] = ctrl->fat_cache_buf[index + 2];
-		buf[3] = ctrl->fat_cache_buf[index + 3];
-		break;
+		return 4;
 	default:
-		ret = 0;
 		break;
 	};
-
-	return ret;
+	return 0;
 }
 
-static u32_t __fatfs_control_write_fat_cache(struct fatfs_control_t * ctrl, u8_t * buf, u32_t pos)
+static u32_t __fatfs_control_read_fat_cache(struct fatfs_control_t * ctrl, u8_t * buf, u32_t pos)
 {
-	int rc, index, cache_buf_index;
-	u32_t ret, sect_num, sect_off;
-
-	if((ctrl->sectors_per_fat * ctrl->bytes_per_sector) <= pos)
-		return 0;
-
-	sect_num = udiv32(pos, ctrl->bytes_per_sector);
-	sect_off = pos - (sect_num * ctrl->bytes_per_sector);
+	u32_t ret, i;
+	u8_t * p;
 
-	rc = __fatfs_control_load_fat_cache(ctrl, sect_num);
-	if(rc)
-		return 0;
+	ret = __fatfs_control_fat_entry_size(ctrl);
+	for(i = 0; i < ret; i++)
+	{
+		p = __fatfs_control_fat_cache_byte(ctrl, pos + i, FALSE);
+		if(!p)
+			return 0;
+		buf[i] = *p;
+	}
 
-	index = __fatfs_control_find_fat_cache(ctrl, sect_num);
-	if(index < 0)
-		return 0;
+	return ret;
+}
 
-	cache_buf_index = (index * ctrl->bytes_per_sector) + sect_off;
+static u32_t __fatfs_control_write_fat_cache(struct fatfs_control_t * ctrl, u8_t * buf, u32_t pos)
+{
+	u32_t ret, i;
+	u8_t * p;
 
-	switch(ctrl->type)
+	ret = __fatfs_control_fat_entry_size(ctrl);
+	for(i = 0; i < ret; i++)
 	{
-	case FAT_TYPE_12:
-	case FAT_TYPE_16:
-		ret = 2;
-		ctrl->fat_cache_buf[cache_buf_index + 0] = buf[0];
-		ctrl->fat_cache_buf[cache_buf_index + 1] = buf[1];
-		break;
-	case FAT_TYPE_32:
-		ret = 4;
-		ctrl->fat_cache_buf[cache_buf_index + 0] = buf[0];
-		ctrl->fat_cache_buf[cache_buf_index + 1] = buf[1];
-		ctrl->fat_cache_buf[cache_buf_index + 2] = buf[2];
-		ctrl->fat_cache_buf[cache_buf_index + 3] = buf[3];
-		break;
-	default:
-		ret = 0;
-		break;
-	};
-	ctrl->fat_cache_dirty[index] = TRUE;
+		p = __fatfs_control_fat_cache_byte(ctrl, pos + i, TRUE);
+		if(!p)
+			return 0;
+		*p = buf[i];
+	}
 
 	return ret;
 }
@@ -197,19 +169,23 @@ static u32_t __fatfs_control_first_valid_cluster(struct fatfs_control_t * ctrl)
 
 static u32_t __fatfs_control_last_valid_cluster(struct fatfs_control_t * ctrl)
 {
+	u32_t last;
+
 	switch(ctrl->type)
 	{
 	case FAT_TYPE_12:
-		return FAT12_RESERVED2_CLUSTER - 1;
+		last = FAT12_RESERVED2_CLUSTER - 1;
 		break;
 	case FAT_TYPE_16:
-		return FAT16_RESERVED2_CLUSTER - 1;
+		last = FAT16_RESERVED2_CLUSTER - 1;
 		break;
 	case FAT_TYPE_32:
-		return FAT32_RESERVED2_CLUSTER - 1;
+		last = FAT32_RESERVED2_CLUSTER - 1;
 		break;
+	default:
+		return 0x0;
 	}
-	return 0x0;
+	return (ctrl->data_clusters + 1 < last) ? ctrl->data_clusters + 1 : last;
 }
 
 static bool_t __fatfs_control_valid_cluster(struct fatfs_control_t * ctrl, u32_t cl)
@@ -284,6 +260,142 @@ static int __fatfs_control_get_next_cluster(struct fatfs_control_t * ctrl, u32_t
 	return 0;
 }
 
+static void __fatfs_control_bitmap_set(struct fatfs_control_t * ctrl, u32_t clust, bool_t used)
+{
+	u32_t * w;
+	u32_t i, m;
+
+	if(!ctrl->free_bitmap || (clust < 2) || (clust - 2 >= ctrl->data_clusters))
+		return;
+
+	i = clust - 2;
+	w = &ctrl->free_bitmap[i >> 5];
+	m = 1U << (i & 31);
+	if(used && !(*w & m))
+	{
+		*w |= m;
+		ctrl->free_count--;
+	}
+	else if(!used && (*w & m))
+	{
+		*w &= ~m;
+		ctrl->free_count++;
+	}
+}
+
+/*
+ * Scan the whole FAT once, FAT16 and FAT32 in large reads straight from the
+ * device after writing back the sector cache
+ */
+static int __fatfs_control_build_bitmap(struct fatfs_control_t * ctrl)
+{
+	struct fat_cache_sector_t * cs;
+	u32_t words, esz, end, last, c, n, i, next;
+	u64_t fat_base, len;
+	u8_t * buf;
+
+	words = (ctrl->data_clusters + 31) >> 5;
+	if(!words)
+		return -1;
+	ctrl->free_bitmap = calloc(words, sizeof(u32_t));
+	if(!ctrl->free_bitmap)
+		return -1;
+	ctrl->free_count = 0;
+	ctrl->free_hint = 0;
+
+	esz = __fatfs_control_fat_entry_size(ctrl);
+	last = __fatfs_control_last_valid_cluster(ctrl);
+	if(ctrl->type == FAT_TYPE_12)
+		end = udiv32(ctrl->sectors_per_fat * ctrl->bytes_per_sector * 2, 3);
+	else
+		end = udiv32(ctrl->sectors_per_fat * ctrl->bytes_per_sector, esz);
+	if(end > last + 1)
+		end = last + 1;
+
+	if(ctrl->type == FAT_TYPE_12)
+	{
+		for(c = 2; c < end; c++)
+		{
+			if(__fatfs_control_get_next_cluster(ctrl, c, &next))
+				goto fail;
+			if(next)
+				ctrl->free_bitmap[(c - 2) >> 5] |= 1U << ((c - 2) & 31);
+			else
+				ctrl->free_count++;
+		}
+	}
+	else
+	{
+		list_for_each_entry(cs, &ctrl->fat_cache_lru, lentry)
+		{
+			if(__fatfs_control_flush_fat_cache(ctrl, cs))
+				goto fail;
+		}
+		buf = malloc(SZ_32K);
+		if(!buf)
+			goto fail;
+		fat_base = (u64_t)ctrl->first_fat_sector * ctrl->bytes_per_sector;
+		for(c = 2; c < end; )
+		{
+			n = end - c;
+			if(n > SZ_32K / esz)
+				n = SZ_32K / esz;
+			len = block_read(ctrl->bdev, buf, fat_base + (u64_t)c * esz, n * esz);
+			if(len != n * esz)
+			{
+				free(buf);
+				goto fail;
+			}
+			for(i = 0; i < n; i++, c++)
+			{
+				if(esz == 4)
+					next = ((u32_t)buf[i * 4 + 3] << 24 | (u32_t)buf[i * 4 + 2] << 16 | (u32_t)buf[i * 4 + 1] << 8 | buf[i * 4 + 0]) & 0x0FFFFFFF;
+				else
+					next = (u32_t)buf[i * 2 + 1] << 8 | buf[i * 2 + 0];
+				if(next)
+					ctrl->free_bitmap[(c - 2) >> 5] |= 1U << ((c - 2) & 31);
+				else
+					ctrl->free_count++;
+			}
+		}
+		free(buf);
+	}
+
+	/* Clusters the FAT can not describe and the tail bits are never free */
+	for(i = (end > 2) ? end - 2 : 0; i < (words << 5); i++)
+		ctrl->free_bitmap[i >> 5] |= 1U << (i & 31);
+	return 0;
+
+fail:
+	free(ctrl->free_bitmap);
+	ctrl->free_bitmap = NULL;
+	return -1;
+}
+
+static bool_t __fatfs_control_bitmap_find(struct fatfs_control_t * ctrl, u32_t start, u32_t * clust)
+{
+	u32_t words = (ctrl->data_clusters + 31) >> 5;
+	u32_t i, n, w;
+
+	if(start >= ctrl->data_clusters)
+		start = 0;
+
+	i = start >> 5;
+	w = ctrl->free_bitmap[i] | ((1U << (start & 31)) - 1);
+	for(n = 0; n <= words; n++)
+	{
+		if(w != 0xFFFFFFFF)
+		{
+			*clust = (i << 5) + __ffs(~w) + 2;
+			return TRUE;
+		}
+		if(++i >= words)
+			i = 0;
+		w = ctrl->free_bitmap[i];
+	}
+	return FALSE;
+}
+
 static int __fatfs_control_set_next_cluster(struct fatfs_control_t * ctrl, u32_t clust, u32_t next)
 {
 	u8_t fat_entry_b[4];
@@ -340,6 +452,7 @@ static int __fatfs_control_set_next_cluster(struct fatfs_control_t * ctrl, u32_t
 	len = __fatfs_control_write_fat_cache(ctrl, &fat_entry_b[0], fat_off);
 	if(len != fat_len)
 		return -1;
+	__fatfs_control_bitmap_set(ctrl, clust, next ? TRUE : FALSE);
 
 	return 0;
 }
@@ -404,26 +517,40 @@ static int __fatfs_control_alloc_cluster(struct fatfs_control_t * ctrl, u32_t cl
 
 	found = FALSE;
 
-	if(__fatfs_control_valid_cluster(ctrl, clust))
+	if(!ctrl->free_bitmap)
+		__fatfs_control_build_bitmap(ctrl);
+
+	if(ctrl->free_bitmap)
 	{
-		first = clust;
+		/* Search after the given cluster so that files stay contiguous */
+		if(!ctrl->free_count)
+			return -1;
+		first = __fatfs_control_valid_cluster(ctrl, clust) ? clust - 2 : ctrl->free_hint;
+		found = __fatfs_control_bitmap_find(ctrl, first, &current);
 	}
 	else
 	{
-		first = __fatfs_control_first_valid_cluster(ctrl);
-	}
-
-	last = __fatfs_control_last_valid_cluster(ctrl);
-	for(current = first; current <= last; current++)
-	{
-		rc = __fatfs_control_get_next_cluster(ctrl, current, &next);
-		if(rc)
-			return rc;
+		if(__fatfs_control_valid_cluster(ctrl, clust))
+		{
+			first = clust;
+		}
+		else
+		{
+			first = __fatfs_control_first_valid_cluster(ctrl);
+		}
 
-		if(next == 0x0)
+		last = __fatfs_control_last_valid_cluster(ctrl);
+		for(current = first; current <= last; current++)
 		{
-			found = TRUE;
-			break;
+			rc = __fatfs_control_get_next_cluster(ctrl, current, &next);
+			if(rc)
+				return rc;
+
+			if(next == 0x0)
+			{
+				found = TRUE;
+				break;
+			}
 		}
 	}
 
@@ -433,6 +560,7 @@ static int __fatfs_control_alloc_cluster(struct fatfs_control_t * ctrl, u32_t cl
 	rc = __fatfs_control_set_last_cluster(ctrl, current);
 	if(rc)
 		return rc;
+	ctrl->free_hint = current - 2 + 1;
 
 	if(newclust)
 		*newclust = current;
@@ -616,7 +744,7 @@ int fatfs_control_sync(struct fatfs_control_t * ctrl)
 	mutex_lock(&ctrl->fat_cache_lock);
 	for(index = 0; index < FAT_TABLE_CACHE_SIZE; index++)
 	{
-		rc = __fatfs_control_flush_fat_cache(ctrl, index);
+		rc = __fatfs_control_flush_fat_cache(ctrl, &ctrl->fat_cache[index]);
 		if(rc)
 		{
 			mutex_unlock(&ctrl->fat_cache_lock);
@@ -720,15 +848,23 @@ int fatfs_control_init(struct fatfs_control_t * ctrl, struct block_t * bdev)
 
 	/* Initialize fat cache */
 	mutex_init(&ctrl->fat_cache_lock);
-	ctrl->fat_cache_victim = 0;
-	for(i = 0; i < FAT_TABLE_CACHE_SIZE; i++)
-	{
-		ctrl->fat_cache_dirty[i] = FALSE;
-		ctrl->fat_cache_num[i] = i;
-	}
 	ctrl->fat_cache_buf = calloc(1, FAT_TABLE_CACHE_SIZE * ctrl->bytes_per_sector);
 	if(!ctrl->fat_cache_buf)
 		return -1;
+	for(i = 0; i < FAT_TABLE_CACHE_HASH; i++)
+		init_list_head(&ctrl->fat_cache_hash[i]);
+	init_list_head(&ctrl->fat_cache_lru);
+	for(i = 0; i < FAT_TABLE_CACHE_SIZE; i++)
+	{
+		ctrl->fat_cache[i].num = i;
+		ctrl->fat_cache[i].dirty = FALSE;
+		ctrl->fat_cache[i].buf = &ctrl->fat_cache_buf[i * ctrl->bytes_per_sector];
+		list_add(&ctrl->fat_cache[i].hentry, &ctrl->fat_cache_hash[i % FAT_TABLE_CACHE_HASH]);
+		list_add_tail(&ctrl->fat_cache[i].lentry, &ctrl->fat_cache_lru);
+	}
+	ctrl->free_bitmap = NULL;
+	ctrl->free_count = 0;
+	ctrl->free_hint = 0;
 
 	/* Load fat cache */
 	rlen = block_read(ctrl->bdev, ctrl->fat_cache_buf, ctrl->first_fat_sector * ctrl->bytes_per_sector,
@@ -744,6 +880,7 @@ int fatfs_control_init(struct fatfs_control_t * ctrl, struct block_t * bdev)
 
 int fatfs_control_exit(struct fatfs_control_t * ctrl)
 {
+	free(ctrl->free_bitmap);
 	free(ctrl->fat_cache_buf);
 	return 0;
 }
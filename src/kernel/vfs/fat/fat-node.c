@@ -167,77 +167,224 @@ static int fatfs_node_clear_cluster(struct fatfs_node_t * node, u32_t clust)
 
 	/* init cluster */
 	memset(node->cached_data, 0, ctrl->bytes_per_cluster);
+	node->cached_dirty = TRUE;
 	return 0;
 }
 
-static int fatfs_node_nth_cluster(struct fatfs_node_t * node, u32_t clust, u32_t pos, u32_t * next)
+static void fatfs_node_extent_reset(struct fatfs_node_t * node)
 {
-	return fatfs_control_nth_cluster(node->ctrl, clust, pos, next);
+	node->extent_count = 0;
+	node->extent_victim = 0;
 }
 
-static int fatfs_node_next_cluster(struct fatfs_node_t * node, u32_t clust, u32_t * next)
+static void fatfs_node_extent_add(struct fatfs_node_t * node, u32_t fcl, u32_t dcl, u32_t len)
 {
-	return fatfs_node_nth_cluster(node, clust, 1, next);
+	struct fatfs_extent_t * e;
+	u32_t i;
+
+	for(i = 0; i < node->extent_count; i++)
+	{
+		e = &node->extent[i];
+		if(e->fcl == fcl)
+		{
+			if(e->len < len)
+				e->len = len;
+			return;
+		}
+		if((e->fcl + e->len == fcl) && (e->dcl + e->len == dcl))
+		{
+			e->len += len;
+			return;
+		}
+	}
+
+	if(node->extent_count < FAT_NODE_EXTENT_CACHE_SIZE)
+	{
+		e = &node->extent[node->extent_count++];
+	}
+	else
+	{
+		e = &node->extent[node->extent_victim];
+		node->extent_victim = (node->extent_victim + 1) % FAT_NODE_EXTENT_CACHE_SIZE;
+	}
+	e->fcl = fcl;
+	e->dcl = dcl;
+	e->len = len;
 }
 
-static int fatfs_node_auto_alloc_next_cluster(struct fatfs_node_t * node, u32_t clust, u32_t * next)
+/*
+ * Map a file cluster index to its device cluster. A miss walks the chain from
+ * the end of the nearest cached run below the index, caching every run it
+ * passes, the last one too when the chain ends early.
+ */
+static int fatfs_node_map_cluster(struct fatfs_node_t * node, u32_t idx, u32_t * clust)
 {
-	int rc;
 	struct fatfs_control_t * ctrl = node->ctrl;
-	u32_t cl = clust;
+	struct fatfs_extent_t * e, * best = NULL;
+	u32_t fcl, dcl, len, next, i;
+	int rc = 0;
 
-	/* Go to next cluster */
-	rc = fatfs_node_next_cluster(node, clust, next);
-	if(!rc)
-		return 0;
+	for(i = 0; i < node->extent_count; i++)
+	{
+		e = &node->extent[i];
+		if(idx < e->fcl)
+			continue;
+		if(idx - e->fcl < e->len)
+		{
+			*clust = e->dcl + (idx - e->fcl);
+			return 0;
+		}
+		if(!best || (e->fcl > best->fcl))
+			best = e;
+	}
 
-	/* Add new cluster */
-	if(fatfs_control_valid_cluster(ctrl, clust))
+	if(best)
 	{
-		rc = fatfs_control_append_free_cluster(ctrl, cl, next);
+		fcl = best->fcl;
+		dcl = best->dcl;
+		len = best->len;
 	}
 	else
 	{
-		rc = fatfs_control_alloc_first_cluster(ctrl, next);
+		if(!fatfs_control_valid_cluster(ctrl, node->first_cluster))
+			return -1;
+		fcl = 0;
+		dcl = node->first_cluster;
+		len = 1;
 	}
 
+	while(fcl + len <= idx)
+	{
+		rc = fatfs_control_nth_cluster(ctrl, dcl + len - 1, 1, &next);
+		if(rc)
+			break;
+		if(next == dcl + len)
+		{
+			len++;
+		}
+		else
+		{
+			fatfs_node_extent_add(node, fcl, dcl, len);
+			fcl += len;
+			dcl = next;
+			len = 1;
+		}
+	}
+	fatfs_node_extent_add(node, fcl, dcl, len);
 	if(rc)
 		return rc;
 
-	rc = fatfs_node_clear_cluster(node, *next);
-
-	if(rc)
-		return rc;
-
+	*clust = dcl + (idx - fcl);
 	return 0;
 }
 
-static void fatfs_node_fast_jump_cluster(struct fatfs_node_t * node, u32_t pos, u32_t * cl_pos, u32_t * cl_num)
+/*
+ * Map a file cluster index and count how many clusters from there, up to max,
+ * are contiguous on the device. Returns zero if the index is not mapped.
+ */
+static u32_t fatfs_node_map_run(struct fatfs_node_t * node, u32_t idx, u32_t max, u32_t * clust)
 {
-	struct fatfs_control_t *ctrl = node->ctrl;
+	u32_t n, c;
 
-	node->cur_pos = ctrl->bytes_per_cluster * udiv32(node->cur_pos, ctrl->bytes_per_cluster);
+	if(fatfs_node_map_cluster(node, idx, clust))
+		return 0;
+	for(n = 1; n < max; n++)
+	{
+		if(fatfs_node_map_cluster(node, idx + n, &c) || (c != *clust + n))
+			break;
+	}
+	return n;
+}
+
+/*
+ * Like fatfs_node_map_cluster, but extends the chain with zeroed clusters up
+ * to the index. The cluster at the index itself is left as is unless clear,
+ * for callers about to overwrite all of it.
+ */
+static int fatfs_node_get_cluster(struct fatfs_node_t * node, u32_t idx, u32_t * clust, bool_t clear)
+{
+	struct fatfs_control_t * ctrl = node->ctrl;
+	struct fatfs_extent_t * e, * tail;
+	u32_t last, next, fcl, c, i;
+	int rc;
 
-	/* Jump to current pos if pos >= cur_cluster*/
-	if(pos >= node->cur_pos)
+	while(fatfs_node_map_cluster(node, idx, clust))
 	{
-		*cl_pos = udiv32(pos - node->cur_pos, ctrl->bytes_per_cluster);
-		*cl_num = node->cur_cluster;
+		if(!fatfs_control_valid_cluster(ctrl, node->first_cluster))
+		{
+			rc = fatfs_control_alloc_first_cluster(ctrl, &c);
+			if(rc)
+				return rc;
+			node->first_cluster = c;
+			node->parent_dent_dirty = TRUE;
+			fatfs_node_extent_reset(node);
+			fatfs_node_extent_add(node, 0, c, 1);
+			fcl = 0;
+		}
+		else
+		{
+			tail = NULL;
+			for(i = 0; i < node->extent_count; i++)
+			{
+				e = &node->extent[i];
+				if(!tail || (e->fcl > tail->fcl))
+					tail = e;
+			}
+			if(!tail)
+				return -1;
+
+			/* Only append at a real end of chain, not after a read error */
+			last = tail->dcl + tail->len - 1;
+			if(!fatfs_control_nth_cluster(ctrl, last, 1, &next) || (next == last))
+				return -1;
+			rc = fatfs_control_append_free_cluster(ctrl, last, &c);
+			if(rc)
+				return rc;
+			fcl = tail->fcl + tail->len;
+			fatfs_node_extent_add(node, fcl, c, 1);
+		}
+
+		if(clear || (fcl != idx))
+		{
+			rc = fatfs_node_clear_cluster(node, c);
+			if(rc)
+				return rc;
+		}
 	}
-	else
+	return 0;
+}
+
+/*
+ * Transfer whole contiguous clusters between the device and the caller's
+ * buffer in one request, bypassing the cached cluster
+ */
+static u64_t fatfs_node_direct_io(struct fatfs_node_t * node, u32_t clust, u32_t count, u8_t * buf, bool_t write)
+{
+	struct fatfs_control_t * ctrl = node->ctrl;
+	u64_t off, len;
+
+	if((node->cached_clust >= clust) && (node->cached_clust - clust < count))
 	{
-		*cl_pos = udiv32(pos, ctrl->bytes_per_cluster);
-		*cl_num = node->first_cluster;
-		node->cur_cluster = node->first_cluster;
-		node->cur_pos = 0;
+		if(write)
+			node->cached_dirty = FALSE;
+		else if(fatfs_node_sync_cached_cluster(node))
+			return 0;
+		node->cached_clust = 0;
 	}
+
+	off = (u64_t) ctrl->first_data_sector * ctrl->bytes_per_sector;
+	off += (u64_t) (clust - 2) * ctrl->bytes_per_cluster;
+	len = (u64_t) count * ctrl->bytes_per_cluster;
+	if(write)
+		return block_write(ctrl->bdev, buf, off, len);
+	return block_read(ctrl->bdev, buf, off, len);
 }
 
 u32_t fatfs_node_read(struct fatfs_node_t * node, u32_t pos, u32_t len, u8_t * buf)
 {
 	u64_t roff, rlen;
-	u32_t r, rstartcl;
-	u32_t cl_off, cl_num, cl_len;
+	u32_t r;
+	u32_t cl_idx, cl_off, cl_num, cl_len, cl_cnt;
 	struct fatfs_control_t *ctrl = node->ctrl;
 
 	if(!node->parent && ctrl->type != FAT_TYPE_32)
@@ -254,46 +401,53 @@ u32_t fatfs_node_read(struct fatfs_node_t * node, u32_t pos, u32_t len, u8_t * b
 		return block_read(ctrl->bdev, (u8_t *) buf, roff, rlen);
 	}
 
-	fatfs_node_fast_jump_cluster(node, pos, &rstartcl, &cl_num);
-
-	if(fatfs_node_nth_cluster(node, cl_num, rstartcl, &cl_num))
-		return 0;
-
 	r = 0;
-	cl_off = umod32(pos + r, ctrl->bytes_per_cluster);
-	do
+	cl_idx = udiv32(pos, ctrl->bytes_per_cluster);
+	cl_off = pos - cl_idx * ctrl->bytes_per_cluster;
+	while(r < len)
 	{
-		/* Current cluster info */
-		cl_len = ctrl->bytes_per_cluster - cl_off;
-		cl_len = (len - r < cl_len) ? len - r : cl_len;
-
-		/* Update current cluster */
-		node->cur_cluster = cl_num;
-		node->cur_pos = pos + r;
+		if(!cl_off && (len - r >= ctrl->bytes_per_cluster))
+		{
+			/* Whole clusters, read each contiguous run at once */
+			cl_cnt = fatfs_node_map_run(node, cl_idx, udiv32(len - r, ctrl->bytes_per_cluster), &cl_num);
+			if(!cl_cnt)
+				break;
+			cl_len = cl_cnt * ctrl->bytes_per_cluster;
+			rlen = fatfs_node_direct_io(node, cl_num, cl_cnt, buf, FALSE);
+			if(rlen != cl_len)
+				break;
+		}
+		else
+		{
+			if(fatfs_node_map_cluster(node, cl_idx, &cl_num))
+				break;
 
-		/* Read from cached cluster */
-		rlen = fatfs_node_read_cluster(node, cl_num, buf, cl_off, cl_len);
+			/* Current cluster info */
+			cl_cnt = 1;
+			cl_len = ctrl->bytes_per_cluster - cl_off;
+			cl_len = (len - r < cl_len) ? len - r : cl_len;
 
-		if(rlen != cl_len)
-		{
-			break;
+			/* Read from cached cluster */
+			rlen = fatfs_node_read_cluster(node, cl_num, buf, cl_off, cl_len);
+			if(rlen != cl_len)
+				break;
 		}
 
 		/* Update iteration */
 		r += cl_len;
 		buf += cl_len;
-		cl_off -= cl_off;
-	} while(r < len && !fatfs_node_next_cluster(node, cl_num, &cl_num));
+		cl_off = 0;
+		cl_idx += cl_cnt;
+	}
 
 	return r;
 }
 
 u32_t fatfs_node_write(struct fatfs_node_t * node, u32_t pos, u32_t len, u8_t * buf)
 {
-	int rc;
 	u64_t woff, wlen;
-	u32_t w = 0, wstartcl;
-	u32_t cl_off, cl_num, cl_len;
+	u32_t w;
+	u32_t cl_idx, cl_off, cl_num, cl_len, cl_cnt, n;
 	struct fatfs_control_t *ctrl = node->ctrl;
 
 	if(!node->parent && ctrl->type != FAT_TYPE_32)
@@ -303,61 +457,58 @@ u32_t fatfs_node_write(struct fatfs_node_t * node, u32_t pos, u32_t len, u8_t *
 			return 0;
 		if((pos + len) > wlen)
 			wlen = wlen - pos;
+		else
+			wlen = len;
 		woff = (u64_t) ctrl->first_root_sector * ctrl->bytes_per_sector;
 		woff += pos;
 		return block_write(ctrl->bdev, (u8_t *) buf, woff, wlen);
 	}
 
-	/* If first cluster is zero then allocate first cluster */
-	if(node->first_cluster == 0)
-	{
-		rc = fatfs_node_auto_alloc_next_cluster(node, 0, &cl_num);
-		if(rc)
-			return 0;
-
-		node->first_cluster = cl_num;
-		node->cur_cluster = node->first_cluster;
-		node->cur_pos = 0;
-
-		/* Mark node directory entry as dirty */
-		node->parent_dent_dirty = TRUE;
-	}
-
-	fatfs_node_fast_jump_cluster(node, pos, &wstartcl, &cl_num);
-
-	/* Make room for new data by appending free clusters */
-	for(int i = 0; i < wstartcl; i++)
-	{
-		rc = fatfs_node_auto_alloc_next_cluster(node, cl_num, &cl_num);
-		if(rc)
-			return 0;
-	}
-
 	w = 0;
-	cl_off = umod32(pos + w, ctrl->bytes_per_cluster);
-	do
+	cl_idx = udiv32(pos, ctrl->bytes_per_cluster);
+	cl_off = pos - cl_idx * ctrl->bytes_per_cluster;
+	while(w < len)
 	{
-		/* Current cluster info */
-		cl_len = ctrl->bytes_per_cluster - cl_off;
-		cl_len = (len - w < cl_len) ? len - w : cl_len;
-
-		/* Update current cluster */
-		node->cur_cluster = cl_num;
-		node->cur_pos = pos + w;
+		if(!cl_off && (len - w >= ctrl->bytes_per_cluster))
+		{
+			/* Whole clusters, allocate without clearing and write each contiguous run at once */
+			cl_cnt = udiv32(len - w, ctrl->bytes_per_cluster);
+			for(n = 0; n < cl_cnt; n++)
+			{
+				if(fatfs_node_get_cluster(node, cl_idx + n, &cl_num, FALSE))
+					break;
+			}
+			cl_cnt = fatfs_node_map_run(node, cl_idx, n, &cl_num);
+			if(!cl_cnt)
+				break;
+			cl_len = cl_cnt * ctrl->bytes_per_cluster;
+			wlen = fatfs_node_direct_io(node, cl_num, cl_cnt, buf, TRUE);
+			if(wlen != cl_len)
+				break;
+		}
+		else
+		{
+			/* Make room for new data by appending free clusters */
+			if(fatfs_node_get_cluster(node, cl_idx, &cl_num, TRUE))
+				break;
 
-		/* Write next cluster */
-		wlen = fatfs_node_write_cluster(node, cl_num, buf, cl_off, cl_len);
+			/* Current cluster info */
+			cl_cnt = 1;
+			cl_len = ctrl->bytes_per_cluster - cl_off;
+			cl_len = (len - w < cl_len) ? len - w : cl_len;
 
-		if(wlen != cl_len)
-		{
-			break;
+			/* Write next cluster */
+			wlen = fatfs_node_write_cluster(node, cl_num, buf, cl_off, cl_len);
+			if(wlen != cl_len)
+				break;
 		}
 
 		/* Update iteration */
 		w += cl_len;
 		buf += cl_len;
-		cl_off -= cl_off;
-	} while(w < len && !fatfs_node_auto_alloc_next_cluster(node, cl_num, &cl_num));
+		cl_off = 0;
+		cl_idx += cl_cnt;
+	}
 
 	/* Mark node directory entry as dirty */
 	node->parent_dent_dirty = TRUE;
@@ -368,7 +519,7 @@ u32_t fatfs_node_write(struct fatfs_node_t * node, u32_t pos, u32_t len, u8_t *
 int fatfs_node_truncate(struct fatfs_node_t * node, u32_t pos)
 {
 	int rc;
-	u32_t cl_pos, cl_num, t_pos;
+	u32_t cl_cnt, cl_num, cl_off, next;
 	struct fatfs_control_t * ctrl = node->ctrl;
 
 	if(!node->parent && ctrl->type != FAT_TYPE_32)
@@ -377,43 +528,54 @@ int fatfs_node_truncate(struct fatfs_node_t * node, u32_t pos)
 		return 0;
 	}
 
-	/* Determine last cluster after truncation */
-	t_pos = udiv32(pos + ctrl->bytes_per_cluster - 1, ctrl->bytes_per_cluster);
-	fatfs_node_fast_jump_cluster(node, t_pos + ctrl->bytes_per_cluster - 1, &cl_pos, &cl_num);
-
-	rc = fatfs_control_nth_cluster(ctrl, cl_num, cl_pos, &cl_num);
-	if(rc)
-		return rc;
+	if(!fatfs_control_valid_cluster(ctrl, node->first_cluster))
+		return 0;
 
-	/* Remove all clusters after last cluster */
-	rc = fatfs_control_truncate_clusters(ctrl, cl_num);
+	/* The cached cluster may be among the ones freed */
+	rc = fatfs_node_sync_cached_cluster(node);
 	if(rc)
 		return rc;
+	node->cached_clust = 0;
 
-	/* If we are removing first cluster then set it to zero
-	 * else set previous cluster as last cluster
-	 */
-	if(cl_pos == 0)
+	/* Number of clusters left after truncation */
+	cl_cnt = udiv32(pos + ctrl->bytes_per_cluster - 1, ctrl->bytes_per_cluster);
+	if(cl_cnt == 0)
 	{
+		rc = fatfs_control_truncate_clusters(ctrl, node->first_cluster);
+		if(rc)
+			return rc;
 		node->first_cluster = 0;
 	}
 	else
 	{
-		/* if go here, t_pos >= node->first_cluster */
-		t_pos -= ctrl->bytes_per_cluster;
-		fatfs_node_fast_jump_cluster(node, t_pos, &cl_pos, &cl_num);
-		rc = fatfs_control_nth_cluster(ctrl, cl_num, cl_pos, &cl_num);
-		if(rc)
-			return rc;
-		rc = fatfs_control_set_last_cluster(ctrl, cl_num);
+		rc = fatfs_node_map_cluster(node, cl_cnt - 1, &cl_num);
 		if(rc)
 			return rc;
+		if(!fatfs_control_nth_cluster(ctrl, cl_num, 1, &next))
+		{
+			rc = fatfs_control_set_last_cluster(ctrl, cl_num);
+			if(rc)
+				return rc;
+			rc = fatfs_control_truncate_clusters(ctrl, next);
+			if(rc)
+				return rc;
+		}
+
+		/* Zero the tail of the last cluster, it reads back if the file grows again */
+		cl_off = pos - (cl_cnt - 1) * ctrl->bytes_per_cluster;
+		if(cl_off < ctrl->bytes_per_cluster)
+		{
+			rc = fatfs_node_alloc_cached_cluster(node, cl_num, TRUE);
+			if(rc)
+				return rc;
+			memset(node->cached_data + cl_off, 0, ctrl->bytes_per_cluster - cl_off);
+			node->cached_dirty = TRUE;
+		}
 	}
+	fatfs_node_extent_reset(node);
 
 	/* Mark node directory entry as dirty */
 	node->parent_dent_dirty = TRUE;
-	node->cur_cluster = node->first_cluster;
-	node->cur_pos = 0;
 	return 0;
 }
 
@@ -441,8 +603,7 @@ int fatfs_node_init(struct fatfs_control_t * ctrl, struct fatfs_node_t * node)
 	memset(&node->parent_dent, 0, sizeof(struct fat_dirent_t));
 	node->parent_dent_dirty = FALSE;
 	node->first_cluster = 0;
-	node->cur_cluster = 0;
-	node->cur_pos = 0;
+	fatfs_node_extent_reset(node);
 
 	node->cached_clust = 0;
 	node->cached_data = NULL;
@@ -617,10 +778,10 @@ int fatfs_node_find_dirent(struct fatfs_node_t * dnode, const char * name, struc
 	{
 		rlen = fatfs_node_read(dnode, off, sizeof(struct fat_dirent_t), (u8_t *) dent);
 		if(rlen != sizeof(struct fat_dirent_t))
-			return -1;
+			return ENOENT;
 
 		if(dent->dos_file_name[0] == 0x0)
-			return -1;
+			return ENOENT;
 
 		off += sizeof(struct fat_dirent_t);
 
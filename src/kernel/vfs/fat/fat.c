@@ -68,8 +68,6 @@ static int fatfs_mount(struct vfs_mount_t * m, const char * dev)
 	{
 		root->first_cluster = 0x0;
 	}
-	root->cur_cluster = root->first_cluster;
-	root->cur_pos = 0;
 	root->parent_dent_dirty = FALSE;
 
 	/* Handcraft the root vfs node */
@@ -146,7 +144,7 @@ static int fatfs_vput(struct vfs_mount_t * m, struct vfs_node_t * n)
 static u64_t fatfs_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 {
 	struct fatfs_node_t * node = n->v_data;
-	u32_t filesize = fatfs_node_get_size(node);
+	u32_t filesize = (u32_t) n->v_size;
 
 	if(filesize <= (u32_t) off)
 		return 0;
@@ -165,8 +163,9 @@ static u64_t fatfs_write(struct vfs_node_t * n, s64_t off, void * buf, u64_t len
 
 	wlen = fatfs_node_write(node, (u32_t) off, len, buf);
 
-	/* Size and mtime might have changed */
-	n->v_size += wlen;
+	/* Size and mtime might have changed, the directory entry follows on sync */
+	if((u64_t) off + wlen > n->v_size)
+		n->v_size = off + wlen;
 	n->v_mtime = time(&t);
 
 	return wlen;
@@ -178,9 +177,9 @@ static int fatfs_truncate(struct vfs_node_t * n, s64_t off)
 	struct fatfs_node_t * node = n->v_data;
 	time_t t;
 
-	if((u32_t) off > fatfs_node_get_size(node))
+	if(off > n->v_size)
 		return -1;
-	else if((u32_t) off == fatfs_node_get_size(node))
+	else if(off == n->v_size)
 		return 0;
 
 	rc = fatfs_node_truncate(node, (u32_t) off);
@@ -291,8 +290,6 @@ static int fatfs_lookup(struct vfs_node_t * dn, const char * name, struct vfs_no
 		node->first_cluster = 0;
 	}
 	node->first_cluster |= le16_to_cpu(dent.first_cluster_lo);
-	node->cur_cluster = node->first_cluster;
-	node->cur_pos = 0;
 
 	n->v_mode = 0;
 
@@ -334,7 +331,7 @@ static int fatfs_create(struct vfs_node_t * dn, const char * name, u32_t mode)
 	struct fatfs_node_t *dnode = dn->v_data;
 
 	rc = fatfs_node_find_dirent(dnode, name, &dent, &off, &len);
-	if(rc != -1)
+	if(rc != ENOENT)
 	{
 		if(!rc)
 			return -1;
@@ -421,7 +418,7 @@ static int fatfs_rename(struct vfs_node_t * sv, const char *sname, struct vfs_no
 	struct fatfs_node_t *dnode = dn->v_data;
 
 	rc = fatfs_node_find_dirent(dnode, dname, &dent, &off, &len);
-	if(rc != -1)
+	if(rc != ENOENT)
 	{
 		if(!rc)
 			return -1;
@@ -454,7 +451,7 @@ static int fatfs_mkdir(struct vfs_node_t * dn, const char *name, u32_t mode)
 	struct fatfs_node_t *dnode = dn->v_data;
 
 	rc = fatfs_node_find_dirent(dnode, name, &dent, &off, &len);
-	if(rc != -1)
+	if(rc != ENOENT)
 	{
 		if(!rc)
 			return -1;
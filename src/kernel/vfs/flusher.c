@@ -0,0 +1,158 @@
+/*
+ * kernel/vfs/flusher.c
+ *
+ * Copyright(c) 2007-2020 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <block/block.h>
+#include <vfs/vfs.h>
+
+/*
+ * Background write back. Every interval the flusher wakes up and writes back
+ * the buffer cache blocks that have been dirty longer than expire, or the
+ * oldest ones while the dirty blocks take more than ratio percent of the
+ * cache budget. Every expire the mounted filesystems are synced as well, after
+ * the buffer cache has been drained so the sync itself has little left to do.
+ * Scheduling is cooperative, so the flusher writes a small batch at a time
+ * and yields in between.
+ */
+struct flusher_stat_t {
+	u64_t wakeup;
+	u64_t vfs;
+	u64_t writeback;
+	u64_t sync;
+	s64_t step;
+};
+
+static int __flusher_interval = CONFIG_FLUSHER_INTERVAL;
+static int __flusher_expire = CONFIG_FLUSHER_DIRTY_EXPIRE;
+static int __flusher_ratio = CONFIG_FLUSHER_DIRTY_RATIO;
+static struct flusher_stat_t __flusher_stat;
+
+static void flusher_writeback(ktime_t expire)
+{
+	ktime_t begin;
+	s64_t us;
+	u64_t n;
+
+	do {
+		begin = ktime_get();
+		n = block_writeback(expire, __flusher_ratio, CONFIG_FLUSHER_BATCH);
+		us = ktime_us_delta(ktime_get(), begin);
+		if(us > __flusher_stat.step)
+			__flusher_stat.step = us;
+		__flusher_stat.writeback += n;
+		task_yield();
+	} while(n > 0);
+}
+
+void vfs_flusher_task(struct task_t * task, void * data)
+{
+	ktime_t now, next, vnext;
+
+	next = vnext = ktime_get();
+	while(1)
+	{
+		now = ktime_get();
+		if(ktime_before(now, next))
+		{
+			task_yield();
+			continue;
+		}
+		next = ktime_add_ms(now, __flusher_interval);
+		__flusher_stat.wakeup++;
+
+		if(ktime_before(now, vnext))
+		{
+			flusher_writeback(ktime_sub_ms(now, __flusher_expire));
+		}
+		else
+		{
+			vnext = ktime_add_ms(now, __flusher_expire);
+			flusher_writeback(now);
+			vfs_sync();
+			__flusher_stat.vfs++;
+		}
+		__flusher_stat.sync += block_writeback_sync();
+	}
+}
+
+static ssize_t flusher_read_interval(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __flusher_interval);
+}
+
+static ssize_t flusher_write_interval(struct kobj_t * kobj, void * buf, size_t size)
+{
+	int v = strtol(buf, NULL, 0);
+	if(v > 0)
+		__flusher_interval = v;
+	return size;
+}
+
+static ssize_t flusher_read_expire(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __flusher_expire);
+}
+
+static ssize_t flusher_write_expire(struct kobj_t * kobj, void * buf, size_t size)
+{
+	int v = strtol(buf, NULL, 0);
+	if(v >= 0)
+		__flusher_expire = v;
+	return size;
+}
+
+static ssize_t flusher_read_ratio(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __flusher_ratio);
+}
+
+static ssize_t flusher_write_ratio(struct kobj_t * kobj, void * buf, size_t size)
+{
+	int v = strtol(buf, NULL, 0);
+	if((v >= 0) && (v <= 100))
+		__flusher_ratio = v;
+	return size;
+}
+
+static ssize_t flusher_read_stat(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct flusher_stat_t * st = &__flusher_stat;
+	return sprintf(buf, "wakeup: %lld\r\nvfs: %lld\r\nwriteback: %lld\r\nsync: %lld\r\nstep: %lldus", st->wakeup, st->vfs, st->writeback, st->sync, st->step);
+}
+
+static __init void flusher_pure_init(void)
+{
+	struct kobj_t * kclass = kobj_search_directory_with_create(kobj_get_root(), "class");
+	struct kobj_t * kflusher = kobj_search_directory_with_create(kclass, "flusher");
+
+	kobj_add_regular(kflusher, "interval", flusher_read_interval, flusher_write_interval, NULL);
+	kobj_add_regular(kflusher, "expire", flusher_read_expire, flusher_write_expire, NULL);
+	kobj_add_regular(kflusher, "ratio", flusher_read_ratio, flusher_write_ratio, NULL);
+	kobj_add_regular(kflusher, "stat", flusher_read_stat, NULL, NULL);
+}
+pure_initcall(flusher_pure_init);
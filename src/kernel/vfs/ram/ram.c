@@ -29,18 +29,137 @@
 #include <xboot.h>
 #include <vfs/vfs.h>
 
+/*
+ * File data lives in fixed size pages, a missing page is a hole that reads
+ * as zeros. Bytes of a page past the end of file are always kept zeroed.
+ * The leading pages of a mapped file are slices of one flat buffer instead.
+ */
+#define RAM_PAGE_SIZE		(CONFIG_RAMFS_PAGE_SIZE)
+
+struct ram_mount_t {
+	atomic_t nodes;
+	atomic_t pages;
+};
+
 struct ram_node_t {
 	struct list_head entry;
 	struct list_head children;
 	enum vfs_node_type_t type;
 	char * name;
 	u32_t mode;
-	char * buf;
-	u64_t buflen;
+	char ** pages;
+	u64_t npages;
+	char * flat;
+	u64_t nflat;
 	u64_t size;
 };
 
-static struct ram_node_t * ram_node_alloc(const char * name, enum vfs_node_type_t type)
+static char * ram_page_get(struct ram_mount_t * rm, struct ram_node_t * rn, u64_t index, bool_t alloc)
+{
+	char ** pages;
+	u64_t npages;
+
+	if(index >= rn->npages)
+	{
+		if(!alloc)
+			return NULL;
+		npages = rn->npages ? rn->npages : 16;
+		while(npages <= index)
+			npages <<= 1;
+		pages = realloc(rn->pages, npages * sizeof(char *));
+		if(!pages)
+			return NULL;
+		memset(&pages[rn->npages], 0, (npages - rn->npages) * sizeof(char *));
+		rn->pages = pages;
+		rn->npages = npages;
+	}
+	if(!rn->pages[index] && alloc)
+	{
+		rn->pages[index] = malloc(RAM_PAGE_SIZE);
+		if(!rn->pages[index])
+			return NULL;
+		memset(rn->pages[index], 0, RAM_PAGE_SIZE);
+		atomic_inc(&rm->pages);
+	}
+	return rn->pages[index];
+}
+
+/*
+ * Move the pages of the whole file into one flat buffer, holes become zeroed
+ * pages. Slices already in the old flat buffer are copied like any other page.
+ */
+static bool_t ram_page_flatten(struct ram_mount_t * rm, struct ram_node_t * rn)
+{
+	u64_t cnt = (rn->size + RAM_PAGE_SIZE - 1) / RAM_PAGE_SIZE;
+	char * flat;
+	u64_t i;
+
+	if(cnt <= rn->nflat)
+		return TRUE;
+	if(!ram_page_get(rm, rn, cnt - 1, TRUE))
+		return FALSE;
+	flat = malloc(cnt * RAM_PAGE_SIZE);
+	if(!flat)
+		return FALSE;
+	for(i = 0; i < cnt; i++)
+	{
+		if(rn->pages[i])
+		{
+			memcpy(flat + i * RAM_PAGE_SIZE, rn->pages[i], RAM_PAGE_SIZE);
+			if(i >= rn->nflat)
+				free(rn->pages[i]);
+		}
+		else
+		{
+			memset(flat + i * RAM_PAGE_SIZE, 0, RAM_PAGE_SIZE);
+			atomic_inc(&rm->pages);
+		}
+		rn->pages[i] = flat + i * RAM_PAGE_SIZE;
+	}
+	free(rn->flat);
+	rn->flat = flat;
+	rn->nflat = cnt;
+	return TRUE;
+}
+
+static void ram_page_trim(struct ram_mount_t * rm, struct ram_node_t * rn, u64_t size)
+{
+	u64_t index = (size + RAM_PAGE_SIZE - 1) / RAM_PAGE_SIZE;
+	u64_t i;
+
+	for(i = index; i < rn->npages; i++)
+	{
+		if(i < rn->nflat)
+		{
+			memset(rn->pages[i], 0, RAM_PAGE_SIZE);
+		}
+		else if(rn->pages[i])
+		{
+			free(rn->pages[i]);
+			rn->pages[i] = NULL;
+			atomic_dec(&rm->pages);
+		}
+	}
+	if(index == 0)
+	{
+		if(rn->flat)
+		{
+			free(rn->flat);
+			atomic_sub(&rm->pages, rn->nflat);
+			rn->flat = NULL;
+			rn->nflat = 0;
+		}
+		free(rn->pages);
+		rn->pages = NULL;
+		rn->npages = 0;
+	}
+	else if((size % RAM_PAGE_SIZE) && (index <= rn->npages) && rn->pages[index - 1])
+	{
+		memset(rn->pages[index - 1] + (size % RAM_PAGE_SIZE), 0, RAM_PAGE_SIZE - (size % RAM_PAGE_SIZE));
+	}
+}
+
+static struct ram_node_t * ram_node_alloc(struct ram_mount_t * rm, const char * name, enum vfs_node_type_t type)
 {
 	struct ram_node_t * rn;
 
@@ -58,38 +177,44 @@ static struct ram_node_t * ram_node_alloc(const char * name, enum vfs_node_type_
 	init_list_head(&rn->children);
 	rn->type = type;
 	rn->mode = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
-	rn->buf = NULL;
-	rn->buflen = 0;
+	rn->pages = NULL;
+	rn->npages = 0;
+	rn->flat = NULL;
+	rn->nflat = 0;
 	rn->size = 0;
+	atomic_inc(&rm->nodes);
 
 	return rn;
 }
 
-static void ram_node_free(struct ram_node_t * rn)
+static void ram_node_free(struct ram_mount_t * rm, struct ram_node_t * rn)
 {
-	if(rn->name)
-		free(rn->name);
-	if(rn->buf)
+	struct ram_node_t * pos, * n;
+
+	list_for_each_entry_safe(pos, n, &(rn->children), entry)
 	{
-		free(rn->buf);
-		rn->buf = NULL;
-		rn->buflen = 0;
+		list_del(&pos->entry);
+		ram_node_free(rm, pos);
 	}
+	if(rn->name)
+		free(rn->name);
+	ram_page_trim(rm, rn, 0);
+	atomic_dec(&rm->nodes);
 	free(rn);
 }
 
-static struct ram_node_t * ram_node_add(struct ram_node_t * rn, const char * name, enum vfs_node_type_t type)
+static struct ram_node_t * ram_node_add(struct ram_mount_t * rm, struct ram_node_t * rn, const char * name, enum vfs_node_type_t type)
 {
 	struct ram_node_t * n;
 
-	n = ram_node_alloc(name, type);
+	n = ram_node_alloc(rm, name, type);
 	if(!n)
 		return NULL;
 	list_add_tail(&n->entry, &rn->children);
 	return n;
 }
 
-static int ram_node_remove(struct ram_node_t * drn, struct ram_node_t * rn)
+static int ram_node_remove(struct ram_mount_t * rm, struct ram_node_t * drn, struct ram_node_t * rn)
 {
 	struct ram_node_t * pos, * n;
 
@@ -98,13 +223,46 @@ static int ram_node_remove(struct ram_node_t * drn, struct ram_node_t * rn)
 		if(pos == rn)
 		{
 			list_del(&pos->entry);
-			ram_node_free(pos);
+			ram_node_free(rm, pos);
 			return 0;
 		}
 	}
 	return -1;
 }
 
+/*
+ * Copy into the pages, a null buffer writes zeros without filling holes
+ */
+static u64_t ram_node_write(struct ram_mount_t * rm, struct ram_node_t * rn, s64_t off, const char * buf, u64_t len)
+{
+	u64_t index, o, sz, done = 0;
+	char * page;
+
+	while(done < len)
+	{
+		index = (off + done) / RAM_PAGE_SIZE;
+		o = (off + done) % RAM_PAGE_SIZE;
+		sz = RAM_PAGE_SIZE - o;
+		if(sz > len - done)
+			sz = len - done;
+		if(buf)
+		{
+			page = ram_page_get(rm, rn, index, TRUE);
+			if(!page)
+				break;
+			memcpy(page + o, buf + done, sz);
+		}
+		else if((page = ram_page_get(rm, rn, index, FALSE)))
+		{
+			memset(page + o, 0, sz);
+		}
+		done += sz;
+	}
+	if(off + done > rn->size)
+		rn->size = off + done;
+	return done;
+}
+
 static int ramfs_rename_node(struct ram_node_t * rn, const char * name)
 {
 	if(rn->name)
@@ -117,22 +275,34 @@ static int ramfs_rename_node(struct ram_node_t * rn, const char * name)
 
 static int ram_mount(struct vfs_mount_t * m, const char * dev)
 {
+	struct ram_mount_t * rm;
 	struct ram_node_t * rn;
 
 	if(dev)
 		return -1;
-	rn = ram_node_alloc("/", VNT_DIR);
+	rm = malloc(sizeof(struct ram_mount_t));
+	if(!rm)
+		return -1;
+	atomic_set(&rm->nodes, 0);
+	atomic_set(&rm->pages, 0);
+	rn = ram_node_alloc(rm, "/", VNT_DIR);
 	if(!rn)
+	{
+		free(rm);
 		return -1;
+	}
 	m->m_root->v_data = (void *)rn;
-	m->m_data = NULL;
+	m->m_data = rm;
 	return 0;
 }
 
 static int ram_unmount(struct vfs_mount_t * m)
 {
-	ram_node_free(m->m_root->v_data);
+	struct ram_mount_t * rm = m->m_data;
+
+	ram_node_free(rm, m->m_root->v_data);
 	m->m_data = NULL;
+	free(rm);
 	return 0;
 }
 
@@ -154,7 +324,8 @@ static int ram_vput(struct vfs_mount_t * m, struct vfs_node_t * n)
 static u64_t ram_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 {
 	struct ram_node_t * rn;
-	u64_t sz;
+	u64_t index, o, sz, done = 0;
+	char * page;
 
 	if(n->v_type != VNT_REG)
 		return 0;
@@ -162,84 +333,49 @@ static u64_t ram_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 	if(off >= n->v_size)
 		return 0;
 
-	sz = len;
-	if((n->v_size - off) < sz)
-		sz = n->v_size - off;
+	if((n->v_size - off) < len)
+		len = n->v_size - off;
 
 	rn = n->v_data;
-	memcpy(buf, rn->buf + off, sz);
-	return sz;
+	while(done < len)
+	{
+		index = (off + done) / RAM_PAGE_SIZE;
+		o = (off + done) % RAM_PAGE_SIZE;
+		sz = RAM_PAGE_SIZE - o;
+		if(sz > len - done)
+			sz = len - done;
+		page = ram_page_get(n->v_mount->m_data, rn, index, FALSE);
+		if(page)
+			memcpy((char *)buf + done, page + o, sz);
+		else
+			memset((char *)buf + done, 0, sz);
+		done += sz;
+	}
+	return len;
 }
 
 static u64_t ram_write(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 {
 	struct ram_node_t * rn;
-	void * nbuf;
-	u64_t nsize;
-	u64_t epos;
+	u64_t ret;
 
 	if(n->v_type != VNT_REG)
 		return 0;
 
 	rn = n->v_data;
-	epos = n->v_size;
+	ret = ram_node_write(n->v_mount->m_data, rn, off, buf, len);
+	n->v_size = rn->size;
 
-	if(off + len > epos)
-	{
-		epos = off + len;
-		if(epos > rn->buflen)
-		{
-			nsize = (epos + 0xfff) & ~0xfff;
-			nbuf = malloc(nsize);
-			if(!nbuf)
-				return -1;
-			if(rn->size != 0)
-			{
-				memcpy(nbuf, rn->buf, n->v_size);
-				free(rn->buf);
-			}
-			rn->buf = nbuf;
-			rn->buflen = nsize;
-		}
-		rn->size = epos;
-		n->v_size = epos;
-	}
-	memcpy(rn->buf + off, buf, len);
-
-	return len;
+	return ret;
 }
 
 static int ram_truncate(struct vfs_node_t * n, s64_t off)
 {
 	struct ram_node_t * rn;
-	void * nbuf;
-	u64_t nsize;
 
 	rn = n->v_data;
-
-	if(off == 0)
-	{
-		if(rn->buf != NULL)
-		{
-			free(rn->buf);
-			rn->buf = NULL;
-			rn->buflen = 0;
-		}
-	}
-	else if(off > rn->buflen)
-	{
-		nsize = (off + 0xfff) & ~0xfff;
-		nbuf = malloc(nsize);
-		if(!nbuf)
-			return -1;
-		if(rn->size != 0)
-		{
-			memcpy(nbuf, rn->buf, n->v_size);
-			free(rn->buf);
-		}
-		rn->buf = nbuf;
-		rn->buflen = nsize;
-	}
+	if(off < rn->size)
+		ram_page_trim(n->v_mount->m_data, rn, off);
 	rn->size = off;
 	n->v_size = off;
 
@@ -303,7 +439,7 @@ static int ram_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node
 			return 0;
 		}
 	}
-	return -1;
+	return ENOENT;
 }
 
 static int ram_create(struct vfs_node_t * dn, const char * name, u32_t mode)
@@ -312,7 +448,7 @@ static int ram_create(struct vfs_node_t * dn, const char * name, u32_t mode)
 
 	if(!S_ISREG(mode))
 		return -1;
-	rn = ram_node_add(dn->v_data, name, VNT_REG);
+	rn = ram_node_add(dn->v_mount->m_data, dn->v_data, name, VNT_REG);
 	if(!rn)
 		return -1;
 	rn->mode = mode & (S_IRWXU | S_IRWXG | S_IRWXO);
@@ -321,7 +457,7 @@ static int ram_create(struct vfs_node_t * dn, const char * name, u32_t mode)
 
 static int ram_remove(struct vfs_node_t * dn, struct vfs_node_t * n, const char * name)
 {
-	return ram_node_remove(dn->v_data, n->v_data);
+	return ram_node_remove(dn->v_mount->m_data, dn->v_data, n->v_data);
 }
 
 static int ram_rename(struct vfs_node_t * sn, const char * sname, struct vfs_node_t * n, struct vfs_node_t * dn, const char * dname)
@@ -336,19 +472,23 @@ static int ram_rename(struct vfs_node_t * sn, const char * sname, struct vfs_nod
 	else
 	{
 		orn = n->v_data;
-		rn = ram_node_add(dn->v_data, dname, VNT_REG);
+		rn = ram_node_add(dn->v_mount->m_data, dn->v_data, dname, VNT_REG);
 		if(!rn)
 			return -1;
 		if(n->v_type == VNT_REG)
 		{
-			rn->buf = orn->buf;
-			rn->buflen = orn->buflen;
+			rn->pages = orn->pages;
+			rn->npages = orn->npages;
+			rn->flat = orn->flat;
+			rn->nflat = orn->nflat;
 			rn->size = orn->size;
-			orn->buf = NULL;
-			orn->buflen = 0;
+			orn->pages = NULL;
+			orn->npages = 0;
+			orn->flat = NULL;
+			orn->nflat = 0;
 			orn->size = 0;
 		}
-		ram_node_remove(sn->v_data, n->v_data);
+		ram_node_remove(sn->v_mount->m_data, sn->v_data, n->v_data);
 	}
 	return 0;
 }
@@ -359,7 +499,7 @@ static int ram_mkdir(struct vfs_node_t * dn, const char * name, u32_t mode)
 
 	if(!S_ISDIR(mode))
 		return -1;
-	rn = ram_node_add(dn->v_data, name, VNT_DIR);
+	rn = ram_node_add(dn->v_mount->m_data, dn->v_data, name, VNT_DIR);
 	if(!rn)
 		return -1;
 	rn->mode = mode & (S_IRWXU | S_IRWXG | S_IRWXO);
@@ -369,7 +509,7 @@ static int ram_mkdir(struct vfs_node_t * dn, const char * name, u32_t mode)
 
 static int ram_rmdir(struct vfs_node_t * dn, struct vfs_node_t * n, const char * name)
 {
-	return ram_node_remove(dn->v_data, n->v_data);
+	return ram_node_remove(dn->v_mount->m_data, dn->v_data, n->v_data);
 }
 
 static int ram_chmod(struct vfs_node_t * n, u32_t mode)
@@ -381,6 +521,54 @@ static int ram_chmod(struct vfs_node_t * n, u32_t mode)
 	return 0;
 }
 
+static u64_t ram_copy(struct vfs_node_t * sn, s64_t soff, struct vfs_node_t * dn, s64_t doff, u64_t len)
+{
+	struct ram_node_t * srn, * drn;
+	u64_t o, sz, r, done = 0;
+	char * page;
+
+	if((sn->v_type != VNT_REG) || (dn->v_type != VNT_REG) || (soff >= sn->v_size))
+		return 0;
+
+	if((sn->v_size - soff) < len)
+		len = sn->v_size - soff;
+
+	/*
+	 * Straight from one ram page into the other, no bounce buffer, and
+	 * holes in the source stay holes
+	 */
+	srn = sn->v_data;
+	drn = dn->v_data;
+	while(done < len)
+	{
+		o = (soff + done) % RAM_PAGE_SIZE;
+		sz = RAM_PAGE_SIZE - o;
+		if(sz > len - done)
+			sz = len - done;
+		page = ram_page_get(sn->v_mount->m_data, srn, (soff + done) / RAM_PAGE_SIZE, FALSE);
+		r = ram_node_write(dn->v_mount->m_data, drn, doff + done, page ? page + o : NULL, sz);
+		done += r;
+		if(r != sz)
+			break;
+	}
+	dn->v_size = drn->size;
+	return done;
+}
+
+/*
+ * Mappings are served in place from the flat buffer. A file only gains pages
+ * past it while unmapped, since vfs refuses to modify a mapped node, so an
+ * older mapping is never left pointing at freed pages.
+ */
+static void * ram_mmap(struct vfs_node_t * n, s64_t off, u64_t len)
+{
+	struct ram_node_t * rn = n->v_data;
+
+	if((n->v_type != VNT_REG) || !ram_page_flatten(n->v_mount->m_data, rn))
+		return NULL;
+	return rn->flat + off;
+}
+
 static struct filesystem_t ram = {
 	.name		= "ram",
 
@@ -402,11 +590,37 @@ static struct filesystem_t ram = {
 	.mkdir		= ram_mkdir,
 	.rmdir		= ram_rmdir,
 	.chmod		= ram_chmod,
+	.copy		= ram_copy,
+	.mmap		= ram_mmap,
 };
 
+static ssize_t ram_read_usage(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct vfs_mount_t * m;
+	struct ram_mount_t * rm;
+	char * p = buf;
+	char tmp[32];
+	int len = 0;
+	int i, cnt;
+
+	len += snprintf(p + len, size - len, "%-24s %8s %8s %s\r\n", "mount", "nodes", "pages", "memory");
+	cnt = vfs_mount_count();
+	for(i = 0; (i < cnt) && (len < size); i++)
+	{
+		m = vfs_mount_get(i);
+		if(!m || (m->m_fs != &ram) || !m->m_data)
+			continue;
+		rm = m->m_data;
+		len += snprintf(p + len, size - len, "%-24s %8d %8d %s\r\n", m->m_path, atomic_get(&rm->nodes), atomic_get(&rm->pages),
+			ssize(tmp, (double)atomic_get(&rm->pages) * RAM_PAGE_SIZE));
+	}
+	return min(len, (int)size);
+}
+
 static __init void filesystem_ram_init(void)
 {
-	register_filesystem(&ram);
+	if(register_filesystem(&ram))
+		kobj_add_regular(ram.kobj, "usage", ram_read_usage, NULL, NULL);
 }
 
 static __exit void filesystem_ram_exit(void)
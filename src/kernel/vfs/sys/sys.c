@@ -34,7 +34,7 @@ static int sys_mount(struct vfs_mount_t * m, const char * dev)
 	if(dev)
 		return -1;
 
-	m->m_flags |= MOUNT_RO;
+	m->m_flags |= MOUNT_RO | MOUNT_NOCACHE;
 	m->m_root->v_data = (void *)kobj_get_root();
 	m->m_data = NULL;
 	return 0;
@@ -143,7 +143,13 @@ static int sys_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node
 	kobj = dn->v_data;
 	obj = kobj_search(kobj, name);
 	if(!obj)
-		return -1;
+	{
+		if(!probe_deferred_device(name))
+			return -1;
+		obj = kobj_search(kobj, name);
+		if(!obj)
+			return -1;
+	}
 
 	n->v_atime = 0;
 	n->v_mtime = 0;
@@ -94,88 +94,215 @@ struct tar_header_t
 	int8_t reserver[12];
 } __attribute__ ((packed));
 
-static bool_t get_next_token(const char * path, const char * perfix, char * result)
-{
-	char full_path[VFS_MAX_PATH];
-	char *p, *q;
-	s32_t l;
+struct tar_entry_t {
+	struct list_head head;
+	struct hlist_node node;
+	struct tar_entry_t * parent;
+	struct tar_entry_t ** child;
+	int nchild;
+	char * path;
+	char * name;
+	u64_t offset;
+	u64_t size;
+	u64_t mtime;
+	u32_t mode;
+	int8_t filetype;
+};
 
-	if(!path || !perfix || !result)
-		return FALSE;
+struct tar_archive_t {
+	struct tar_entry_t root;
+	struct list_head list;
+	struct hlist_head * hash;
+	int hsize;
+};
 
-	full_path[0] = '\0';
+static inline u64_t tar_oct(const int8_t * s, int len)
+{
+	char buf[16];
 
-	if(path[0] != '/')
-		strcpy(full_path, (const char *)("/"));
-	strlcat(full_path, path, sizeof(full_path));
+	memcpy(buf, s, len);
+	buf[len] = '\0';
+	return strtoull(buf, NULL, 8);
+}
 
-	l = strlen(perfix);
-	if(memcmp(full_path, perfix, l) != 0)
-		return FALSE;
+static struct hlist_head * tar_hash(struct tar_archive_t * a, const char * path)
+{
+	return &a->hash[shash(path) % a->hsize];
+}
 
-	p = &full_path[l];
-	if(*p == '\0')
-		return FALSE;
-	if(*p == '/')
-		p++;
-	if(*p == '\0')
-		return FALSE;
+static struct tar_entry_t * tar_search(struct tar_archive_t * a, const char * path)
+{
+	struct tar_entry_t * pos;
 
-	q = strchr(p, '/');
-	if(q)
+	hlist_for_each_entry(pos, tar_hash(a, path), node)
 	{
-		if(*(q+1) != '\0')
-			return FALSE;
-		*q = 0;
+		if(strcmp(pos->path, path) == 0)
+			return pos;
 	}
+	return NULL;
+}
 
-	strcpy(result, p);
+static void tar_archive_free(struct tar_archive_t * a)
+{
+	struct tar_entry_t * pos, * n;
 
-	return TRUE;
+	if(a)
+	{
+		list_for_each_entry_safe(pos, n, &a->list, head)
+		{
+			free(pos->child);
+			free(pos);
+		}
+		free(a->root.child);
+		free(a->hash);
+		free(a);
+	}
 }
 
-static bool_t check_path(const char * path, const char * perfix, const char * name)
+/*
+ * Walk the archive once, hash every path and attach each entry to the child
+ * list of its parent directory, lookup and readdir never rescan the headers.
+ */
+static struct tar_archive_t * tar_archive_alloc(struct block_t * dev)
 {
-	char path1[VFS_MAX_PATH];
-	char path2[VFS_MAX_PATH];
-	char *p;
-	s32_t l;
+	struct tar_header_t header;
+	struct tar_archive_t * a;
+	struct tar_entry_t * e, * pos, * n;
+	char path[VFS_MAX_PATH];
+	u64_t off = 0, data, size;
+	int count = 0;
+	int i, l;
+	char * p;
+
+	a = malloc(sizeof(struct tar_archive_t));
+	if(!a)
+		return NULL;
+	memset(a, 0, sizeof(struct tar_archive_t));
+	init_list_head(&a->list);
+	a->root.path = a->root.name = "";
+	a->root.filetype = FILE_TYPE_DIRECTORY;
 
-	if(!path || !perfix || !name)
-		return FALSE;
+	while(1)
+	{
+		if(block_read(dev, (u8_t *)&header, off, sizeof(struct tar_header_t)) != sizeof(struct tar_header_t))
+			break;
 
-	path1[0] = path2[0] = '\0';
+		if(strncmp((const char *)(header.magic), "ustar", 5) != 0)
+			break;
+
+		size = tar_oct(header.size, sizeof(header.size));
+		data = off + sizeof(struct tar_header_t);
+		off = data + (((size + 511) >> 9) << 9);
+
+		/*
+		 * Skip the extended headers of pax and gnu tar
+		 */
+		if((header.filetype == 'x') || (header.filetype == 'g') || (header.filetype == 'L') || (header.filetype == 'K'))
+			continue;
 
-	if(path[0] != '/')
-		strcpy(path1, (const char *)("/"));
-	strlcat(path1, path, sizeof(path1));
+		memcpy(path, header.name, sizeof(header.name));
+		path[sizeof(header.name)] = '\0';
+		for(p = path; (*p == '/') || ((p[0] == '.') && (p[1] == '/')); p += (*p == '/') ? 1 : 2);
+		for(l = strlen(p); (l > 0) && (p[l - 1] == '/'); l--)
+			p[l - 1] = '\0';
+		if((l == 0) || (strcmp(p, ".") == 0) || (strcmp(p, "..") == 0))
+			continue;
 
-	if(perfix[0] != '/')
-		strcpy(path2, (const char *)("/"));
-	strlcat(path2, perfix, sizeof(path2));
+		e = malloc(sizeof(struct tar_entry_t) + l + 1);
+		if(!e)
+		{
+			tar_archive_free(a);
+			return NULL;
+		}
+		memset(e, 0, sizeof(struct tar_entry_t));
+		e->path = (char *)(e + 1);
+		memcpy(e->path, p, l + 1);
+		e->name = strrchr(e->path, '/');
+		e->name = e->name ? e->name + 1 : e->path;
+		e->offset = data;
+		e->size = size;
+		e->mtime = tar_oct(header.mtime, sizeof(header.mtime));
+		e->mode = tar_oct(header.mode, sizeof(header.mode));
+		e->filetype = header.filetype;
+		list_add_tail(&e->head, &a->list);
+		count++;
+	}
 
-	if(path2[strlen(path2) - 1] != '/')
-		strlcat(path2, (const char *)"/", sizeof(path2));
-	strlcat(path2, (const char *)name, sizeof(path2));
+	a->hsize = count * 2 + 1;
+	a->hash = malloc(sizeof(struct hlist_head) * a->hsize);
+	if(!a->hash)
+	{
+		tar_archive_free(a);
+		return NULL;
+	}
+	for(i = 0; i < a->hsize; i++)
+		init_hlist_head(&a->hash[i]);
 
-	l = strlen(path2);
-	if(memcmp(path1, path2, l) != 0)
-		return FALSE;
+	list_for_each_entry_safe(pos, n, &a->list, head)
+	{
+		if(tar_search(a, pos->path))
+		{
+			list_del(&pos->head);
+			free(pos);
+			continue;
+		}
+		init_hlist_node(&pos->node);
+		hlist_add_head(&pos->node, tar_hash(a, pos->path));
+	}
+
+	list_for_each_entry(pos, &a->list, head)
+	{
+		if(pos->name == pos->path)
+		{
+			pos->parent = &a->root;
+		}
+		else
+		{
+			l = pos->name - pos->path - 1;
+			memcpy(path, pos->path, l);
+			path[l] = '\0';
+			pos->parent = tar_search(a, path);
+		}
+		if(pos->parent)
+			pos->parent->nchild++;
+	}
 
-	p = &path1[l];
-	if(*p == '\0')
-		return TRUE;
-	if(*p == '/')
-		p++;
-	if(*p == '\0')
-		return TRUE;
+	if(a->root.nchild > 0)
+	{
+		a->root.child = malloc(sizeof(struct tar_entry_t *) * a->root.nchild);
+		if(!a->root.child)
+		{
+			tar_archive_free(a);
+			return NULL;
+		}
+		a->root.nchild = 0;
+	}
+	list_for_each_entry(pos, &a->list, head)
+	{
+		if(pos->nchild > 0)
+		{
+			pos->child = malloc(sizeof(struct tar_entry_t *) * pos->nchild);
+			if(!pos->child)
+			{
+				tar_archive_free(a);
+				return NULL;
+			}
+			pos->nchild = 0;
+		}
+	}
+	list_for_each_entry(pos, &a->list, head)
+	{
+		if(pos->parent)
+			pos->parent->child[pos->parent->nchild++] = pos;
+	}
 
-	return FALSE;
+	return a;
 }
 
 static int tar_mount(struct vfs_mount_t * m, const char * dev)
 {
 	struct tar_header_t header;
+	struct tar_archive_t * a;
 	u64_t rd;
 
 	if(dev == NULL)
@@ -191,15 +318,20 @@ static int tar_mount(struct vfs_mount_t * m, const char * dev)
 	if(strncmp((const char *)(header.magic), "ustar", 5) != 0)
 		return -1;
 
+	a = tar_archive_alloc(m->m_dev);
+	if(!a)
+		return -1;
+
 	m->m_flags |= MOUNT_RO;
-	m->m_root->v_data = NULL;
-	m->m_data = NULL;
+	m->m_root->v_data = &a->root;
+	m->m_data = a;
 
 	return 0;
 }
 
 static int tar_unmount(struct vfs_mount_t * m)
 {
+	tar_archive_free(m->m_data);
 	m->m_data = NULL;
 	return 0;
 }
@@ -221,8 +353,9 @@ static int tar_vput(struct vfs_mount_t * m, struct vfs_node_t * n)
 
 static u64_t tar_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 {
-	u64_t toff;
+	struct tar_entry_t * e = (struct tar_entry_t *)(n->v_data);
 	u64_t sz = 0;
+	void * p;
 
 	if(n->v_type != VNT_REG)
 		return 0;
@@ -234,8 +367,11 @@ static u64_t tar_read(struct vfs_node_t * n, s64_t off, void * buf, u64_t len)
 	if((n->v_size - off) < sz)
 		sz = n->v_size - off;
 
-	toff = (u64_t)((unsigned long)(n->v_data));
-	sz = block_read(n->v_mount->m_dev, (u8_t *)buf, (toff + off), sz);
+	p = block_mmap(n->v_mount->m_dev, e->offset + off, sz);
+	if(p)
+		memcpy(buf, p, sz);
+	else
+		sz = block_read(n->v_mount->m_dev, (u8_t *)buf, e->offset + off, sz);
 
 	return sz;
 }
@@ -257,40 +393,12 @@ static int tar_sync(struct vfs_node_t * n)
 
 static int tar_readdir(struct vfs_node_t * dn, s64_t off, struct vfs_dirent_t * d)
 {
-	struct tar_header_t header;
-	char name[VFS_MAX_NAME];
-	u64_t toff = 0, size, rd;
-	int i = 0;
-
-	while(1)
-	{
-		rd = block_read(dn->v_mount->m_dev, (u8_t *)&header, toff, sizeof(struct tar_header_t));
-		if(rd != sizeof(struct tar_header_t))
-			return -1;
-
-		if(strncmp((const char *)(header.magic), "ustar", 5) != 0)
-			return -1;
-
-		size = strtoull((const char *)(header.size), NULL, 0);
-		if(size < 0)
-			return -1;
-
-		if(size == 0)
-			toff += sizeof(struct tar_header_t);
-		else
-			toff += sizeof(struct tar_header_t) + (((size + 512) >> 9) << 9);
-
-		if(!get_next_token((const char *)header.name, dn->v_path, name))
-			continue;
+	struct tar_entry_t * de = (struct tar_entry_t *)(dn->v_data);
 
-		if(i++ == off)
-		{
-			toff = 0;
-			break;
-		}
-	}
+	if((off < 0) || (off >= de->nchild))
+		return -1;
 
-	switch(header.filetype)
+	switch(de->child[off]->filetype)
 	{
 	case FILE_TYPE_NORMAL:
 		d->d_type = VDT_REG;
@@ -320,7 +428,7 @@ static int tar_readdir(struct vfs_node_t * dn, s64_t off, struct vfs_dirent_t *
 		d->d_type = VDT_REG;
 		break;
 	}
-	strlcpy(d->d_name, name, sizeof(d->d_name));
+	strlcpy(d->d_name, de->child[off]->name, sizeof(d->d_name));
 	d->d_off = off;
 	d->d_reclen = 1;
 
@@ -329,41 +437,26 @@ static int tar_readdir(struct vfs_node_t * dn, s64_t off, struct vfs_dirent_t *
 
 static int tar_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node_t * n)
 {
-	struct tar_header_t header;
-	u64_t off = 0, size, rd;
-	u64_t mtime;
+	struct tar_archive_t * a = (struct tar_archive_t *)(dn->v_mount->m_data);
+	struct tar_entry_t * de = (struct tar_entry_t *)(dn->v_data);
+	struct tar_entry_t * e;
+	char path[VFS_MAX_PATH];
 	u32_t mode;
-	char buf[9];
-
-	while(1)
-	{
-		rd = block_read(dn->v_mount->m_dev, (u8_t *)&header, off, sizeof(struct tar_header_t));
-		if(rd != sizeof(struct tar_header_t))
-			return -1;
-
-		if(strncmp((const char *)(header.magic), "ustar", 5) != 0)
-			return -1;
 
-		size = strtoull((const char *)(header.size), NULL, 0);
-		if(size < 0)
-			return -1;
-
-		if(check_path((const char *)(header.name), dn->v_path, name))
-			break;
-
-		if(size == 0)
-			off += sizeof(struct tar_header_t);
-		else
-			off += sizeof(struct tar_header_t) + (((size + 512) >> 9) << 9);
-	}
-
-	mtime = strtoull((const char *)(header.mtime), NULL, 0);
-	n->v_atime = mtime;
-	n->v_mtime = mtime;
-	n->v_ctime = mtime;
+	if(de == &a->root)
+		strlcpy(path, name, sizeof(path));
+	else
+		snprintf(path, sizeof(path), "%s/%s", de->path, name);
+	e = tar_search(a, path);
+	if(!e)
+		return ENOENT;
+
+	n->v_atime = e->mtime;
+	n->v_mtime = e->mtime;
+	n->v_ctime = e->mtime;
 	n->v_mode = 0;
 
-	switch(header.filetype)
+	switch(e->filetype)
 	{
 	case FILE_TYPE_NORMAL:
 		n->v_type = VNT_REG;
@@ -403,9 +496,7 @@ static int tar_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node
 		break;
 	}
 
-	buf[8] = '\0';
-	memcpy(buf, (const char *)(header.mode), 8);
-	mode = strtoul(buf, NULL, 8);
+	mode = e->mode;
 
 	if(mode & 00400)
 		n->v_mode |= S_IRUSR;
@@ -426,8 +517,8 @@ static int tar_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node
 	if(mode & 00001)
 		n->v_mode |= S_IXOTH;
 
-	n->v_size = size;
-	n->v_data = (void *)((unsigned long)(off + sizeof(struct tar_header_t)));
+	n->v_size = e->size;
+	n->v_data = e;
 
 	return 0;
 }
@@ -462,6 +553,15 @@ static int tar_chmod(struct vfs_node_t * n, u32_t mode)
 	return -1;
 }
 
+static void * tar_mmap(struct vfs_node_t * n, s64_t off, u64_t len)
+{
+	struct tar_entry_t * e = (struct tar_entry_t *)(n->v_data);
+
+	if(n->v_type != VNT_REG)
+		return NULL;
+	return block_mmap(n->v_mount->m_dev, e->offset + off, len);
+}
+
 static struct filesystem_t tar = {
 	.name		= "tar",
 
@@ -483,6 +583,7 @@ static struct filesystem_t tar = {
 	.mkdir		= tar_mkdir,
 	.rmdir		= tar_rmdir,
 	.chmod		= tar_chmod,
+	.mmap		= tar_mmap,
 };
 
 static __init void filesystem_tar_init(void)
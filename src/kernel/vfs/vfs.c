@@ -301,6 +301,216 @@ static void vfs_node_put(struct vfs_node_t * n)
 	free(n);
 }
 
+/*
+ * Dentry cache keyed by (parent node, name). A positive entry holds a reference
+ * to the node it names, a negative one records that the filesystem reported the
+ * name missing with ENOENT, other lookup errors are not cached. Both hold a
+ * reference to the parent, so the key stays valid while cached.
+ */
+struct vfs_dentry_t {
+	struct list_head d_link;
+	struct list_head d_lru;
+	struct vfs_node_t * d_parent;
+	struct vfs_node_t * d_node;
+	char d_name[];
+};
+
+static struct list_head dentry_list[CONFIG_VFS_DENTRY_HASH_SIZE];
+static struct list_head dentry_lru;
+static struct mutex_t dentry_lock;
+static int dentry_count;
+static u64_t dentry_hit;
+static u64_t dentry_miss;
+
+static u32_t vfs_dentry_hash(struct vfs_node_t * dn, const char * name)
+{
+	return (shash(name) ^ (u32_t)(((unsigned long)dn) >> 4)) % CONFIG_VFS_DENTRY_HASH_SIZE;
+}
+
+static struct vfs_dentry_t * vfs_dentry_search(struct vfs_node_t * dn, const char * name)
+{
+	struct vfs_dentry_t * d;
+
+	list_for_each_entry(d, &dentry_list[vfs_dentry_hash(dn, name)], d_link)
+	{
+		if((d->d_parent == dn) && !strcmp(d->d_name, name))
+			return d;
+	}
+	return NULL;
+}
+
+static void vfs_dentry_free(struct vfs_dentry_t * d)
+{
+	list_del(&d->d_link);
+	list_del(&d->d_lru);
+	dentry_count--;
+	if(d->d_node)
+		vfs_node_put(d->d_node);
+	vfs_node_put(d->d_parent);
+	free(d);
+}
+
+/*
+ * Return one for a positive hit with a new reference in np, minus one for a
+ * negative hit and zero if nothing is cached
+ */
+static int vfs_dentry_lookup(struct vfs_node_t * dn, const char * name, struct vfs_node_t ** np)
+{
+	struct vfs_dentry_t * d;
+	int ret = 0;
+
+	if(dn->v_mount->m_flags & MOUNT_NOCACHE)
+		return 0;
+
+	mutex_lock(&dentry_lock);
+	d = vfs_dentry_search(dn, name);
+	if(d)
+	{
+		dentry_hit++;
+		list_move(&d->d_lru, &dentry_lru);
+		if(d->d_node)
+		{
+			vfs_node_ref(d->d_node);
+			*np = d->d_node;
+			ret = 1;
+		}
+		else
+		{
+			ret = -1;
+		}
+	}
+	else
+	{
+		dentry_miss++;
+	}
+	mutex_unlock(&dentry_lock);
+
+	return ret;
+}
+
+static void vfs_dentry_add(struct vfs_node_t * dn, const char * name, struct vfs_node_t * n)
+{
+	struct vfs_dentry_t * d;
+	int len;
+
+	if((dn->v_mount->m_flags & MOUNT_NOCACHE) || (CONFIG_VFS_DENTRY_CACHE_SIZE <= 0))
+		return;
+
+	len = strlen(name) + 1;
+	mutex_lock(&dentry_lock);
+	if(!vfs_dentry_search(dn, name) && (d = malloc(sizeof(struct vfs_dentry_t) + len)))
+	{
+		while(dentry_count >= CONFIG_VFS_DENTRY_CACHE_SIZE)
+			vfs_dentry_free(list_last_entry(&dentry_lru, struct vfs_dentry_t, d_lru));
+		vfs_node_ref(dn);
+		if(n)
+			vfs_node_ref(n);
+		d->d_parent = dn;
+		d->d_node = n;
+		memcpy(d->d_name, name, len);
+		list_add(&d->d_link, &dentry_list[vfs_dentry_hash(dn, name)]);
+		list_add(&d->d_lru, &dentry_lru);
+		dentry_count++;
+	}
+	mutex_unlock(&dentry_lock);
+}
+
+static void vfs_dentry_invalidate(struct vfs_node_t * dn, const char * name)
+{
+	struct vfs_dentry_t * d;
+
+	mutex_lock(&dentry_lock);
+	if((d = vfs_dentry_search(dn, name)))
+		vfs_dentry_free(d);
+	mutex_unlock(&dentry_lock);
+}
+
+/*
+ * Drop the entries that name a node or live below it, before checking it is busy
+ */
+static void vfs_dentry_forget(struct vfs_node_t * n)
+{
+	struct vfs_dentry_t * d, * t;
+
+	mutex_lock(&dentry_lock);
+	list_for_each_entry_safe(d, t, &dentry_lru, d_lru)
+	{
+		if((d->d_node == n) || (d->d_parent == n))
+			vfs_dentry_free(d);
+	}
+	mutex_unlock(&dentry_lock);
+}
+
+static void vfs_dentry_purge(struct vfs_mount_t * m)
+{
+	struct vfs_dentry_t * d, * t;
+
+	mutex_lock(&dentry_lock);
+	list_for_each_entry_safe(d, t, &dentry_lru, d_lru)
+	{
+		if(d->d_parent->v_mount == m)
+			vfs_dentry_free(d);
+	}
+	mutex_unlock(&dentry_lock);
+}
+
+static ssize_t vfs_dentry_read_stat(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "hit: %lld\r\nmiss: %lld\r\ncount: %d", dentry_hit, dentry_miss, dentry_count);
+}
+
+static __init void vfs_dentry_pure_init(void)
+{
+	struct kobj_t * kclass = kobj_search_directory_with_create(kobj_get_root(), "class");
+	struct kobj_t * kdentry = kobj_search_directory_with_create(kclass, "dentry");
+
+	kobj_add_regular(kdentry, "stat", vfs_dentry_read_stat, NULL, NULL);
+}
+pure_initcall(vfs_dentry_pure_init);
+
+/*
+ * Read only file mappings. A filesystem whose data already sits in memory hands
+ * out a direct pointer, anything else gets a private copy that is shared by
+ * later mappings of the same range until the file changes. A direct mapping
+ * pins the file, writing or truncating it fails until the last unmap.
+ */
+struct vfs_mmap_t {
+	struct list_head mm_link;
+	struct vfs_node_t * mm_node;
+	s64_t mm_off;
+	u64_t mm_len;
+	void * mm_addr;
+	int mm_copy;
+	int mm_stale;
+	int mm_refcnt;
+};
+
+static struct list_head mmap_list;
+static struct mutex_t mmap_lock;
+
+static int vfs_mmap_modify(struct vfs_node_t * n)
+{
+	struct vfs_mmap_t * mm;
+	int ret = 0;
+
+	mutex_lock(&mmap_lock);
+	list_for_each_entry(mm, &mmap_list, mm_link)
+	{
+		if(mm->mm_node == n)
+		{
+			if(!mm->mm_copy)
+			{
+				ret = -1;
+				break;
+			}
+			mm->mm_stale = 1;
+		}
+	}
+	mutex_unlock(&mmap_lock);
+
+	return ret;
+}
+
 static int vfs_node_stat(struct vfs_node_t * n, struct vfs_stat_t * st)
 {
 	u32_t mode;
@@ -457,7 +667,14 @@ static int vfs_node_acquire(const char * path, struct vfs_node_t ** np)
 		}
 		node[i] = '\0';
 
-		n = vfs_node_lookup(m, node);
+		err = vfs_dentry_lookup(dn, &node[j], &n);
+		if(err < 0)
+		{
+			vfs_node_release(dn);
+			return err;
+		}
+		if(err == 0)
+			n = vfs_node_lookup(m, node);
 		if(n == NULL)
 		{
 			n = vfs_node_get(m, node);
@@ -472,11 +689,19 @@ static int vfs_node_acquire(const char * path, struct vfs_node_t ** np)
 			err = dn->v_mount->m_fs->lookup(dn, &node[j], n);
 			mutex_unlock(&dn->v_lock);
 			mutex_unlock(&n->v_lock);
-			if(err || (*p == '/' && n->v_type != VNT_DIR))
+			if(err)
 			{
+				if(err == ENOENT)
+					vfs_dentry_add(dn, &node[j], NULL);
 				vfs_node_release(n);
 				return err;
 			}
+			vfs_dentry_add(dn, &node[j], n);
+		}
+		if(*p == '/' && n->v_type != VNT_DIR)
+		{
+			vfs_node_release(n);
+			return -1;
 		}
 		dn = n;
 	}
@@ -508,6 +733,7 @@ void vfs_force_unmount(struct vfs_mount_t * m)
 		vfs_force_unmount(tm);
 	}
 	list_del(&m->m_link);
+	vfs_dentry_purge(m);
 
 	mutex_lock(&fd_file_lock);
 	for(i = 0; i < VFS_MAX_FD; i++)
@@ -564,6 +790,8 @@ int vfs_mount(const char * dev, const char * dir, const char * fsname, u32_t fla
 	struct filesystem_t * fs;
 	struct vfs_mount_t * m, * tm;
 	struct vfs_node_t * n, * n_covered;
+	char name[VFS_MAX_PATH + 64];
+	ktime_t begin;
 	int err;
 
 	if(!dir || *dir == '\0')
@@ -629,9 +857,12 @@ int vfs_mount(const char * dev, const char * dir, const char * fsname, u32_t fla
 	n->v_mode = S_IFDIR | S_IRWXU | S_IRWXG | S_IRWXO;
 	m->m_root = n;
 
+	begin = ktime_get();
 	mutex_lock(&m->m_lock);
 	err = m->m_fs->mount(m, dev);
 	mutex_unlock(&m->m_lock);
+	snprintf(name, sizeof(name), "%s %s %s%s", fsname, dev ? dev : "none", dir, (err != 0) ? " (failed)" : "");
+	boottime_record("mount", name, begin, ktime_get());
 	if(err != 0)
 	{
 		vfs_node_release(m->m_root);
@@ -687,6 +918,7 @@ int vfs_unmount(const char * path)
 		mutex_unlock(&mnt_list_lock);
 		return -1;
 	}
+	vfs_dentry_purge(m);
 	if(atomic_get(&m->m_refcnt) > 1)
 	{
 		mutex_unlock(&mnt_list_lock);
@@ -838,6 +1070,7 @@ int vfs_open(const char * path, u32_t flags, u32_t mode)
 			if(!err)
 				err = dn->v_mount->m_fs->sync(dn);
 			mutex_unlock(&dn->v_lock);
+			vfs_dentry_invalidate(dn, filename);
 			vfs_node_release(dn);
 			if(err)
 				return err;
@@ -884,7 +1117,7 @@ int vfs_open(const char * path, u32_t flags, u32_t mode)
 			return -1;
 		}
 		mutex_lock(&n->v_lock);
-		err = n->v_mount->m_fs->truncate(n, 0);
+		err = vfs_mmap_modify(n) ? -1 : n->v_mount->m_fs->truncate(n, 0);
 		mutex_unlock(&n->v_lock);
 		if(err)
 		{
@@ -1018,7 +1251,7 @@ u64_t vfs_write(int fd, void * buf, u64_t len)
 	}
 
 	mutex_lock(&n->v_lock);
-	ret = n->v_mount->m_fs->write(n, f->f_offset, buf, len);
+	ret = vfs_mmap_modify(n) ? 0 : n->v_mount->m_fs->write(n, f->f_offset, buf, len);
 	mutex_unlock(&n->v_lock);
 
 	f->f_offset += ret;
@@ -1027,6 +1260,357 @@ u64_t vfs_write(int fd, void * buf, u64_t len)
 	return ret;
 }
 
+/*
+ * Take a reference on the regular file behind fd, so positional io does not
+ * serialize on the file lock of a shared descriptor
+ */
+static struct vfs_node_t * vfs_fd_to_node(int fd, u32_t flags)
+{
+	struct vfs_node_t * n;
+	struct vfs_file_t * f;
+
+	f = vfs_fd_to_file(fd);
+	if(!f)
+		return NULL;
+
+	mutex_lock(&f->f_lock);
+	n = f->f_node;
+	if(n && (n->v_type == VNT_REG) && (f->f_flags & flags))
+		vfs_node_ref(n);
+	else
+		n = NULL;
+	mutex_unlock(&f->f_lock);
+
+	return n;
+}
+
+u64_t vfs_pread(int fd, void * buf, u64_t len, s64_t off)
+{
+	struct vfs_node_t * n;
+	u64_t ret;
+
+	if(!buf || !len || (off < 0))
+		return 0;
+
+	n = vfs_fd_to_node(fd, O_RDONLY);
+	if(!n)
+		return 0;
+
+	mutex_lock(&n->v_lock);
+	ret = n->v_mount->m_fs->read(n, off, buf, len);
+	mutex_unlock(&n->v_lock);
+	vfs_node_put(n);
+
+	return ret;
+}
+
+u64_t vfs_pwrite(int fd, void * buf, u64_t len, s64_t off)
+{
+	struct vfs_node_t * n;
+	u64_t ret;
+
+	if(!buf || !len || (off < 0))
+		return 0;
+
+	n = vfs_fd_to_node(fd, O_WRONLY);
+	if(!n)
+		return 0;
+
+	mutex_lock(&n->v_lock);
+	ret = vfs_mmap_modify(n) ? 0 : n->v_mount->m_fs->write(n, off, buf, len);
+	mutex_unlock(&n->v_lock);
+	vfs_node_put(n);
+
+	return ret;
+}
+
+static u64_t vfs_xferv(int fd, struct vfs_iovec_t * iov, int iovcnt, int wr)
+{
+	struct vfs_node_t * n;
+	struct vfs_file_t * f;
+	u64_t ret = 0, len;
+	int i;
+
+	if(!iov || (iovcnt <= 0))
+		return 0;
+
+	f = vfs_fd_to_file(fd);
+	if(!f)
+		return 0;
+
+	mutex_lock(&f->f_lock);
+	n = f->f_node;
+	if(!n || (n->v_type != VNT_REG) || !(f->f_flags & (wr ? O_WRONLY : O_RDONLY)))
+	{
+		mutex_unlock(&f->f_lock);
+		return 0;
+	}
+
+	mutex_lock(&n->v_lock);
+	if(wr && vfs_mmap_modify(n))
+		iovcnt = 0;
+	for(i = 0; i < iovcnt; i++)
+	{
+		if(!iov[i].iov_base || !iov[i].iov_len)
+			continue;
+		if(wr)
+			len = n->v_mount->m_fs->write(n, f->f_offset + ret, iov[i].iov_base, iov[i].iov_len);
+		else
+			len = n->v_mount->m_fs->read(n, f->f_offset + ret, iov[i].iov_base, iov[i].iov_len);
+		if(len > iov[i].iov_len)
+			break;
+		ret += len;
+		if(len != iov[i].iov_len)
+			break;
+	}
+	mutex_unlock(&n->v_lock);
+
+	f->f_offset += ret;
+	mutex_unlock(&f->f_lock);
+
+	return ret;
+}
+
+u64_t vfs_readv(int fd, struct vfs_iovec_t * iov, int iovcnt)
+{
+	return vfs_xferv(fd, iov, iovcnt, 0);
+}
+
+u64_t vfs_writev(int fd, struct vfs_iovec_t * iov, int iovcnt)
+{
+	return vfs_xferv(fd, iov, iovcnt, 1);
+}
+
+/*
+ * Copy a range between two files without a round trip through the caller,
+ * filesystems with a copy hook move the data in place when both files are
+ * on the same mount. A null offset pointer means the file offset is used
+ * and advanced, otherwise it is updated and the file offset left alone.
+ */
+u64_t vfs_copy_file_range(int fdin, s64_t * offin, int fdout, s64_t * offout, u64_t len)
+{
+	struct vfs_node_t * ni, * no, * n1, * n2;
+	struct vfs_file_t * fi, * fo, * f1, * f2;
+	s64_t soff, doff;
+	u64_t ret = 0, r, w;
+	void * buf;
+
+	if(!len)
+		return 0;
+
+	fi = vfs_fd_to_file(fdin);
+	fo = vfs_fd_to_file(fdout);
+	if(!fi || !fo)
+		return 0;
+
+	f1 = (fdin <= fdout) ? fi : fo;
+	f2 = (fdin <= fdout) ? fo : fi;
+	mutex_lock(&f1->f_lock);
+	if(f2 != f1)
+		mutex_lock(&f2->f_lock);
+
+	ni = fi->f_node;
+	no = fo->f_node;
+	if(!ni || !no || (ni->v_type != VNT_REG) || (no->v_type != VNT_REG) || !(fi->f_flags & O_RDONLY) || !(fo->f_flags & O_WRONLY))
+		goto out;
+
+	soff = offin ? *offin : fi->f_offset;
+	doff = offout ? *offout : fo->f_offset;
+	if((soff < 0) || (doff < 0))
+		goto out;
+	if((ni == no) && (soff < doff + (s64_t)len) && (doff < soff + (s64_t)len))
+		goto out;
+
+	if((ni != no) && (ni->v_mount == no->v_mount) && ni->v_mount->m_fs->copy)
+	{
+		n1 = (ni < no) ? ni : no;
+		n2 = (ni < no) ? no : ni;
+		mutex_lock(&n1->v_lock);
+		mutex_lock(&n2->v_lock);
+		ret = vfs_mmap_modify(no) ? 0 : ni->v_mount->m_fs->copy(ni, soff, no, doff, len);
+		mutex_unlock(&n2->v_lock);
+		mutex_unlock(&n1->v_lock);
+		if(ret > len)
+			ret = 0;
+	}
+	else
+	{
+		buf = malloc(len < SZ_64K ? len : SZ_64K);
+		if(!buf)
+			goto out;
+		while(ret < len)
+		{
+			mutex_lock(&ni->v_lock);
+			r = ni->v_mount->m_fs->read(ni, soff + ret, buf, (len - ret) < SZ_64K ? (len - ret) : SZ_64K);
+			mutex_unlock(&ni->v_lock);
+			if(!r || (r > SZ_64K))
+				break;
+			mutex_lock(&no->v_lock);
+			w = vfs_mmap_modify(no) ? 0 : no->v_mount->m_fs->write(no, doff + ret, buf, r);
+			mutex_unlock(&no->v_lock);
+			if(w > r)
+				break;
+			ret += w;
+			if(w != r)
+				break;
+		}
+		free(buf);
+	}
+
+	if(offin)
+		*offin = soff + ret;
+	else
+		fi->f_offset += ret;
+	if(offout)
+		*offout = doff + ret;
+	else
+		fo->f_offset += ret;
+
+out:
+	if(f2 != f1)
+		mutex_unlock(&f2->f_lock);
+	mutex_unlock(&f1->f_lock);
+
+	return ret;
+}
+
+static void * vfs_mmap_range(int fd, s64_t off, u64_t len, int copy)
+{
+	struct vfs_node_t * n;
+	struct vfs_mmap_t * mm;
+	void * addr = NULL;
+	u64_t r, ret;
+
+	if((off < 0) || !len)
+		return NULL;
+
+	n = vfs_fd_to_node(fd, O_RDONLY);
+	if(!n)
+		return NULL;
+
+	mutex_lock(&n->v_lock);
+	if((off > n->v_size) || (len > (u64_t)(n->v_size - off)))
+		goto fail;
+
+	mutex_lock(&mmap_lock);
+	list_for_each_entry(mm, &mmap_list, mm_link)
+	{
+		if((mm->mm_node == n) && (mm->mm_off == off) && (mm->mm_len == len) && !mm->mm_stale && (copy || !mm->mm_copy))
+		{
+			mm->mm_refcnt++;
+			addr = mm->mm_addr;
+			break;
+		}
+	}
+	mutex_unlock(&mmap_lock);
+	if(addr)
+	{
+		mutex_unlock(&n->v_lock);
+		vfs_node_put(n);
+		return addr;
+	}
+
+	mm = malloc(sizeof(struct vfs_mmap_t));
+	if(!mm)
+		goto fail;
+	mm->mm_node = n;
+	mm->mm_off = off;
+	mm->mm_len = len;
+	mm->mm_copy = 0;
+	mm->mm_stale = 0;
+	mm->mm_refcnt = 1;
+	mm->mm_addr = n->v_mount->m_fs->mmap ? n->v_mount->m_fs->mmap(n, off, len) : NULL;
+	if(!mm->mm_addr)
+	{
+		if(!copy)
+		{
+			free(mm);
+			goto fail;
+		}
+		mm->mm_addr = malloc(len);
+		if(!mm->mm_addr)
+		{
+			free(mm);
+			goto fail;
+		}
+		for(ret = 0; ret < len; ret += r)
+		{
+			r = n->v_mount->m_fs->read(n, off + ret, (char *)mm->mm_addr + ret, len - ret);
+			if(!r || (r > len - ret))
+				break;
+		}
+		if(ret != len)
+		{
+			free(mm->mm_addr);
+			free(mm);
+			goto fail;
+		}
+		mm->mm_copy = 1;
+	}
+	mutex_lock(&mmap_lock);
+	list_add(&mm->mm_link, &mmap_list);
+	mutex_unlock(&mmap_lock);
+	mutex_unlock(&n->v_lock);
+
+	return mm->mm_addr;
+
+fail:
+	mutex_unlock(&n->v_lock);
+	vfs_node_put(n);
+	return NULL;
+}
+
+void * vfs_mmap(int fd, s64_t off, u64_t len)
+{
+	return vfs_mmap_range(fd, off, len, 1);
+}
+
+/*
+ * Like vfs_mmap, but fails instead of falling back to a private copy
+ */
+void * vfs_mmap_direct(int fd, s64_t off, u64_t len)
+{
+	return vfs_mmap_range(fd, off, len, 0);
+}
+
+int vfs_munmap(void * addr)
+{
+	struct vfs_mmap_t * mm;
+	int found = 0;
+
+	if(!addr)
+		return -1;
+
+	mutex_lock(&mmap_lock);
+	list_for_each_entry(mm, &mmap_list, mm_link)
+	{
+		if(mm->mm_addr == addr)
+		{
+			found = 1;
+			break;
+		}
+	}
+	if(!found)
+	{
+		mutex_unlock(&mmap_lock);
+		return -1;
+	}
+	if(--mm->mm_refcnt > 0)
+	{
+		mutex_unlock(&mmap_lock);
+		return 0;
+	}
+	list_del(&mm->mm_link);
+	mutex_unlock(&mmap_lock);
+
+	if(mm->mm_copy)
+		free(mm->mm_addr);
+	vfs_node_put(mm->mm_node);
+	free(mm);
+
+	return 0;
+}
+
 s64_t vfs_lseek(int fd, s64_t off, int whence)
 {
 	struct vfs_node_t * n;
@@ -1332,6 +1916,7 @@ int vfs_mkdir(const char * path, u32_t mode)
 
 fail:
 	mutex_unlock(&dn->v_lock);
+	vfs_dentry_invalidate(dn, name);
 	vfs_node_release(dn);
 
 	return err;
@@ -1379,6 +1964,7 @@ int vfs_rmdir(const char * path)
 	if((err = vfs_node_acquire(path, &n)))
 		return err;
 
+	vfs_dentry_forget(n);
 	if((n->v_flags == VNF_ROOT) || (atomic_get(&n->v_refcnt) >= 2))
 	{
 		vfs_node_release(n);
@@ -1437,6 +2023,14 @@ int vfs_rename(const char * src, const char * dst)
 	if((err = vfs_node_acquire(src, &n1)))
 		return err;
 
+	/*
+	 * Cached nodes below a directory keep their old path, drop the whole mount
+	 */
+	if(n1->v_type == VNT_DIR)
+		vfs_dentry_purge(n1->v_mount);
+	else
+		vfs_dentry_forget(n1);
+
 	if((err = vfs_node_access(n1, W_OK)))
 		goto fail1;
 
@@ -1473,6 +2067,7 @@ int vfs_rename(const char * src, const char * dst)
 		mutex_lock(&dn->v_lock);
 
 	err = sn->v_mount->m_fs->rename(sn, sname, n1, dn, dname);
+	vfs_dentry_invalidate(dn, dname);
 	if(err)
 		goto fail4;
 
@@ -1516,6 +2111,7 @@ int vfs_unlink(const char * path)
 		return -1;
 	}
 
+	vfs_dentry_forget(n);
 	if((n->v_flags == VNF_ROOT) || (atomic_get(&n->v_refcnt) >= 2))
 	{
 		vfs_node_release(n);
@@ -1639,4 +2235,13 @@ void do_init_vfs(void)
 		init_list_head(&node_list[i]);
 		mutex_init(&node_list_lock[i]);
 	}
+
+	for(i = 0; i < CONFIG_VFS_DENTRY_HASH_SIZE; i++)
+		init_list_head(&dentry_list[i]);
+	init_list_head(&dentry_lru);
+	mutex_init(&dentry_lock);
+	dentry_count = 0;
+
+	init_list_head(&mmap_list);
+	mutex_init(&mmap_lock);
 }
@@ -255,6 +255,23 @@ static void dir_close(void * f)
 	free(fh);
 }
 
+static void * dir_mmap(void * f, s64_t offset, s64_t size)
+{
+	struct fhandle_dir_t * fh = (struct fhandle_dir_t *)f;
+	return vfs_mmap(fh->fd, offset, size);
+}
+
+static void * dir_mmap_direct(void * f, s64_t offset, s64_t size)
+{
+	struct fhandle_dir_t * fh = (struct fhandle_dir_t *)f;
+	return vfs_mmap_direct(fh->fd, offset, size);
+}
+
+static void dir_munmap(void * f, void * addr)
+{
+	vfs_munmap(addr);
+}
+
 static struct xfs_archiver_t archiver_dir = {
 	.name		= "",
 	.mount		= dir_mount,
@@ -271,6 +288,9 @@ static struct xfs_archiver_t archiver_dir = {
 	.tell		= dir_tell,
 	.length		= dir_length,
 	.close		= dir_close,
+	.mmap		= dir_mmap,
+	.mmap_direct	= dir_mmap_direct,
+	.munmap		= dir_munmap,
 };
 
 static __init void archiver_dir_init(void)
@@ -0,0 +1,669 @@
+/*
+ * kernel/xfs/archiver-zip.c
+ *
+ * Copyright(c) 2007-2020 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <vfs/vfs.h>
+#include <xfs/archiver.h>
+#include <zlib.h>
+
+/*
+ * The zlib port maps posix file calls onto vfs, which would clash with the archiver members
+ */
+#undef open
+#undef lseek
+#undef read
+#undef write
+#undef close
+
+#define ZIP_LOCAL_SIGNATURE		(0x04034b50)
+#define ZIP_CENTRAL_SIGNATURE	(0x02014b50)
+#define ZIP_END_SIGNATURE		(0x06054b50)
+
+#define ZIP_METHOD_STORED		(0)
+#define ZIP_METHOD_DEFLATED		(8)
+
+#define ZIP_BUFFER_SIZE			(SZ_16K)
+#define ZIP_WINDOW_SIZE			(SZ_32K)
+#define ZIP_RESTART_SPAN		(SZ_256K)
+
+/*
+ * A point where inflate can be restarted, with the bits left over from the
+ * last input byte and the sliding window before it
+ */
+struct zip_restart_t {
+	s64_t out;
+	s64_t in;
+	int bits;
+	u8_t byte;
+	u8_t * window;
+	uInt wlen;
+};
+
+struct zip_entry_t {
+	struct list_head head;
+	struct hlist_node node;
+	struct list_head child;
+	struct list_head sibling;
+	char * name;
+	char * base;
+	s64_t local;
+	s64_t start;
+	s64_t csize;
+	s64_t size;
+	int method;
+	int flags;
+	int isdir;
+	struct zip_restart_t * restart;
+	int nrestart;
+};
+
+struct mhandle_zip_t {
+	struct list_head list;
+	struct hlist_head * hash;
+	int hsize;
+	struct zip_entry_t root;
+	int fd;
+};
+
+struct fhandle_zip_t {
+	struct mhandle_zip_t * m;
+	struct zip_entry_t * e;
+	s64_t offset;
+	s64_t in;
+	z_stream z;
+	u8_t * ibuf;
+	u8_t * sbuf;
+};
+
+static inline u16_t zip_u16(const u8_t * p)
+{
+	return (p[0] << 0) | (p[1] << 8);
+}
+
+static inline u32_t zip_u32(const u8_t * p)
+{
+	return (p[0] << 0) | (p[1] << 8) | (p[2] << 16) | ((u32_t)p[3] << 24);
+}
+
+static struct hlist_head * zip_hash(struct mhandle_zip_t * m, const char * name)
+{
+	return &m->hash[shash(name) % m->hsize];
+}
+
+static struct zip_entry_t * search_entry(struct mhandle_zip_t * m, const char * name)
+{
+	struct zip_entry_t * pos;
+
+	if(!name)
+		return NULL;
+	if(*name == '\0')
+		return &m->root;
+
+	hlist_for_each_entry(pos, zip_hash(m, name), node)
+	{
+		if(strcmp(pos->name, name) == 0)
+			return pos;
+	}
+	return NULL;
+}
+
+/*
+ * Add an entry and any missing parent directory, archives often carry no
+ * entries for directories at all
+ */
+static struct zip_entry_t * add_entry(struct mhandle_zip_t * m, const char * name, int len, int isdir)
+{
+	struct zip_entry_t * e, * parent;
+	char * p;
+	int l;
+
+	e = malloc(sizeof(struct zip_entry_t) + len + 1);
+	if(!e)
+		return NULL;
+	memset(e, 0, sizeof(struct zip_entry_t));
+	e->name = (char *)(e + 1);
+	memcpy(e->name, name, len);
+	e->name[len] = '\0';
+
+	parent = search_entry(m, e->name);
+	if(parent)
+	{
+		free(e);
+		return parent->isdir == isdir ? parent : NULL;
+	}
+
+	p = strrchr(e->name, '/');
+	if(p)
+	{
+		l = p - e->name;
+		e->base = p + 1;
+		*p = '\0';
+		parent = search_entry(m, e->name);
+		*p = '/';
+		if(!parent)
+			parent = add_entry(m, e->name, l, 1);
+		if(!parent || !parent->isdir)
+		{
+			free(e);
+			return NULL;
+		}
+	}
+	else
+	{
+		e->base = e->name;
+		parent = &m->root;
+	}
+
+	e->start = -1;
+	e->isdir = isdir;
+	init_list_head(&e->child);
+	list_add_tail(&e->sibling, &parent->child);
+	list_add_tail(&e->head, &m->list);
+	init_hlist_node(&e->node);
+	hlist_add_head(&e->node, zip_hash(m, e->name));
+	return e;
+}
+
+static void free_mhandle(struct mhandle_zip_t * m)
+{
+	struct zip_entry_t * pos, * n;
+	int i;
+
+	if(m)
+	{
+		list_for_each_entry_safe(pos, n, &m->list, head)
+		{
+			list_del(&pos->head);
+			for(i = 0; i < pos->nrestart; i++)
+				free(pos->restart[i].window);
+			free(pos->restart);
+			free(pos);
+		}
+		free(m->hash);
+		free(m);
+	}
+}
+
+static struct mhandle_zip_t * alloc_mhandle(int fd, s64_t size)
+{
+	struct mhandle_zip_t * m;
+	struct zip_entry_t * e;
+	u8_t * buf, * p, * name;
+	s64_t off, cdoff, cdsize;
+	int count, len, i;
+
+	/*
+	 * Find the end of central directory record, which may be followed by a comment
+	 */
+	len = (size < 22 + 65535) ? size : 22 + 65535;
+	if(len < 22)
+		return NULL;
+	buf = malloc(len);
+	if(!buf)
+		return NULL;
+	off = size - len;
+	if(vfs_pread(fd, buf, len, off) != len)
+	{
+		free(buf);
+		return NULL;
+	}
+	for(p = &buf[len - 22]; p >= buf; p--)
+	{
+		if((zip_u32(p) == ZIP_END_SIGNATURE) && (p + 22 + zip_u16(&p[20]) <= &buf[len]))
+			break;
+	}
+	if(p < buf)
+	{
+		free(buf);
+		return NULL;
+	}
+	count = zip_u16(&p[10]);
+	cdsize = zip_u32(&p[12]);
+	cdoff = zip_u32(&p[16]);
+	free(buf);
+	if((count == 0xffff) || (cdoff == 0xffffffff) || (cdoff + cdsize > size))
+		return NULL;
+
+	buf = malloc(cdsize + 1);
+	if(!buf)
+		return NULL;
+	if(vfs_pread(fd, buf, cdsize, cdoff) != cdsize)
+	{
+		free(buf);
+		return NULL;
+	}
+
+	m = malloc(sizeof(struct mhandle_zip_t));
+	if(!m)
+	{
+		free(buf);
+		return NULL;
+	}
+	memset(m, 0, sizeof(struct mhandle_zip_t));
+	m->hsize = count * 2 + 1;
+	m->fd = fd;
+	m->hash = malloc(sizeof(struct hlist_head) * m->hsize);
+	if(!m->hash)
+	{
+		free(buf);
+		free(m);
+		return NULL;
+	}
+	init_list_head(&m->list);
+	for(i = 0; i < m->hsize; i++)
+		init_hlist_head(&m->hash[i]);
+	m->root.name = m->root.base = "";
+	m->root.isdir = 1;
+	init_list_head(&m->root.child);
+
+	for(i = 0, p = buf; i < count; i++)
+	{
+		if((p + 46 > &buf[cdsize]) || (zip_u32(p) != ZIP_CENTRAL_SIGNATURE))
+			break;
+		len = zip_u16(&p[28]);
+		name = &p[46];
+		if(name + len > &buf[cdsize])
+			break;
+
+		while((len > 0) && ((name[0] == '/') || ((len > 1) && (name[0] == '.') && (name[1] == '/'))))
+		{
+			len -= (name[0] == '/') ? 1 : 2;
+			name += (name[0] == '/') ? 1 : 2;
+		}
+		if((len > 0) && (name[len - 1] == '/'))
+		{
+			while((len > 0) && (name[len - 1] == '/'))
+				len--;
+			if(len > 0)
+				add_entry(m, (const char *)name, len, 1);
+		}
+		else if(len > 0)
+		{
+			e = add_entry(m, (const char *)name, len, 0);
+			if(e)
+			{
+				e->flags = zip_u16(&p[8]);
+				e->method = zip_u16(&p[10]);
+				e->csize = zip_u32(&p[20]);
+				e->size = zip_u32(&p[24]);
+				e->local = zip_u32(&p[42]);
+			}
+		}
+		p += 46 + zip_u16(&p[28]) + zip_u16(&p[30]) + zip_u16(&p[32]);
+	}
+	free(buf);
+
+	return m;
+}
+
+static void * zip_mount(const char * path, int * writable)
+{
+	struct mhandle_zip_t * m;
+	struct vfs_stat_t st;
+	u8_t sig[4];
+	int fd;
+
+	if((vfs_stat(path, &st) < 0) || !S_ISREG(st.st_mode))
+		return NULL;
+
+	fd = vfs_open(path, O_RDONLY, 0);
+	if(fd < 0)
+		return NULL;
+
+	if((vfs_pread(fd, sig, 4, 0) != 4) || (zip_u32(sig) != ZIP_LOCAL_SIGNATURE))
+	{
+		vfs_close(fd);
+		return NULL;
+	}
+
+	m = alloc_mhandle(fd, st.st_size);
+	if(!m)
+	{
+		vfs_close(fd);
+		return NULL;
+	}
+
+	if(writable)
+		*writable = 0;
+	return m;
+}
+
+static void zip_umount(void * m)
+{
+	struct mhandle_zip_t * mh = (struct mhandle_zip_t *)m;
+
+	if(mh)
+	{
+		vfs_close(mh->fd);
+		free_mhandle(mh);
+	}
+}
+
+static void zip_walk(void * m, const char * name, xfs_walk_callback_t cb, void * data)
+{
+	struct mhandle_zip_t * mh = (struct mhandle_zip_t *)m;
+	struct zip_entry_t * e = search_entry(mh, name);
+	struct zip_entry_t * pos, * n;
+
+	if(e && e->isdir)
+	{
+		list_for_each_entry_safe(pos, n, &e->child, sibling)
+		{
+			cb(name, pos->base, data);
+		}
+	}
+}
+
+static bool_t zip_isdir(void * m, const char * name)
+{
+	struct mhandle_zip_t * mh = (struct mhandle_zip_t *)m;
+	struct zip_entry_t * e = search_entry(mh, name);
+	return (e && e->isdir) ? TRUE : FALSE;
+}
+
+static bool_t zip_isfile(void * m, const char * name)
+{
+	struct mhandle_zip_t * mh = (struct mhandle_zip_t *)m;
+	struct zip_entry_t * e = search_entry(mh, name);
+	return (e && !e->isdir) ? TRUE : FALSE;
+}
+
+static bool_t zip_mkdir(void * m, const char * name)
+{
+	return FALSE;
+}
+
+static bool_t zip_remove(void * m, const char * name)
+{
+	return FALSE;
+}
+
+static void * zip_open(void * m, const char * name, int mode)
+{
+	struct mhandle_zip_t * mh = (struct mhandle_zip_t *)m;
+	struct fhandle_zip_t * fh;
+	struct zip_entry_t * e;
+	u8_t hdr[30];
+
+	if(mode != XFS_OPEN_MODE_READ)
+		return NULL;
+	e = search_entry(mh, name);
+	if(!e || e->isdir || (e->flags & 0x1))
+		return NULL;
+	if((e->method != ZIP_METHOD_STORED) && (e->method != ZIP_METHOD_DEFLATED))
+		return NULL;
+
+	if(e->start < 0)
+	{
+		if((vfs_pread(mh->fd, hdr, 30, e->local) != 30) || (zip_u32(hdr) != ZIP_LOCAL_SIGNATURE))
+			return NULL;
+		e->start = e->local + 30 + zip_u16(&hdr[26]) + zip_u16(&hdr[28]);
+	}
+
+	fh = malloc(sizeof(struct fhandle_zip_t));
+	if(!fh)
+		return NULL;
+	memset(fh, 0, sizeof(struct fhandle_zip_t));
+	fh->m = mh;
+	fh->e = e;
+
+	if(e->method == ZIP_METHOD_DEFLATED)
+	{
+		fh->ibuf = malloc(ZIP_BUFFER_SIZE);
+		if(!fh->ibuf || (inflateInit2(&fh->z, -MAX_WBITS) != Z_OK))
+		{
+			free(fh->ibuf);
+			free(fh);
+			return NULL;
+		}
+	}
+	return ((void *)fh);
+}
+
+static void zip_add_restart(struct fhandle_zip_t * fh, s64_t out)
+{
+	struct zip_entry_t * e = fh->e;
+	struct zip_restart_t * r;
+	s64_t last = (e->nrestart > 0) ? e->restart[e->nrestart - 1].out : 0;
+
+	if((out < last + ZIP_RESTART_SPAN) || (fh->z.next_in <= fh->ibuf))
+		return;
+	if(out + ZIP_RESTART_SPAN / 2 > e->size)
+		return;
+
+	r = realloc(e->restart, sizeof(struct zip_restart_t) * (e->nrestart + 1));
+	if(!r)
+		return;
+	e->restart = r;
+	r = &e->restart[e->nrestart];
+	r->window = malloc(ZIP_WINDOW_SIZE);
+	if(!r->window)
+		return;
+	if(inflateGetDictionary(&fh->z, r->window, &r->wlen) != Z_OK)
+	{
+		free(r->window);
+		return;
+	}
+	r->out = out;
+	r->in = fh->in - fh->z.avail_in;
+	r->bits = fh->z.data_type & 7;
+	r->byte = fh->z.next_in[-1];
+	e->nrestart++;
+}
+
+/*
+ * Inflate straight into the caller buffer, stopping at every deflate block
+ * boundary so that restart points can be recorded on the way
+ */
+static s64_t zip_inflate(struct fhandle_zip_t * fh, void * buf, s64_t size)
+{
+	struct zip_entry_t * e = fh->e;
+	s64_t n;
+	int ret;
+
+	if(size > e->size - fh->offset)
+		size = e->size - fh->offset;
+	if(size <= 0)
+		return 0;
+
+	fh->z.next_out = buf;
+	fh->z.avail_out = size;
+	while(fh->z.avail_out > 0)
+	{
+		if(fh->z.avail_in == 0)
+		{
+			n = e->csize - fh->in;
+			if(n > ZIP_BUFFER_SIZE)
+				n = ZIP_BUFFER_SIZE;
+			if(n <= 0)
+				break;
+			n = vfs_pread(fh->m->fd, fh->ibuf, n, e->start + fh->in);
+			if(n <= 0)
+				break;
+			fh->in += n;
+			fh->z.next_in = fh->ibuf;
+			fh->z.avail_in = n;
+		}
+		ret = inflate(&fh->z, Z_BLOCK);
+		if((ret != Z_OK) && (ret != Z_BUF_ERROR))
+			break;
+		if((ret == Z_BUF_ERROR) && (fh->z.avail_in > 0))
+			break;
+		if((fh->z.data_type & 128) && !(fh->z.data_type & 64))
+			zip_add_restart(fh, fh->offset + size - fh->z.avail_out);
+	}
+	n = size - fh->z.avail_out;
+	fh->offset += n;
+	return n;
+}
+
+static s64_t zip_read(void * f, void * buf, s64_t size)
+{
+	struct fhandle_zip_t * fh = (struct fhandle_zip_t *)f;
+	struct zip_entry_t * e = fh->e;
+	s64_t len;
+
+	if(e->method == ZIP_METHOD_DEFLATED)
+		return zip_inflate(fh, buf, size);
+
+	if(size > e->size - fh->offset)
+		size = e->size - fh->offset;
+	if(size <= 0)
+		return 0;
+	len = vfs_pread(fh->m->fd, buf, size, e->start + fh->offset);
+	if(len > 0)
+		fh->offset += len;
+	return len;
+}
+
+static s64_t zip_write(void * f, void * buf, s64_t size)
+{
+	return 0;
+}
+
+static s64_t zip_seek(void * f, s64_t offset)
+{
+	struct fhandle_zip_t * fh = (struct fhandle_zip_t *)f;
+	struct zip_entry_t * e = fh->e;
+	struct zip_restart_t * r = NULL;
+	s64_t n;
+	int i;
+
+	if(offset < 0)
+		offset = 0;
+	else if(offset > e->size)
+		offset = e->size;
+
+	if(e->method != ZIP_METHOD_DEFLATED)
+	{
+		fh->offset = offset;
+		return fh->offset;
+	}
+
+	for(i = e->nrestart - 1; i >= 0; i--)
+	{
+		if(e->restart[i].out <= offset)
+		{
+			r = &e->restart[i];
+			break;
+		}
+	}
+
+	/*
+	 * Go back to the nearest restart point unless decoding on from here is shorter
+	 */
+	if((offset < fh->offset) || (r && (r->out > fh->offset)))
+	{
+		inflateReset(&fh->z);
+		fh->z.avail_in = 0;
+		if(r)
+		{
+			if(r->bits)
+				inflatePrime(&fh->z, r->bits, r->byte >> (8 - r->bits));
+			inflateSetDictionary(&fh->z, r->window, r->wlen);
+			fh->in = r->in;
+			fh->offset = r->out;
+		}
+		else
+		{
+			fh->in = 0;
+			fh->offset = 0;
+		}
+	}
+
+	if(fh->offset < offset)
+	{
+		if(!fh->sbuf)
+			fh->sbuf = malloc(ZIP_BUFFER_SIZE);
+		while(fh->sbuf && (fh->offset < offset))
+		{
+			n = offset - fh->offset;
+			if(n > ZIP_BUFFER_SIZE)
+				n = ZIP_BUFFER_SIZE;
+			if(zip_inflate(fh, fh->sbuf, n) <= 0)
+				break;
+		}
+	}
+	return fh->offset;
+}
+
+static s64_t zip_tell(void * f)
+{
+	struct fhandle_zip_t * fh = (struct fhandle_zip_t *)f;
+	return fh->offset;
+}
+
+static s64_t zip_length(void * f)
+{
+	struct fhandle_zip_t * fh = (struct fhandle_zip_t *)f;
+	return fh->e->size;
+}
+
+static void zip_close(void * f)
+{
+	struct fhandle_zip_t * fh = (struct fhandle_zip_t *)f;
+
+	if(fh)
+	{
+		if(fh->ibuf)
+			inflateEnd(&fh->z);
+		free(fh->ibuf);
+		free(fh->sbuf);
+		free(fh);
+	}
+}
+
+static struct xfs_archiver_t archiver_zip = {
+	.name		= "zip",
+	.mount		= zip_mount,
+	.umount 	= zip_umount,
+	.walk		= zip_walk,
+	.isdir		= zip_isdir,
+	.isfile		= zip_isfile,
+	.mkdir		= zip_mkdir,
+	.remove		= zip_remove,
+	.open		= zip_open,
+	.read		= zip_read,
+	.write		= zip_write,
+	.seek		= zip_seek,
+	.tell		= zip_tell,
+	.length		= zip_length,
+	.close		= zip_close,
+};
+
+static __init void archiver_zip_init(void)
+{
+	register_archiver(&archiver_zip);
+}
+
+static __exit void archiver_zip_exit(void)
+{
+	unregister_archiver(&archiver_zip);
+}
+
+core_initcall(archiver_zip_init);
+core_exitcall(archiver_zip_exit);
@@ -80,7 +80,11 @@ static const char * fileext(const char * filename)
 		if(ret != NULL)
 			ret++;
 	}
-	return (ret && (strcasecmp(ret, "x") == 0)) ? "tar" : ret;
+	if(ret && (strcasecmp(ret, "x") == 0))
+		return "tar";
+	if(ret && (strcasecmp(ret, "xapp") == 0))
+		return "zip";
+	return ret;
 }
 
 void * mount_archiver(const char * path, struct xfs_archiver_t ** archiver, int * writable)
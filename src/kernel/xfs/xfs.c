@@ -343,6 +343,74 @@ s64_t xfs_length(struct xfs_file_t * file)
 	return 0;
 }
 
+/*
+ * Read only view of a file range, archivers without a mmap method get a heap copy
+ */
+void * xfs_mmap(struct xfs_file_t * file, s64_t offset, s64_t size)
+{
+	struct xfs_archiver_t * archiver;
+	void * addr;
+	s64_t pos, len, n;
+
+	if(!file || (offset < 0) || (size <= 0))
+		return NULL;
+
+	archiver = file->path->archiver;
+	if(archiver->mmap)
+		return archiver->mmap(file->fhandle, offset, size);
+
+	addr = malloc(size);
+	if(!addr)
+		return NULL;
+	pos = archiver->tell(file->fhandle);
+	len = 0;
+	if(archiver->seek(file->fhandle, offset) == offset)
+	{
+		while(len < size)
+		{
+			n = archiver->read(file->fhandle, (char *)addr + len, size - len);
+			if(n <= 0)
+				break;
+			len += n;
+		}
+	}
+	archiver->seek(file->fhandle, pos);
+	if(len != size)
+	{
+		free(addr);
+		return NULL;
+	}
+	return addr;
+}
+
+/*
+ * Read only view of a file range that is used in place, NULL when the archiver
+ * could only hand out a copy
+ */
+void * xfs_mmap_direct(struct xfs_file_t * file, s64_t offset, s64_t size)
+{
+	struct xfs_archiver_t * archiver;
+
+	if(!file || (offset < 0) || (size <= 0))
+		return NULL;
+
+	archiver = file->path->archiver;
+	if(archiver->mmap_direct)
+		return archiver->mmap_direct(file->fhandle, offset, size);
+	return NULL;
+}
+
+void xfs_munmap(struct xfs_file_t * file, void * addr)
+{
+	if(file && addr)
+	{
+		if(file->path->archiver->munmap)
+			file->path->archiver->munmap(file->fhandle, addr);
+		else
+			free(addr);
+	}
+}
+
 void xfs_close(struct xfs_file_t * file)
 {
 	if(file)
@@ -4,6 +4,7 @@
 
 #include <math.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <xboot/module.h>
 
@@ -200,307 +201,88 @@ static size_t format_int(char * q, size_t n, uintmax_t val, enum flags flags,
 	return o;
 }
 
-#define CVT_BUFSZ	(309 + 43)
-
-static char * cvt(double arg, int ndigits, int * decpt, int * sign, char * buf, int eflag)
-{
-	int r2;
-	double fi, fj;
-	char * p, * p1;
-
-	if (ndigits < 0)
-		ndigits = 0;
-	if (ndigits >= CVT_BUFSZ - 1)
-		ndigits = CVT_BUFSZ - 2;
-
-	r2 = 0;
-	*sign = 0;
-	p = &buf[0];
-
-	if (arg < 0)
-	{
-		*sign = 1;
-		arg = -arg;
-	}
-	arg = modf(arg, &fi);
-	p1 = &buf[CVT_BUFSZ];
-
-	if (fi != 0)
-	{
-		p1 = &buf[CVT_BUFSZ];
-		while (fi != 0)
-		{
-			fj = modf(fi / 10, &fi);
-			*--p1 = (int) ((fj + .03) * 10) + '0';
-			r2++;
-		}
-		while (p1 < &buf[CVT_BUFSZ])
-			*p++ = *p1++;
-	}
-	else if (arg > 0)
-	{
-		while ((fj = arg * 10) < 1)
-		{
-			arg = fj;
-			r2--;
-		}
-	}
-
-	p1 = &buf[ndigits];
-	if (eflag == 0)
-		p1 += r2;
-	*decpt = r2;
-	if (p1 < &buf[0])
-	{
-		buf[0] = '\0';
-		return buf;
-	}
-
-	while (p <= p1 && p < &buf[CVT_BUFSZ])
-	{
-		arg *= 10;
-		arg = modf(arg, &fj);
-		*p++ = (int) fj + '0';
-	}
-
-	if (p1 >= &buf[CVT_BUFSZ])
-	{
-		buf[CVT_BUFSZ - 1] = '\0';
-		return buf;
-	}
-	p = p1;
-	*p1 += 5;
-
-	while (*p1 > '9')
-	{
-		*p1 = '0';
-		if (p1 > buf)
-			++*--p1;
-		else
-		{
-			*p1 = '1';
-			(*decpt)++;
-			if (eflag == 0)
-			{
-				if (p > buf)
-					*p = '0';
-				p++;
-			}
-		}
-	}
-
-	*p = '\0';
-	return buf;
-}
-
-static void cfltcvt(double value, char * buffer, char fmt, int precision)
+static size_t format_float(char * q, size_t n, double val, enum flags flags, char fmt, int width, int prec)
 {
-	int decpt, sign, exp, pos;
-	char * digits = 0;
-	char cvtbuf[CVT_BUFSZ];
-	int capexp = 0;
-	int magnitude;
+	size_t o = 0;
+	char digits[DTOA_BUFSZ];
+	const char * s = NULL;
+	char sign = 0, e = 'e';
+	int nd = 0, decpt = 1, exp = 0, len, i;
 
-	if (fmt == 'G' || fmt == 'E')
+	if (fmt >= 'A' && fmt <= 'Z')
 	{
-		capexp = 1;
 		fmt += 'a' - 'A';
+		e = 'E';
 	}
 
-	if (fmt == 'g')
+	if (signbit(val))
 	{
-		digits = cvt(value, precision, &decpt, &sign, cvtbuf, 1);
-
-		magnitude = decpt - 1;
-		if (magnitude < -4 || magnitude > precision - 1)
-		{
-			fmt = 'e';
-			precision -= 1;
-		}
-		else
-		{
-			fmt = 'f';
-			precision -= decpt;
-		}
+		sign = '-';
+		val = -val;
 	}
+	else if (flags & FL_PLUS)
+		sign = '+';
+	else if (flags & FL_SPACE)
+		sign = ' ';
 
-	if (fmt == 'e')
-	{
-		digits = cvt(value, precision + 1, &decpt, &sign, cvtbuf, 1);
-
-		if (sign)
-			*buffer++ = '-';
-		*buffer++ = *digits;
-		if (precision > 0)
-			*buffer++ = '.';
-		memcpy(buffer, digits + 1, precision);
-		buffer += precision;
-		*buffer++ = capexp ? 'E' : 'e';
-
-		if (decpt == 0)
-		{
-			if (value == 0.0)
-				exp = 0;
-			else
-				exp = -1;
-		}
-		else
-			exp = decpt - 1;
+	if (prec < 0)
+		prec = 6;
 
-		if (exp < 0)
-		{
-			*buffer++ = '-';
-			exp = -exp;
-		}
+	if (isnan(val) || isinf(val))
+	{
+		if (isnan(val))
+			s = (e == 'E') ? "NAN" : "nan";
 		else
-			*buffer++ = '+';
-
-		buffer[2] = (exp % 10) + '0';
-		exp = exp / 10;
-		buffer[1] = (exp % 10) + '0';
-		exp = exp / 10;
-		buffer[0] = (exp % 10) + '0';
-		buffer += 3;
+			s = (e == 'E') ? "INF" : "inf";
+		flags &= ~FL_ZERO;
+		len = 3;
 	}
-	else if (fmt == 'f')
+	else
 	{
-		digits = cvt(value, precision, &decpt, &sign, cvtbuf, 0);
-
-		if (sign)
-			*buffer++ = '-';
-		if (*digits)
+		if (fmt == 'g')
 		{
-			if (decpt <= 0)
+			if (prec == 0)
+				prec = 1;
+			nd = __dtoa(val, 2, prec, digits, &decpt);
+			exp = nd ? decpt - 1 : 0;
+			if (exp < -4 || exp >= prec)
 			{
-				*buffer++ = '0';
-				*buffer++ = '.';
-				for (pos = 0; pos < -decpt; pos++)
-					*buffer++ = '0';
-				while (*digits)
-					*buffer++ = *digits++;
+				fmt = 'e';
+				prec = prec - 1;
+				if (!(flags & FL_HASH) && prec > nd - 1)
+					prec = (nd > 1) ? nd - 1 : 0;
 			}
 			else
 			{
-				pos = 0;
-				while (*digits)
-				{
-					if (pos++ == decpt)
-						*buffer++ = '.';
-					*buffer++ = *digits++;
-				}
-			}
-		}
-		else
-		{
-			*buffer++ = '0';
-			if (precision > 0)
-			{
-				*buffer++ = '.';
-				for (pos = 0; pos < precision; pos++)
-					*buffer++ = '0';
+				fmt = 'f';
+				prec = prec - 1 - exp;
+				if (!(flags & FL_HASH) && prec > nd - decpt)
+					prec = (nd > decpt) ? nd - decpt : 0;
 			}
 		}
-	}
-
-	*buffer = '\0';
-}
-
-static void forcdecpt(char * buffer)
-{
-	while (*buffer)
-	{
-		if (*buffer == '.')
-			return;
-		if (*buffer == 'e' || *buffer == 'E')
-			break;
-		buffer++;
-	}
-
-	if (*buffer)
-	{
-		int n = strlen(buffer);
-		while (n > 0)
+		else if (fmt == 'e')
 		{
-			buffer[n + 1] = buffer[n];
-			n--;
+			nd = __dtoa(val, 2, prec + 1, digits, &decpt);
+			exp = nd ? decpt - 1 : 0;
 		}
+		else
+			nd = __dtoa(val, 3, prec, digits, &decpt);
 
-		*buffer = '.';
-	}
-	else
-	{
-		*buffer++ = '.';
-		*buffer = '\0';
-	}
-}
-
-static void cropzeros(char *buffer)
-{
-	char * stop;
-
-	while (*buffer && *buffer != '.')
-		buffer++;
-	if (*buffer++)
-	{
-		while (*buffer && *buffer != 'e' && *buffer != 'E')
-			buffer++;
-		stop = buffer--;
-		while (*buffer == '0')
-			buffer--;
-		if (*buffer == '.')
-			buffer--;
-		while ((*++buffer = *stop++));
+		if (fmt == 'e')
+			len = 1 + 2 + ((exp <= -100 || exp >= 100) ? 3 : 2);
+		else
+			len = (decpt > 0) ? decpt : 1;
+		if (prec > 0 || (flags & FL_HASH))
+			len += 1 + prec;
 	}
-}
 
-static size_t format_float(char * q, size_t n, double val, enum flags flags, char fmt, int width, int prec)
-{
-	size_t o = 0;
-	char tmp[CVT_BUFSZ];
-	char c, sign;
-	int len, i;
+	if (sign)
+		width--;
+	width -= len;
 
 	if (flags & FL_MINUS)
 		flags &= ~FL_ZERO;
 
-	c = (flags & FL_ZERO) ? '0' : ' ';
-	sign = 0;
-	if (flags & FL_SIGNED)
-	{
-		if (val < 0.0)
-		{
-			sign = '-';
-			val = -val;
-			width--;
-		}
-		else if (flags & FL_PLUS)
-		{
-			sign = '+';
-			width--;
-		}
-		else if (flags & FL_SPACE)
-		{
-			sign = ' ';
-			width--;
-		}
-	}
-
-	if (prec < 0)
-		prec = 6;
-	else if (prec == 0 && fmt == 'g')
-		prec = 1;
-
-	cfltcvt(val, tmp, fmt, prec);
-
-	if ((flags & FL_HASH) && prec == 0)
-		forcdecpt(tmp);
-
-	if (fmt == 'g' && !(flags & FL_HASH))
-		cropzeros(tmp);
-
-	len = strlen(tmp);
-	width -= len;
-
 	if (!(flags & (FL_ZERO | FL_MINUS)))
 		while (width-- > 0)
 			EMIT(' ');
@@ -508,14 +290,46 @@ static size_t format_float(char * q, size_t n, double val, enum flags flags, cha
 	if (sign)
 		EMIT(sign);
 
-	if (!(flags & FL_MINUS))
-	{
+	if (flags & FL_ZERO)
 		while (width-- > 0)
-			EMIT(c);
-	}
+			EMIT('0');
 
-	for (i = 0; i < len; i++)
-		EMIT(tmp[i]);
+	if (s)
+	{
+		for (i = 0; i < len; i++)
+			EMIT(s[i]);
+	}
+	else if (fmt == 'e')
+	{
+		EMIT(nd ? digits[0] : '0');
+		if (prec > 0 || (flags & FL_HASH))
+			EMIT('.');
+		for (i = 1; i <= prec; i++)
+			EMIT((i < nd) ? digits[i] : '0');
+		EMIT(e);
+		if (exp < 0)
+		{
+			EMIT('-');
+			exp = -exp;
+		}
+		else
+			EMIT('+');
+		if (exp >= 100)
+			EMIT('0' + exp / 100);
+		EMIT('0' + exp / 10 % 10);
+		EMIT('0' + exp % 10);
+	}
+	else
+	{
+		if (decpt <= 0)
+			EMIT('0');
+		for (i = 0; i < decpt; i++)
+			EMIT((i < nd) ? digits[i] : '0');
+		if (prec > 0 || (flags & FL_HASH))
+			EMIT('.');
+		for (i = 0; i < prec; i++)
+			EMIT((decpt + i >= 0 && decpt + i < nd) ? digits[decpt + i] : '0');
+	}
 
 	while (width-- > 0)
 		EMIT(' ');
@@ -838,6 +652,7 @@ int vsnprintf(char * buf, size_t n, const char * fmt, va_list ap)
 
 				case 'E':
 				case 'G':
+				case 'F':
 				case 'e':
 				case 'f':
 				case 'g':
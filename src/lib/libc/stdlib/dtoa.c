@@ -0,0 +1,429 @@
+/*
+ * libc/stdlib/dtoa.c
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <xboot/module.h>
+
+/*
+ * Cached powers of ten for grisu, 10^k for k = -348, -340, ..., 340
+ */
+static const struct {
+	u64_t f;
+	int e;
+} cached_powers[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220 }, { 0xbaaee17fa23ebf76ULL, -1193 },
+	{ 0x8b16fb203055ac76ULL, -1166 }, { 0xcf42894a5dce35eaULL, -1140 },
+	{ 0x9a6bb0aa55653b2dULL, -1113 }, { 0xe61acf033d1a45dfULL, -1087 },
+	{ 0xab70fe17c79ac6caULL, -1060 }, { 0xff77b1fcbebcdc4fULL, -1034 },
+	{ 0xbe5691ef416bd60cULL, -1007 }, { 0x8dd01fad907ffc3cULL, -980 },
+	{ 0xd3515c2831559a83ULL, -954 }, { 0x9d71ac8fada6c9b5ULL, -927 },
+	{ 0xea9c227723ee8bcbULL, -901 }, { 0xaecc49914078536dULL, -874 },
+	{ 0x823c12795db6ce57ULL, -847 }, { 0xc21094364dfb5637ULL, -821 },
+	{ 0x9096ea6f3848984fULL, -794 }, { 0xd77485cb25823ac7ULL, -768 },
+	{ 0xa086cfcd97bf97f4ULL, -741 }, { 0xef340a98172aace5ULL, -715 },
+	{ 0xb23867fb2a35b28eULL, -688 }, { 0x84c8d4dfd2c63f3bULL, -661 },
+	{ 0xc5dd44271ad3cdbaULL, -635 }, { 0x936b9fcebb25c996ULL, -608 },
+	{ 0xdbac6c247d62a584ULL, -582 }, { 0xa3ab66580d5fdaf6ULL, -555 },
+	{ 0xf3e2f893dec3f126ULL, -529 }, { 0xb5b5ada8aaff80b8ULL, -502 },
+	{ 0x87625f056c7c4a8bULL, -475 }, { 0xc9bcff6034c13053ULL, -449 },
+	{ 0x964e858c91ba2655ULL, -422 }, { 0xdff9772470297ebdULL, -396 },
+	{ 0xa6dfbd9fb8e5b88fULL, -369 }, { 0xf8a95fcf88747d94ULL, -343 },
+	{ 0xb94470938fa89bcfULL, -316 }, { 0x8a08f0f8bf0f156bULL, -289 },
+	{ 0xcdb02555653131b6ULL, -263 }, { 0x993fe2c6d07b7facULL, -236 },
+	{ 0xe45c10c42a2b3b06ULL, -210 }, { 0xaa242499697392d3ULL, -183 },
+	{ 0xfd87b5f28300ca0eULL, -157 }, { 0xbce5086492111aebULL, -130 },
+	{ 0x8cbccc096f5088ccULL, -103 }, { 0xd1b71758e219652cULL, -77 },
+	{ 0x9c40000000000000ULL, -50 }, { 0xe8d4a51000000000ULL, -24 },
+	{ 0xad78ebc5ac620000ULL, 3 }, { 0x813f3978f8940984ULL, 30 },
+	{ 0xc097ce7bc90715b3ULL, 56 }, { 0x8f7e32ce7bea5c70ULL, 83 },
+	{ 0xd5d238a4abe98068ULL, 109 }, { 0x9f4f2726179a2245ULL, 136 },
+	{ 0xed63a231d4c4fb27ULL, 162 }, { 0xb0de65388cc8ada8ULL, 189 },
+	{ 0x83c7088e1aab65dbULL, 216 }, { 0xc45d1df942711d9aULL, 242 },
+	{ 0x924d692ca61be758ULL, 269 }, { 0xda01ee641a708deaULL, 295 },
+	{ 0xa26da3999aef774aULL, 322 }, { 0xf209787bb47d6b85ULL, 348 },
+	{ 0xb454e4a179dd1877ULL, 375 }, { 0x865b86925b9bc5c2ULL, 402 },
+	{ 0xc83553c5c8965d3dULL, 428 }, { 0x952ab45cfa97a0b3ULL, 455 },
+	{ 0xde469fbd99a05fe3ULL, 481 }, { 0xa59bc234db398c25ULL, 508 },
+	{ 0xf6c69a72a3989f5cULL, 534 }, { 0xb7dcbf5354e9beceULL, 561 },
+	{ 0x88fcf317f22241e2ULL, 588 }, { 0xcc20ce9bd35c78a5ULL, 614 },
+	{ 0x98165af37b2153dfULL, 641 }, { 0xe2a0b5dc971f303aULL, 667 },
+	{ 0xa8d9d1535ce3b396ULL, 694 }, { 0xfb9b7cd9a4a7443cULL, 720 },
+	{ 0xbb764c4ca7a44410ULL, 747 }, { 0x8bab8eefb6409c1aULL, 774 },
+	{ 0xd01fef10a657842cULL, 800 }, { 0x9b10a4e5e9913129ULL, 827 },
+	{ 0xe7109bfba19c0c9dULL, 853 }, { 0xac2820d9623bf429ULL, 880 },
+	{ 0x80444b5e7aa7cf85ULL, 907 }, { 0xbf21e44003acdd2dULL, 933 },
+	{ 0x8e679c2f5e44ff8fULL, 960 }, { 0xd433179d9c8cb841ULL, 986 },
+	{ 0x9e19db92b4e31ba9ULL, 1013 }, { 0xeb96bf6ebadf77d9ULL, 1039 },
+	{ 0xaf87023b9bf0ee6bULL, 1066 },
+};
+
+static const u64_t pow10_u64[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+	100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+struct diyfp_t {
+	u64_t f;
+	int e;
+};
+
+static inline struct diyfp_t diyfp_mul(struct diyfp_t x, struct diyfp_t y)
+{
+	struct diyfp_t r;
+	u64_t a = x.f >> 32, b = (u32_t)x.f;
+	u64_t c = y.f >> 32, d = (u32_t)y.f;
+	u64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	u64_t t = (bd >> 32) + (u32_t)ad + (u32_t)bc + (1ULL << 31);
+
+	r.f = ac + (ad >> 32) + (bc >> 32) + (t >> 32);
+	r.e = x.e + y.e + 64;
+	return r;
+}
+
+static inline struct diyfp_t diyfp_normalize(struct diyfp_t x)
+{
+	int s = __builtin_clzll(x.f);
+
+	x.f <<= s;
+	x.e -= s;
+	return x;
+}
+
+static void grisu_round(char * buf, int len, u64_t delta, u64_t rest, u64_t ten_kappa, u64_t wp_w)
+{
+	while((rest < wp_w) && (delta - rest >= ten_kappa) &&
+		((rest + ten_kappa < wp_w) || (wp_w - rest > rest + ten_kappa - wp_w)))
+	{
+		buf[len - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+/*
+ * Grisu2, the shortest digits in nearly all cases and always round trip
+ */
+static int grisu2(u64_t m, int e, char * buf, int * decpt)
+{
+	struct diyfp_t v, w, mp, mm, c, one;
+	u64_t delta, p2, wp_w, tmp;
+	u32_t p1, d;
+	double dk;
+	int k, idx, kappa, len = 0;
+
+	v.f = m;
+	v.e = e;
+	mp.f = (v.f << 1) + 1;
+	mp.e = v.e - 1;
+	mp = diyfp_normalize(mp);
+	if(v.f == (1ULL << 52) && e > -1074)
+	{
+		mm.f = (v.f << 2) - 1;
+		mm.e = v.e - 2;
+	}
+	else
+	{
+		mm.f = (v.f << 1) - 1;
+		mm.e = v.e - 1;
+	}
+	mm.f <<= mm.e - mp.e;
+	mm.e = mp.e;
+
+	dk = (-61 - mp.e) * 0.30102999566398114 + 347;
+	k = (int)dk;
+	if(dk - k > 0.0)
+		k++;
+	idx = (k >> 3) + 1;
+	c.f = cached_powers[idx].f;
+	c.e = cached_powers[idx].e;
+	k = -(-348 + idx * 8);
+
+	w = diyfp_mul(diyfp_normalize(v), c);
+	mp = diyfp_mul(mp, c);
+	mm = diyfp_mul(mm, c);
+	mm.f++;
+	mp.f--;
+	delta = mp.f - mm.f;
+
+	one.f = 1ULL << -mp.e;
+	one.e = mp.e;
+	wp_w = mp.f - w.f;
+	p1 = (u32_t)(mp.f >> -one.e);
+	p2 = mp.f & (one.f - 1);
+	for(kappa = 1; kappa < 10 && p1 >= pow10_u64[kappa]; kappa++);
+
+	while(kappa > 0)
+	{
+		switch(kappa)
+		{
+		case 10: d = p1 / 1000000000; p1 %= 1000000000; break;
+		case  9: d = p1 / 100000000; p1 %= 100000000; break;
+		case  8: d = p1 / 10000000; p1 %= 10000000; break;
+		case  7: d = p1 / 1000000; p1 %= 1000000; break;
+		case  6: d = p1 / 100000; p1 %= 100000; break;
+		case  5: d = p1 / 10000; p1 %= 10000; break;
+		case  4: d = p1 / 1000; p1 %= 1000; break;
+		case  3: d = p1 / 100; p1 %= 100; break;
+		case  2: d = p1 / 10; p1 %= 10; break;
+		default: d = p1; p1 = 0; break;
+		}
+		if(d || len)
+			buf[len++] = '0' + d;
+		kappa--;
+		tmp = ((u64_t)p1 << -one.e) + p2;
+		if(tmp <= delta)
+		{
+			grisu_round(buf, len, delta, tmp, pow10_u64[kappa] << -one.e, wp_w);
+			*decpt = len + k + kappa;
+			return len;
+		}
+	}
+	for(;;)
+	{
+		p2 *= 10;
+		delta *= 10;
+		d = (u32_t)(p2 >> -one.e);
+		if(d || len)
+			buf[len++] = '0' + d;
+		p2 &= one.f - 1;
+		kappa--;
+		if(p2 < delta)
+		{
+			grisu_round(buf, len, delta, p2, one.f, (-kappa < 20) ? wp_w * pow10_u64[-kappa] : 0);
+			*decpt = len + k + kappa;
+			return len;
+		}
+	}
+}
+
+/*
+ * Exact decimal expansion with a base 10^9 big integer, at most 767 digits
+ */
+static int dtoa_exact(u64_t m, int e, char * buf, int * decpt)
+{
+	u32_t a[90];
+	u32_t f;
+	u64_t c;
+	int n, i, j, k, len;
+
+	a[0] = (u32_t)(m % 1000000000);
+	a[1] = (u32_t)(m / 1000000000);
+	n = a[1] ? 2 : 1;
+	for(k = (e < 0) ? -e : e; k > 0; k -= i)
+	{
+		if(e < 0)
+		{
+			i = (k > 13) ? 13 : k;
+			for(f = 1, j = 0; j < i; j++)
+				f *= 5;
+		}
+		else
+		{
+			i = (k > 29) ? 29 : k;
+			f = 1 << i;
+		}
+		for(c = 0, j = 0; j < n; j++)
+		{
+			c += (u64_t)a[j] * f;
+			a[j] = (u32_t)(c % 1000000000);
+			c /= 1000000000;
+		}
+		for(; c; c /= 1000000000)
+			a[n++] = (u32_t)(c % 1000000000);
+	}
+
+	for(f = a[n - 1], len = 0; f; f /= 10)
+		len++;
+	for(i = len, f = a[n - 1]; i > 0; f /= 10)
+		buf[--i] = '0' + f % 10;
+	for(k = n - 2; k >= 0; k--)
+	{
+		for(i = 9, f = a[k]; i > 0; f /= 10)
+			buf[len + --i] = '0' + f % 10;
+		len += 9;
+	}
+	*decpt = len + ((e < 0) ? e : 0);
+	return len;
+}
+
+/*
+ * Round digits to p significant ones, ties to even
+ */
+static int dtoa_round(char * buf, int len, int p, int * decpt)
+{
+	int up, i;
+
+	if(p < 0)
+		len = 0;
+	else if(p < len)
+	{
+		if(buf[p] > '5')
+			up = 1;
+		else if(buf[p] < '5')
+			up = 0;
+		else
+		{
+			for(up = 0, i = p + 1; i < len; i++)
+			{
+				if(buf[i] != '0')
+				{
+					up = 1;
+					break;
+				}
+			}
+			if(!up && p > 0)
+				up = (buf[p - 1] - '0') & 1;
+		}
+		len = p;
+		if(up)
+		{
+			while(len > 0 && buf[len - 1] == '9')
+				len--;
+			if(len > 0)
+				buf[len - 1]++;
+			else
+			{
+				buf[len++] = '1';
+				(*decpt)++;
+			}
+		}
+	}
+	while(len > 0 && buf[len - 1] == '0')
+		len--;
+	if(len == 0)
+		*decpt = 1;
+	buf[len] = '\0';
+	return len;
+}
+
+/*
+ * Convert a finite non negative double to decimal digits, the value is
+ * 0.d1d2...dn * 10^decpt with trailing zeros removed. Mode 0 gives the
+ * shortest digits that round trip, mode 2 rounds to ndigits significant
+ * digits and mode 3 to ndigits past the decimal point. The buffer must
+ * hold DTOA_BUFSZ characters, or 32 for mode 0. Returns the number of
+ * digits, zero for zero.
+ */
+int __dtoa(double v, int mode, int ndigits, char * buf, int * decpt)
+{
+	union { double d; u64_t u; } x;
+	u64_t m;
+	int be, e, len, p;
+
+	x.d = v;
+	m = x.u & ((1ULL << 52) - 1);
+	be = (int)(x.u >> 52) & 0x7ff;
+	if(be == 0 && m == 0)
+	{
+		*decpt = 1;
+		buf[0] = '\0';
+		return 0;
+	}
+	if(be)
+	{
+		m |= 1ULL << 52;
+		e = be - 1075;
+	}
+	else
+		e = -1074;
+
+	if(mode == 0 || (be != 0 && (mode != 2 || ndigits <= 15)))
+	{
+		len = grisu2(m, e, buf, decpt);
+		if(mode == 0)
+			return dtoa_round(buf, len, len, decpt);
+		/*
+		 * The grisu digits are within half an ulp, which is below half a
+		 * unit in the fifteenth significant digit, so they are already
+		 * the correctly rounded result when short enough.
+		 */
+		p = (mode == 2) ? ndigits : *decpt + ndigits;
+		if(len <= p && p <= 15)
+			return dtoa_round(buf, len, len, decpt);
+	}
+	len = dtoa_exact(m, e, buf, decpt);
+	p = (mode == 2) ? ndigits : *decpt + ndigits;
+	return dtoa_round(buf, len, p, decpt);
+}
+EXPORT_SYMBOL(__dtoa);
+
+/*
+ * Shortest round trip string of a double in the style of %g, plain for
+ * decimal exponents in [-4, 16) and scientific otherwise
+ */
+int dtostr(char * buf, size_t size, double v)
+{
+	char digits[32];
+	char tmp[32];
+	union { double d; u64_t u; } x;
+	int len = 0, n, decpt, i, exp;
+
+	x.d = v;
+	if(x.u >> 63)
+	{
+		tmp[len++] = '-';
+		x.u &= ~(1ULL << 63);
+	}
+	if(((x.u >> 52) & 0x7ff) == 0x7ff)
+	{
+		memcpy(&tmp[len], (x.u << 12) ? "nan" : "inf", 3);
+		len += 3;
+	}
+	else
+	{
+		n = __dtoa(x.d, 0, 0, digits, &decpt);
+		if(n == 0)
+		{
+			digits[n++] = '0';
+			decpt = 1;
+		}
+		exp = decpt - 1;
+		if(exp < -4 || exp >= 16)
+		{
+			tmp[len++] = digits[0];
+			if(n > 1)
+			{
+				tmp[len++] = '.';
+				for(i = 1; i < n; i++)
+					tmp[len++] = digits[i];
+			}
+			tmp[len++] = 'e';
+			tmp[len++] = (exp < 0) ? '-' : '+';
+			if(exp < 0)
+				exp = -exp;
+			if(exp >= 100)
+				tmp[len++] = '0' + exp / 100;
+			tmp[len++] = '0' + exp / 10 % 10;
+			tmp[len++] = '0' + exp % 10;
+		}
+		else if(decpt <= 0)
+		{
+			tmp[len++] = '0';
+			tmp[len++] = '.';
+			for(i = decpt; i < 0; i++)
+				tmp[len++] = '0';
+			for(i = 0; i < n; i++)
+				tmp[len++] = digits[i];
+		}
+		else
+		{
+			for(i = 0; i < n || i < decpt; i++)
+			{
+				if(i == decpt)
+					tmp[len++] = '.';
+				tmp[len++] = (i < n) ? digits[i] : '0';
+			}
+		}
+	}
+	if(size > 0)
+	{
+		i = ((size_t)len < size) ? len : size - 1;
+		memcpy(buf, tmp, i);
+		buf[i] = '\0';
+	}
+	return len;
+}
+EXPORT_SYMBOL(dtostr);
@@ -6,39 +6,44 @@
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <malloc.h>
 #include <json.h>
 
-enum {
-	FLAG_NEXT				= 1 << 0,
-	FLAG_REPROC				= 1 << 1,
-	FLAG_NEED_COMMA			= 1 << 2,
-	FLAG_SEEK_VALUE			= 1 << 3,
-	FLAG_ESCAPED			= 1 << 4,
-	FLAG_STRING				= 1 << 5,
-	FLAG_NEED_COLON			= 1 << 6,
-	FLAG_DONE				= 1 << 7,
-	FLAG_NUM_NEGATIVE		= 1 << 8,
-	FLAG_NUM_ZERO			= 1 << 9,
-	FLAG_NUM_E				= 1 << 10,
-	FLAG_NUM_E_GOT_SIGN		= 1 << 11,
-	FLAG_NUM_E_NEGATIVE		= 1 << 12,
-	FLAG_LINE_COMMENT		= 1 << 13,
-	FLAG_BLOCK_COMMENT		= 1 << 14,
-	FLAG_NUM_GOT_DECIMAL	= 1 << 15,
+/*
+ * Tokenizer, the stack of open containers is kept on the heap so that the
+ * depth of the document doesn't eat the kernel stack.
+ */
+struct json_parser_t {
+	const struct json_sax_t * sax;
+	void * ctx;
+	const char * ptr;
+	const char * end;
+	const char * line_ptr;
+	unsigned int line;
+	int insitu;
+
+	char * scratch;
+	size_t scratch_size;
+
+	char * stack;
+	int depth;
+	int stack_size;
+
+	char * error;
 };
 
-struct json_state_t
-{
-	unsigned long used_memory;
-	unsigned int uint_max;
-	unsigned long ulong_max;
-	int first_pass;
-	const char * ptr;
-	unsigned int cur_line;
-	unsigned int cur_col;
+static const double pow10_table[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
 };
 
+static inline int json_isdigit(char c)
+{
+	return ((c >= '0') && (c <= '9'));
+}
+
 static unsigned char hex_value(char c)
 {
 	if(isdigit(c))
@@ -69,810 +74,815 @@ static unsigned char hex_value(char c)
 	}
 }
 
-static void * json_alloc(struct json_state_t * state, unsigned long size, int zero)
+static int json_error(struct json_parser_t * p, const char * msg)
 {
-	if((state->ulong_max - state->used_memory) < size)
-		return 0;
-	return zero ? calloc(1, size) : malloc(size);
+	if(p->error && !*p->error)
+		sprintf(p->error, "%d:%d: %s", p->line, (int)(p->ptr - p->line_ptr) + 1, msg);
+	return 0;
 }
 
-static int new_value(struct json_state_t * state, struct json_value_t ** top, struct json_value_t ** root, struct json_value_t ** alloc, enum json_type_t type)
+static int json_skip(struct json_parser_t * p)
 {
-	struct json_value_t * value;
-	int values_size;
-
-	if(!state->first_pass)
+	while(p->ptr < p->end)
 	{
-		value = *top = *alloc;
-		*alloc = (*alloc)->reserved.next_alloc;
-
-		if(!*root)
-			*root = value;
-
-		switch(value->type)
+		switch(*p->ptr)
 		{
-		case JSON_ARRAY:
-			if(value->u.array.length == 0)
-				break;
-			if(!(value->u.array.values = (struct json_value_t **)json_alloc(state, value->u.array.length * sizeof(struct json_value_t *), 0)))
-				return 0;
-			value->u.array.length = 0;
+		case '\n':
+			p->line++;
+			p->line_ptr = ++p->ptr;
 			break;
-
-		case JSON_OBJECT:
-			if(value->u.object.length == 0)
-				break;
-			values_size = sizeof(*value->u.object.values) * value->u.object.length;
-
-			if(!(value->u.object.values = (struct json_object_entry_t *)json_alloc(state, values_size + ((unsigned long)value->u.object.values), 0)))
-				return 0;
-			value->reserved.object_mem = (char *)value->u.object.values + values_size;
-			value->u.object.length = 0;
+		case ' ':
+		case '\t':
+		case '\r':
+			p->ptr++;
 			break;
-
-		case JSON_STRING:
-			if(!(value->u.string.ptr = (char *)json_alloc(state, (value->u.string.length + 1) * sizeof(char), 0)))
-				return 0;
-			value->u.string.length = 0;
+		case '/':
+			if((p->ptr + 1 < p->end) && (p->ptr[1] == '/'))
+			{
+				while((p->ptr < p->end) && (*p->ptr != '\n'))
+					p->ptr++;
+			}
+			else if((p->ptr + 1 < p->end) && (p->ptr[1] == '*'))
+			{
+				for(p->ptr += 2;; p->ptr++)
+				{
+					if(p->ptr + 1 >= p->end)
+						return json_error(p, "Unexpected EOF in block comment");
+					if(*p->ptr == '\n')
+					{
+						p->line++;
+						p->line_ptr = p->ptr + 1;
+					}
+					else if((p->ptr[0] == '*') && (p->ptr[1] == '/'))
+					{
+						p->ptr += 2;
+						break;
+					}
+				}
+			}
+			else
+				return json_error(p, "Unexpected `/` in comment opening sequence");
 			break;
-
 		default:
-			break;
-		};
-		return 1;
+			return 1;
+		}
 	}
+	return 1;
+}
 
-	if(!(value = (struct json_value_t *)json_alloc(state, sizeof(struct json_value_t), 1)))
-		return 0;
+static int json_push(struct json_parser_t * p, char c)
+{
+	char * stack;
 
-	if(!*root)
-		*root = value;
+	if(p->depth >= p->stack_size)
+	{
+		stack = realloc(p->stack, p->stack_size ? p->stack_size * 2 : 32);
+		if(!stack)
+			return json_error(p, "Memory allocation failure");
+		p->stack = stack;
+		p->stack_size = p->stack_size ? p->stack_size * 2 : 32;
+	}
+	p->stack[p->depth++] = c;
+	return 1;
+}
 
-	value->type = type;
-	value->parent = *top;
+static int json_utf8(char * d, unsigned int uchar)
+{
+	if(uchar <= 0x7f)
+	{
+		d[0] = (char)uchar;
+		return 1;
+	}
+	if(uchar <= 0x7ff)
+	{
+		d[0] = 0xc0 | (uchar >> 6);
+		d[1] = 0x80 | (uchar & 0x3f);
+		return 2;
+	}
+	if(uchar <= 0xffff)
+	{
+		d[0] = 0xe0 | (uchar >> 12);
+		d[1] = 0x80 | ((uchar >> 6) & 0x3f);
+		d[2] = 0x80 | (uchar & 0x3f);
+		return 3;
+	}
+	d[0] = 0xf0 | (uchar >> 18);
+	d[1] = 0x80 | ((uchar >> 12) & 0x3f);
+	d[2] = 0x80 | ((uchar >> 6) & 0x3f);
+	d[3] = 0x80 | (uchar & 0x3f);
+	return 4;
+}
+
+static int json_hex4(const char * s, unsigned int * v)
+{
+	unsigned char b1, b2, b3, b4;
 
-	if(*alloc)
-		(*alloc)->reserved.next_alloc = value;
-	*alloc = *top = value;
+	if(((b1 = hex_value(s[0])) == 0xff) || ((b2 = hex_value(s[1])) == 0xff)
+		|| ((b3 = hex_value(s[2])) == 0xff) || ((b4 = hex_value(s[3])) == 0xff))
+		return 0;
+	*v = (b1 << 12) | (b2 << 8) | (b3 << 4) | b4;
 	return 1;
 }
 
-struct json_value_t * json_parse(const char * json, size_t length, char * errbuf)
+/*
+ * Scan a string, the opening quote is already consumed. Strings without escapes
+ * are returned in place. Escaped strings are decoded into the source itself in
+ * insitu mode, decoding never grows the text, otherwise into the scratch buffer.
+ */
+static int json_string(struct json_parser_t * p, const char ** str, size_t * len)
 {
-	char error[256];
-	const char * end;
-	struct json_value_t * top, * root, * alloc = 0;
-	struct json_state_t state = { 0 };
-	long flags = 0;
-	double num_digits = 0, num_e = 0;
-	double num_fraction = 0;
-
-	if (length >= 3 && ((unsigned char)json[0]) == 0xef
-					&& ((unsigned char)json[1]) == 0xbb
-					&& ((unsigned char)json[2]) == 0xbf)
+	const char * s = p->ptr, * q = p->ptr;
+	unsigned int uchar, uchar2;
+	char * d, * buf;
+
+	while((q < p->end) && (*q != '"') && (*q != '\\'))
+		q++;
+	if(q >= p->end)
+		return json_error(p, "Unexpected EOF in string");
+	if(*q == '"')
 	{
-		json += 3;
-		length -= 3;
+		*str = s;
+		*len = q - s;
+		if(p->insitu)
+			*((char *)q) = '\0';
+		p->ptr = q + 1;
+		return 1;
 	}
 
-	error[0] = '\0';
-	end = json + length;
-	memset(&state.uint_max, 0xff, sizeof(state.uint_max));
-	memset(&state.ulong_max, 0xff, sizeof(state.ulong_max));
-	state.uint_max -= 8;
-	state.ulong_max -= 8;
-
-   for(state.first_pass = 1; state.first_pass >= 0; --state.first_pass)
-   {
-		unsigned int uchar;
-		unsigned char uc_b1, uc_b2, uc_b3, uc_b4;
-		char * string = 0;
-		unsigned int string_length = 0;
-
-		top = root = 0;
-		flags = FLAG_SEEK_VALUE;
-		state.cur_line = 1;
-
-		for(state.ptr = json;; ++state.ptr)
+	if(p->insitu)
+		d = buf = (char *)s;
+	else
+	{
+		if(p->scratch_size < (size_t)(p->end - s) + 1)
 		{
-			char b = (state.ptr == end ? 0 : *state.ptr);
+			buf = realloc(p->scratch, (p->end - s) + 1);
+			if(!buf)
+				return json_error(p, "Memory allocation failure");
+			p->scratch = buf;
+			p->scratch_size = (p->end - s) + 1;
+		}
+		buf = p->scratch;
+		memcpy(buf, s, q - s);
+		d = buf + (q - s);
+	}
 
-			if(flags & FLAG_STRING)
+	while(q < p->end)
+	{
+		if(*q == '"')
+		{
+			*d = '\0';
+			*str = buf;
+			*len = d - buf;
+			p->ptr = q + 1;
+			return 1;
+		}
+		if(*q != '\\')
+		{
+			*d++ = *q++;
+			continue;
+		}
+		if(++q >= p->end)
+			break;
+		switch(*q)
+		{
+		case 'b':
+			*d++ = '\b';
+			break;
+		case 'f':
+			*d++ = '\f';
+			break;
+		case 'n':
+			*d++ = '\n';
+			break;
+		case 'r':
+			*d++ = '\r';
+			break;
+		case 't':
+			*d++ = '\t';
+			break;
+		case 'u':
+			if((p->end - q <= 4) || !json_hex4(q + 1, &uchar))
 			{
-				if(!b)
+				p->ptr = q;
+				return json_error(p, "Invalid character value `u`");
+			}
+			q += 4;
+			if((uchar & 0xf800) == 0xd800)
+			{
+				if((p->end - q <= 6) || (q[1] != '\\') || (q[2] != 'u') || !json_hex4(q + 3, &uchar2))
 				{
-					sprintf(error, "Unexpected EOF in string (at %d:%d)", state.cur_line, state.cur_col);
-					goto e_failed;
+					p->ptr = q;
+					return json_error(p, "Invalid character value `u`");
 				}
+				q += 6;
+				uchar = 0x010000 | ((uchar & 0x3ff) << 10) | (uchar2 & 0x3ff);
+			}
+			d += json_utf8(d, uchar);
+			break;
+		default:
+			*d++ = *q;
+			break;
+		}
+		q++;
+	}
+	p->ptr = q;
+	return json_error(p, "Unexpected EOF in string");
+}
 
-				if(string_length > state.uint_max)
-					goto e_overflow;
+/*
+ * Integers are accumulated exactly. Doubles with at most 15 significant digits
+ * and a small exponent are exact in one multiply or divide, anything else goes
+ * through strtod().
+ */
+static int json_number(struct json_parser_t * p, int * isint, int64_t * ival, double * dval)
+{
+	const char * s = p->ptr, * q = p->ptr;
+	uint64_t mant = 0;
+	int digits = 0, dropped = 0, frac = 0;
+	int neg = 0, exp = 0, eneg = 0, isdbl = 0;
+	char buf[64];
+	char * tmp;
+	double d;
+
+	if(*q == '-')
+	{
+		neg = 1;
+		q++;
+	}
+	if((q >= p->end) || !json_isdigit(*q))
+	{
+		p->ptr = q;
+		return json_error(p, "Expected digit");
+	}
+	if((*q == '0') && (q + 1 < p->end) && json_isdigit(q[1]))
+	{
+		p->ptr = q;
+		return json_error(p, "Unexpected `0` before digit");
+	}
+	while((q < p->end) && json_isdigit(*q))
+	{
+		if(digits < 19)
+		{
+			mant = mant * 10 + (*q - '0');
+			if(mant)
+				digits++;
+		}
+		else
+			dropped++;
+		q++;
+	}
+	if((q < p->end) && (*q == '.'))
+	{
+		isdbl = 1;
+		if((++q >= p->end) || !json_isdigit(*q))
+		{
+			p->ptr = q;
+			return json_error(p, "Expected digit after `.`");
+		}
+		while((q < p->end) && json_isdigit(*q))
+		{
+			if(digits < 19)
+			{
+				mant = mant * 10 + (*q - '0');
+				if(mant)
+					digits++;
+				frac++;
+			}
+			q++;
+		}
+	}
+	if((q < p->end) && ((*q == 'e') || (*q == 'E')))
+	{
+		isdbl = 1;
+		if((++q < p->end) && ((*q == '+') || (*q == '-')))
+			eneg = (*q++ == '-');
+		if((q >= p->end) || !json_isdigit(*q))
+		{
+			p->ptr = q;
+			return json_error(p, "Expected digit after `e`");
+		}
+		while((q < p->end) && json_isdigit(*q))
+		{
+			if(exp < 100000)
+				exp = exp * 10 + (*q - '0');
+			q++;
+		}
+	}
+	p->ptr = q;
 
-				if(flags & FLAG_ESCAPED)
-				{
-					flags &= ~FLAG_ESCAPED;
+	if(!isdbl && !dropped && (mant <= 9223372036854775807ULL))
+	{
+		*isint = 1;
+		*ival = neg ? -(int64_t)mant : (int64_t)mant;
+		return 1;
+	}
 
-					switch(b)
-					{
-					case 'b':
-						if(!state.first_pass)
-							string[string_length] = '\b';
-						++string_length;
-						break;
-					case 'f':
-						if(!state.first_pass)
-							string[string_length] = '\f';
-						++string_length;
-						break;
-					case 'n':
-						if(!state.first_pass)
-							string[string_length] = '\n';
-						++string_length;
-						break;
-					case 'r':
-						if(!state.first_pass)
-							string[string_length] = '\r';
-						++string_length;
-						break;
-					case 't':
-						if(!state.first_pass)
-							string[string_length] = '\t';
-						++string_length;
-						break;
-					case 'u':
-						if(end - state.ptr <= 4
-								|| (uc_b1 = hex_value(*++state.ptr)) == 0xff
-								|| (uc_b2 = hex_value(*++state.ptr)) == 0xff
-								|| (uc_b3 = hex_value(*++state.ptr)) == 0xff
-								|| (uc_b4 = hex_value(*++state.ptr)) == 0xff) {
-							sprintf(error, "Invalid character value `%c` (at %d:%d)", b, state.cur_line, state.cur_col);
-							goto e_failed;
-						}
-
-						uc_b1 = (uc_b1 << 4) | uc_b2;
-						uc_b2 = (uc_b3 << 4) | uc_b4;
-						uchar = (uc_b1 << 8) | uc_b2;
-
-						if((uchar & 0xf800) == 0xd800)
-						{
-							unsigned int uchar2;
-
-							if(end - state.ptr <= 6
-									|| (*++state.ptr) != '\\'
-									|| (*++state.ptr) != 'u'
-									|| (uc_b1 = hex_value(*++state.ptr)) == 0xff
-									|| (uc_b2 = hex_value(*++state.ptr)) == 0xff
-									|| (uc_b3 = hex_value(*++state.ptr)) == 0xff
-									|| (uc_b4 = hex_value(*++state.ptr)) == 0xff)
-							{
-								sprintf(error, "Invalid character value `%c` (at %d:%d)", b, state.cur_line, state.cur_col);
-								goto e_failed;
-							}
-
-							uc_b1 = (uc_b1 << 4) | uc_b2;
-							uc_b2 = (uc_b3 << 4) | uc_b4;
-							uchar2 = (uc_b1 << 8) | uc_b2;
-							uchar = 0x010000 | ((uchar & 0x3ff) << 10) | (uchar2 & 0x3ff);
-						}
-
-						if(sizeof(char) >= sizeof(unsigned int) || (uchar <= 0x7f))
-						{
-							if(!state.first_pass)
-								string[string_length] = (char )uchar;
-							++string_length;
-							break;
-						}
-
-						if(uchar <= 0x7ff)
-						{
-							if(state.first_pass)
-								string_length += 2;
-							else
-							{
-								string[string_length++] = 0xc0 | (uchar >> 6);
-								string[string_length++] = 0x80 | (uchar & 0x3f);
-							}
-							break;
-						}
-
-						if(uchar <= 0xffff)
-						{
-							if(state.first_pass)
-								string_length += 3;
-							else
-							{
-								string[string_length++] = 0xe0 | (uchar >> 12);
-								string[string_length++] = 0x80 | ((uchar >> 6) & 0x3f);
-								string[string_length++] = 0x80 | (uchar & 0x3f);
-							}
-							break;
-						}
-
-						if(state.first_pass)
-							string_length += 4;
-						else {
-							string[string_length++] = 0xf0 | (uchar >> 18);
-							string[string_length++] = 0x80 | ((uchar >> 12) & 0x3f);
-							string[string_length++] = 0x80 | ((uchar >> 6) & 0x3f);
-							string[string_length++] = 0x80 | (uchar & 0x3f);
-						}
-						break;
+	exp = (eneg ? -exp : exp) - frac + dropped;
+	if((mant < (1ULL << 53)) && (exp >= -22) && (exp <= 22))
+	{
+		d = (double)mant;
+		d = (exp < 0) ? d / pow10_table[-exp] : d * pow10_table[exp];
+	}
+	else
+	{
+		if(q - s < sizeof(buf))
+			tmp = buf;
+		else if(!(tmp = malloc(q - s + 1)))
+			return json_error(p, "Memory allocation failure");
+		memcpy(tmp, s, q - s);
+		tmp[q - s] = '\0';
+		d = strtod(tmp, NULL);
+		if(tmp != buf)
+			free(tmp);
+		neg = 0;
+	}
+	*isint = 0;
+	*dval = neg ? -d : d;
+	return 1;
+}
 
-					default:
-						if(!state.first_pass)
-							string[string_length] = b;
-						++string_length;
-					};
-					continue;
-				}
+static int json_literal(struct json_parser_t * p, const char * word)
+{
+	int l = strlen(word);
 
-				if(b == '\\')
-				{
-					flags |= FLAG_ESCAPED;
-					continue;
-				}
+	if((p->end - p->ptr < l) || (memcmp(p->ptr, word, l) != 0))
+		return json_error(p, "Unknown value");
+	p->ptr += l;
+	return 1;
+}
 
-				if(b == '"')
-				{
-					if(!state.first_pass)string[string_length] = 0;
-					flags &= ~FLAG_STRING;
-					string = 0;
+#define SAX_CALL(fn, ...)	((!sax->fn || sax->fn(p->ctx, ##__VA_ARGS__)) ? 1 : json_error(p, "Aborted by callback"))
 
-					switch(top->type)
-					{
-					case JSON_STRING:
-						top->u.string.length = string_length;
-						flags |= FLAG_NEXT;
-						break;
+enum {
+	STATE_VALUE,
+	STATE_ARRAY_FIRST,
+	STATE_OBJECT_FIRST,
+	STATE_NEXT,
+};
 
-					case JSON_OBJECT:
-						if(state.first_pass)
-							top->u.object.values = (void *)((char *)top->u.object.values + string_length + 1);
-						else
-						{
-							top->u.object.values[top->u.object.length].name = (char *)top->reserved.object_mem;
-							top->u.object.values[top->u.object.length].name_length = string_length;
-							(*(char **)&top->reserved.object_mem) += string_length + 1;
-						}
-						flags |= (FLAG_SEEK_VALUE | FLAG_NEED_COLON);
-						continue;
-
-					default:
-						break;
-					};
-				}
-				else
-				{
-					if(!state.first_pass)
-						string[string_length] = b;
-					++string_length;
-					continue;
-				}
+static int json_run(struct json_parser_t * p)
+{
+	const struct json_sax_t * sax = p->sax;
+	const char * str;
+	size_t len;
+	int64_t ival = 0;
+	double dval = 0;
+	int isint = 0;
+	int state = STATE_VALUE;
+	char c;
+
+	if((p->end - p->ptr >= 3) && ((unsigned char)p->ptr[0] == 0xef) && ((unsigned char)p->ptr[1] == 0xbb) && ((unsigned char)p->ptr[2] == 0xbf))
+		p->ptr += 3;
+	p->line = 1;
+	p->line_ptr = p->ptr;
+
+	for(;;)
+	{
+		if(!json_skip(p))
+			return 0;
+		if(p->ptr >= p->end)
+		{
+			if((state == STATE_NEXT) && (p->depth == 0))
+				return 1;
+			return json_error(p, "EOF unexpected");
+		}
+		c = *p->ptr;
+
+		switch(state)
+		{
+		case STATE_ARRAY_FIRST:
+			if(c == ']')
+			{
+				p->ptr++;
+				p->depth--;
+				if(!SAX_CALL(end_array))
+					return 0;
+				state = STATE_NEXT;
+				continue;
+			}
+			/* fall through */
+		case STATE_VALUE:
+			switch(c)
+			{
+			case '{':
+				p->ptr++;
+				if(!json_push(p, '{') || !SAX_CALL(start_object))
+					return 0;
+				state = STATE_OBJECT_FIRST;
+				continue;
+			case '[':
+				p->ptr++;
+				if(!json_push(p, '[') || !SAX_CALL(start_array))
+					return 0;
+				state = STATE_ARRAY_FIRST;
+				continue;
+			case '"':
+				p->ptr++;
+				if(!json_string(p, &str, &len) || !SAX_CALL(string, str, len))
+					return 0;
+				break;
+			case 't':
+				if(!json_literal(p, "true") || !SAX_CALL(boolean, 1))
+					return 0;
+				break;
+			case 'f':
+				if(!json_literal(p, "false") || !SAX_CALL(boolean, 0))
+					return 0;
+				break;
+			case 'n':
+				if(!json_literal(p, "null") || !SAX_CALL(null))
+					return 0;
+				break;
+			default:
+				if(!json_isdigit(c) && (c != '-'))
+					return json_error(p, "Unexpected character when seeking value");
+				if(!json_number(p, &isint, &ival, &dval))
+					return 0;
+				if(isint ? !SAX_CALL(integer, ival) : !SAX_CALL(dbl, dval))
+					return 0;
+				break;
 			}
+			state = STATE_NEXT;
+			continue;
 
-			if(flags & (FLAG_LINE_COMMENT | FLAG_BLOCK_COMMENT))
+		case STATE_OBJECT_FIRST:
+			if(c == '}')
 			{
-				if(flags & FLAG_LINE_COMMENT)
-				{
-					if(b == '\r' || b == '\n' || !b)
-					{
-						flags &= ~FLAG_LINE_COMMENT;
-						--state.ptr;
-					}
-					continue;
-				}
+				p->ptr++;
+				p->depth--;
+				if(!SAX_CALL(end_object))
+					return 0;
+				state = STATE_NEXT;
+				continue;
+			}
+			if(c != '"')
+				return json_error(p, "Expected \" in object");
+			p->ptr++;
+			if(!json_string(p, &str, &len) || !SAX_CALL(key, str, len))
+				return 0;
+			if(!json_skip(p))
+				return 0;
+			if((p->ptr >= p->end) || (*p->ptr != ':'))
+				return json_error(p, "Expected : after key");
+			p->ptr++;
+			state = STATE_VALUE;
+			continue;
 
-				if(flags & FLAG_BLOCK_COMMENT)
-				{
-					if(!b)
-					{
-						sprintf(error, "%d:%d: Unexpected EOF in block comment", state.cur_line, state.cur_col);
-						goto e_failed;
-					}
-					if(b == '*' && state.ptr < (end - 1) && state.ptr[1] == '/')
-					{
-						flags &= ~FLAG_BLOCK_COMMENT;
-						++state.ptr;
-					}
-					continue;
-				}
+		case STATE_NEXT:
+			if(p->depth == 0)
+				return json_error(p, "Trailing garbage");
+			if(c == ',')
+			{
+				/* a trailing comma before the closing bracket is tolerated */
+				p->ptr++;
+				state = (p->stack[p->depth - 1] == '{') ? STATE_OBJECT_FIRST : STATE_ARRAY_FIRST;
+				continue;
 			}
-			else if(b == '/')
+			if((c == '}') && (p->stack[p->depth - 1] == '{'))
 			{
-				if(!(flags & (FLAG_SEEK_VALUE | FLAG_DONE)) && top->type != JSON_OBJECT)
-				{
-					sprintf(error, "%d:%d: Comment not allowed here", state.cur_line, state.cur_col);
-					goto e_failed;
-				}
+				p->ptr++;
+				p->depth--;
+				if(!SAX_CALL(end_object))
+					return 0;
+				continue;
+			}
+			if((c == ']') && (p->stack[p->depth - 1] == '['))
+			{
+				p->ptr++;
+				p->depth--;
+				if(!SAX_CALL(end_array))
+					return 0;
+				continue;
+			}
+			return json_error(p, "Expected , or closing bracket");
 
-				if(++state.ptr == end)
-				{
-					sprintf(error, "%d:%d: EOF unexpected", state.cur_line, state.cur_col);
-					goto e_failed;
-				}
+		default:
+			return 0;
+		}
+	}
+}
 
-				switch(b = *state.ptr)
-				{
-				case '/':
-					flags |= FLAG_LINE_COMMENT;
-					continue;
-
-				case '*':
-					flags |= FLAG_BLOCK_COMMENT;
-					continue;
-
-				default:
-					sprintf(error, "%d:%d: Unexpected `%c` in comment opening sequence", state.cur_line, state.cur_col, b);
-					goto e_failed;
-				};
-			}
+static bool_t json_sax_run(const char * json, size_t length, int insitu, const struct json_sax_t * sax, void * ctx, char * errbuf)
+{
+	struct json_parser_t p;
+	char error[256];
+	int ret;
+
+	memset(&p, 0, sizeof(struct json_parser_t));
+	p.sax = sax;
+	p.ctx = ctx;
+	p.ptr = json;
+	p.end = json + length;
+	p.insitu = insitu;
+	p.error = error;
+	error[0] = '\0';
 
-			if(flags & FLAG_DONE)
-			{
-				if(!b)
-					break;
+	ret = (json && sax) ? json_run(&p) : json_error(&p, "Invalid argument");
+	if(p.scratch)
+		free(p.scratch);
+	if(p.stack)
+		free(p.stack);
+	if(!ret && errbuf)
+		strcpy(errbuf, *error ? error : "Unknown error");
+	return ret ? TRUE : FALSE;
+}
 
-				switch(b)
-				{
-				case '\n':
-					++state.cur_line;
-					state.cur_col = 0;
-					continue;
-				case ' ':
-				case '\t':
-				case '\r':
-					continue;
-
-				default:
-					sprintf(error, "%d:%d: Trailing garbage: `%c`", state.cur_line, state.cur_col, b);
-					goto e_failed;
-				};
-			}
+bool_t json_sax_parse(const char * json, size_t length, const struct json_sax_t * sax, void * ctx, char * errbuf)
+{
+	return json_sax_run(json, length, 0, sax, ctx, errbuf);
+}
 
-			if(flags & FLAG_SEEK_VALUE)
-			{
-				switch(b)
-				{
-				case '\n':
-					++state.cur_line;
-					state.cur_col = 0;
-					continue;
-				case ' ':
-				case '\t':
-				case '\r':
-					continue;
-
-				case ']':
-					if(top && top->type == JSON_ARRAY)
-						flags = (flags & ~(FLAG_NEED_COMMA | FLAG_SEEK_VALUE)) | FLAG_NEXT;
-					else
-					{
-						sprintf(error, "%d:%d: Unexpected ]", state.cur_line, state.cur_col);
-						goto e_failed;
-					}
-					break;
+/*
+ * Tree builder, a counting pass sizes one arena that holds every value, the
+ * array slots and the object entries. The root value sits at the start of the
+ * arena and is tagged by pointing its reserved field to itself, so json_free()
+ * on anything but a root is a no-op.
+ */
+struct json_count_t {
+	unsigned long values;
+	unsigned long members;
+};
 
-				default:
-					if(flags & FLAG_NEED_COMMA)
-					{
-						if(b == ',')
-						{
-							flags &= ~FLAG_NEED_COMMA;
-							continue;
-						}
-						else
-						{
-							sprintf(error, "%d:%d: Expected , before %c", state.cur_line, state.cur_col, b);
-							goto e_failed;
-						}
-					}
+static int count_value(void * ctx)
+{
+	((struct json_count_t *)ctx)->values++;
+	return 1;
+}
 
-					if(flags & FLAG_NEED_COLON)
-					{
-						if(b == ':')
-						{
-							flags &= ~FLAG_NEED_COLON;
-							continue;
-						}
-						else
-						{
-							sprintf(error, "%d:%d: Expected : before %c", state.cur_line, state.cur_col, b);
-							goto e_failed;
-						}
-					}
+static int count_boolean(void * ctx, int v)
+{
+	return count_value(ctx);
+}
 
-					flags &= ~FLAG_SEEK_VALUE;
-					switch(b)
-					{
-					case '{':
-						if(!new_value(&state, &top, &root, &alloc, JSON_OBJECT))
-							goto e_alloc_failure;
-						continue;
-
-					case '[':
-						if(!new_value(&state, &top, &root, &alloc, JSON_ARRAY))
-							goto e_alloc_failure;
-						flags |= FLAG_SEEK_VALUE;
-						continue;
-
-					case '"':
-						if(!new_value(&state, &top, &root, &alloc, JSON_STRING))
-							goto e_alloc_failure;
-						flags |= FLAG_STRING;
-						string = top->u.string.ptr;
-						string_length = 0;
-						continue;
-
-					case 't':
-						if((end - state.ptr) <= 3
-								|| *(++state.ptr) != 'r'
-								|| *(++state.ptr) != 'u'
-								|| *(++state.ptr) != 'e')
-						{
-							goto e_unknown_value;
-						}
-						if(!new_value(&state, &top, &root, &alloc, JSON_BOOLEAN))
-							goto e_alloc_failure;
-
-						top->u.boolean = 1;
-						flags |= FLAG_NEXT;
-						break;
+static int count_integer(void * ctx, int64_t v)
+{
+	return count_value(ctx);
+}
 
-					case 'f':
-						if((end - state.ptr) <= 4
-								|| *(++state.ptr) != 'a'
-								|| *(++state.ptr) != 'l'
-								|| *(++state.ptr) != 's'
-								|| *(++state.ptr) != 'e')
-						{
-							goto e_unknown_value;
-						}
-						if(!new_value(&state, &top, &root, &alloc, JSON_BOOLEAN))
-							goto e_alloc_failure;
-						flags |= FLAG_NEXT;
-						break;
+static int count_dbl(void * ctx, double v)
+{
+	return count_value(ctx);
+}
 
-					case 'n':
-						if((end - state.ptr) <= 3
-								|| *(++state.ptr) != 'u'
-								|| *(++state.ptr) != 'l'
-								|| *(++state.ptr) != 'l')
-						{
-							goto e_unknown_value;
-						}
-						if(!new_value(&state, &top, &root, &alloc, JSON_NULL))
-							goto e_alloc_failure;
-						flags |= FLAG_NEXT;
-						break;
+static int count_string(void * ctx, const char * s, size_t len)
+{
+	return count_value(ctx);
+}
 
-					default:
-						if(isdigit(b) || b == '-')
-						{
-							if(!new_value(&state, &top, &root, &alloc, JSON_INTEGER))
-								goto e_alloc_failure;
-							if(!state.first_pass)
-							{
-								while(isdigit(b) || b == '+' || b == '-' || b == 'e' || b == 'E' || b == '.')
-								{
-									if((++state.ptr) == end)
-									{
-										b = 0;
-										break;
-									}
-									b = *state.ptr;
-								}
-								flags |= FLAG_NEXT | FLAG_REPROC;
-								break;
-							}
-
-							flags &= ~(FLAG_NUM_NEGATIVE
-									| FLAG_NUM_E
-									| FLAG_NUM_E_GOT_SIGN
-									| FLAG_NUM_E_NEGATIVE
-									| FLAG_NUM_ZERO);
-							num_digits = 0;
-							num_fraction = 0;
-							num_e = 0;
-
-							if(b != '-')
-							{
-								flags |= FLAG_REPROC;
-								break;
-							}
-							flags |= FLAG_NUM_NEGATIVE;
-							continue;
-						}
-						else
-						{
-							sprintf(error, "%d:%d: Unexpected %c when seeking value", state.cur_line, state.cur_col, b);
-							goto e_failed;
-						}
-					}
-				}
-			}
-			else
-			{
-				switch(top->type)
-				{
-				case JSON_OBJECT:
-					switch(b)
-					{
-					case '\n':
-						++state.cur_line;
-						state.cur_col = 0;
-						continue;
-					case ' ':
-					case '\t':
-					case '\r':
-						continue;
-
-					case '"':
-						if(flags & FLAG_NEED_COMMA)
-						{
-							sprintf(error, "%d:%d: Expected , before \"", state.cur_line, state.cur_col);
-							goto e_failed;
-						}
-						flags |= FLAG_STRING;
-						string = (char *)top->reserved.object_mem;
-						string_length = 0;
-						break;
+static int count_key(void * ctx, const char * s, size_t len)
+{
+	((struct json_count_t *)ctx)->members++;
+	return 1;
+}
 
-					case '}':
-						flags = (flags & ~FLAG_NEED_COMMA) | FLAG_NEXT;
-						break;
+static const struct json_sax_t json_count_sax = {
+	.null			= count_value,
+	.boolean		= count_boolean,
+	.integer		= count_integer,
+	.dbl			= count_dbl,
+	.string			= count_string,
+	.key			= count_key,
+	.start_object	= count_value,
+	.start_array	= count_value,
+};
 
-					case ',':
-						if(!(flags & FLAG_NEED_COMMA))
-						{
-							sprintf(error, "%d:%d: Unexpected `%c` in object", state.cur_line, state.cur_col, b);
-							goto e_failed;
-						}
-						flags &= ~FLAG_NEED_COMMA;
-						break;
+struct json_build_t {
+	struct json_value_t * root;
+	struct json_value_t * top;
+	struct json_value_t * values;
+	struct json_value_t ** slots;
+	struct json_object_entry_t * entries;
 
-					default:
-						sprintf(error, "%d:%d: Unexpected `%c` in object", state.cur_line, state.cur_col, b);
-						goto e_failed;
-					}
-					break;
+	struct json_value_t ** pslots;
+	int npslots, szpslots;
+	struct json_object_entry_t * pentries;
+	int npentries, szpentries;
 
-				case JSON_INTEGER:
-				case JSON_DOUBLE:
-					if(isdigit(b))
-					{
-						++num_digits;
-
-						if(top->type == JSON_INTEGER || (flags & FLAG_NUM_E))
-						{
-							if(!(flags & FLAG_NUM_E))
-							{
-								if(flags & FLAG_NUM_ZERO)
-								{
-									sprintf(error, "%d:%d: Unexpected `0` before `%c`", state.cur_line, state.cur_col, b);
-									goto e_failed;
-								}
-								if (num_digits == 1 && b == '0')
-									flags |= FLAG_NUM_ZERO;
-							}
-							else
-							{
-								flags |= FLAG_NUM_E_GOT_SIGN;
-								num_e = (num_e * 10) + (b - '0');
-								continue;
-							}
-							if(((9223372036854775807LL - (b - '0')) / 10) < top->u.integer)
-							{
-								--num_digits;
-								--state.ptr;
-								top->type = JSON_DOUBLE;
-								top->u.dbl = (double)top->u.integer;
-								continue;
-							}
-							top->u.integer = (top->u.integer * 10) + (b - '0');
-							continue;
-						}
-						if(flags & FLAG_NUM_GOT_DECIMAL)
-							num_fraction = (num_fraction * 10) + (b - '0');
-						else
-							top->u.dbl = (top->u.dbl * 10) + (b - '0');
-						continue;
-					}
+	char * key;
+	unsigned int key_length;
+};
 
-					if(b == '+' || b == '-')
-					{
-						if((flags & FLAG_NUM_E) && !(flags & FLAG_NUM_E_GOT_SIGN))
-						{
-							flags |= FLAG_NUM_E_GOT_SIGN;
-							if(b == '-')
-								flags |= FLAG_NUM_E_NEGATIVE;
-							continue;
-						}
-					}
-					else if(b == '.' && top->type == JSON_INTEGER)
-					{
-						if(!num_digits)
-						{
-							sprintf(error, "%d:%d: Expected digit before `.`", state.cur_line, state.cur_col);
-							goto e_failed;
-						}
-						top->type = JSON_DOUBLE;
-						top->u.dbl = (double)top->u.integer;
-						flags |= FLAG_NUM_GOT_DECIMAL;
-						num_digits = 0;
-						continue;
-					}
+static struct json_value_t * build_new(struct json_build_t * b, enum json_type_t type)
+{
+	struct json_value_t * v = b->values++;
+	struct json_value_t * parent = b->top;
+	void * p;
+
+	memset(v, 0, sizeof(struct json_value_t));
+	v->type = type;
+	v->parent = parent;
+	if(!parent)
+	{
+		b->root = v;
+		return v;
+	}
+	if(parent->type == JSON_ARRAY)
+	{
+		if(b->npslots >= b->szpslots)
+		{
+			if(!(p = realloc(b->pslots, sizeof(struct json_value_t *) * (b->szpslots ? b->szpslots * 2 : 64))))
+				return NULL;
+			b->pslots = p;
+			b->szpslots = b->szpslots ? b->szpslots * 2 : 64;
+		}
+		b->pslots[b->npslots++] = v;
+	}
+	else
+	{
+		if(b->npentries >= b->szpentries)
+		{
+			if(!(p = realloc(b->pentries, sizeof(struct json_object_entry_t) * (b->szpentries ? b->szpentries * 2 : 64))))
+				return NULL;
+			b->pentries = p;
+			b->szpentries = b->szpentries ? b->szpentries * 2 : 64;
+		}
+		b->pentries[b->npentries].name = b->key;
+		b->pentries[b->npentries].name_length = b->key_length;
+		b->pentries[b->npentries].value = v;
+		b->npentries++;
+	}
+	return v;
+}
 
-					if(!(flags & FLAG_NUM_E))
-					{
-						if(top->type == JSON_DOUBLE)
-						{
-							if(!num_digits)
-							{
-								sprintf(error, "%d:%d: Expected digit after `.`", state.cur_line, state.cur_col);
-								goto e_failed;
-							}
-							top->u.dbl += num_fraction / pow(10.0, num_digits);
-						}
-
-						if(b == 'e' || b == 'E')
-						{
-							flags |= FLAG_NUM_E;
-							if(top->type == JSON_INTEGER)
-							{
-								top->type = JSON_DOUBLE;
-								top->u.dbl = (double) top->u.integer;
-							}
-							num_digits = 0;
-							flags &= ~FLAG_NUM_ZERO;
-							continue;
-						}
-					}
-					else
-					{
-						if(!num_digits)
-						{
-							sprintf(error, "%d:%d: Expected digit after `e`", state.cur_line, state.cur_col);
-							goto e_failed;
-						}
-						top->u.dbl *= pow(10.0, (flags & FLAG_NUM_E_NEGATIVE ? -num_e : num_e));
-					}
+static int build_null(void * ctx)
+{
+	return build_new(ctx, JSON_NULL) ? 1 : 0;
+}
 
-					if(flags & FLAG_NUM_NEGATIVE)
-					{
-						if(top->type == JSON_INTEGER)
-							top->u.integer = -top->u.integer;
-						else
-							top->u.dbl = -top->u.dbl;
-					}
-					flags |= FLAG_NEXT | FLAG_REPROC;
-					break;
+static int build_boolean(void * ctx, int b)
+{
+	struct json_value_t * v = build_new(ctx, JSON_BOOLEAN);
 
-				default:
-					break;
-				};
-			}
+	if(!v)
+		return 0;
+	v->u.boolean = b;
+	return 1;
+}
 
-			if(flags & FLAG_REPROC)
-			{
-				flags &= ~FLAG_REPROC;
-				--state.ptr;
-			}
+static int build_integer(void * ctx, int64_t i)
+{
+	struct json_value_t * v = build_new(ctx, JSON_INTEGER);
 
-			if(flags & FLAG_NEXT)
-			{
-				flags = (flags & ~FLAG_NEXT) | FLAG_NEED_COMMA;
+	if(!v)
+		return 0;
+	v->u.integer = i;
+	return 1;
+}
 
-				if(!top->parent)
-				{
-					flags |= FLAG_DONE;
-					continue;
-				}
+static int build_dbl(void * ctx, double d)
+{
+	struct json_value_t * v = build_new(ctx, JSON_DOUBLE);
 
-				if(top->parent->type == JSON_ARRAY)
-					flags |= FLAG_SEEK_VALUE;
+	if(!v)
+		return 0;
+	v->u.dbl = d;
+	return 1;
+}
 
-				if(!state.first_pass)
-				{
-					struct json_value_t * parent = top->parent;
+static int build_string(void * ctx, const char * s, size_t len)
+{
+	struct json_value_t * v = build_new(ctx, JSON_STRING);
 
-					switch(parent->type)
-					{
-					case JSON_OBJECT:
-						parent->u.object.values[parent->u.object.length].value = top;
-						break;
+	if(!v)
+		return 0;
+	v->u.string.ptr = (char *)s;
+	v->u.string.length = len;
+	return 1;
+}
 
-					case JSON_ARRAY:
-						parent->u.array.values[parent->u.array.length] = top;
-						break;
+static int build_key(void * ctx, const char * s, size_t len)
+{
+	struct json_build_t * b = (struct json_build_t *)ctx;
 
-					default:
-						break;
-					};
-				}
+	b->key = (char *)s;
+	b->key_length = len;
+	return 1;
+}
 
-				if((++top->parent->u.array.length) > state.uint_max)
-					goto e_overflow;
-				top = top->parent;
-				continue;
-			}
-		}
-		alloc = root;
-	}
-	return root;
+static int build_start(struct json_build_t * b, enum json_type_t type)
+{
+	struct json_value_t * v = build_new(b, type);
+
+	if(!v)
+		return 0;
+	v->reserved.next_alloc = (void *)(unsigned long)((type == JSON_ARRAY) ? b->npslots : b->npentries);
+	b->top = v;
+	return 1;
+}
 
-e_unknown_value:
-	sprintf(error, "%d:%d: Unknown value", state.cur_line, state.cur_col);
-	goto e_failed;
+static int build_start_object(void * ctx)
+{
+	return build_start(ctx, JSON_OBJECT);
+}
 
-e_alloc_failure:
-	strcpy(error, "Memory allocation failure");
-	goto e_failed;
+static int build_start_array(void * ctx)
+{
+	return build_start(ctx, JSON_ARRAY);
+}
 
-e_overflow:
-	sprintf(error, "%d:%d: Too long (caught overflow)", state.cur_line, state.cur_col);
-	goto e_failed;
+static int build_end(void * ctx)
+{
+	struct json_build_t * b = (struct json_build_t *)ctx;
+	struct json_value_t * v = b->top;
+	int start = (int)(unsigned long)v->reserved.next_alloc;
+	int n;
 
-e_failed:
-	if(errbuf)
+	if(v->type == JSON_ARRAY)
 	{
-		if(*error)
-			strcpy(errbuf, error);
-		else
-			strcpy(errbuf, "Unknown error");
+		n = b->npslots - start;
+		v->u.array.length = n;
+		v->u.array.values = b->slots;
+		if(n)
+			memcpy(b->slots, &b->pslots[start], sizeof(struct json_value_t *) * n);
+		b->slots += n;
+		b->npslots = start;
 	}
-	if(state.first_pass)
-		alloc = root;
-	while(alloc)
+	else
 	{
-		top = alloc->reserved.next_alloc;
-		free(alloc);
-		alloc = top;
+		n = b->npentries - start;
+		v->u.object.length = n;
+		v->u.object.values = b->entries;
+		if(n)
+			memcpy(b->entries, &b->pentries[start], sizeof(struct json_object_entry_t) * n);
+		b->entries += n;
+		b->npentries = start;
 	}
-	if(!state.first_pass)
-		json_free(root);
-	return 0;
+	v->reserved.next_alloc = NULL;
+	b->top = v->parent;
+	return 1;
 }
 
-void json_free(struct json_value_t * value)
-{
-	struct json_value_t * v;
-
-	if(!value)
-		return;
+static const struct json_sax_t json_build_sax = {
+	.null			= build_null,
+	.boolean		= build_boolean,
+	.integer		= build_integer,
+	.dbl			= build_dbl,
+	.string			= build_string,
+	.key			= build_key,
+	.start_object	= build_start_object,
+	.end_object		= build_end,
+	.start_array	= build_start_array,
+	.end_array		= build_end,
+};
 
-	value->parent = 0;
-	while(value)
+static struct json_value_t * json_build(char * json, size_t length, int copy, char * errbuf)
+{
+	struct json_count_t c = { 0, 0 };
+	struct json_build_t b;
+	char * mem, * src;
+	unsigned long size;
+	int ret;
+
+	if(!json_sax_run(json, length, 0, &json_count_sax, &c, errbuf))
+		return NULL;
+
+	size = sizeof(struct json_value_t) * c.values
+		+ sizeof(struct json_object_entry_t) * c.members
+		+ sizeof(struct json_value_t *) * c.values;
+	mem = malloc(size + (copy ? length + 1 : 0));
+	if(!mem)
 	{
-		switch(value->type)
-		{
-		case JSON_ARRAY:
-			if(!value->u.array.length)
-			{
-				free(value->u.array.values);
-				break;
-			}
-			value = value->u.array.values[--value->u.array.length];
-			continue;
-
-		case JSON_OBJECT:
-			if(!value->u.object.length)
-			{
-				free(value->u.object.values);
-				break;
-			}
-			value = value->u.object.values[--value->u.object.length].value;
-			continue;
+		if(errbuf)
+			strcpy(errbuf, "Memory allocation failure");
+		return NULL;
+	}
+	if(copy)
+	{
+		src = mem + size;
+		memcpy(src, json, length);
+		src[length] = '\0';
+	}
+	else
+		src = json;
+
+	memset(&b, 0, sizeof(struct json_build_t));
+	b.values = (struct json_value_t *)mem;
+	b.entries = (struct json_object_entry_t *)(b.values + c.values);
+	b.slots = (struct json_value_t **)(b.entries + c.members);
+	ret = json_sax_run(src, length, 1, &json_build_sax, &b, errbuf);
+	free(b.pslots);
+	free(b.pentries);
+	if(!ret || (b.root != (struct json_value_t *)mem))
+	{
+		free(mem);
+		return NULL;
+	}
+	b.root->reserved.object_mem = b.root;
+	return b.root;
+}
 
-		case JSON_STRING:
-			free(value->u.string.ptr);
-			break;
+struct json_value_t * json_parse(const char * json, size_t length, char * errbuf)
+{
+	return json_build((char *)json, length, 1, errbuf);
+}
 
-		default:
-			break;
-		};
+struct json_value_t * json_parse_insitu(char * json, size_t length, char * errbuf)
+{
+	return json_build(json, length, 0, errbuf);
+}
 
-		v = value;
-		value = value->parent;
-		free(v);
-	}
+void json_free(struct json_value_t * value)
+{
+	if(value && (value->reserved.object_mem == (void *)value))
+		free(value);
 }
@@ -0,0 +1,181 @@
+/*
+ * wboxtest/benchmark/fat.c
+ */
+
+#include <wboxtest.h>
+#include <vfs/fat/fat.h>
+
+/*
+ * A FAT16 image on a wboxtest ramdisk
+ */
+#define FAT_DISK_SIZE		(SZ_16M)
+#define FAT_LATENCY_US		(50)
+#define FAT_FILE_SIZE		(SZ_4M)
+#define FAT_MOUNT_PATH		"/tmp/wbt-fat"
+#define FAT_FILE_PATH		"/tmp/wbt-fat/bench.bin"
+
+struct wbt_fat_pdata_t
+{
+	struct wboxtest_ramdisk_t * rd;
+	unsigned char * buf;
+};
+
+/*
+ * An empty FAT16 volume with 2K clusters and a fixed root directory
+ */
+static void fat_format(unsigned char * buf, u32_t size)
+{
+	struct fat_bootsec_t * bsec = (struct fat_bootsec_t *)buf;
+	u32_t sectors = size / 512;
+	u32_t fatsz = ((sectors / 4 + 2) * 2 + 511) / 512;
+	u16_t * fat;
+	int i;
+
+	memset(buf, 0, size);
+	memcpy(bsec->jump, "\xeb\x3c\x90", 3);
+	memcpy(bsec->oem_name, "XBOOT   ", 8);
+	bsec->bytes_per_sector = cpu_to_le16(512);
+	bsec->sectors_per_cluster = 4;
+	bsec->reserved_sector_count = cpu_to_le16(1);
+	bsec->number_of_fat = 2;
+	bsec->root_entry_count = cpu_to_le16(512);
+	bsec->total_sectors_16 = cpu_to_le16(sectors);
+	bsec->media_type = 0xf8;
+	bsec->sectors_per_fat = cpu_to_le16(fatsz);
+	bsec->ext.e16.extended_signature = 0x29;
+	memcpy(bsec->ext.e16.volume_label, "WBT-FAT    ", 11);
+	memcpy(bsec->ext.e16.fs_type, "FAT16   ", 8);
+	bsec->ext.e16.boot_sector_signature = cpu_to_le16(0xaa55);
+
+	for(i = 0; i < 2; i++)
+	{
+		fat = (u16_t *)&buf[(1 + i * fatsz) * 512];
+		fat[0] = cpu_to_le16(0xfff8);
+		fat[1] = cpu_to_le16(0xffff);
+	}
+}
+
+static void * fat_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_fat_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_fat_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->rd = wboxtest_ramdisk_alloc("wbt-fat", FAT_DISK_SIZE, FAT_LATENCY_US);
+	pdat->buf = malloc(FAT_FILE_SIZE);
+	if(!pdat->rd || !pdat->buf)
+	{
+		wboxtest_ramdisk_free(pdat->rd);
+		free(pdat->buf);
+		free(pdat);
+		return NULL;
+	}
+	fat_format(pdat->rd->rambuf, FAT_DISK_SIZE);
+
+	vfs_mkdir(FAT_MOUNT_PATH, 0755);
+	if(vfs_mount("wbt-fat", FAT_MOUNT_PATH, "fat", MOUNT_RW) != 0)
+	{
+		vfs_rmdir(FAT_MOUNT_PATH);
+		wboxtest_ramdisk_free(pdat->rd);
+		free(pdat->buf);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void fat_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_fat_pdata_t * pdat = (struct wbt_fat_pdata_t *)data;
+
+	if(pdat)
+	{
+		vfs_unmount(FAT_MOUNT_PATH);
+		vfs_rmdir(FAT_MOUNT_PATH);
+		wboxtest_ramdisk_free(pdat->rd);
+		free(pdat->buf);
+		free(pdat);
+	}
+}
+
+static void fat_transfer(struct wbt_fat_pdata_t * pdat, const char * title, int chunk, int write)
+{
+	ktime_t t1, t2;
+	char buf[32];
+	s64_t us;
+	int calls, fd, n, i;
+
+	fd = vfs_open(FAT_FILE_PATH, write ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+	if(fd < 0)
+		return;
+	calls = pdat->rd->reads + pdat->rd->writes;
+	t1 = ktime_get();
+	for(i = 0; i < FAT_FILE_SIZE; i += n)
+	{
+		if(write)
+			n = vfs_write(fd, &pdat->buf[i], chunk);
+		else
+			n = vfs_read(fd, &pdat->buf[i], chunk);
+		if(n <= 0)
+			break;
+	}
+	vfs_close(fd);
+	t2 = ktime_get();
+	us = ktime_us_delta(t2, t1);
+	assert_equal(i, FAT_FILE_SIZE);
+	wboxtest_print(" %s %6d: %5d calls, %s/s\r\n", title, chunk, pdat->rd->reads + pdat->rd->writes - calls, ssize(buf, (double)FAT_FILE_SIZE * 1000000.0 / (us > 0 ? us : 1)));
+}
+
+static void fat_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_fat_pdata_t * pdat = (struct wbt_fat_pdata_t *)data;
+	unsigned char * ref;
+	int chunk;
+
+	if(pdat)
+	{
+		ref = malloc(FAT_FILE_SIZE);
+		if(!ref)
+			return;
+		wboxtest_random_buffer((char *)ref, FAT_FILE_SIZE);
+
+		/*
+		 * Small chunks go through the cached cluster, whole clusters go
+		 * straight between the device and the buffer a run at a time
+		 */
+		for(chunk = SZ_1K; chunk <= SZ_256K; chunk <<= 4)
+		{
+			memcpy(pdat->buf, ref, FAT_FILE_SIZE);
+			fat_transfer(pdat, "Write", chunk, 1);
+			memset(pdat->buf, 0, FAT_FILE_SIZE);
+			fat_transfer(pdat, "Read ", chunk, 0);
+			assert_memory_equal(pdat->buf, ref, FAT_FILE_SIZE);
+		}
+		vfs_unlink(FAT_FILE_PATH);
+		free(ref);
+	}
+}
+
+static struct wboxtest_t wbt_fat = {
+	.group	= "benchmark",
+	.name	= "fat",
+	.setup	= fat_setup,
+	.clean	= fat_clean,
+	.run	= fat_run,
+};
+
+static __init void fat_wbt_init(void)
+{
+	register_wboxtest(&wbt_fat);
+}
+
+static __exit void fat_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_fat);
+}
+
+wboxtest_initcall(fat_wbt_init);
+wboxtest_exitcall(fat_wbt_exit);
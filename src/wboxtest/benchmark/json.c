@@ -0,0 +1,127 @@
+/*
+ * wboxtest/benchmark/json.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_json_pdata_t
+{
+	char * json;
+	char * copy;
+	size_t size;
+
+	ktime_t t1;
+	ktime_t t2;
+	int calls;
+};
+
+static void * json_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_json_pdata_t * pdat;
+	size_t len = 0;
+	int i;
+
+	pdat = malloc(sizeof(struct wbt_json_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->size = SZ_512K;
+	pdat->json = malloc(pdat->size);
+	pdat->copy = malloc(pdat->size);
+	if(!pdat->json || !pdat->copy)
+	{
+		free(pdat->json);
+		free(pdat->copy);
+		free(pdat);
+		return NULL;
+	}
+
+	/*
+	 * A sprite atlas like document
+	 */
+	len += snprintf(pdat->json + len, pdat->size - len, "{\"frames\":{");
+	for(i = 0; len < pdat->size - 256; i++)
+	{
+		len += snprintf(pdat->json + len, pdat->size - len,
+			"%s\"sprite-%05d.png\":{\"frame\":{\"x\":%d,\"y\":%d,\"w\":64,\"h\":64},\"rotated\":false,\"pivot\":{\"x\":0.5,\"y\":0.25},\"tags\":[\"idle\",\"w\\u00e9st\"]}",
+			i ? "," : "", i, (i * 37) & 0xfff, (i * 91) & 0xfff);
+	}
+	len += snprintf(pdat->json + len, pdat->size - len, "},\"meta\":{\"scale\":1.0}}");
+	pdat->size = len;
+
+	return pdat;
+}
+
+static void json_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_json_pdata_t * pdat = (struct wbt_json_pdata_t *)data;
+
+	if(pdat)
+	{
+		free(pdat->copy);
+		free(pdat->json);
+		free(pdat);
+	}
+}
+
+static void json_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_json_pdata_t * pdat = (struct wbt_json_pdata_t *)data;
+	struct json_sax_t sax;
+	char buf[32];
+
+	if(pdat)
+	{
+		wboxtest_print(" Document: %s\r\n", ssize(buf, (double)pdat->size));
+
+		pdat->calls = 0;
+		pdat->t2 = pdat->t1 = ktime_get();
+		do {
+			pdat->calls++;
+			json_free(json_parse(pdat->json, pdat->size, NULL));
+			pdat->t2 = ktime_get();
+		} while(ktime_before(pdat->t2, ktime_add_ms(pdat->t1, 2000)));
+		wboxtest_print(" Tree: %s/s\r\n", ssize(buf, (double)pdat->calls * pdat->size * 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1)));
+
+		pdat->calls = 0;
+		pdat->t2 = pdat->t1 = ktime_get();
+		do {
+			pdat->calls++;
+			memcpy(pdat->copy, pdat->json, pdat->size);
+			json_free(json_parse_insitu(pdat->copy, pdat->size, NULL));
+			pdat->t2 = ktime_get();
+		} while(ktime_before(pdat->t2, ktime_add_ms(pdat->t1, 2000)));
+		wboxtest_print(" Insitu: %s/s\r\n", ssize(buf, (double)pdat->calls * pdat->size * 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1)));
+
+		memset(&sax, 0, sizeof(struct json_sax_t));
+		pdat->calls = 0;
+		pdat->t2 = pdat->t1 = ktime_get();
+		do {
+			pdat->calls++;
+			json_sax_parse(pdat->json, pdat->size, &sax, NULL, NULL);
+			pdat->t2 = ktime_get();
+		} while(ktime_before(pdat->t2, ktime_add_ms(pdat->t1, 2000)));
+		wboxtest_print(" Sax: %s/s\r\n", ssize(buf, (double)pdat->calls * pdat->size * 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1)));
+	}
+}
+
+static struct wboxtest_t wbt_json = {
+	.group	= "benchmark",
+	.name	= "json",
+	.setup	= json_setup,
+	.clean	= json_clean,
+	.run	= json_run,
+};
+
+static __init void json_wbt_init(void)
+{
+	register_wboxtest(&wbt_json);
+}
+
+static __exit void json_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_json);
+}
+
+wboxtest_initcall(json_wbt_init);
+wboxtest_exitcall(json_wbt_exit);
@@ -0,0 +1,142 @@
+/*
+ * wboxtest/benchmark/ramfs.c
+ */
+
+#include <wboxtest.h>
+
+#define RAMFS_FILE_SIZE		(SZ_4M)
+#define RAMFS_MOUNT_PATH	"/tmp/wbt-ram"
+#define RAMFS_FILE_PATH		"/tmp/wbt-ram/bench.bin"
+
+struct wbt_ramfs_pdata_t
+{
+	unsigned char * ref;
+	unsigned char * buf;
+};
+
+static void * ramfs_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_ramfs_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_ramfs_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->ref = malloc(RAMFS_FILE_SIZE);
+	pdat->buf = malloc(RAMFS_FILE_SIZE);
+	if(!pdat->ref || !pdat->buf)
+	{
+		free(pdat->ref);
+		free(pdat->buf);
+		free(pdat);
+		return NULL;
+	}
+	wboxtest_random_buffer((char *)pdat->ref, RAMFS_FILE_SIZE);
+
+	vfs_mkdir(RAMFS_MOUNT_PATH, 0755);
+	if(vfs_mount(NULL, RAMFS_MOUNT_PATH, "ram", MOUNT_RW) != 0)
+	{
+		vfs_rmdir(RAMFS_MOUNT_PATH);
+		free(pdat->ref);
+		free(pdat->buf);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void ramfs_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_ramfs_pdata_t * pdat = (struct wbt_ramfs_pdata_t *)data;
+
+	if(pdat)
+	{
+		vfs_unmount(RAMFS_MOUNT_PATH);
+		vfs_rmdir(RAMFS_MOUNT_PATH);
+		free(pdat->ref);
+		free(pdat->buf);
+		free(pdat);
+	}
+}
+
+static void ramfs_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_ramfs_pdata_t * pdat = (struct wbt_ramfs_pdata_t *)data;
+	struct vfs_stat_t st;
+	ktime_t t1, t2;
+	char buf[32];
+	s64_t us;
+	int chunk, fd, i;
+
+	if(pdat)
+	{
+		/*
+		 * Appending grows the file a page at a time, small chunks cost no
+		 * more per byte than large ones
+		 */
+		for(chunk = 64; chunk <= SZ_64K; chunk <<= 5)
+		{
+			fd = vfs_open(RAMFS_FILE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if(fd < 0)
+				return;
+			t1 = ktime_get();
+			for(i = 0; i < RAMFS_FILE_SIZE; i += chunk)
+			{
+				if(vfs_write(fd, &pdat->ref[i], chunk) != chunk)
+					break;
+			}
+			t2 = ktime_get();
+			vfs_close(fd);
+			us = ktime_us_delta(t2, t1);
+			assert_equal(i, RAMFS_FILE_SIZE);
+			wboxtest_print(" Append %6d: %s/s\r\n", chunk, ssize(buf, (double)RAMFS_FILE_SIZE * 1000000.0 / (us > 0 ? us : 1)));
+
+			memset(pdat->buf, 0, RAMFS_FILE_SIZE);
+			fd = vfs_open(RAMFS_FILE_PATH, O_RDONLY, 0);
+			assert_equal(vfs_read(fd, pdat->buf, RAMFS_FILE_SIZE), RAMFS_FILE_SIZE);
+			vfs_close(fd);
+			assert_memory_equal(pdat->buf, pdat->ref, RAMFS_FILE_SIZE);
+		}
+
+		/*
+		 * A write far past the end leaves a hole that reads as zeros
+		 */
+		fd = vfs_open(RAMFS_FILE_PATH, O_RDWR | O_TRUNC, 0644);
+		if(fd < 0)
+			return;
+		assert_equal(vfs_pwrite(fd, pdat->ref, SZ_1K, SZ_64M), SZ_1K);
+		assert_equal(vfs_pread(fd, pdat->buf, SZ_4K, SZ_64M - SZ_4K), SZ_4K);
+		for(i = 0; i < SZ_4K; i++)
+		{
+			if(pdat->buf[i])
+				break;
+		}
+		assert_equal(i, SZ_4K);
+		vfs_close(fd);
+		assert_equal(vfs_stat(RAMFS_FILE_PATH, &st), 0);
+		assert_equal(st.st_size, SZ_64M + SZ_1K);
+		vfs_unlink(RAMFS_FILE_PATH);
+	}
+}
+
+static struct wboxtest_t wbt_ramfs = {
+	.group	= "benchmark",
+	.name	= "ramfs",
+	.setup	= ramfs_setup,
+	.clean	= ramfs_clean,
+	.run	= ramfs_run,
+};
+
+static __init void ramfs_wbt_init(void)
+{
+	register_wboxtest(&wbt_ramfs);
+}
+
+static __exit void ramfs_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_ramfs);
+}
+
+wboxtest_initcall(ramfs_wbt_init);
+wboxtest_exitcall(ramfs_wbt_exit);
@@ -0,0 +1,135 @@
+/*
+ * wboxtest/benchmark/strtod.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_strtod_pdata_t
+{
+	double * value;
+	char * text;
+	size_t size;
+	int count;
+
+	ktime_t t1;
+	ktime_t t2;
+	int calls;
+};
+
+static void * strtod_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_strtod_pdata_t * pdat;
+	size_t len = 0;
+	int i;
+
+	pdat = malloc(sizeof(struct wbt_strtod_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->count = 4096;
+	pdat->size = pdat->count * 32;
+	pdat->value = malloc(pdat->count * sizeof(double));
+	pdat->text = malloc(pdat->size);
+	if(!pdat->value || !pdat->text)
+	{
+		free(pdat->value);
+		free(pdat->text);
+		free(pdat);
+		return NULL;
+	}
+
+	/*
+	 * Half full precision numbers, half short ones like in svg and json
+	 */
+	for(i = 0; i < pdat->count; i++)
+	{
+		if(i & 1)
+		{
+			pdat->value[i] = wboxtest_random_float(-1e6, 1e6);
+			len += snprintf(pdat->text + len, pdat->size - len, "%.17g ", pdat->value[i]);
+		}
+		else
+		{
+			pdat->value[i] = wboxtest_random_float(-1000, 1000);
+			len += snprintf(pdat->text + len, pdat->size - len, "%.3f ", pdat->value[i]);
+		}
+	}
+	pdat->size = len;
+
+	return pdat;
+}
+
+static void strtod_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_strtod_pdata_t * pdat = (struct wbt_strtod_pdata_t *)data;
+
+	if(pdat)
+	{
+		free(pdat->text);
+		free(pdat->value);
+		free(pdat);
+	}
+}
+
+static void strtod_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_strtod_pdata_t * pdat = (struct wbt_strtod_pdata_t *)data;
+	char buf[32];
+	char * p;
+	int i;
+
+	if(pdat)
+	{
+		pdat->calls = 0;
+		pdat->t2 = pdat->t1 = ktime_get();
+		do {
+			pdat->calls++;
+			for(i = 0, p = pdat->text; i < pdat->count; i++)
+				strtod(p, &p);
+			pdat->t2 = ktime_get();
+		} while(ktime_before(pdat->t2, ktime_add_ms(pdat->t1, 2000)));
+		wboxtest_print(" Strtod: %.3f M/s, %s/s\r\n", (double)pdat->calls * pdat->count / 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1),
+			ssize(buf, (double)pdat->calls * pdat->size * 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1)));
+
+		pdat->calls = 0;
+		pdat->t2 = pdat->t1 = ktime_get();
+		do {
+			pdat->calls++;
+			for(i = 0; i < pdat->count; i++)
+				snprintf(buf, sizeof(buf), "%.17g", pdat->value[i]);
+			pdat->t2 = ktime_get();
+		} while(ktime_before(pdat->t2, ktime_add_ms(pdat->t1, 2000)));
+		wboxtest_print(" Printf: %.3f M/s\r\n", (double)pdat->calls * pdat->count / 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1));
+
+		pdat->calls = 0;
+		pdat->t2 = pdat->t1 = ktime_get();
+		do {
+			pdat->calls++;
+			for(i = 0; i < pdat->count; i++)
+				dtostr(buf, sizeof(buf), pdat->value[i]);
+			pdat->t2 = ktime_get();
+		} while(ktime_before(pdat->t2, ktime_add_ms(pdat->t1, 2000)));
+		wboxtest_print(" Dtostr: %.3f M/s\r\n", (double)pdat->calls * pdat->count / 1000.0 / ktime_ms_delta(pdat->t2, pdat->t1));
+	}
+}
+
+static struct wboxtest_t wbt_strtod = {
+	.group	= "benchmark",
+	.name	= "strtod",
+	.setup	= strtod_setup,
+	.clean	= strtod_clean,
+	.run	= strtod_run,
+};
+
+static __init void strtod_wbt_init(void)
+{
+	register_wboxtest(&wbt_strtod);
+}
+
+static __exit void strtod_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_strtod);
+}
+
+wboxtest_initcall(strtod_wbt_init);
+wboxtest_exitcall(strtod_wbt_exit);
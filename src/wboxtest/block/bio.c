@@ -0,0 +1,130 @@
+/*
+ * wboxtest/block/bio.c
+ */
+
+#include <wboxtest.h>
+
+#define BIO_LATENCY_US		(200)
+#define BIO_COUNT			(256)
+#define BIO_BLKCNT			(8)
+
+static void * bio_setup(struct wboxtest_t * wbt)
+{
+	return wboxtest_ramdisk_alloc("wbt-bio", SZ_1M, BIO_LATENCY_US);
+}
+
+static void bio_clean(struct wboxtest_t * wbt, void * data)
+{
+	wboxtest_ramdisk_free((struct wboxtest_ramdisk_t *)data);
+}
+
+static void bio_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)data;
+	struct block_t * blk;
+	struct bio_vec_t * vec;
+	struct bio_t * bio;
+	ktime_t t1, t2;
+	u8_t * buf1, * buf2;
+	int len, calls, i, j;
+
+	if(rd)
+	{
+		blk = &rd->blk;
+		len = BIO_COUNT * BIO_BLKCNT * block_size(blk);
+		buf1 = malloc(len);
+		buf2 = malloc(len);
+		bio = malloc(sizeof(struct bio_t) * BIO_COUNT);
+		vec = malloc(sizeof(struct bio_vec_t) * BIO_COUNT * 2);
+		if(!buf1 || !buf2 || !bio || !vec)
+		{
+			free(buf1);
+			free(buf2);
+			free(bio);
+			free(vec);
+			return;
+		}
+
+		/*
+		 * Write in shuffled order with two segments per bio, read back in one bio per block run
+		 */
+		wboxtest_random_buffer((char *)buf1, len);
+		for(i = 0; i < BIO_COUNT; i++)
+		{
+			j = (i * 97) % BIO_COUNT;
+			vec[j * 2 + 0].buf = &buf1[block_size(blk) * BIO_BLKCNT * j];
+			vec[j * 2 + 0].blkcnt = BIO_BLKCNT / 2;
+			vec[j * 2 + 1].buf = &buf1[block_size(blk) * (BIO_BLKCNT * j + BIO_BLKCNT / 2)];
+			vec[j * 2 + 1].blkcnt = BIO_BLKCNT / 2;
+			bio_init(&bio[j], BIO_WRITE, BIO_BLKCNT * j, &vec[j * 2], 2, NULL, NULL);
+			assert_true(bio_submit(blk, &bio[j]));
+		}
+		for(i = 0; i < BIO_COUNT; i++)
+		{
+			bio_wait(&bio[i]);
+			assert_equal(bio[i].done, BIO_BLKCNT);
+		}
+		memset(buf2, 0, len);
+		block_read(blk, buf2, 0, len);
+		assert_memory_equal(buf1, buf2, len);
+
+		/*
+		 * One bio at a time, every request pays the driver latency
+		 */
+		calls = rd->reads + rd->writes;
+		t1 = ktime_get();
+		for(i = 0; i < BIO_COUNT; i++)
+		{
+			vec[i].buf = &buf2[block_size(blk) * BIO_BLKCNT * i];
+			vec[i].blkcnt = BIO_BLKCNT;
+			bio_init(&bio[i], BIO_READ, BIO_BLKCNT * i, &vec[i], 1, NULL, NULL);
+			bio_submit(blk, &bio[i]);
+			bio_wait(&bio[i]);
+		}
+		t2 = ktime_get();
+		wboxtest_print(" Sync: %d calls, %lld ms\r\n", rd->reads + rd->writes - calls, ktime_ms_delta(t2, t1));
+
+		/*
+		 * All bios queued before waiting, adjacent ones merge into large requests
+		 */
+		memset(buf2, 0, len);
+		calls = rd->reads + rd->writes;
+		t1 = ktime_get();
+		for(i = 0; i < BIO_COUNT; i++)
+		{
+			bio_init(&bio[i], BIO_READ, BIO_BLKCNT * i, &vec[i], 1, NULL, NULL);
+			bio_submit(blk, &bio[i]);
+		}
+		for(i = 0; i < BIO_COUNT; i++)
+			bio_wait(&bio[i]);
+		t2 = ktime_get();
+		wboxtest_print(" Async: %d calls, %lld ms\r\n", rd->reads + rd->writes - calls, ktime_ms_delta(t2, t1));
+		assert_memory_equal(buf1, buf2, len);
+
+		free(buf1);
+		free(buf2);
+		free(bio);
+		free(vec);
+	}
+}
+
+static struct wboxtest_t wbt_bio = {
+	.group	= "block",
+	.name	= "bio",
+	.setup	= bio_setup,
+	.clean	= bio_clean,
+	.run	= bio_run,
+};
+
+static __init void bio_wbt_init(void)
+{
+	register_wboxtest(&wbt_bio);
+}
+
+static __exit void bio_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_bio);
+}
+
+wboxtest_initcall(bio_wbt_init);
+wboxtest_exitcall(bio_wbt_exit);
@@ -0,0 +1,267 @@
+/*
+ * wboxtest/block/spinor.c
+ */
+
+#include <wboxtest.h>
+#include <spi/spi.h>
+
+/*
+ * A w25x40 emulated in ram behind a mock spi bus, program only clears bits
+ * and erase sets a whole 4K sector back to 0xff
+ */
+#define SPINOR_CAPACITY		(SZ_512K)
+#define SPINOR_SECTOR		(SZ_4K)
+#define SPINOR_BUFSZ		(2048)
+#define SPINOR_DT			"{\"spi-bus\": \"wbt-spinor\"}"
+
+struct wbt_spinor_pdata_t
+{
+	struct spi_t spi;
+	struct driver_t * drv;
+	struct device_t * dev;
+	struct json_value_t * json;
+	unsigned char * flash;
+	u8_t cmd[5];
+	int ncmd;
+	u32_t addr;
+	int wel;
+	int erases;
+	int programs;
+};
+
+static int spinor_mock_transfer(struct spi_t * spi, struct spi_msg_t * msg)
+{
+	struct wbt_spinor_pdata_t * pdat = (struct wbt_spinor_pdata_t *)spi->priv;
+	u8_t * tx = msg->txbuf;
+	u8_t * rx = msg->rxbuf;
+	int i;
+
+	if(tx && (pdat->ncmd == 0))
+	{
+		pdat->ncmd = min(msg->len, 5);
+		memcpy(pdat->cmd, tx, pdat->ncmd);
+		pdat->addr = (pdat->cmd[1] << 16) | (pdat->cmd[2] << 8) | (pdat->cmd[3] << 0);
+		switch(pdat->cmd[0])
+		{
+		case 0x06:
+			pdat->wel = 1;
+			break;
+		case 0x20:
+			if(pdat->wel)
+			{
+				memset(&pdat->flash[(pdat->addr % SPINOR_CAPACITY) & ~(SPINOR_SECTOR - 1)], 0xff, SPINOR_SECTOR);
+				pdat->erases++;
+			}
+			pdat->wel = 0;
+			break;
+		case 0x02:
+			if(pdat->wel)
+				pdat->programs++;
+			break;
+		default:
+			break;
+		}
+	}
+	else if(tx && (pdat->cmd[0] == 0x02) && pdat->wel)
+	{
+		for(i = 0; i < msg->len; i++)
+			pdat->flash[(pdat->addr + i) % SPINOR_CAPACITY] &= tx[i];
+	}
+	else if(rx)
+	{
+		switch(pdat->cmd[0])
+		{
+		case 0x9f:
+			memset(rx, 0, msg->len);
+			rx[0] = 0xef;
+			if(msg->len > 1)
+				rx[1] = 0x30;
+			if(msg->len > 2)
+				rx[2] = 0x13;
+			break;
+		case 0x03:
+			for(i = 0; i < msg->len; i++)
+				rx[i] = pdat->flash[(pdat->addr + i) % SPINOR_CAPACITY];
+			break;
+		default:
+			memset(rx, 0, msg->len);
+			break;
+		}
+	}
+	return msg->len;
+}
+
+static void spinor_mock_select(struct spi_t * spi, int cs)
+{
+	struct wbt_spinor_pdata_t * pdat = (struct wbt_spinor_pdata_t *)spi->priv;
+	pdat->ncmd = 0;
+}
+
+static void spinor_mock_deselect(struct spi_t * spi, int cs)
+{
+	struct wbt_spinor_pdata_t * pdat = (struct wbt_spinor_pdata_t *)spi->priv;
+
+	if((pdat->ncmd > 0) && (pdat->cmd[0] == 0x02))
+		pdat->wel = 0;
+	pdat->ncmd = 0;
+}
+
+static void * spinor_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_spinor_pdata_t * pdat;
+	struct dtnode_t n;
+
+	pdat = malloc(sizeof(struct wbt_spinor_pdata_t));
+	if(!pdat)
+		return NULL;
+	memset(pdat, 0, sizeof(struct wbt_spinor_pdata_t));
+
+	pdat->flash = malloc(SPINOR_CAPACITY);
+	pdat->json = json_parse(SPINOR_DT, strlen(SPINOR_DT), NULL);
+	pdat->drv = search_driver("blk-spinor");
+	if(!pdat->flash || !pdat->json || !pdat->drv)
+	{
+		free(pdat->flash);
+		json_free(pdat->json);
+		free(pdat);
+		return NULL;
+	}
+	memset(pdat->flash, 0xff, SPINOR_CAPACITY);
+
+	pdat->spi.name = "wbt-spinor";
+	pdat->spi.type = SPI_TYPE_SINGLE;
+	pdat->spi.transfer = spinor_mock_transfer;
+	pdat->spi.select = spinor_mock_select;
+	pdat->spi.deselect = spinor_mock_deselect;
+	pdat->spi.priv = pdat;
+	if(!register_spi(&pdat->spi, NULL))
+	{
+		free(pdat->flash);
+		json_free(pdat->json);
+		free(pdat);
+		return NULL;
+	}
+
+	n.name = "blk-spinor";
+	n.addr = 0;
+	n.value = pdat->json;
+	n.blob = NULL;
+	n.bvalue = NULL;
+	if(!(pdat->dev = pdat->drv->probe(pdat->drv, &n)))
+	{
+		unregister_spi(&pdat->spi);
+		free(pdat->flash);
+		json_free(pdat->json);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void spinor_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_spinor_pdata_t * pdat = (struct wbt_spinor_pdata_t *)data;
+
+	if(pdat)
+	{
+		pdat->drv->remove(pdat->dev);
+		unregister_spi(&pdat->spi);
+		free(pdat->flash);
+		json_free(pdat->json);
+		free(pdat);
+	}
+}
+
+static void spinor_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_spinor_pdata_t * pdat = (struct wbt_spinor_pdata_t *)data;
+	struct block_t * blk;
+	unsigned char ref[SPINOR_BUFSZ];
+	unsigned char buf[SPINOR_BUFSZ];
+	int i;
+
+	if(pdat)
+	{
+		blk = (struct block_t *)pdat->dev->priv;
+		assert_equal(block_size(blk), 512);
+		assert_equal(block_capacity(blk), SPINOR_CAPACITY);
+
+		/*
+		 * A partial sector write on blank flash only clears bits, no erase
+		 * and the untouched part of the sector stays blank
+		 */
+		wboxtest_random_buffer((char *)ref, sizeof(ref));
+		assert_equal(block_write(blk, ref, 100, 700), 700);
+		block_sync(blk);
+		assert_equal(pdat->erases, 0);
+		assert_memory_equal(&pdat->flash[100], ref, 700);
+		for(i = 800; i < SPINOR_SECTOR; i++)
+		{
+			if(pdat->flash[i] != 0xff)
+				break;
+		}
+		assert_equal(i, SPINOR_SECTOR);
+
+		/*
+		 * Clearing more bits of the same bytes still needs no erase
+		 */
+		for(i = 0; i < 700; i++)
+			buf[i] = ref[i] & 0x0f;
+		assert_equal(block_write(blk, buf, 100, 700), 700);
+		block_sync(blk);
+		assert_equal(pdat->erases, 0);
+		assert_memory_equal(&pdat->flash[100], buf, 700);
+
+		/*
+		 * Setting bits back erases the sector once, the rest of it survives
+		 */
+		assert_equal(block_write(blk, ref, 300, 200), 200);
+		block_sync(blk);
+		assert_equal(pdat->erases, 1);
+		assert_memory_equal(&pdat->flash[100], buf, 200);
+		assert_memory_equal(&pdat->flash[300], ref, 200);
+		assert_memory_equal(&pdat->flash[500], &buf[400], 300);
+
+		/*
+		 * A write across a sector boundary, read back through the block layer
+		 */
+		assert_equal(block_write(blk, ref, SPINOR_SECTOR * 3 - 1000, SPINOR_BUFSZ), SPINOR_BUFSZ);
+		block_sync(blk);
+		assert_memory_equal(&pdat->flash[SPINOR_SECTOR * 3 - 1000], ref, SPINOR_BUFSZ);
+		memset(buf, 0, sizeof(buf));
+		assert_equal(block_read(blk, buf, SPINOR_SECTOR * 3 - 1000, SPINOR_BUFSZ), SPINOR_BUFSZ);
+		assert_memory_equal(buf, ref, SPINOR_BUFSZ);
+
+		/*
+		 * Rewriting unchanged data programs and erases nothing
+		 */
+		i = pdat->programs;
+		assert_equal(block_write(blk, ref, SPINOR_SECTOR * 3 - 1000, SPINOR_BUFSZ), SPINOR_BUFSZ);
+		block_sync(blk);
+		assert_equal(pdat->erases, 1);
+		assert_equal(pdat->programs, i);
+		wboxtest_print(" Erase %d, program %d\r\n", pdat->erases, pdat->programs);
+	}
+}
+
+static struct wboxtest_t wbt_spinor = {
+	.group	= "block",
+	.name	= "spinor",
+	.setup	= spinor_setup,
+	.clean	= spinor_clean,
+	.run	= spinor_run,
+};
+
+static __init void spinor_wbt_init(void)
+{
+	register_wboxtest(&wbt_spinor);
+}
+
+static __exit void spinor_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_spinor);
+}
+
+wboxtest_initcall(spinor_wbt_init);
+wboxtest_exitcall(spinor_wbt_exit);
@@ -0,0 +1,102 @@
+/*
+ * wboxtest/block/writeback.c
+ */
+
+#include <wboxtest.h>
+
+#define WRITEBACK_DISK_SIZE		(SZ_1M)
+#define WRITEBACK_LENGTH		(SZ_64K)
+#define WRITEBACK_CHUNK			(SZ_4K)
+#define WRITEBACK_BATCH			(16)
+
+static void * writeback_setup(struct wboxtest_t * wbt)
+{
+	return wboxtest_ramdisk_alloc("wbt-writeback", WRITEBACK_DISK_SIZE, 0);
+}
+
+static void writeback_clean(struct wboxtest_t * wbt, void * data)
+{
+	wboxtest_ramdisk_free((struct wboxtest_ramdisk_t *)data);
+}
+
+static void writeback_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)data;
+	struct block_t * blk;
+	u8_t * ref;
+	u64_t n, total = 0;
+	int i;
+
+	if(rd)
+	{
+		blk = &rd->blk;
+		ref = malloc(WRITEBACK_LENGTH);
+		if(!ref)
+			return;
+		wboxtest_random_buffer((char *)ref, WRITEBACK_LENGTH);
+
+		/*
+		 * Small writes stay dirty in the buffer cache, nothing is old enough yet
+		 */
+		for(i = 0; i < WRITEBACK_LENGTH; i += WRITEBACK_CHUNK)
+			assert_equal(block_write(blk, &ref[i], i, WRITEBACK_CHUNK), WRITEBACK_CHUNK);
+		assert_equal(rd->writes, 0);
+		assert_equal(block_writeback(ktime_set(0, 0), 100, WRITEBACK_BATCH), 0);
+
+		/*
+		 * Once expired they go out a batch at a time, merged into few driver calls
+		 */
+		while((n = block_writeback(ktime_get(), 100, WRITEBACK_BATCH)) > 0)
+		{
+			assert_inrange(n, 1, WRITEBACK_BATCH);
+			total += n;
+		}
+		assert_equal(total, WRITEBACK_LENGTH / block_size(blk));
+		assert_inrange(rd->writes, 1, WRITEBACK_LENGTH / WRITEBACK_CHUNK);
+		assert_memory_equal(rd->rambuf, ref, WRITEBACK_LENGTH);
+
+		/*
+		 * The driver of a written device is synced once afterwards
+		 */
+		assert_equal(rd->syncs, 0);
+		assert_true(block_writeback_sync() > 0);
+		assert_equal(rd->syncs, 1);
+		block_writeback_sync();
+		assert_equal(rd->syncs, 1);
+
+		/*
+		 * The block dirtied first goes out first, wherever it is on the device
+		 */
+		n = block_size(blk);
+		assert_equal(block_write(blk, &ref[0], WRITEBACK_DISK_SIZE - n, n), n);
+		assert_equal(block_write(blk, &ref[n], 0, n), n);
+		assert_equal(block_writeback(ktime_get(), 0, 1), 1);
+		assert_memory_equal(&rd->rambuf[WRITEBACK_DISK_SIZE - n], &ref[0], n);
+		assert_memory_equal(&rd->rambuf[0], &ref[0], n);
+		assert_equal(block_writeback(ktime_get(), 0, 1), 1);
+		assert_memory_equal(&rd->rambuf[0], &ref[n], n);
+
+		free(ref);
+	}
+}
+
+static struct wboxtest_t wbt_writeback = {
+	.group	= "block",
+	.name	= "writeback",
+	.setup	= writeback_setup,
+	.clean	= writeback_clean,
+	.run	= writeback_run,
+};
+
+static __init void writeback_wbt_init(void)
+{
+	register_wboxtest(&wbt_writeback);
+}
+
+static __exit void writeback_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_writeback);
+}
+
+wboxtest_initcall(writeback_wbt_init);
+wboxtest_exitcall(writeback_wbt_exit);
@@ -0,0 +1,109 @@
+/*
+ * wboxtest/graphic-bench/blit.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_blit_pdata_t
+{
+	struct surface_t * s;
+	struct surface_t * o;
+};
+
+static void * blit_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_blit_pdata_t * pdat;
+	struct color_t c;
+
+	pdat = malloc(sizeof(struct wbt_blit_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->s = surface_alloc(640, 480, NULL);
+	pdat->o = surface_alloc(256, 256, NULL);
+	if(!pdat->s || !pdat->o)
+	{
+		if(pdat->s)
+			surface_free(pdat->s);
+		if(pdat->o)
+			surface_free(pdat->o);
+		free(pdat);
+		return NULL;
+	}
+	color_init(&c, 0x20, 0x80, 0xc0, 0xff);
+	surface_clear(pdat->o, &c, 0, 0, 256, 256);
+	color_init(&c, 0xff, 0xff, 0xff, 0x80);
+	surface_shape_circle(pdat->o, NULL, 128, 128, 100, 0, &c);
+
+	return pdat;
+}
+
+static void blit_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_blit_pdata_t * pdat = (struct wbt_blit_pdata_t *)data;
+
+	if(pdat)
+	{
+		surface_free(pdat->o);
+		surface_free(pdat->s);
+		free(pdat);
+	}
+}
+
+static void blit_bench(struct wbt_blit_pdata_t * pdat, const char * name, struct matrix_t * m, double scale, enum render_type_t type)
+{
+	ktime_t t1, t2;
+	double ms, pixels;
+	int calls = 0;
+
+	t2 = t1 = ktime_get();
+	do {
+		calls++;
+		surface_blit(pdat->s, NULL, m, pdat->o, type);
+		t2 = ktime_get();
+	} while(ktime_before(t2, ktime_add_ms(t1, 1000)));
+	ms = ktime_ms_delta(t2, t1);
+	pixels = (double)surface_get_width(pdat->o) * surface_get_height(pdat->o) * scale * calls;
+	wboxtest_print(" %-10s: %10.2f calls/s, %12.2f Mpixels/s\r\n", name, calls * 1000.0 / ms, pixels / ms / 1000.0);
+}
+
+static void blit_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_blit_pdata_t * pdat = (struct wbt_blit_pdata_t *)data;
+	struct matrix_t m;
+
+	if(pdat)
+	{
+		matrix_init_identity(&m);
+		blit_bench(pdat, "identity", &m, 1.0, RENDER_TYPE_GOOD);
+		matrix_init_translate(&m, 100.5, 50.25);
+		blit_bench(pdat, "translate", &m, 1.0, RENDER_TYPE_GOOD);
+		matrix_init_scale(&m, 1.5, 1.5);
+		blit_bench(pdat, "scale", &m, 1.5 * 1.5, RENDER_TYPE_GOOD);
+		matrix_init_translate(&m, 320, 240);
+		matrix_rotate(&m, M_PI / 6);
+		matrix_translate(&m, -128, -128);
+		blit_bench(pdat, "rotate", &m, 1.0, RENDER_TYPE_GOOD);
+	}
+}
+
+static struct wboxtest_t wbt_blit = {
+	.group	= "graphic-bench",
+	.name	= "blit",
+	.setup	= blit_setup,
+	.clean	= blit_clean,
+	.run	= blit_run,
+};
+
+static __init void blit_wbt_init(void)
+{
+	register_wboxtest(&wbt_blit);
+}
+
+static __exit void blit_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_blit);
+}
+
+wboxtest_initcall(blit_wbt_init);
+wboxtest_exitcall(blit_wbt_exit);
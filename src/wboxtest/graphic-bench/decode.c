@@ -0,0 +1,156 @@
+/*
+ * wboxtest/graphic-bench/decode.c
+ */
+
+#include <wboxtest.h>
+
+/*
+ * Images are taken from the framework assets, 'sample.jpg' being the jpeg
+ * one. Drop extra png or jpeg files into '/private/wboxtest' to benchmark
+ * them as well.
+ */
+struct wbt_decode_pdata_t
+{
+	struct xfs_context_t * ctx;
+	char * files[64];
+	int nfiles;
+};
+
+static const char * fileext(const char * filename)
+{
+	const char * ret = NULL;
+	const char * p;
+
+	if(filename != NULL)
+	{
+		ret = p = strchr(filename, '.');
+		while(p != NULL)
+		{
+			p = strchr(p + 1, '.');
+			if(p != NULL)
+				ret = p;
+		}
+		if(ret != NULL)
+			ret++;
+	}
+	return ret ? ret : "";
+}
+
+static void decode_walk_callback(const char * dir, const char * name, void * data)
+{
+	struct wbt_decode_pdata_t * pdat = (struct wbt_decode_pdata_t *)data;
+	const char * ext = fileext(name);
+	char path[VFS_MAX_PATH];
+
+	if((strcasecmp(ext, "png") == 0) || (strcasecmp(ext, "jpg") == 0) || (strcasecmp(ext, "jpeg") == 0))
+	{
+		if(pdat->nfiles < ARRAY_SIZE(pdat->files))
+		{
+			if(dir && *dir)
+				snprintf(path, sizeof(path), "%s/%s", dir, name);
+			else
+				snprintf(path, sizeof(path), "%s", name);
+			pdat->files[pdat->nfiles++] = strdup(path);
+		}
+	}
+}
+
+static void * decode_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_decode_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_decode_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->ctx = xfs_alloc("/private/wboxtest", 0);
+	if(!pdat->ctx)
+	{
+		free(pdat);
+		return NULL;
+	}
+	pdat->nfiles = 0;
+	xfs_walk(pdat->ctx, "assets/images", decode_walk_callback, pdat);
+	xfs_walk(pdat->ctx, "assets/themes/default", decode_walk_callback, pdat);
+	xfs_walk(pdat->ctx, "", decode_walk_callback, pdat);
+
+	return pdat;
+}
+
+static void decode_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_decode_pdata_t * pdat = (struct wbt_decode_pdata_t *)data;
+	int i;
+
+	if(pdat)
+	{
+		for(i = 0; i < pdat->nfiles; i++)
+			free(pdat->files[i]);
+		xfs_free(pdat->ctx);
+		free(pdat);
+	}
+}
+
+static void decode_bench(struct wbt_decode_pdata_t * pdat, const char * type)
+{
+	struct surface_t * s;
+	ktime_t t1, t2;
+	s64_t ns = 0;
+	double pixels = 0;
+	int calls = 0;
+	int files = 0;
+	int i;
+
+	for(i = 0; i < pdat->nfiles; i++)
+	{
+		if(strncasecmp(fileext(pdat->files[i]), type, 2) != 0)
+			continue;
+		files++;
+		t1 = ktime_get();
+		s = surface_alloc_from_xfs(pdat->ctx, pdat->files[i]);
+		t2 = ktime_get();
+		if(s)
+		{
+			ns += ktime_to_ns(ktime_sub(t2, t1));
+			pixels += (double)surface_get_width(s) * surface_get_height(s);
+			calls++;
+			surface_free(s);
+		}
+	}
+	if(calls > 0 && ns > 0)
+		wboxtest_print(" %-4s %2d files: %10.2f calls/s, %12.2f Mpixels/s\r\n", type, files, calls * 1e9 / ns, pixels * 1e3 / ns);
+	else
+		wboxtest_print(" %-4s %2d files: no image decoded\r\n", type, files);
+}
+
+static void decode_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_decode_pdata_t * pdat = (struct wbt_decode_pdata_t *)data;
+
+	if(pdat)
+	{
+		decode_bench(pdat, "png");
+		decode_bench(pdat, "jpg");
+	}
+}
+
+static struct wboxtest_t wbt_decode = {
+	.group	= "graphic-bench",
+	.name	= "decode",
+	.setup	= decode_setup,
+	.clean	= decode_clean,
+	.run	= decode_run,
+};
+
+static __init void decode_wbt_init(void)
+{
+	register_wboxtest(&wbt_decode);
+}
+
+static __exit void decode_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_decode);
+}
+
+wboxtest_initcall(decode_wbt_init);
+wboxtest_exitcall(decode_wbt_exit);
@@ -0,0 +1,98 @@
+/*
+ * wboxtest/graphic-bench/fill.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_fill_pdata_t
+{
+	struct surface_t * s;
+};
+
+static void * fill_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_fill_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_fill_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->s = surface_alloc(640, 480, NULL);
+	if(!pdat->s)
+	{
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void fill_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_fill_pdata_t * pdat = (struct wbt_fill_pdata_t *)data;
+
+	if(pdat)
+	{
+		surface_free(pdat->s);
+		free(pdat);
+	}
+}
+
+static void fill_bench(struct wbt_fill_pdata_t * pdat, const char * name, struct matrix_t * m, int w, int h, struct color_t * c)
+{
+	ktime_t t1, t2;
+	double ms;
+	int calls = 0;
+
+	t2 = t1 = ktime_get();
+	do {
+		calls++;
+		surface_fill(pdat->s, NULL, m, w, h, c, RENDER_TYPE_GOOD);
+		t2 = ktime_get();
+	} while(ktime_before(t2, ktime_add_ms(t1, 1000)));
+	ms = ktime_ms_delta(t2, t1);
+	wboxtest_print(" %-16s: %10.2f calls/s, %12.2f Mpixels/s\r\n", name, calls * 1000.0 / ms, (double)w * h * calls / ms / 1000.0);
+}
+
+static void fill_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_fill_pdata_t * pdat = (struct wbt_fill_pdata_t *)data;
+	struct matrix_t m;
+	struct color_t c;
+
+	if(pdat)
+	{
+		matrix_init_identity(&m);
+		color_init(&c, 0x20, 0x80, 0xc0, 0xff);
+		fill_bench(pdat, "opaque 640x480", &m, 640, 480, &c);
+		fill_bench(pdat, "opaque 64x64", &m, 64, 64, &c);
+		color_init(&c, 0x20, 0x80, 0xc0, 0x80);
+		fill_bench(pdat, "alpha 640x480", &m, 640, 480, &c);
+		fill_bench(pdat, "alpha 64x64", &m, 64, 64, &c);
+		matrix_init_translate(&m, 320, 240);
+		matrix_rotate(&m, M_PI / 6);
+		matrix_translate(&m, -128, -128);
+		fill_bench(pdat, "rotate 256x256", &m, 256, 256, &c);
+	}
+}
+
+static struct wboxtest_t wbt_fill = {
+	.group	= "graphic-bench",
+	.name	= "fill",
+	.setup	= fill_setup,
+	.clean	= fill_clean,
+	.run	= fill_run,
+};
+
+static __init void fill_wbt_init(void)
+{
+	register_wboxtest(&wbt_fill);
+}
+
+static __exit void fill_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_fill);
+}
+
+wboxtest_initcall(fill_wbt_init);
+wboxtest_exitcall(fill_wbt_exit);
@@ -0,0 +1,135 @@
+/*
+ * wboxtest/graphic-bench/filter.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_filter_pdata_t
+{
+	struct surface_t * s;
+	struct surface_t * clut;
+};
+
+static void * filter_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_filter_pdata_t * pdat;
+	u32_t * p;
+	int i;
+
+	pdat = malloc(sizeof(struct wbt_filter_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->s = surface_alloc(256, 256, NULL);
+	pdat->clut = surface_alloc(64, 64, NULL);
+	if(!pdat->s || !pdat->clut)
+	{
+		if(pdat->s)
+			surface_free(pdat->s);
+		if(pdat->clut)
+			surface_free(pdat->clut);
+		free(pdat);
+		return NULL;
+	}
+	p = surface_get_pixels(pdat->clut);
+	for(i = 0; i < 64 * 64; i++)
+		p[i] = 0xff000000 | ((i % 16) * 17 << 16) | (((i / 16) % 16) * 17 << 8) | ((i / 256) * 17);
+
+	return pdat;
+}
+
+static void filter_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_filter_pdata_t * pdat = (struct wbt_filter_pdata_t *)data;
+
+	if(pdat)
+	{
+		surface_free(pdat->clut);
+		surface_free(pdat->s);
+		free(pdat);
+	}
+}
+
+static void filter_reset(struct surface_t * s)
+{
+	u32_t * p = surface_get_pixels(s);
+	int i;
+
+	for(i = 0; i < surface_get_width(s) * surface_get_height(s); i++)
+		p[i] = 0xff000000 | (i * 2654435761u >> 8);
+}
+
+static void filter_apply(struct wbt_filter_pdata_t * pdat, int index)
+{
+	struct surface_t * s = pdat->s;
+
+	switch(index)
+	{
+	case 0:  surface_filter_haldclut(s, pdat->clut, "nearest"); break;
+	case 1:  surface_filter_grayscale(s); break;
+	case 2:  surface_filter_sepia(s); break;
+	case 3:  surface_filter_invert(s); break;
+	case 4:  surface_filter_threshold(s, "binary", 128, 255); break;
+	case 5:  surface_filter_colorize(s, "parula"); break;
+	case 6:  surface_filter_hue(s, 90); break;
+	case 7:  surface_filter_saturate(s, 50); break;
+	case 8:  surface_filter_brightness(s, 20); break;
+	case 9:  surface_filter_contrast(s, 20); break;
+	case 10: surface_filter_opacity(s, 50); break;
+	case 11: surface_filter_blur(s, 4); break;
+	default: break;
+	}
+}
+
+static void filter_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_filter_pdata_t * pdat = (struct wbt_filter_pdata_t *)data;
+	static const char * name[] = {
+		"haldclut", "grayscale", "sepia", "invert", "threshold", "colorize",
+		"hue", "saturate", "brightness", "contrast", "opacity", "blur",
+	};
+	ktime_t t1, t2;
+	s64_t ns;
+	double pixels;
+	int calls, i;
+
+	if(pdat)
+	{
+		pixels = (double)surface_get_width(pdat->s) * surface_get_height(pdat->s);
+		for(i = 0; i < ARRAY_SIZE(name); i++)
+		{
+			calls = 0;
+			ns = 0;
+			do {
+				filter_reset(pdat->s);
+				calls++;
+				t1 = ktime_get();
+				filter_apply(pdat, i);
+				t2 = ktime_get();
+				ns += ktime_to_ns(ktime_sub(t2, t1));
+			} while(ns < 1000000000LL);
+			wboxtest_print(" %-10s: %10.2f calls/s, %12.2f Mpixels/s\r\n", name[i], calls * 1e9 / ns, pixels * calls * 1e3 / ns);
+		}
+	}
+}
+
+static struct wboxtest_t wbt_filter = {
+	.group	= "graphic-bench",
+	.name	= "filter",
+	.setup	= filter_setup,
+	.clean	= filter_clean,
+	.run	= filter_run,
+};
+
+static __init void filter_wbt_init(void)
+{
+	register_wboxtest(&wbt_filter);
+}
+
+static __exit void filter_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_filter);
+}
+
+wboxtest_initcall(filter_wbt_init);
+wboxtest_exitcall(filter_wbt_exit);
@@ -0,0 +1,162 @@
+/*
+ * wboxtest/graphic-bench/shape.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_shape_pdata_t
+{
+	struct surface_t * s;
+	struct color_t c;
+};
+
+static void * shape_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_shape_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_shape_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->s = surface_alloc(640, 480, NULL);
+	if(!pdat->s)
+	{
+		free(pdat);
+		return NULL;
+	}
+	color_init(&pdat->c, 0x20, 0x80, 0xc0, 0xc0);
+
+	return pdat;
+}
+
+static void shape_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_shape_pdata_t * pdat = (struct wbt_shape_pdata_t *)data;
+
+	if(pdat)
+	{
+		surface_free(pdat->s);
+		free(pdat);
+	}
+}
+
+static void shape_draw(struct wbt_shape_pdata_t * pdat, int index, int size, int thickness)
+{
+	struct surface_t * s = pdat->s;
+	struct color_t * c = &pdat->c;
+	struct point_t p[5];
+	int x = 320 - size / 2;
+	int y = 240 - size / 2;
+
+	switch(index)
+	{
+	case 0:
+		point_init(&p[0], x, y);
+		point_init(&p[1], x + size, y + size);
+		surface_shape_line(s, NULL, &p[0], &p[1], thickness ? thickness : 1, c);
+		break;
+	case 1:
+		point_init(&p[0], x, y);
+		point_init(&p[1], x + size, y);
+		point_init(&p[2], x, y + size);
+		point_init(&p[3], x + size, y + size);
+		surface_shape_polyline(s, NULL, p, 4, thickness ? thickness : 1, c);
+		break;
+	case 2:
+		point_init(&p[0], x, y + size);
+		point_init(&p[1], x, y);
+		point_init(&p[2], x + size, y + size);
+		point_init(&p[3], x + size, y);
+		surface_shape_curve(s, NULL, p, 4, thickness ? thickness : 1, c);
+		break;
+	case 3:
+		point_init(&p[0], x + size / 2, y);
+		point_init(&p[1], x, y + size);
+		point_init(&p[2], x + size, y + size);
+		surface_shape_triangle(s, NULL, &p[0], &p[1], &p[2], thickness, c);
+		break;
+	case 4:
+		surface_shape_rectangle(s, NULL, x, y, size, size, 0, thickness, c);
+		break;
+	case 5:
+		surface_shape_rectangle(s, NULL, x, y, size, size, size / 8, thickness, c);
+		break;
+	case 6:
+		point_init(&p[0], x + size / 2, y);
+		point_init(&p[1], x + size, y + size * 2 / 5);
+		point_init(&p[2], x + size * 4 / 5, y + size);
+		point_init(&p[3], x + size / 5, y + size);
+		point_init(&p[4], x, y + size * 2 / 5);
+		surface_shape_polygon(s, NULL, p, 5, thickness, c);
+		break;
+	case 7:
+		surface_shape_circle(s, NULL, 320, 240, size / 2, thickness, c);
+		break;
+	case 8:
+		surface_shape_ellipse(s, NULL, 320, 240, size / 2, size / 3, thickness, c);
+		break;
+	case 9:
+		surface_shape_arc(s, NULL, 320, 240, size / 2, 0, 270, thickness ? thickness : 1, c);
+		break;
+	default:
+		break;
+	}
+}
+
+static void shape_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_shape_pdata_t * pdat = (struct wbt_shape_pdata_t *)data;
+	static const char * name[] = {
+		"line", "polyline", "curve", "triangle", "rectangle",
+		"roundrect", "polygon", "circle", "ellipse", "arc",
+	};
+	static const int sizes[] = { 16, 64, 256 };
+	static const int thickness[] = { 0, 4 };
+	ktime_t t1, t2;
+	double ms;
+	int calls, i, j, k;
+
+	if(pdat)
+	{
+		for(i = 0; i < ARRAY_SIZE(name); i++)
+		{
+			for(j = 0; j < ARRAY_SIZE(sizes); j++)
+			{
+				for(k = 0; k < ARRAY_SIZE(thickness); k++)
+				{
+					calls = 0;
+					t2 = t1 = ktime_get();
+					do {
+						calls++;
+						shape_draw(pdat, i, sizes[j], thickness[k]);
+						t2 = ktime_get();
+					} while(ktime_before(t2, ktime_add_ms(t1, 250)));
+					ms = ktime_ms_delta(t2, t1);
+					wboxtest_print(" %-10s %3d %s: %10.2f calls/s, %12.2f Mpixels/s\r\n", name[i], sizes[j], thickness[k] ? "stroke" : "fill  ",
+						calls * 1000.0 / ms, (double)sizes[j] * sizes[j] * calls / ms / 1000.0);
+				}
+			}
+		}
+	}
+}
+
+static struct wboxtest_t wbt_shape = {
+	.group	= "graphic-bench",
+	.name	= "shape",
+	.setup	= shape_setup,
+	.clean	= shape_clean,
+	.run	= shape_run,
+};
+
+static __init void shape_wbt_init(void)
+{
+	register_wboxtest(&wbt_shape);
+}
+
+static __exit void shape_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_shape);
+}
+
+wboxtest_initcall(shape_wbt_init);
+wboxtest_exitcall(shape_wbt_exit);
@@ -0,0 +1,126 @@
+/*
+ * wboxtest/graphic-bench/svg.c
+ */
+
+#include <graphic/svg.h>
+#include <wboxtest.h>
+
+static const char svg_logo[] =
+	"<svg width=\"324px\" height=\"324px\" viewBox=\"0 0 324 324\" xmlns=\"http://www.w3.org/2000/svg\">"
+	"<g stroke=\"none\" stroke-width=\"1\" fill=\"none\" fill-rule=\"evenodd\">"
+	"<path d=\"M42,0 C41.9999908,5.33217644e-07 0,42 0,42 L115,157 L157,157 L157,115 C157,115 42.0000092,-5.33217637e-07 42,0 Z\" fill=\"#E93E30\"/>"
+	"<path d=\"M209,167 C208.999991,167.000001 167,209 167,209 L282,324 L324,324 L324,282 C324,282 209.000009,166.999999 209,167 Z\" fill=\"#52B529\" transform=\"translate(245.5, 245.5) scale(-1, -1) translate(-245.5, -245.5)\"/>"
+	"<path d=\"M42,167 C41.9999908,167.000001 0,209 0,209 L115,324 L157,324 L157,282 C157,282 42.0000092,166.999999 42,167 Z\" fill=\"#F8C63D\" transform=\"translate(78.5, 245.5) scale(1, -1) translate(-78.5, -245.5)\"/>"
+	"<path d=\"M209,0 C208.999991,5.33217644e-07 167,42 167,42 L282,157 L324,157 L324,115 C324,115 209.000009,-5.33217637e-07 209,0 Z\" fill=\"#1A9BD7\" transform=\"translate(245.5, 78.5) scale(-1, 1) translate(-245.5, -78.5)\"/>"
+	"<circle cx=\"162\" cy=\"162\" r=\"40\" stroke=\"#333333\" stroke-width=\"8\"/>"
+	"</g>"
+	"</svg>";
+
+struct wbt_svg_pdata_t
+{
+	struct surface_t * s;
+	struct svg_t * svg;
+};
+
+static void * svg_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_svg_pdata_t * pdat;
+	char * str;
+
+	pdat = malloc(sizeof(struct wbt_svg_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	str = strdup(svg_logo);
+	pdat->s = surface_alloc(640, 640, NULL);
+	pdat->svg = str ? svg_alloc(str) : NULL;
+	free(str);
+	if(!pdat->s || !pdat->svg)
+	{
+		if(pdat->s)
+			surface_free(pdat->s);
+		if(pdat->svg)
+			svg_free(pdat->svg);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void svg_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_svg_pdata_t * pdat = (struct wbt_svg_pdata_t *)data;
+
+	if(pdat)
+	{
+		svg_free(pdat->svg);
+		surface_free(pdat->s);
+		free(pdat);
+	}
+}
+
+static void svg_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_svg_pdata_t * pdat = (struct wbt_svg_pdata_t *)data;
+	static const float scales[] = { 0.25, 1.0, 1.9 };
+	struct svg_t * svg;
+	char * str;
+	ktime_t t1, t2;
+	double ms, w, h;
+	int calls, i;
+
+	if(pdat)
+	{
+		calls = 0;
+		t2 = t1 = ktime_get();
+		do {
+			calls++;
+			if((str = strdup(svg_logo)))
+			{
+				if((svg = svg_alloc(str)))
+					svg_free(svg);
+				free(str);
+			}
+			t2 = ktime_get();
+		} while(ktime_before(t2, ktime_add_ms(t1, 1000)));
+		ms = ktime_ms_delta(t2, t1);
+		wboxtest_print(" parse      : %10.2f calls/s\r\n", calls * 1000.0 / ms);
+
+		for(i = 0; i < ARRAY_SIZE(scales); i++)
+		{
+			w = pdat->svg->width * scales[i];
+			h = pdat->svg->height * scales[i];
+			calls = 0;
+			t2 = t1 = ktime_get();
+			do {
+				calls++;
+				surface_shape_raster(pdat->s, pdat->svg, 0, 0, scales[i], scales[i]);
+				t2 = ktime_get();
+			} while(ktime_before(t2, ktime_add_ms(t1, 1000)));
+			ms = ktime_ms_delta(t2, t1);
+			wboxtest_print(" raster %4dx%-4d: %10.2f calls/s, %12.2f Mpixels/s\r\n", (int)w, (int)h, calls * 1000.0 / ms, w * h * calls / ms / 1000.0);
+		}
+	}
+}
+
+static struct wboxtest_t wbt_svg = {
+	.group	= "graphic-bench",
+	.name	= "svg",
+	.setup	= svg_setup,
+	.clean	= svg_clean,
+	.run	= svg_run,
+};
+
+static __init void svg_wbt_init(void)
+{
+	register_wboxtest(&wbt_svg);
+}
+
+static __exit void svg_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_svg);
+}
+
+wboxtest_initcall(svg_wbt_init);
+wboxtest_exitcall(svg_wbt_exit);
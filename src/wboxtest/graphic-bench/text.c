@@ -0,0 +1,105 @@
+/*
+ * wboxtest/graphic-bench/text.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_text_pdata_t
+{
+	struct surface_t * s;
+	struct font_context_t * fctx;
+};
+
+static void * text_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_text_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_text_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->s = surface_alloc(640, 480, NULL);
+	pdat->fctx = font_context_alloc();
+	if(!pdat->s || !pdat->fctx)
+	{
+		if(pdat->s)
+			surface_free(pdat->s);
+		if(pdat->fctx)
+			font_context_free(pdat->fctx);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void text_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_text_pdata_t * pdat = (struct wbt_text_pdata_t *)data;
+
+	if(pdat)
+	{
+		font_context_free(pdat->fctx);
+		surface_free(pdat->s);
+		free(pdat);
+	}
+}
+
+static void text_bench(struct wbt_text_pdata_t * pdat, const char * utf8, int size)
+{
+	struct text_t * txt;
+	struct matrix_t m;
+	struct color_t c;
+	ktime_t t1, t2;
+	double ms;
+	int calls = 0;
+
+	color_init(&c, 0xff, 0xff, 0xff, 0xff);
+	txt = text_alloc(utf8, &c, pdat->fctx, "roboto", size);
+	if(!txt)
+		return;
+	matrix_init_translate(&m, 0, 0);
+	t2 = t1 = ktime_get();
+	do {
+		calls++;
+		surface_text(pdat->s, NULL, &m, txt);
+		t2 = ktime_get();
+	} while(ktime_before(t2, ktime_add_ms(t1, 1000)));
+	ms = ktime_ms_delta(t2, t1);
+	wboxtest_print(" %3dpx x %3d glyphs: %10.2f calls/s, %12.2f Mpixels/s\r\n", size, (int)strlen(utf8), calls * 1000.0 / ms, (double)txt->e.w * txt->e.h * calls / ms / 1000.0);
+	text_free(txt);
+}
+
+static void text_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_text_pdata_t * pdat = (struct wbt_text_pdata_t *)data;
+
+	if(pdat)
+	{
+		text_bench(pdat, "The quick brown fox jumps over the lazy dog", 12);
+		text_bench(pdat, "The quick brown fox jumps over the lazy dog", 24);
+		text_bench(pdat, "The quick brown fox", 48);
+		text_bench(pdat, "0123456789", 96);
+	}
+}
+
+static struct wboxtest_t wbt_text = {
+	.group	= "graphic-bench",
+	.name	= "text",
+	.setup	= text_setup,
+	.clean	= text_clean,
+	.run	= text_run,
+};
+
+static __init void text_wbt_init(void)
+{
+	register_wboxtest(&wbt_text);
+}
+
+static __exit void text_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_text);
+}
+
+wboxtest_initcall(text_wbt_init);
+wboxtest_exitcall(text_wbt_exit);
@@ -0,0 +1,142 @@
+/*
+ * wboxtest/graphic/glyph.c
+ */
+
+#include <wboxtest.h>
+
+/*
+ * The first draw fills the glyph cache and the second one is served from it,
+ * both must produce the same pixels
+ */
+#define GLYPH_TEXT		"The quick brown fox jumps over the lazy dog 0123456789"
+
+struct wbt_glyph_pdata_t
+{
+	struct surface_t * s1;
+	struct surface_t * s2;
+	struct font_context_t * fctx;
+};
+
+static void * glyph_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_glyph_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_glyph_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->s1 = surface_alloc(640, 480, NULL);
+	pdat->s2 = surface_alloc(640, 480, NULL);
+	pdat->fctx = font_context_alloc();
+	if(!pdat->s1 || !pdat->s2 || !pdat->fctx)
+	{
+		if(pdat->s1)
+			surface_free(pdat->s1);
+		if(pdat->s2)
+			surface_free(pdat->s2);
+		if(pdat->fctx)
+			font_context_free(pdat->fctx);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void glyph_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_glyph_pdata_t * pdat = (struct wbt_glyph_pdata_t *)data;
+
+	if(pdat)
+	{
+		font_context_free(pdat->fctx);
+		surface_free(pdat->s1);
+		surface_free(pdat->s2);
+		free(pdat);
+	}
+}
+
+static void glyph_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_glyph_pdata_t * pdat = (struct wbt_glyph_pdata_t *)data;
+	struct font_glyph_t * g1, * g2;
+	struct text_t * txt;
+	struct region_t e;
+	struct matrix_t m;
+	struct color_t c;
+	void * face;
+	int glyph;
+	int len;
+
+	if(pdat)
+	{
+		color_init(&c, 0xff, 0xff, 0xff, 0xff);
+		txt = text_alloc(GLYPH_TEXT, &c, pdat->fctx, "roboto", 24);
+		if(!txt)
+			return;
+		len = surface_get_stride(pdat->s1) * surface_get_height(pdat->s1);
+
+		/*
+		 * Cold and warm draws, plain and rotated
+		 */
+		matrix_init_translate(&m, 10.25, 100.5);
+		memset(surface_get_pixels(pdat->s1), 0, len);
+		memset(surface_get_pixels(pdat->s2), 0, len);
+		surface_text(pdat->s1, NULL, &m, txt);
+		surface_text(pdat->s2, NULL, &m, txt);
+		assert_memory_equal(surface_get_pixels(pdat->s1), surface_get_pixels(pdat->s2), len);
+
+		matrix_init_rotate(&m, 0.5);
+		matrix_translate(&m, 100, 100);
+		memset(surface_get_pixels(pdat->s1), 0, len);
+		memset(surface_get_pixels(pdat->s2), 0, len);
+		surface_text(pdat->s1, NULL, &m, txt);
+		surface_text(pdat->s2, NULL, &m, txt);
+		assert_memory_equal(surface_get_pixels(pdat->s1), surface_get_pixels(pdat->s2), len);
+
+		/*
+		 * Extents come from cached metrics and do not change
+		 */
+		region_clone(&e, &txt->e);
+		text_set_font_size(txt, 48);
+		text_set_font_size(txt, 24);
+		assert_equal(memcmp(&e, &txt->e, sizeof(struct region_t)), 0);
+
+		/*
+		 * Pen fractions within the same quarter pixel share a cache entry
+		 */
+		glyph = search_glyph(pdat->fctx, "roboto", 'A', &face);
+		assert_not_equal(glyph, 0);
+		assert_true(search_glyph(pdat->fctx, "roboto", 'A', &face) == glyph);
+		matrix_init_identity(&m);
+		g1 = font_glyph_render(pdat->fctx, face, 24, glyph, &m, 0, 0);
+		g2 = font_glyph_render(pdat->fctx, face, 24, glyph, &m, 15, 15);
+		assert_not_null(g1);
+		assert_true(g1 == g2);
+		g2 = font_glyph_render(pdat->fctx, face, 24, glyph, &m, 16, 0);
+		assert_true(g1 != g2);
+
+		text_free(txt);
+	}
+}
+
+static struct wboxtest_t wbt_glyph = {
+	.group	= "graphic",
+	.name	= "glyph",
+	.setup	= glyph_setup,
+	.clean	= glyph_clean,
+	.run	= glyph_run,
+};
+
+static __init void glyph_wbt_init(void)
+{
+	register_wboxtest(&wbt_glyph);
+}
+
+static __exit void glyph_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_glyph);
+}
+
+wboxtest_initcall(glyph_wbt_init);
+wboxtest_exitcall(glyph_wbt_exit);
@@ -0,0 +1,113 @@
+/*
+ * wboxtest/memory/dmapool.c
+ */
+
+#include <dma/dmapool.h>
+#include <wboxtest.h>
+
+struct wbt_dmapool_pdata_t
+{
+	char * cached[2];
+	char * coherent[2];
+	char * noncoherent[2];
+	size_t size;
+};
+
+static void * dmapool_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_dmapool_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_dmapool_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->size = SZ_256K;
+	pdat->cached[0] = malloc(pdat->size);
+	pdat->cached[1] = malloc(pdat->size);
+	pdat->coherent[0] = dma_alloc_coherent(pdat->size);
+	pdat->coherent[1] = dma_alloc_coherent(pdat->size);
+	pdat->noncoherent[0] = dma_alloc_noncoherent(pdat->size);
+	pdat->noncoherent[1] = dma_alloc_noncoherent(pdat->size);
+	if(!pdat->cached[0] || !pdat->cached[1] || !pdat->coherent[0] || !pdat->coherent[1] || !pdat->noncoherent[0] || !pdat->noncoherent[1])
+	{
+		free(pdat->cached[0]);
+		free(pdat->cached[1]);
+		dma_free_coherent(pdat->coherent[0]);
+		dma_free_coherent(pdat->coherent[1]);
+		dma_free_noncoherent(pdat->noncoherent[0]);
+		dma_free_noncoherent(pdat->noncoherent[1]);
+		free(pdat);
+		return NULL;
+	}
+	memset(pdat->cached[0], 0x5a, pdat->size);
+	memset(pdat->coherent[0], 0x5a, pdat->size);
+	memset(pdat->noncoherent[0], 0x5a, pdat->size);
+
+	return pdat;
+}
+
+static void dmapool_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_dmapool_pdata_t * pdat = (struct wbt_dmapool_pdata_t *)data;
+
+	if(pdat)
+	{
+		free(pdat->cached[0]);
+		free(pdat->cached[1]);
+		dma_free_coherent(pdat->coherent[0]);
+		dma_free_coherent(pdat->coherent[1]);
+		dma_free_noncoherent(pdat->noncoherent[0]);
+		dma_free_noncoherent(pdat->noncoherent[1]);
+		free(pdat);
+	}
+}
+
+static double dmapool_bandwidth(char * dst, char * src, size_t size)
+{
+	ktime_t t1, t2;
+	int calls = 0;
+
+	t2 = t1 = ktime_get();
+	do {
+		calls++;
+		memcpy(dst, src, size);
+		t2 = ktime_get();
+	} while(ktime_before(t2, ktime_add_ms(t1, 1000)));
+	return (double)calls * size * 1000.0 / ktime_ms_delta(t2, t1);
+}
+
+static void dmapool_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_dmapool_pdata_t * pdat = (struct wbt_dmapool_pdata_t *)data;
+	char buf[32];
+
+	if(pdat)
+	{
+		wboxtest_print(" Cached      : %s/s\r\n", ssize(buf, dmapool_bandwidth(pdat->cached[1], pdat->cached[0], pdat->size)));
+		wboxtest_print(" Coherent    : %s/s\r\n", ssize(buf, dmapool_bandwidth(pdat->coherent[1], pdat->coherent[0], pdat->size)));
+		wboxtest_print(" Noncoherent : %s/s\r\n", ssize(buf, dmapool_bandwidth(pdat->noncoherent[1], pdat->noncoherent[0], pdat->size)));
+		wboxtest_print(" Cached to coherent : %s/s\r\n", ssize(buf, dmapool_bandwidth(pdat->coherent[1], pdat->cached[0], pdat->size)));
+		wboxtest_print(" Coherent to cached : %s/s\r\n", ssize(buf, dmapool_bandwidth(pdat->cached[1], pdat->coherent[0], pdat->size)));
+	}
+}
+
+static struct wboxtest_t wbt_dmapool = {
+	.group	= "memory",
+	.name	= "dmapool",
+	.setup	= dmapool_setup,
+	.clean	= dmapool_clean,
+	.run	= dmapool_run,
+};
+
+static __init void dmapool_wbt_init(void)
+{
+	register_wboxtest(&wbt_dmapool);
+}
+
+static __exit void dmapool_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_dmapool);
+}
+
+wboxtest_initcall(dmapool_wbt_init);
+wboxtest_exitcall(dmapool_wbt_exit);
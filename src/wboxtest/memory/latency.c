@@ -0,0 +1,127 @@
+/*
+ * wboxtest/memory/latency.c
+ */
+
+#include <wboxtest.h>
+
+static void * volatile latency_sink;
+
+struct wbt_latency_pdata_t
+{
+	void ** buf;
+	size_t size;
+	size_t * idx;
+};
+
+static void * latency_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_latency_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_latency_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->size = SZ_64M;
+	do {
+		pdat->buf = malloc(pdat->size);
+		if(pdat->buf)
+			break;
+		pdat->size >>= 1;
+	} while(pdat->size >= SZ_1K);
+	pdat->idx = malloc(pdat->size / 64 * sizeof(size_t));
+	if(!pdat->buf || !pdat->idx)
+	{
+		free(pdat->buf);
+		free(pdat->idx);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void latency_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_latency_pdata_t * pdat = (struct wbt_latency_pdata_t *)data;
+
+	if(pdat)
+	{
+		free(pdat->idx);
+		free(pdat->buf);
+		free(pdat);
+	}
+}
+
+/*
+ * Link one pointer per cache line into a single random cycle, so that
+ * every load depends on the previous one and prefetchers cannot help.
+ */
+static void ** latency_chain(struct wbt_latency_pdata_t * pdat, size_t size)
+{
+	size_t step = 64 / sizeof(void *);
+	size_t n = size / 64;
+	size_t i, j, t;
+
+	for(i = 0; i < n; i++)
+		pdat->idx[i] = i;
+	for(i = n - 1; i > 0; i--)
+	{
+		j = wboxtest_random_int(0, i);
+		t = pdat->idx[i];
+		pdat->idx[i] = pdat->idx[j];
+		pdat->idx[j] = t;
+	}
+	for(i = 0; i < n; i++)
+		pdat->buf[pdat->idx[i] * step] = &pdat->buf[pdat->idx[(i + 1) % n] * step];
+	return &pdat->buf[pdat->idx[0] * step];
+}
+
+static void latency_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_latency_pdata_t * pdat = (struct wbt_latency_pdata_t *)data;
+	void ** p;
+	ktime_t t1, t2;
+	size_t size;
+	int loads = 1 << 20;
+	int i;
+
+	if(pdat)
+	{
+		for(size = SZ_1K; size <= pdat->size; size <<= 1)
+		{
+			p = latency_chain(pdat, size);
+			for(i = 0; i < size / 64; i++)
+				p = (void **)*p;
+			t1 = ktime_get();
+			for(i = 0; i < loads; i += 8)
+			{
+				p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+				p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+			}
+			t2 = ktime_get();
+			latency_sink = p;
+			wboxtest_print(" %8ldKB: %8.3f ns\r\n", (long)(size >> 10), (double)ktime_to_ns(ktime_sub(t2, t1)) / loads);
+		}
+	}
+}
+
+static struct wboxtest_t wbt_latency = {
+	.group	= "memory",
+	.name	= "latency",
+	.setup	= latency_setup,
+	.clean	= latency_clean,
+	.run	= latency_run,
+};
+
+static __init void latency_wbt_init(void)
+{
+	register_wboxtest(&wbt_latency);
+}
+
+static __exit void latency_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_latency);
+}
+
+wboxtest_initcall(latency_wbt_init);
+wboxtest_exitcall(latency_wbt_exit);
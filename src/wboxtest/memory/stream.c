@@ -0,0 +1,143 @@
+/*
+ * wboxtest/memory/stream.c
+ */
+
+#include <wboxtest.h>
+
+struct wbt_stream_pdata_t
+{
+	double * a;
+	double * b;
+	double * c;
+	size_t n;
+};
+
+static void * stream_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_stream_pdata_t * pdat;
+	size_t i;
+
+	pdat = malloc(sizeof(struct wbt_stream_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->n = SZ_2M;
+	do {
+		pdat->a = malloc(pdat->n * sizeof(double));
+		pdat->b = malloc(pdat->n * sizeof(double));
+		pdat->c = malloc(pdat->n * sizeof(double));
+		if(pdat->a && pdat->b && pdat->c)
+			break;
+		free(pdat->a);
+		free(pdat->b);
+		free(pdat->c);
+		pdat->a = pdat->b = pdat->c = NULL;
+		pdat->n >>= 1;
+	} while(pdat->n >= SZ_1K);
+	if(!pdat->a)
+	{
+		free(pdat);
+		return NULL;
+	}
+	for(i = 0; i < pdat->n; i++)
+	{
+		pdat->a[i] = 1.0;
+		pdat->b[i] = 2.0;
+		pdat->c[i] = 0.0;
+	}
+
+	return pdat;
+}
+
+static void stream_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_stream_pdata_t * pdat = (struct wbt_stream_pdata_t *)data;
+
+	if(pdat)
+	{
+		free(pdat->c);
+		free(pdat->b);
+		free(pdat->a);
+		free(pdat);
+	}
+}
+
+static void stream_kernel(struct wbt_stream_pdata_t * pdat, int kernel)
+{
+	double * a = pdat->a, * b = pdat->b, * c = pdat->c;
+	double s = 3.0;
+	size_t i, n = pdat->n;
+
+	switch(kernel)
+	{
+	case 0:
+		for(i = 0; i < n; i++)
+			c[i] = a[i];
+		break;
+	case 1:
+		for(i = 0; i < n; i++)
+			b[i] = s * c[i];
+		break;
+	case 2:
+		for(i = 0; i < n; i++)
+			c[i] = a[i] + b[i];
+		break;
+	case 3:
+		for(i = 0; i < n; i++)
+			a[i] = b[i] + s * c[i];
+		break;
+	default:
+		break;
+	}
+}
+
+static void stream_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_stream_pdata_t * pdat = (struct wbt_stream_pdata_t *)data;
+	static const char * name[] = { "Copy", "Scale", "Add", "Triad" };
+	static const int words[] = { 2, 2, 3, 3 };
+	ktime_t t1, t2;
+	s64_t best, ns;
+	char buf[32];
+	int k, i;
+
+	if(pdat)
+	{
+		wboxtest_print(" Array size: %s x 3\r\n", ssize(buf, (double)(pdat->n * sizeof(double))));
+		for(k = 0; k < 4; k++)
+		{
+			best = KTIME_MAX;
+			for(i = 0; i < 10; i++)
+			{
+				t1 = ktime_get();
+				stream_kernel(pdat, k);
+				t2 = ktime_get();
+				ns = ktime_to_ns(ktime_sub(t2, t1));
+				if(ns > 0 && ns < best)
+					best = ns;
+			}
+			wboxtest_print(" %-6s: %s/s\r\n", name[k], ssize(buf, (double)(words[k] * sizeof(double) * pdat->n) * 1000000000.0 / best));
+		}
+	}
+}
+
+static struct wboxtest_t wbt_stream = {
+	.group	= "memory",
+	.name	= "stream",
+	.setup	= stream_setup,
+	.clean	= stream_clean,
+	.run	= stream_run,
+};
+
+static __init void stream_wbt_init(void)
+{
+	register_wboxtest(&wbt_stream);
+}
+
+static __exit void stream_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_stream);
+}
+
+wboxtest_initcall(stream_wbt_init);
+wboxtest_exitcall(stream_wbt_exit);
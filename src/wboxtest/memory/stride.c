@@ -0,0 +1,102 @@
+/*
+ * wboxtest/memory/stride.c
+ */
+
+#include <wboxtest.h>
+
+static volatile u32_t stride_sink;
+
+struct wbt_stride_pdata_t
+{
+	u32_t * buf;
+	size_t size;
+};
+
+static void * stride_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_stride_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_stride_pdata_t));
+	if(!pdat)
+		return NULL;
+
+	pdat->size = SZ_16M;
+	do {
+		pdat->buf = malloc(pdat->size);
+		if(pdat->buf)
+			break;
+		pdat->size >>= 1;
+	} while(pdat->size >= SZ_64K);
+	if(!pdat->buf)
+	{
+		free(pdat);
+		return NULL;
+	}
+	memset(pdat->buf, 0x5a, pdat->size);
+
+	return pdat;
+}
+
+static void stride_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_stride_pdata_t * pdat = (struct wbt_stride_pdata_t *)data;
+
+	if(pdat)
+	{
+		free(pdat->buf);
+		free(pdat);
+	}
+}
+
+static void stride_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_stride_pdata_t * pdat = (struct wbt_stride_pdata_t *)data;
+	size_t n, stride, off, i;
+	ktime_t t1, t2;
+	s64_t ns;
+	u32_t sum;
+
+	if(pdat)
+	{
+		n = pdat->size / sizeof(u32_t);
+		for(stride = sizeof(u32_t); stride <= SZ_4K; stride <<= 1)
+		{
+			/*
+			 * Touch every word exactly once, walking the buffer in
+			 * interleaved passes so each pass hits one word per stride.
+			 */
+			sum = 0;
+			t1 = ktime_get();
+			for(off = 0; off < stride / sizeof(u32_t); off++)
+			{
+				for(i = off; i < n; i += stride / sizeof(u32_t))
+					sum += pdat->buf[i];
+			}
+			t2 = ktime_get();
+			stride_sink = sum;
+			ns = ktime_to_ns(ktime_sub(t2, t1));
+			wboxtest_print(" %6ld bytes: %8.3f ns/word\r\n", (long)stride, (double)ns / n);
+		}
+	}
+}
+
+static struct wboxtest_t wbt_stride = {
+	.group	= "memory",
+	.name	= "stride",
+	.setup	= stride_setup,
+	.clean	= stride_clean,
+	.run	= stride_run,
+};
+
+static __init void stride_wbt_init(void)
+{
+	register_wboxtest(&wbt_stride);
+}
+
+static __exit void stride_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_stride);
+}
+
+wboxtest_initcall(stride_wbt_init);
+wboxtest_exitcall(stride_wbt_exit);
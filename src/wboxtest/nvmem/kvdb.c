@@ -0,0 +1,255 @@
+/*
+ * wboxtest/nvmem/kvdb.c
+ */
+
+#include <wboxtest.h>
+#include <crc32.h>
+#include <nvmem/nvmem.h>
+
+/*
+ * A ram backed nvmem that loses power after a given number of written bytes,
+ * every cut is followed by a remount that must see each key either before or
+ * after the interrupted change
+ */
+#define KVDB_CAPACITY		(1024)
+#define KVDB_KEYS			(8)
+#define KVDB_VALUE_MAX		(24)
+#define KVDB_ROUNDS			(2000)
+
+struct wbt_kvdb_pdata_t
+{
+	struct nvmem_t nv;
+	unsigned char * ram;
+	int budget;
+	int cut;
+	char value[KVDB_KEYS][KVDB_VALUE_MAX + 1];
+};
+
+static int kvdb_ram_capacity(struct nvmem_t * m)
+{
+	return KVDB_CAPACITY;
+}
+
+static int kvdb_ram_read(struct nvmem_t * m, void * buf, int offset, int count)
+{
+	struct wbt_kvdb_pdata_t * pdat = (struct wbt_kvdb_pdata_t *)m->priv;
+
+	memcpy(buf, &pdat->ram[offset], count);
+	return count;
+}
+
+static int kvdb_ram_write(struct nvmem_t * m, void * buf, int offset, int count)
+{
+	struct wbt_kvdb_pdata_t * pdat = (struct wbt_kvdb_pdata_t *)m->priv;
+	int n = count;
+
+	if(pdat->budget >= 0)
+	{
+		if(n > pdat->budget)
+		{
+			n = pdat->budget;
+			pdat->cut = 1;
+		}
+		pdat->budget -= n;
+	}
+	memcpy(&pdat->ram[offset], buf, n);
+	return n;
+}
+
+static void * kvdb_setup(struct wboxtest_t * wbt)
+{
+	struct wbt_kvdb_pdata_t * pdat;
+
+	pdat = malloc(sizeof(struct wbt_kvdb_pdata_t));
+	if(!pdat)
+		return NULL;
+	memset(pdat, 0, sizeof(struct wbt_kvdb_pdata_t));
+
+	pdat->ram = malloc(KVDB_CAPACITY);
+	if(!pdat->ram)
+	{
+		free(pdat);
+		return NULL;
+	}
+	memset(pdat->ram, 0xff, KVDB_CAPACITY);
+
+	pdat->budget = -1;
+	pdat->nv.name = "wbt-kvdb";
+	pdat->nv.capacity = kvdb_ram_capacity;
+	pdat->nv.read = kvdb_ram_read;
+	pdat->nv.write = kvdb_ram_write;
+	pdat->nv.priv = pdat;
+	if(!register_nvmem(&pdat->nv, NULL))
+	{
+		free(pdat->ram);
+		free(pdat);
+		return NULL;
+	}
+
+	return pdat;
+}
+
+static void kvdb_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_kvdb_pdata_t * pdat = (struct wbt_kvdb_pdata_t *)data;
+
+	if(pdat)
+	{
+		unregister_nvmem(&pdat->nv);
+		free(pdat->ram);
+		free(pdat);
+	}
+}
+
+static int kvdb_check(struct wbt_kvdb_pdata_t * pdat)
+{
+	char key[16];
+	char * v;
+	int i;
+
+	for(i = 0; i < KVDB_KEYS; i++)
+	{
+		sprintf(key, "key%d", i);
+		v = nvmem_get(&pdat->nv, key, NULL);
+		if(pdat->value[i][0] ? (!v || (strcmp(v, pdat->value[i]) != 0)) : (v != NULL))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * The single string image of older releases, crc and length then the pairs
+ */
+static void kvdb_legacy_image(struct wbt_kvdb_pdata_t * pdat, const char * str)
+{
+	u32_t l = strlen(str) + 1;
+	u32_t c;
+
+	memset(pdat->ram, 0xff, KVDB_CAPACITY);
+	pdat->ram[4] = (l >> 0) & 0xff;
+	pdat->ram[5] = (l >> 8) & 0xff;
+	pdat->ram[6] = (l >> 16) & 0xff;
+	pdat->ram[7] = (l >> 24) & 0xff;
+	memcpy(&pdat->ram[8], str, l);
+	c = crc32_sum(crc32_sum(0, &pdat->ram[4], 4), &pdat->ram[8], l);
+	pdat->ram[0] = (c >> 0) & 0xff;
+	pdat->ram[1] = (c >> 8) & 0xff;
+	pdat->ram[2] = (c >> 16) & 0xff;
+	pdat->ram[3] = (c >> 24) & 0xff;
+	unregister_nvmem(&pdat->nv);
+	assert_not_null(register_nvmem(&pdat->nv, NULL));
+}
+
+static void kvdb_legacy(struct wbt_kvdb_pdata_t * pdat)
+{
+	unsigned char * ram;
+	char str[KVDB_CAPACITY];
+	char * v;
+	int i, l;
+
+	/*
+	 * A small image is migrated into the log and survives a remount
+	 */
+	kvdb_legacy_image(pdat, "key0=abc,key1 = de;key2=f");
+	unregister_nvmem(&pdat->nv);
+	assert_not_null(register_nvmem(&pdat->nv, NULL));
+	v = nvmem_get(&pdat->nv, "key0", NULL);
+	assert_true(v && (strcmp(v, "abc") == 0));
+	v = nvmem_get(&pdat->nv, "key2", NULL);
+	assert_true(v && (strcmp(v, "f") == 0));
+	nvmem_set(&pdat->nv, "key1", "xyz");
+	v = nvmem_get(&pdat->nv, "key1", NULL);
+	assert_true(v && (strcmp(v, "xyz") == 0));
+
+	/*
+	 * One reaching into the second half, with more pairs than the log holds,
+	 * is read as far as it fits but never overwritten
+	 */
+	for(i = 0, l = 0; i < 24; i++)
+		l += sprintf(&str[l], "legacy%02d=%032d,", i, i);
+	kvdb_legacy_image(pdat, str);
+	v = nvmem_get(&pdat->nv, "legacy00", NULL);
+	assert_true(v && (atoi(v) == 0));
+	assert_null(nvmem_get(&pdat->nv, "legacy23", NULL));
+	ram = malloc(KVDB_CAPACITY);
+	if(ram)
+	{
+		memcpy(ram, pdat->ram, KVDB_CAPACITY);
+		nvmem_set(&pdat->nv, "key0", "abc");
+		nvmem_clear(&pdat->nv);
+		assert_memory_equal(ram, pdat->ram, KVDB_CAPACITY);
+		free(ram);
+	}
+
+	memset(pdat->ram, 0xff, KVDB_CAPACITY);
+	unregister_nvmem(&pdat->nv);
+	assert_not_null(register_nvmem(&pdat->nv, NULL));
+}
+
+static void kvdb_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wbt_kvdb_pdata_t * pdat = (struct wbt_kvdb_pdata_t *)data;
+	char old[KVDB_VALUE_MAX + 1];
+	char val[KVDB_VALUE_MAX + 1];
+	char key[16];
+	char * v;
+	int cuts = 0;
+	int i, k;
+
+	if(pdat)
+	{
+		kvdb_legacy(pdat);
+		for(i = 0; i < KVDB_ROUNDS; i++)
+		{
+			k = wboxtest_random_int(0, KVDB_KEYS - 1);
+			sprintf(key, "key%d", k);
+			if(wboxtest_random_int(0, 7) == 0)
+				val[0] = '\0';
+			else
+				wboxtest_random_string(val, wboxtest_random_int(1, KVDB_VALUE_MAX));
+			strcpy(old, pdat->value[k]);
+
+			pdat->cut = 0;
+			pdat->budget = (wboxtest_random_int(0, 3) == 0) ? wboxtest_random_int(0, 64) : -1;
+			nvmem_set(&pdat->nv, key, val[0] ? val : NULL);
+			pdat->budget = -1;
+			strcpy(pdat->value[k], val);
+
+			if(pdat->cut || (wboxtest_random_int(0, 15) == 0))
+			{
+				unregister_nvmem(&pdat->nv);
+				assert_not_null(register_nvmem(&pdat->nv, NULL));
+				if(pdat->cut)
+				{
+					v = nvmem_get(&pdat->nv, key, NULL);
+					if(!v || (strcmp(v, val) != 0))
+						strcpy(pdat->value[k], old);
+					cuts++;
+				}
+			}
+			assert_true(kvdb_check(pdat));
+		}
+		wboxtest_print(" Power cuts: %d\r\n", cuts);
+	}
+}
+
+static struct wboxtest_t wbt_kvdb = {
+	.group	= "nvmem",
+	.name	= "kvdb",
+	.setup	= kvdb_setup,
+	.clean	= kvdb_clean,
+	.run	= kvdb_run,
+};
+
+static __init void kvdb_wbt_init(void)
+{
+	register_wboxtest(&wbt_kvdb);
+}
+
+static __exit void kvdb_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_kvdb);
+}
+
+wboxtest_initcall(kvdb_wbt_init);
+wboxtest_exitcall(kvdb_wbt_exit);
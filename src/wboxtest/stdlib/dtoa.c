@@ -0,0 +1,103 @@
+/*
+ * wboxtest/stdlib/dtoa.c
+ */
+
+#include <wboxtest.h>
+
+static const struct {
+	const char * fmt;
+	double v;
+	const char * s;
+} printf_vectors[] = {
+	{ "%f", 1.5, "1.500000" },
+	{ "%.0f", 0.5, "0" },
+	{ "%.0f", 1.5, "2" },
+	{ "%.0f", 2.5, "2" },
+	{ "%.2f", 2.675, "2.67" },
+	{ "%.1f", 0.25, "0.2" },
+	{ "%.3f", 1.0005, "1.000" },
+	{ "%e", 0.0, "0.000000e+00" },
+	{ "%.3e", 123456.0, "1.235e+05" },
+	{ "%E", -1e-300, "-1.000000E-300" },
+	{ "%.0e", 5e-324, "5e-324" },
+	{ "%.16e", 0.1, "1.0000000000000001e-01" },
+	{ "%g", 100000.0, "100000" },
+	{ "%g", 1000000.0, "1e+06" },
+	{ "%g", 0.0001, "0.0001" },
+	{ "%g", 0.00001, "1e-05" },
+	{ "%.3g", 999.5, "1e+03" },
+	{ "%#.3g", 1.0, "1.00" },
+	{ "%.17g", 0.1, "0.10000000000000001" },
+	{ "%+08.2f", 3.14159, "+0003.14" },
+	{ "%-10.1e|", -2.5, "-2.5e+00  |" },
+	{ "%.20f", 1e-10, "0.00000000010000000000" },
+	{ "%.0f", 1e22, "10000000000000000000000" },
+};
+
+static const struct {
+	double v;
+	const char * s;
+} dtostr_vectors[] = {
+	{ 0.0, "0" },
+	{ -0.0, "-0" },
+	{ 0.1, "0.1" },
+	{ 0.1 + 0.2, "0.30000000000000004" },
+	{ 100.0, "100" },
+	{ 1e15, "1000000000000000" },
+	{ 1e16, "1e+16" },
+	{ 9007199254740992.0, "9007199254740992" },
+	{ 1e-5, "1e-05" },
+	{ 0.0001, "0.0001" },
+	{ 5e-324, "5e-324" },
+	{ 1.7976931348623157e308, "1.7976931348623157e+308" },
+	{ 1.0 / 3.0, "0.3333333333333333" },
+};
+
+static void * dtoa_setup(struct wboxtest_t * wbt)
+{
+	return NULL;
+}
+
+static void dtoa_clean(struct wboxtest_t * wbt, void * data)
+{
+}
+
+static void dtoa_run(struct wboxtest_t * wbt, void * data)
+{
+	char buf[256];
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(printf_vectors); i++)
+	{
+		snprintf(buf, sizeof(buf), printf_vectors[i].fmt, printf_vectors[i].v);
+		assert_string_equal(buf, printf_vectors[i].s);
+	}
+	for(i = 0; i < ARRAY_SIZE(dtostr_vectors); i++)
+	{
+		dtostr(buf, sizeof(buf), dtostr_vectors[i].v);
+		assert_string_equal(buf, dtostr_vectors[i].s);
+	}
+	snprintf(buf, sizeof(buf), "%f %E", INFINITY, -NAN);
+	assert_string_equal(buf, "inf -NAN");
+}
+
+static struct wboxtest_t wbt_dtoa = {
+	.group	= "stdlib",
+	.name	= "dtoa",
+	.setup	= dtoa_setup,
+	.clean	= dtoa_clean,
+	.run	= dtoa_run,
+};
+
+static __init void dtoa_wbt_init(void)
+{
+	register_wboxtest(&wbt_dtoa);
+}
+
+static __exit void dtoa_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_dtoa);
+}
+
+wboxtest_initcall(dtoa_wbt_init);
+wboxtest_exitcall(dtoa_wbt_exit);
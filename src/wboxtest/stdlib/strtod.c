@@ -0,0 +1,126 @@
+/*
+ * wboxtest/stdlib/strtod.c
+ */
+
+#include <wboxtest.h>
+
+static const struct {
+	const char * s;
+	u64_t bits;
+} strtod_vectors[] = {
+	{ "0", 0x0000000000000000ULL },
+	{ "-0", 0x8000000000000000ULL },
+	{ "1", 0x3ff0000000000000ULL },
+	{ "0.1", 0x3fb999999999999aULL },
+	{ "1e23", 0x44b52d02c7e14af6ULL },
+	{ "8.98846567431158e307", 0x7fe0000000000000ULL },
+	{ "1.7976931348623157e308", 0x7fefffffffffffffULL },
+	{ "1.7976931348623158e308", 0x7fefffffffffffffULL },
+	{ "1e309", 0x7ff0000000000000ULL },
+	{ "2.2250738585072011e-308", 0x000fffffffffffffULL },
+	{ "2.2250738585072012e-308", 0x0010000000000000ULL },
+	{ "4.9406564584124654e-324", 0x0000000000000001ULL },
+	{ "2.4703282292062327e-324", 0x0000000000000000ULL },
+	{ "2.4703282292062328e-324", 0x0000000000000001ULL },
+	{ "9007199254740993", 0x4340000000000000ULL },
+	{ "9007199254740993.0000000000000000000000001", 0x4340000000000001ULL },
+	{ "123456789012345678901234567890", 0x45f8ee90ff6c373eULL },
+	{ "0.30000000000000004", 0x3fd3333333333334ULL },
+	{ "-12.5e-3", 0xbf8999999999999aULL },
+	{ "0x1.8p1", 0x4008000000000000ULL },
+	{ "0x1p-1074", 0x0000000000000001ULL },
+	{ "inf", 0x7ff0000000000000ULL },
+	{ "-Infinity", 0xfff0000000000000ULL },
+};
+
+static const struct {
+	const char * s;
+	u32_t bits;
+} strtof_vectors[] = {
+	{ "0.1", 0x3dcccccd },
+	{ "3.4028235e38", 0x7f7fffff },
+	{ "3.4028236e38", 0x7f800000 },
+	{ "1.00000005960464477539062499", 0x3f800000 },
+	{ "1.000000059604644775390625", 0x3f800000 },
+	{ "1.000000059604644775390625000001", 0x3f800001 },
+	{ "7.006492321624085e-46", 0x00000000 },
+	{ "7.006492321624086e-46", 0x00000001 },
+	{ "16777217", 0x4b800000 },
+};
+
+static void * strtod_setup(struct wboxtest_t * wbt)
+{
+	return NULL;
+}
+
+static void strtod_clean(struct wboxtest_t * wbt, void * data)
+{
+}
+
+static void strtod_run(struct wboxtest_t * wbt, void * data)
+{
+	union { double d; u64_t u; } x, y;
+	union { float f; u32_t u; } z;
+	char buf[64];
+	char * end;
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(strtod_vectors); i++)
+	{
+		x.d = strtod(strtod_vectors[i].s, &end);
+		assert_equal(x.u, strtod_vectors[i].bits);
+		assert_equal(*end, '\0');
+	}
+	for(i = 0; i < ARRAY_SIZE(strtof_vectors); i++)
+	{
+		z.f = strtof(strtof_vectors[i].s, &end);
+		assert_equal(z.u, strtof_vectors[i].bits);
+		assert_equal(*end, '\0');
+	}
+
+	strtod(" 1.5e", &end);
+	assert_string_equal(end, "e");
+	strtod("0x", &end);
+	assert_string_equal(end, "x");
+	strtod("nan(123)z", &end);
+	assert_string_equal(end, "z");
+	strtod(".e1", &end);
+	assert_string_equal(end, ".e1");
+	errno = 0;
+	strtod("1e-400", NULL);
+	assert_equal(errno, ERANGE);
+
+	for(i = 0; i < 10000; i++)
+	{
+		wboxtest_random_buffer((char *)&x.u, sizeof(x.u));
+		if(isnan(x.d))
+			continue;
+		snprintf(buf, sizeof(buf), "%.17g", x.d);
+		y.d = strtod(buf, NULL);
+		assert_equal(x.u, y.u);
+		dtostr(buf, sizeof(buf), x.d);
+		y.d = strtod(buf, NULL);
+		assert_equal(x.u, y.u);
+	}
+}
+
+static struct wboxtest_t wbt_strtod = {
+	.group	= "stdlib",
+	.name	= "strtod",
+	.setup	= strtod_setup,
+	.clean	= strtod_clean,
+	.run	= strtod_run,
+};
+
+static __init void strtod_wbt_init(void)
+{
+	register_wboxtest(&wbt_strtod);
+}
+
+static __exit void strtod_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_strtod);
+}
+
+wboxtest_initcall(strtod_wbt_init);
+wboxtest_exitcall(strtod_wbt_exit);
@@ -0,0 +1,176 @@
+/*
+ * wboxtest/vfs/dentry.c
+ */
+
+#include <wboxtest.h>
+
+#define DENTRY_PATH		"/tmp/wbt-dentry"
+#define DENTRY_FILES	(CONFIG_VFS_DENTRY_CACHE_SIZE + 8)
+
+struct dentry_stat_t {
+	s64_t hit;
+	s64_t miss;
+	int count;
+};
+
+static int dentry_stat(struct dentry_stat_t * st)
+{
+	char buf[128];
+	u64_t len;
+	int fd;
+
+	memset(st, 0, sizeof(struct dentry_stat_t));
+	fd = vfs_open("/sys/class/dentry/stat", O_RDONLY, 0);
+	if(fd < 0)
+		return 0;
+	len = vfs_read(fd, buf, sizeof(buf) - 1);
+	vfs_close(fd);
+	buf[len] = '\0';
+	return (sscanf(buf, "hit: %lld\r\nmiss: %lld\r\ncount: %d", &st->hit, &st->miss, &st->count) == 3) ? 1 : 0;
+}
+
+static int dentry_create(const char * path)
+{
+	int fd = vfs_open(path, O_WRONLY | O_CREAT, 0644);
+
+	if(fd < 0)
+		return 0;
+	vfs_close(fd);
+	return 1;
+}
+
+/*
+ * Stat a path and return how many of its names missed the dentry cache
+ */
+static s64_t dentry_misses(const char * path, int * exist)
+{
+	struct dentry_stat_t a, b;
+	struct vfs_stat_t st;
+
+	dentry_stat(&a);
+	*exist = (vfs_stat(path, &st) == 0) ? 1 : 0;
+	dentry_stat(&b);
+	return b.miss - a.miss;
+}
+
+static void * dentry_setup(struct wboxtest_t * wbt)
+{
+	struct dentry_stat_t st;
+
+	if(!dentry_stat(&st))
+		return NULL;
+	if(vfs_mkdir(DENTRY_PATH, 0755) != 0)
+		return NULL;
+	return (void *)1;
+}
+
+static void dentry_clean(struct wboxtest_t * wbt, void * data)
+{
+	char path[VFS_MAX_PATH];
+	int i;
+
+	if(data)
+	{
+		for(i = 0; i < DENTRY_FILES; i++)
+		{
+			snprintf(path, sizeof(path), DENTRY_PATH "/f%d", i);
+			vfs_unlink(path);
+		}
+		vfs_unlink(DENTRY_PATH "/a");
+		vfs_unlink(DENTRY_PATH "/b");
+		vfs_unlink(DENTRY_PATH "/c");
+		vfs_rmdir(DENTRY_PATH);
+	}
+}
+
+static void dentry_run(struct wboxtest_t * wbt, void * data)
+{
+	struct dentry_stat_t st;
+	char path[VFS_MAX_PATH];
+	int exist, i;
+
+	if(data)
+	{
+		/*
+		 * A name looked up once is a hit afterwards
+		 */
+		assert_true(dentry_create(DENTRY_PATH "/a"));
+		dentry_misses(DENTRY_PATH "/a", &exist);
+		assert_true(exist);
+		assert_equal(dentry_misses(DENTRY_PATH "/a", &exist), 0);
+		assert_true(exist);
+
+		/*
+		 * A missing name is cached as such, until it is created
+		 */
+		assert_equal(dentry_misses(DENTRY_PATH "/b", &exist), 1);
+		assert_false(exist);
+		assert_equal(dentry_misses(DENTRY_PATH "/b", &exist), 0);
+		assert_false(exist);
+		assert_true(dentry_create(DENTRY_PATH "/b"));
+		dentry_misses(DENTRY_PATH "/b", &exist);
+		assert_true(exist);
+
+		/*
+		 * Rename and unlink drop the names they change
+		 */
+		assert_equal(dentry_misses(DENTRY_PATH "/c", &exist), 1);
+		assert_false(exist);
+		assert_equal(vfs_rename(DENTRY_PATH "/b", DENTRY_PATH "/c"), 0);
+		dentry_misses(DENTRY_PATH "/b", &exist);
+		assert_false(exist);
+		dentry_misses(DENTRY_PATH "/c", &exist);
+		assert_true(exist);
+		assert_equal(vfs_rename(DENTRY_PATH "/c", DENTRY_PATH "/b"), 0);
+		dentry_misses(DENTRY_PATH "/c", &exist);
+		assert_false(exist);
+		dentry_misses(DENTRY_PATH "/b", &exist);
+		assert_true(exist);
+		assert_equal(vfs_unlink(DENTRY_PATH "/a"), 0);
+		dentry_misses(DENTRY_PATH "/a", &exist);
+		assert_false(exist);
+
+		/*
+		 * The cache holds at most CONFIG_VFS_DENTRY_CACHE_SIZE names, the
+		 * least recently used go first
+		 */
+		for(i = 0; i < DENTRY_FILES; i++)
+		{
+			snprintf(path, sizeof(path), DENTRY_PATH "/f%d", i);
+			assert_true(dentry_create(path));
+			dentry_misses(path, &exist);
+			assert_true(exist);
+		}
+		dentry_stat(&st);
+		assert_equal(st.count, CONFIG_VFS_DENTRY_CACHE_SIZE);
+		snprintf(path, sizeof(path), DENTRY_PATH "/f%d", DENTRY_FILES - 1);
+		assert_equal(dentry_misses(path, &exist), 0);
+		assert_true(exist);
+		snprintf(path, sizeof(path), DENTRY_PATH "/f%d", 0);
+		assert_equal(dentry_misses(path, &exist), 1);
+		assert_true(exist);
+		assert_equal(dentry_misses(path, &exist), 0);
+		assert_true(exist);
+	}
+}
+
+static struct wboxtest_t wbt_dentry = {
+	.group	= "vfs",
+	.name	= "dentry",
+	.setup	= dentry_setup,
+	.clean	= dentry_clean,
+	.run	= dentry_run,
+};
+
+static __init void dentry_wbt_init(void)
+{
+	register_wboxtest(&wbt_dentry);
+}
+
+static __exit void dentry_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_dentry);
+}
+
+wboxtest_initcall(dentry_wbt_init);
+wboxtest_exitcall(dentry_wbt_exit);
@@ -0,0 +1,580 @@
+/*
+ * wboxtest/vfs/ext4-rw.c
+ */
+
+#include <wboxtest.h>
+#include <vfs/ext4/ext4.h>
+
+#define EXT4_RW_DISK_SIZE	(SZ_1M)
+#define EXT4_RW_MOUNT_PATH	"/tmp/wbt-ext4-rw"
+
+/*
+ * A 1M ext4 image with 1K blocks and no checksums, so it mounts writable. Made
+ * on the host by
+ *
+ *   mke2fs -t ext4 -b 1024 -N 64 -O ^has_journal,^resize_inode,^metadata_csum,^uninit_bg img 1024
+ *   debugfs -w -f cmds img
+ *   e2fsck -fyD img
+ *
+ * Block i of 'ext.bin' is filled with (i * 31 + 3) % 255 + 1, its 8 blocks are
+ * one extent at 23 to 30, with only blocks 31 to 34 free behind it. 'dir' is an
+ * htree of 64 links to 'small.txt', inode 12. Inodes 14 and 15 are 'ext.bin'
+ * and the first one created. Zero runs are left out of the table.
+ */
+static const struct {
+	u32_t offset;
+	u16_t length;
+	s16_t fill;
+} ext4_rw_image_runs[] = {
+	{ 0x00400,    1,   -1 },
+	{ 0x00405,   16,   -1 },
+	{ 0x00421,    8,   -1 },
+	{ 0x00430,   20,   -1 },
+	{ 0x0044c,    1,   -1 },
+	{ 0x00454,    1,   -1 },
+	{ 0x00459,   31,   -1 },
+	{ 0x004ec,   21,   -1 },
+	{ 0x00508,    4,   -1 },
+	{ 0x0055c,    5,   -1 },
+	{ 0x00574,    5,   -1 },
+	{ 0x00648,    1,   -1 },
+	{ 0x00800,   17,   -1 },
+	{ 0x00c00,    7,   -1 },
+	{ 0x00c7f,    1,   -1 },
+	{ 0x00c80,  896,  255 },
+	{ 0x01000,   91,   -1 },
+	{ 0x01400,   22,   -1 },
+	{ 0x01805,    1,   -1 },
+	{ 0x01c05,    1,   -1 },
+	{ 0x02005,    1,   -1 },
+	{ 0x02405,    1,   -1 },
+	{ 0x02805,    1,   -1 },
+	{ 0x02c05,    1,   -1 },
+	{ 0x03005,    1,   -1 },
+	{ 0x03405,    1,   -1 },
+	{ 0x03805,    1,   -1 },
+	{ 0x03c05,    1,   -1 },
+	{ 0x04005,    1,   -1 },
+	{ 0x04400,   22,   -1 },
+	{ 0x0441c,   25,   -1 },
+	{ 0x04800,  841,   -1 },
+	{ 0x04c00,    2,   -1 },
+	{ 0x04c08, 1016,  255 },
+	{ 0x05000,  845,   -1 },
+	{ 0x05400,  569,   -1 },
+	{ 0x05800,   11,   -1 },
+	{ 0x05c00, 1024,    4 },
+	{ 0x06000, 1024,   35 },
+	{ 0x06400, 1024,   66 },
+	{ 0x06800, 1024,   97 },
+	{ 0x06c00, 1024,  128 },
+	{ 0x07000, 1024,  159 },
+	{ 0x07400, 1024,  190 },
+	{ 0x07800, 1024,  221 },
+	{ 0x08c08,   12,   -1 },
+	{ 0x08d00,   20,   -1 },
+	{ 0x08d1a,    3,   -1 },
+	{ 0x08d22,    1,   -1 },
+	{ 0x08d28,    5,   -1 },
+	{ 0x08d38,    5,   -1 },
+	{ 0x08d80,    1,   -1 },
+	{ 0x08d90,    4,   -1 },
+	{ 0x09600,   20,   -1 },
+	{ 0x0961a,    3,   -1 },
+	{ 0x09622,    1,   -1 },
+	{ 0x09628,    5,   -1 },
+	{ 0x09638,    5,   -1 },
+	{ 0x09680,    1,   -1 },
+	{ 0x09690,    4,   -1 },
+	{ 0x09700,   20,   -1 },
+	{ 0x0971a,    3,   -1 },
+	{ 0x09721,    2,   -1 },
+	{ 0x09728,    5,   -1 },
+	{ 0x09738,   17,   -1 },
+	{ 0x09780,    1,   -1 },
+	{ 0x09790,    4,   -1 },
+	{ 0x09800,   20,   -1 },
+	{ 0x0981a,    3,   -1 },
+	{ 0x09822,    1,   -1 },
+	{ 0x09828,    5,   -1 },
+	{ 0x09838,    5,   -1 },
+	{ 0x09880,    1,   -1 },
+	{ 0x09890,    4,   -1 },
+	{ 0x09900,   20,   -1 },
+	{ 0x0991a,    3,   -1 },
+	{ 0x09922,    1,   -1 },
+	{ 0x09928,    5,   -1 },
+	{ 0x09938,    5,   -1 },
+	{ 0x09980,    1,   -1 },
+	{ 0x09990,    4,   -1 },
+};
+
+static const u8_t ext4_rw_image_bytes[] = {
+	0x40, 0x04, 0x00, 0x00, 0x33, 0x00, 0x00, 0x00, 0xd1, 0x03, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00,
+	0x01, 0x20, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x40, 0xc5, 0x8a, 0xd5, 0x6a, 0x00, 0x00, 0xff,
+	0xff, 0x53, 0xef, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0xc5, 0x8a, 0xd5, 0x6a, 0x01, 0x0b, 0x01,
+	0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0xc2, 0x02, 0x00, 0x00, 0x6b, 0x00, 0x00, 0x00, 0x60, 0xd7,
+	0x53, 0x46, 0x11, 0x1f, 0x49, 0x01, 0x9b, 0xb3, 0x91, 0x85, 0x91, 0xd9, 0x62, 0x20, 0x20, 0x9b,
+	0x9b, 0x28, 0xbe, 0x0b, 0x42, 0x61, 0xaa, 0x45, 0x74, 0x1b, 0xc6, 0x40, 0x48, 0xd5, 0x01, 0x00,
+	0x40, 0x00, 0x0c, 0xc5, 0x8a, 0xd5, 0x6a, 0x20, 0x00, 0x20, 0x00, 0x01, 0x04, 0x00, 0x00, 0x00,
+	0x3a, 0x15, 0x03, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 0xd1, 0x03,
+	0x32, 0x00, 0x03, 0xff, 0xff, 0xff, 0x3f, 0xfc, 0xff, 0x03, 0x80, 0x02, 0x00, 0x00, 0x00, 0x0c,
+	0x00, 0x01, 0x02, 0x2e, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x02, 0x02, 0x2e,
+	0x2e, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x14, 0x00, 0x0a, 0x02, 0x6c, 0x6f, 0x73, 0x74, 0x2b,
+	0x66, 0x6f, 0x75, 0x6e, 0x64, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x03, 0x02, 0x64,
+	0x69, 0x72, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x14, 0x00, 0x09, 0x01, 0x73, 0x6d, 0x61, 0x6c, 0x6c,
+	0x2e, 0x74, 0x78, 0x74, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0xb4, 0x03, 0x07, 0x01, 0x65,
+	0x78, 0x74, 0x2e, 0x62, 0x69, 0x6e, 0x0b, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x01, 0x02, 0x2e, 0x00,
+	0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0xf4, 0x03, 0x02, 0x02, 0x2e, 0x2e, 0x04, 0x04, 0x04, 0x04,
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0c, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x01, 0x02, 0x2e,
+	0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0xf4, 0x03, 0x02, 0x02, 0x2e, 0x2e, 0x01, 0x08, 0x00,
+	0x00, 0x7c, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0a, 0xc6, 0xb2, 0x5c, 0x02, 0x00, 0x00,
+	0x00, 0x9e, 0x35, 0x95, 0xd5, 0x03, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x37, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x36, 0x31, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x38, 0x0d, 0x00,
+	0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x30, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x37, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x35, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00,
+	0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x35, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x35, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x36, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x31, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x33, 0x36, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x36, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x36, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0xd8, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x31, 0xff,
+	0x3f, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x31, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x35, 0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x35, 0x36, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x0d, 0x00, 0x00,
+	0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x39, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x34, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x34, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x34, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x39, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x33, 0x31, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x36, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x32, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x37, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x34, 0x31, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x36, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x36, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x31, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x35, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0xd4, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x39, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x33, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x34, 0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x31, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x36, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x38, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x32, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x31, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00,
+	0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c,
+	0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00,
+	0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68,
+	0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x32, 0x00,
+	0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d,
+	0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65,
+	0x2d, 0x32, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x0d, 0x00, 0x00, 0x00, 0xe8, 0x01, 0x19, 0x01, 0x65, 0x6e,
+	0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d,
+	0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x34, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x65, 0x78, 0x74,
+	0x34, 0x0a, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0xed, 0x41,
+	0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a,
+	0xd5, 0x6a, 0x04, 0x00, 0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x04,
+	0x20, 0xc5, 0x8a, 0xd5, 0x6a, 0xc0, 0x41, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0xc5, 0x8a, 0xd5,
+	0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0x02, 0x00, 0x18, 0x08, 0x0a, 0xf3, 0x01,
+	0x00, 0x04, 0x0c, 0x00, 0x00, 0x00, 0x05, 0x20, 0xc5, 0x8a, 0xd5, 0x6a, 0xed, 0x41, 0x00, 0x00,
+	0x00, 0x10, 0x00, 0x00, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a,
+	0x02, 0x00, 0x08, 0x10, 0x08, 0x0a, 0xf3, 0x02, 0x00, 0x04, 0x02, 0x00, 0x00, 0x00, 0x11, 0x00,
+	0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x14, 0x20, 0xc5, 0x8a, 0xd5, 0x6a,
+	0xa4, 0x81, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a,
+	0xc5, 0x8a, 0xd5, 0x6a, 0x41, 0x00, 0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00,
+	0x00, 0x16, 0x20, 0xc5, 0x8a, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0xc5,
+	0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0xc5, 0x8a, 0xd5, 0x6a, 0x01, 0x00, 0x10, 0x08, 0x0a,
+	0xf3, 0x01, 0x00, 0x04, 0x08, 0x00, 0x00, 0x00, 0x17, 0x20, 0xc5, 0x8a, 0xd5, 0x6a,
+};
+
+static u8_t ext4_rw_pattern(int blk, int id)
+{
+	return (blk * 31 + id) % 255 + 1;
+}
+
+/*
+ * Counters read back from the unmounted image, the free blocks of the
+ * superblock and the inodes of the single group
+ */
+static u32_t ext4_rw_free_blocks(struct wboxtest_ramdisk_t * rd)
+{
+	return le32_to_cpu(*((u32_t *)&rd->rambuf[SZ_1K + 12]));
+}
+
+static struct ext2_inode_t * ext4_rw_inode(struct wboxtest_ramdisk_t * rd, int ino)
+{
+	u32_t table = le32_to_cpu(*((u32_t *)&rd->rambuf[2 * SZ_1K + 8]));
+	u32_t isize = le16_to_cpu(*((u16_t *)&rd->rambuf[SZ_1K + 88]));
+
+	return (struct ext2_inode_t *)&rd->rambuf[table * SZ_1K + (ino - 1) * isize];
+}
+
+static void * ext4_rw_setup(struct wboxtest_t * wbt)
+{
+	struct wboxtest_ramdisk_t * rd;
+	const u8_t * p = ext4_rw_image_bytes;
+	int i;
+
+	rd = wboxtest_ramdisk_alloc("wbt-ext4-rw", EXT4_RW_DISK_SIZE, 0);
+	if(!rd)
+		return NULL;
+	for(i = 0; i < ARRAY_SIZE(ext4_rw_image_runs); i++)
+	{
+		if(ext4_rw_image_runs[i].fill < 0)
+		{
+			memcpy(&rd->rambuf[ext4_rw_image_runs[i].offset], p, ext4_rw_image_runs[i].length);
+			p += ext4_rw_image_runs[i].length;
+		}
+		else
+			memset(&rd->rambuf[ext4_rw_image_runs[i].offset], ext4_rw_image_runs[i].fill, ext4_rw_image_runs[i].length);
+	}
+
+	vfs_mkdir(EXT4_RW_MOUNT_PATH, 0755);
+	if(vfs_mount("wbt-ext4-rw", EXT4_RW_MOUNT_PATH, "ext4", MOUNT_RW) != 0)
+	{
+		vfs_rmdir(EXT4_RW_MOUNT_PATH);
+		wboxtest_ramdisk_free(rd);
+		return NULL;
+	}
+	return rd;
+}
+
+static void ext4_rw_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)data;
+
+	if(rd)
+	{
+		vfs_unmount(EXT4_RW_MOUNT_PATH);
+		vfs_rmdir(EXT4_RW_MOUNT_PATH);
+		wboxtest_ramdisk_free(rd);
+	}
+}
+
+static int ext4_rw_write(const char * path, int flags, int blk, int nblk, int id)
+{
+	u8_t * buf;
+	int fd, i, len = 0;
+
+	buf = malloc(nblk * SZ_1K);
+	if(!buf)
+		return -1;
+	for(i = 0; i < nblk * SZ_1K; i++)
+		buf[i] = ext4_rw_pattern(blk + i / SZ_1K, id);
+	fd = vfs_open(path, O_WRONLY | flags, 0644);
+	if(fd >= 0)
+	{
+		len = vfs_pwrite(fd, buf, nblk * SZ_1K, blk * SZ_1K);
+		vfs_close(fd);
+	}
+	free(buf);
+	return (len == nblk * SZ_1K) ? 0 : -1;
+}
+
+/*
+ * Compare blk to blk + nblk against the pattern of id, a negative id for a hole
+ */
+static int ext4_rw_check(const char * path, int blk, int nblk, int id)
+{
+	u8_t * buf;
+	int fd, i = -1;
+
+	buf = malloc(nblk * SZ_1K);
+	if(!buf)
+		return -1;
+	fd = vfs_open(path, O_RDONLY, 0);
+	if(fd >= 0)
+	{
+		memset(buf, 0x5a, nblk * SZ_1K);
+		if(vfs_pread(fd, buf, nblk * SZ_1K, blk * SZ_1K) == nblk * SZ_1K)
+		{
+			for(i = 0; i < nblk * SZ_1K; i++)
+			{
+				if(buf[i] != ((id < 0) ? 0 : ext4_rw_pattern(blk + i / SZ_1K, id)))
+					break;
+			}
+		}
+		vfs_close(fd);
+	}
+	free(buf);
+	return (i == nblk * SZ_1K) ? 0 : -1;
+}
+
+static void ext4_rw_check_files(void)
+{
+	struct vfs_stat_t st;
+	char buf[SZ_1K];
+	int fd;
+
+	assert_equal(vfs_stat(EXT4_RW_MOUNT_PATH "/ext.bin", &st), 0);
+	assert_equal(st.st_size, 14 * SZ_1K);
+	assert_equal(ext4_rw_check(EXT4_RW_MOUNT_PATH "/ext.bin", 0, 2, 3), 0);
+	assert_equal(ext4_rw_check(EXT4_RW_MOUNT_PATH "/ext.bin", 3, 11, 3), 0);
+	fd = vfs_open(EXT4_RW_MOUNT_PATH "/ext.bin", O_RDONLY, 0);
+	assert_true(fd >= 0);
+	if(fd >= 0)
+	{
+		assert_equal(vfs_pread(fd, buf, SZ_1K, 2 * SZ_1K), SZ_1K);
+		assert_equal(buf[99], ext4_rw_pattern(2, 3));
+		assert_equal(buf[100], ext4_rw_pattern(2, 4));
+		assert_equal(buf[599], ext4_rw_pattern(2, 4));
+		assert_equal(buf[600], ext4_rw_pattern(2, 3));
+		vfs_close(fd);
+	}
+
+	assert_equal(vfs_stat(EXT4_RW_MOUNT_PATH "/ind.bin", &st), 0);
+	assert_equal(st.st_size, 402 * SZ_1K);
+	assert_equal(ext4_rw_check(EXT4_RW_MOUNT_PATH "/ind.bin", 0, 300, 5), 0);
+	assert_equal(ext4_rw_check(EXT4_RW_MOUNT_PATH "/ind.bin", 300, 100, -1), 0);
+	assert_equal(ext4_rw_check(EXT4_RW_MOUNT_PATH "/ind.bin", 400, 2, 6), 0);
+
+	assert_equal(vfs_stat(EXT4_RW_MOUNT_PATH "/trunc.bin", &st), 0);
+	assert_equal(st.st_size, 3 * SZ_1K);
+	assert_equal(ext4_rw_check(EXT4_RW_MOUNT_PATH "/trunc.bin", 0, 3, 7), 0);
+
+	assert_not_equal(vfs_access(EXT4_RW_MOUNT_PATH "/gone.bin", R_OK), 0);
+}
+
+static void ext4_rw_check_dir(void)
+{
+	struct vfs_stat_t st;
+	char path[VFS_MAX_PATH];
+	int i;
+
+	for(i = 0; i < 64; i++)
+	{
+		snprintf(path, sizeof(path), EXT4_RW_MOUNT_PATH "/dir/entry-with-a-long-name-%d", i);
+		assert_equal(vfs_access(path, R_OK), 0);
+	}
+	for(i = 0; i < 24; i++)
+	{
+		snprintf(path, sizeof(path), EXT4_RW_MOUNT_PATH "/dir/created-with-a-long-name-%d", i);
+		if(i & 1)
+		{
+			assert_equal(ext4_rw_check(path, 0, 1, i), 0);
+		}
+		else
+		{
+			assert_not_equal(vfs_access(path, R_OK), 0);
+		}
+	}
+	assert_equal(vfs_stat(EXT4_RW_MOUNT_PATH "/dir/moved", &st), 0);
+	assert_true(S_ISDIR(st.st_mode));
+	assert_not_equal(vfs_access(EXT4_RW_MOUNT_PATH "/dir/sub", R_OK), 0);
+	assert_not_equal(vfs_access(EXT4_RW_MOUNT_PATH "/sub", R_OK), 0);
+}
+
+static void ext4_rw_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)data;
+	struct vfs_stat_t st;
+	char path[VFS_MAX_PATH];
+	u32_t nfree;
+	u8_t buf[500];
+	int fd, i;
+
+	if(rd)
+	{
+		nfree = ext4_rw_free_blocks(rd);
+
+		/*
+		 * Extent mapped, overwrite in place and append, which grows the extent
+		 * over blocks 31 to 34 and then needs a second one
+		 */
+		fd = vfs_open(EXT4_RW_MOUNT_PATH "/ext.bin", O_RDWR, 0);
+		assert_true(fd >= 0);
+		if(fd >= 0)
+		{
+			memset(buf, ext4_rw_pattern(2, 4), sizeof(buf));
+			assert_equal(vfs_pwrite(fd, buf, sizeof(buf), 2 * SZ_1K + 100), sizeof(buf));
+			vfs_close(fd);
+		}
+		assert_equal(ext4_rw_write(EXT4_RW_MOUNT_PATH "/ext.bin", 0, 8, 6, 3), 0);
+
+		/*
+		 * New files are block mapped, 300 blocks reach the double indirect
+		 * range and a write past the end leaves a hole
+		 */
+		assert_equal(ext4_rw_write(EXT4_RW_MOUNT_PATH "/ind.bin", O_CREAT, 0, 300, 5), 0);
+		assert_equal(ext4_rw_write(EXT4_RW_MOUNT_PATH "/ind.bin", 0, 400, 2, 6), 0);
+
+		/*
+		 * Truncating frees the data and the indirect blocks, so does unlink
+		 */
+		assert_equal(ext4_rw_write(EXT4_RW_MOUNT_PATH "/trunc.bin", O_CREAT, 0, 290, 7), 0);
+		assert_equal(ext4_rw_write(EXT4_RW_MOUNT_PATH "/trunc.bin", O_TRUNC, 0, 3, 7), 0);
+		assert_equal(ext4_rw_write(EXT4_RW_MOUNT_PATH "/gone.bin", O_CREAT, 0, 20, 8), 0);
+		assert_equal(vfs_unlink(EXT4_RW_MOUNT_PATH "/gone.bin"), 0);
+		fd = vfs_open(EXT4_RW_MOUNT_PATH "/empty.bin", O_WRONLY | O_CREAT, 0644);
+		assert_true(fd >= 0);
+		if(fd >= 0)
+			vfs_close(fd);
+		assert_equal(vfs_stat(EXT4_RW_MOUNT_PATH "/empty.bin", &st), 0);
+		assert_equal(st.st_size, 0);
+		assert_equal(vfs_unlink(EXT4_RW_MOUNT_PATH "/empty.bin"), 0);
+
+		ext4_rw_check_files();
+
+		/*
+		 * Remount, the counters on disk must match what the files hold, 6 more
+		 * blocks for 'ext.bin', 302 data and 3 map blocks for 'ind.bin' and 3
+		 * for 'trunc.bin'
+		 */
+		assert_equal(vfs_unmount(EXT4_RW_MOUNT_PATH), 0);
+		assert_equal(ext4_rw_free_blocks(rd), nfree - 6 - 305 - 3);
+		assert_equal(le32_to_cpu(ext4_rw_inode(rd, 14)->blockcnt), 14 * 2);
+		assert_equal(le32_to_cpu(ext4_rw_inode(rd, 15)->blockcnt), 305 * 2);
+		assert_equal(le32_to_cpu(ext4_rw_inode(rd, 16)->blockcnt), 3 * 2);
+		assert_true(le32_to_cpu(ext4_rw_inode(rd, 12)->flags) & EXT2_INDEX_FL);
+		assert_equal(vfs_mount("wbt-ext4-rw", EXT4_RW_MOUNT_PATH, "ext4", MOUNT_RW), 0);
+		ext4_rw_check_files();
+
+		/*
+		 * Names added to the htree go wherever there is room, which drops the
+		 * index. Directory links follow mkdir, rename and rmdir.
+		 */
+		for(i = 0; i < 24; i++)
+		{
+			snprintf(path, sizeof(path), EXT4_RW_MOUNT_PATH "/dir/created-with-a-long-name-%d", i);
+			assert_equal(ext4_rw_write(path, O_CREAT, 0, 1, i), 0);
+		}
+		for(i = 0; i < 24; i += 2)
+		{
+			snprintf(path, sizeof(path), EXT4_RW_MOUNT_PATH "/dir/created-with-a-long-name-%d", i);
+			assert_equal(vfs_unlink(path), 0);
+		}
+		assert_equal(vfs_mkdir(EXT4_RW_MOUNT_PATH "/dir/sub", 0755), 0);
+		assert_equal(vfs_mkdir(EXT4_RW_MOUNT_PATH "/sub", 0755), 0);
+		assert_equal(vfs_rename(EXT4_RW_MOUNT_PATH "/sub", EXT4_RW_MOUNT_PATH "/dir/moved"), 0);
+		assert_equal(vfs_rmdir(EXT4_RW_MOUNT_PATH "/dir/sub"), 0);
+		ext4_rw_check_dir();
+
+		assert_equal(vfs_unmount(EXT4_RW_MOUNT_PATH), 0);
+		assert_false(le32_to_cpu(ext4_rw_inode(rd, 12)->flags) & EXT2_INDEX_FL);
+		assert_equal(le16_to_cpu(ext4_rw_inode(rd, 2)->nlinks), 4);
+		assert_equal(le16_to_cpu(ext4_rw_inode(rd, 12)->nlinks), 3);
+		assert_equal(vfs_mount("wbt-ext4-rw", EXT4_RW_MOUNT_PATH, "ext4", MOUNT_RW), 0);
+		ext4_rw_check_dir();
+	}
+}
+
+static struct wboxtest_t wbt_ext4_rw = {
+	.group	= "vfs",
+	.name	= "ext4-rw",
+	.setup	= ext4_rw_setup,
+	.clean	= ext4_rw_clean,
+	.run	= ext4_rw_run,
+};
+
+static __init void ext4_rw_wbt_init(void)
+{
+	register_wboxtest(&wbt_ext4_rw);
+}
+
+static __exit void ext4_rw_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_ext4_rw);
+}
+
+wboxtest_initcall(ext4_rw_wbt_init);
+wboxtest_exitcall(ext4_rw_wbt_exit);
@@ -0,0 +1,702 @@
+/*
+ * wboxtest/vfs/ext4.c
+ */
+
+#include <wboxtest.h>
+#include <vfs/ext4/ext4-control.h>
+#include <vfs/ext4/ext4-node.h>
+
+#define EXT4_DISK_SIZE		(SZ_512K)
+#define EXT4_MOUNT_PATH		"/tmp/wbt-ext4"
+
+/*
+ * A 512K ext4 image with 1K blocks and metadata_csum, made on the host by
+ *
+ *   mke2fs -t ext4 -b 1024 -N 32 -O ^has_journal,^resize_inode img 512
+ *   debugfs -w -f cmds img
+ *   e2fsck -fyD img
+ *
+ * Block i of 'big.bin' and 'sparse.bin' is filled with (i * 31 + id) % 255 + 1,
+ * id being 1 and 2. The even pads written before 'big.bin' are removed, which
+ * splits its 32 blocks into 7 extents under a depth 1 tree. 'sparse.bin' has a
+ * hole at blocks 4 to 11, 'prealloc' is 8K of uninitialized extents, and 'dir'
+ * is an htree of 64 links to 'small.txt'. Zero runs are left out of the table.
+ */
+static const struct {
+	u32_t offset;
+	u16_t length;
+	s16_t fill;
+} ext4_image_runs[] = {
+	{ 0x00400,    1,   -1 },
+	{ 0x00405,   16,   -1 },
+	{ 0x00421,    8,   -1 },
+	{ 0x00430,   20,   -1 },
+	{ 0x0044c,    1,   -1 },
+	{ 0x00454,    1,   -1 },
+	{ 0x00459,   31,   -1 },
+	{ 0x004ec,   21,   -1 },
+	{ 0x00508,    4,   -1 },
+	{ 0x0055c,    5,   -1 },
+	{ 0x00574,    5,   -1 },
+	{ 0x00648,    1,   -1 },
+	{ 0x007fc,   21,   -1 },
+	{ 0x00818,    8,   -1 },
+	{ 0x00838,    4,   -1 },
+	{ 0x00c00,   12,   -1 },
+	{ 0x00c3f,    1,   -1 },
+	{ 0x00c40,  960,  255 },
+	{ 0x01000,  221,   -1 },
+	{ 0x013f8,   30,   -1 },
+	{ 0x017f8,    8,   -1 },
+	{ 0x01804,    2,   -1 },
+	{ 0x01bf8,    8,   -1 },
+	{ 0x01c04,    2,   -1 },
+	{ 0x01ff8,    8,   -1 },
+	{ 0x02004,    2,   -1 },
+	{ 0x023f8,    8,   -1 },
+	{ 0x02404,    2,   -1 },
+	{ 0x027f8,    8,   -1 },
+	{ 0x02804,    2,   -1 },
+	{ 0x02bf8,    8,   -1 },
+	{ 0x02c04,    2,   -1 },
+	{ 0x02ff8,    8,   -1 },
+	{ 0x03004,    2,   -1 },
+	{ 0x033f8,    8,   -1 },
+	{ 0x03404,    2,   -1 },
+	{ 0x037f8,    8,   -1 },
+	{ 0x03804,    2,   -1 },
+	{ 0x03bf8,    8,   -1 },
+	{ 0x03c04,    2,   -1 },
+	{ 0x03ff8,    8,   -1 },
+	{ 0x04004,    2,   -1 },
+	{ 0x043f8,   30,   -1 },
+	{ 0x0441c,   25,   -1 },
+	{ 0x047fc,  816,   -1 },
+	{ 0x04bf8,   12,   -1 },
+	{ 0x04c04, 1020,  255 },
+	{ 0x05000,  821,   -1 },
+	{ 0x053f8,  633,   -1 },
+	{ 0x057f8,   19,   -1 },
+	{ 0x05c00, 2048,    2 },
+	{ 0x06400, 1024,   33 },
+	{ 0x06800, 1024,    4 },
+	{ 0x06c00, 1024,   64 },
+	{ 0x07000, 1024,    6 },
+	{ 0x07400, 1024,   95 },
+	{ 0x07800, 1024,    8 },
+	{ 0x07c00, 1024,  126 },
+	{ 0x08000, 1025,   10 },
+	{ 0x08401,    4,   -1 },
+	{ 0x08410,   65,   -1 },
+	{ 0x087fc,    4,   -1 },
+	{ 0x08800, 1024,   12 },
+	{ 0x08c08,   12,   -1 },
+	{ 0x08c7c,    2,   -1 },
+	{ 0x08d00,   20,   -1 },
+	{ 0x08d1a,    3,   -1 },
+	{ 0x08d22,    1,   -1 },
+	{ 0x08d28,    5,   -1 },
+	{ 0x08d38,    5,   -1 },
+	{ 0x08d7c,    8,   -1 },
+	{ 0x08d90,    4,   -1 },
+	{ 0x08e7c,    2,   -1 },
+	{ 0x08f7c,    2,   -1 },
+	{ 0x0907c,    2,   -1 },
+	{ 0x0917c,    2,   -1 },
+	{ 0x0927c,    2,   -1 },
+	{ 0x0937c,    2,   -1 },
+	{ 0x0947c,    2,   -1 },
+	{ 0x0957c,    2,   -1 },
+	{ 0x09600,   20,   -1 },
+	{ 0x0961a,    3,   -1 },
+	{ 0x09622,    1,   -1 },
+	{ 0x09628,    5,   -1 },
+	{ 0x09638,    5,   -1 },
+	{ 0x0967c,    8,   -1 },
+	{ 0x09690,    4,   -1 },
+	{ 0x09700,   20,   -1 },
+	{ 0x0971a,    3,   -1 },
+	{ 0x09721,    2,   -1 },
+	{ 0x09728,    5,   -1 },
+	{ 0x09738,   17,   -1 },
+	{ 0x0977c,    8,   -1 },
+	{ 0x09790,    4,   -1 },
+	{ 0x09800,   20,   -1 },
+	{ 0x0981a,    3,   -1 },
+	{ 0x09822,    1,   -1 },
+	{ 0x09828,    5,   -1 },
+	{ 0x09838,    5,   -1 },
+	{ 0x0987c,    8,   -1 },
+	{ 0x09890,    4,   -1 },
+	{ 0x09900,   20,   -1 },
+	{ 0x0991a,    3,   -1 },
+	{ 0x09922,    1,   -1 },
+	{ 0x09928,    7,   -1 },
+	{ 0x09938,    1,   -1 },
+	{ 0x09940,   33,   -1 },
+	{ 0x0997c,    8,   -1 },
+	{ 0x09990,    4,   -1 },
+	{ 0x09a00,   20,   -1 },
+	{ 0x09a1a,    3,   -1 },
+	{ 0x09a22,    1,   -1 },
+	{ 0x09a28,    5,   -1 },
+	{ 0x09a38,    5,   -1 },
+	{ 0x09a7c,    8,   -1 },
+	{ 0x09a90,    4,   -1 },
+	{ 0x09b00,   20,   -1 },
+	{ 0x09b1a,    3,   -1 },
+	{ 0x09b22,    1,   -1 },
+	{ 0x09b28,    5,   -1 },
+	{ 0x09b38,   17,   -1 },
+	{ 0x09b7c,    8,   -1 },
+	{ 0x09b90,    4,   -1 },
+	{ 0x09c00,   20,   -1 },
+	{ 0x09c1a,    3,   -1 },
+	{ 0x09c22,    1,   -1 },
+	{ 0x09c28,    5,   -1 },
+	{ 0x09c38,    5,   -1 },
+	{ 0x09c7c,    8,   -1 },
+	{ 0x09c90,    4,   -1 },
+	{ 0x09d00,   20,   -1 },
+	{ 0x09d1a,    3,   -1 },
+	{ 0x09d22,    1,   -1 },
+	{ 0x09d28,    5,   -1 },
+	{ 0x09d38,    5,   -1 },
+	{ 0x09d7c,    8,   -1 },
+	{ 0x09d90,    4,   -1 },
+	{ 0x09e00,   20,   -1 },
+	{ 0x09e1a,    3,   -1 },
+	{ 0x09e22,    1,   -1 },
+	{ 0x09e28,    5,   -1 },
+	{ 0x09e38,    5,   -1 },
+	{ 0x09e7c,    8,   -1 },
+	{ 0x09e90,    4,   -1 },
+	{ 0x09f00,   24,   -1 },
+	{ 0x09f1c,    1,   -1 },
+	{ 0x09f22,    1,   -1 },
+	{ 0x09f28,    5,   -1 },
+	{ 0x09f38,    5,   -1 },
+	{ 0x09f7c,    8,   -1 },
+	{ 0x09f90,    4,   -1 },
+	{ 0x0a000,   20,   -1 },
+	{ 0x0a01a,    3,   -1 },
+	{ 0x0a022,    1,   -1 },
+	{ 0x0a028,    5,   -1 },
+	{ 0x0a038,    5,   -1 },
+	{ 0x0a07c,    8,   -1 },
+	{ 0x0a090,    4,   -1 },
+	{ 0x0a100,   24,   -1 },
+	{ 0x0a11c,    1,   -1 },
+	{ 0x0a122,    1,   -1 },
+	{ 0x0a128,    5,   -1 },
+	{ 0x0a138,    5,   -1 },
+	{ 0x0a17c,    8,   -1 },
+	{ 0x0a190,    4,   -1 },
+	{ 0x0a200,   20,   -1 },
+	{ 0x0a21a,    3,   -1 },
+	{ 0x0a222,    1,   -1 },
+	{ 0x0a228,    5,   -1 },
+	{ 0x0a238,    5,   -1 },
+	{ 0x0a27c,    8,   -1 },
+	{ 0x0a290,    4,   -1 },
+	{ 0x0a300,   24,   -1 },
+	{ 0x0a31c,    1,   -1 },
+	{ 0x0a322,    1,   -1 },
+	{ 0x0a328,    5,   -1 },
+	{ 0x0a338,    5,   -1 },
+	{ 0x0a37c,    8,   -1 },
+	{ 0x0a390,    4,   -1 },
+	{ 0x0a400,   20,   -1 },
+	{ 0x0a41a,    3,   -1 },
+	{ 0x0a422,    1,   -1 },
+	{ 0x0a428,    5,   -1 },
+	{ 0x0a438,    5,   -1 },
+	{ 0x0a47c,    8,   -1 },
+	{ 0x0a490,    4,   -1 },
+	{ 0x0ac00, 1024,  157 },
+	{ 0x0b000, 1024,  188 },
+	{ 0x0b400, 1024,  219 },
+	{ 0x0b800, 1024,  250 },
+	{ 0x0bc00, 1024,   26 },
+	{ 0x0c000, 1024,   57 },
+	{ 0x0c400, 1024,   88 },
+	{ 0x0c800, 1024,  119 },
+	{ 0x0cc00, 1024,  150 },
+	{ 0x0d000, 1024,  181 },
+	{ 0x0d400, 1024,  212 },
+	{ 0x0d800, 1024,  243 },
+	{ 0x0dc00, 1024,   19 },
+	{ 0x0e000, 1024,   50 },
+	{ 0x0e400, 1024,   81 },
+	{ 0x0e800, 1024,  112 },
+	{ 0x0ec00, 1024,  143 },
+	{ 0x0f000, 1024,  174 },
+	{ 0x0f400, 1024,  205 },
+	{ 0x0f800, 1024,  236 },
+	{ 0x0fc00, 1024,   12 },
+	{ 0x10000, 1024,   43 },
+	{ 0x10400, 1024,   74 },
+	{ 0x10800, 1024,  105 },
+	{ 0x10c00, 1024,  136 },
+	{ 0x11000, 1024,  167 },
+	{ 0x11400, 1024,  198 },
+	{ 0x11800, 1024,    3 },
+	{ 0x11c00, 1024,   34 },
+	{ 0x12000, 1024,   65 },
+	{ 0x12400, 1024,   96 },
+	{ 0x12800, 1024,  120 },
+	{ 0x12c00, 1024,  151 },
+	{ 0x13000, 1024,  182 },
+	{ 0x13400, 1024,  213 },
+	{ 0x13800, 1024,  244 },
+	{ 0x13c00, 1024,   20 },
+	{ 0x14000, 1024,   51 },
+	{ 0x14400, 1024,   82 },
+};
+
+static const u8_t ext4_image_bytes[] = {
+	0x20, 0x02, 0x00, 0x00, 0x19, 0x00, 0x00, 0x00, 0xa6, 0x01, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00,
+	0x01, 0x20, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x20, 0x9f, 0x85, 0xd5, 0x6a, 0x00, 0x00, 0xff,
+	0xff, 0x53, 0xef, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x0b, 0x01,
+	0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0xc2, 0x02, 0x00, 0x00, 0x6b, 0x04, 0x00, 0x00, 0x0e, 0x12,
+	0x49, 0x6a, 0x22, 0x89, 0x41, 0xa2, 0x8b, 0x38, 0x8f, 0x18, 0x7b, 0xf5, 0x94, 0x70, 0xca, 0x08,
+	0x3d, 0x30, 0x4f, 0xbd, 0x47, 0xf0, 0x9b, 0x49, 0xd9, 0xd3, 0x60, 0x7d, 0x19, 0x2e, 0x01, 0x00,
+	0x40, 0x00, 0x0c, 0x9f, 0x85, 0xd5, 0x6a, 0x20, 0x00, 0x20, 0x00, 0x01, 0x04, 0x01, 0x00, 0x00,
+	0x7b, 0x0d, 0xb6, 0xf6, 0xbd, 0xf8, 0x03, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x23, 0x00,
+	0x00, 0x00, 0xa6, 0x01, 0x0a, 0x00, 0x03, 0xda, 0x58, 0x0e, 0xa0, 0x07, 0x00, 0xa2, 0xf0, 0xa5,
+	0xca, 0xd3, 0xd7, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0x80,
+	0x02, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x01, 0x02, 0x2e, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+	0x0c, 0x00, 0x02, 0x02, 0x2e, 0x2e, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x14, 0x00, 0x0a, 0x02,
+	0x6c, 0x6f, 0x73, 0x74, 0x2b, 0x66, 0x6f, 0x75, 0x6e, 0x64, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00,
+	0x0c, 0x00, 0x03, 0x02, 0x64, 0x69, 0x72, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x14, 0x00, 0x09, 0x01,
+	0x73, 0x6d, 0x61, 0x6c, 0x6c, 0x2e, 0x74, 0x78, 0x74, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00,
+	0x10, 0x00, 0x07, 0x01, 0x62, 0x69, 0x67, 0x2e, 0x62, 0x69, 0x6e, 0x00, 0x0f, 0x00, 0x00, 0x00,
+	0x10, 0x00, 0x05, 0x01, 0x70, 0x61, 0x64, 0x30, 0x31, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+	0x14, 0x00, 0x0a, 0x01, 0x73, 0x70, 0x61, 0x72, 0x73, 0x65, 0x2e, 0x62, 0x69, 0x6e, 0x00, 0x00,
+	0x11, 0x00, 0x00, 0x00, 0x10, 0x00, 0x05, 0x01, 0x70, 0x61, 0x64, 0x30, 0x33, 0x00, 0x00, 0x00,
+	0x12, 0x00, 0x00, 0x00, 0x10, 0x00, 0x08, 0x01, 0x70, 0x72, 0x65, 0x61, 0x6c, 0x6c, 0x6f, 0x63,
+	0x13, 0x00, 0x00, 0x00, 0x10, 0x00, 0x05, 0x01, 0x70, 0x61, 0x64, 0x30, 0x35, 0x00, 0x00, 0x00,
+	0x15, 0x00, 0x00, 0x00, 0x10, 0x00, 0x05, 0x01, 0x70, 0x61, 0x64, 0x30, 0x37, 0x00, 0x00, 0x00,
+	0x17, 0x00, 0x00, 0x00, 0x10, 0x00, 0x05, 0x01, 0x70, 0x61, 0x64, 0x30, 0x39, 0x00, 0x00, 0x00,
+	0x19, 0x00, 0x00, 0x00, 0x24, 0x03, 0x05, 0x01, 0x70, 0x61, 0x64, 0x31, 0x31, 0x0c, 0x00, 0x00,
+	0xde, 0xa6, 0x61, 0xca, 0xdd, 0x0b, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x01, 0x02, 0x2e, 0x00, 0x00,
+	0x00, 0x02, 0x00, 0x00, 0x00, 0xe8, 0x03, 0x02, 0x02, 0x2e, 0x2e, 0x0c, 0x00, 0x00, 0xde, 0x82,
+	0x9f, 0x18, 0x70, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c,
+	0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd,
+	0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00,
+	0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4,
+	0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc,
+	0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c,
+	0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd, 0x84, 0xf4, 0x03, 0x0c, 0x00, 0x00, 0xde, 0xfc, 0xae, 0xcd,
+	0x84, 0x0c, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x01, 0x02, 0x2e, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+	0x00, 0xf4, 0x03, 0x02, 0x02, 0x2e, 0x2e, 0x01, 0x08, 0x00, 0x00, 0x7b, 0x00, 0x03, 0x00, 0x01,
+	0x00, 0x00, 0x00, 0x2e, 0x26, 0x20, 0x56, 0x02, 0x00, 0x00, 0x00, 0x3a, 0xec, 0xd3, 0xb8, 0x03,
+	0x2b, 0x42, 0x66, 0xc3, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x39, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x31, 0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x30, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35,
+	0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x31, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x31, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x39, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31,
+	0x36, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x34, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x36, 0x31, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35,
+	0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x32, 0x36, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x36, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x34, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34,
+	0x31, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x33, 0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x32, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0xe8, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x37,
+	0x0c, 0x00, 0x00, 0xde, 0xb8, 0x2e, 0xa5, 0x1f, 0xff, 0xff, 0x57, 0x01, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x35, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35,
+	0x31, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x34, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x34, 0x34, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x36, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31,
+	0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x33, 0x36, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x37, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35,
+	0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x31, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x30, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32,
+	0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x35, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x33, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33,
+	0x38, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72,
+	0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61,
+	0x6d, 0x65, 0x2d, 0x35, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01,
+	0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e,
+	0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x37, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,
+	0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61,
+	0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x31, 0x31, 0x00, 0x00, 0x00,
+	0x0d, 0x00, 0x00, 0x00, 0xe0, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69,
+	0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32,
+	0x31, 0x0c, 0x00, 0x00, 0xde, 0x85, 0x20, 0xb8, 0x7d, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x35, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x32, 0x30, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x30, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x38, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x33, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x34, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x38, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x36, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x35, 0x39, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x32, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x36, 0x32, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00,
+	0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d,
+	0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x34, 0x32, 0x00, 0x00,
+	0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77,
+	0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d,
+	0x33, 0x35, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x19, 0x01, 0x65, 0x6e, 0x74,
+	0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f, 0x6e, 0x67, 0x2d, 0x6e,
+	0x61, 0x6d, 0x65, 0x2d, 0x36, 0x33, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x18,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x36, 0x0d, 0x00, 0x00, 0x00, 0xa4, 0x01, 0x19,
+	0x01, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x2d, 0x77, 0x69, 0x74, 0x68, 0x2d, 0x61, 0x2d, 0x6c, 0x6f,
+	0x6e, 0x67, 0x2d, 0x6e, 0x61, 0x6d, 0x65, 0x2d, 0x33, 0x31, 0x0c, 0x00, 0x00, 0xde, 0xc6, 0x4b,
+	0xf1, 0x82, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x65, 0x78, 0x74, 0x34, 0x0a, 0xf3, 0x06, 0x00,
+	0x54, 0x01, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+	0x00, 0x19, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x00,
+	0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x1d, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+	0x00, 0x01, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x00,
+	0x00, 0x2b, 0x34, 0x69, 0x99, 0x31, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85,
+	0xd5, 0x6a, 0xda, 0x47, 0xed, 0x41, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a,
+	0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x04, 0x00, 0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00,
+	0x04, 0x01, 0x00, 0x00, 0x00, 0x04, 0x35, 0x89, 0x00, 0x00, 0x20, 0x00, 0xf1, 0x09, 0x9f, 0x85,
+	0xd5, 0x6a, 0xe2, 0x19, 0x08, 0xbe, 0x46, 0x84, 0x94, 0xca, 0xda, 0xf0, 0x40, 0x85, 0x0e, 0xbf,
+	0xdc, 0xf1, 0xc0, 0x41, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85,
+	0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x02, 0x00, 0x18, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x0c,
+	0x00, 0x00, 0x00, 0x05, 0x3c, 0x3b, 0x00, 0x00, 0x20, 0x00, 0x18, 0xad, 0x9f, 0x85, 0xd5, 0x6a,
+	0xed, 0x41, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a,
+	0x9f, 0x85, 0xd5, 0x6a, 0x02, 0x00, 0x08, 0x10, 0x08, 0x0a, 0xf3, 0x02, 0x00, 0x04, 0x02, 0x00,
+	0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x14, 0xf0,
+	0x66, 0x00, 0x00, 0x20, 0x00, 0xc5, 0x67, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x0b,
+	0x00, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x41,
+	0x00, 0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x16, 0xae, 0x2b, 0x00,
+	0x00, 0x20, 0x00, 0xb0, 0x53, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x80, 0x00,
+	0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00, 0x42,
+	0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x00, 0x01, 0x21, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+	0x00, 0x19, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x00,
+	0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x1d, 0x54, 0x70, 0x00, 0x00, 0x20, 0x00,
+	0x21, 0x64, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85,
+	0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00, 0x02, 0x08, 0x0a, 0xf3,
+	0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x18, 0xc6, 0x28, 0x00, 0x00, 0x20, 0x00, 0x1c, 0xcf,
+	0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a,
+	0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00, 0x18, 0x08, 0x0a, 0xf3, 0x02, 0x00,
+	0x04, 0x04, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00,
+	0x00, 0x4a, 0xe9, 0xb8, 0x00, 0x00, 0x20, 0x00, 0xa0, 0x11, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81,
+	0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85,
+	0xd5, 0x6a, 0x01, 0x00, 0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x1a,
+	0xe7, 0xc2, 0x00, 0x00, 0x20, 0x00, 0x67, 0x2e, 0x9f, 0x85, 0xd5, 0x6a, 0xb6, 0x81, 0x00, 0x00,
+	0x00, 0x20, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a,
+	0x01, 0x00, 0x10, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x08, 0x80, 0x00, 0x00, 0x52, 0x27, 0x0c,
+	0x00, 0x00, 0x20, 0x00, 0x68, 0xc6, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04,
+	0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00,
+	0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x1c, 0xa6, 0x58, 0x00, 0x00,
+	0x20, 0x00, 0x54, 0x10, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+	0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a,
+	0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x1d, 0x9e, 0xda, 0x00, 0x00,
+	0x20, 0x00, 0x00, 0x93, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00,
+	0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00, 0x02, 0x08,
+	0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x1e, 0xe6, 0xb2, 0x00, 0x00, 0x20, 0x00,
+	0x69, 0xba, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85,
+	0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x02, 0x08,
+	0x0a, 0xf3, 0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x1f, 0xe6, 0xd9, 0x00, 0x00, 0x20, 0x00,
+	0xf1, 0x5b, 0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85,
+	0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00, 0x02, 0x08, 0x0a, 0xf3,
+	0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x20, 0xcc, 0x1a, 0x00, 0x00, 0x20, 0x00, 0x9c, 0x16,
+	0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a,
+	0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x02, 0x08, 0x0a, 0xf3,
+	0x01, 0x00, 0x04, 0x01, 0x00, 0x00, 0x00, 0x21, 0x84, 0x4a, 0x00, 0x00, 0x20, 0x00, 0x51, 0x50,
+	0x9f, 0x85, 0xd5, 0x6a, 0xa4, 0x81, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x9f, 0x85, 0xd5, 0x6a,
+	0x9f, 0x85, 0xd5, 0x6a, 0x9f, 0x85, 0xd5, 0x6a, 0x01, 0x00, 0x02, 0x08, 0x0a, 0xf3, 0x01, 0x00,
+	0x04, 0x01, 0x00, 0x00, 0x00, 0x22, 0xfc, 0x22, 0x00, 0x00, 0x20, 0x00, 0x38, 0x79, 0x9f, 0x85,
+	0xd5, 0x6a,
+};
+
+/*
+ * Directory hashes from 'debugfs -R "dx_hash -h alg -s seed name"' on the host,
+ * with no seed and with 6bf5a0f3-1b1e-4bd3-9b5d-93d5e8f42c11. Names over 16 and
+ * 32 bytes take more than one tea and half_md4 round, and the unsigned variants
+ * only differ on bytes above 0x7f.
+ */
+static const u8_t ext4_dx_seed[16] = {
+	0x6b, 0xf5, 0xa0, 0xf3, 0x1b, 0x1e, 0x4b, 0xd3, 0x9b, 0x5d, 0x93, 0xd5, 0xe8, 0xf4, 0x2c, 0x11,
+};
+
+static const struct {
+	int version;
+	int seeded;
+	const char * name;
+	u32_t hash;
+} ext4_dx_hashes[] = {
+	{ EXT2_HASH_LEGACY, 0, "a", 0xe74b53e2 },
+	{ EXT2_HASH_LEGACY, 0, "hello", 0x32252546 },
+	{ EXT2_HASH_LEGACY, 1, "entry-with-a-long-name-that-is-longer-than-32-bytes", 0xe4de6824 },
+	{ EXT2_HASH_LEGACY, 1, "caf\xe9-\xff\x80", 0xf7caf538 },
+	{ EXT2_HASH_LEGACY_UNSIGNED, 1, "caf\xe9-\xff\x80", 0x48e56128 },
+	{ EXT2_HASH_HALF_MD4, 0, "hello", 0x1746da32 },
+	{ EXT2_HASH_HALF_MD4, 0, "0123456789abcdef0123456789abcdef", 0x36184620 },
+	{ EXT2_HASH_HALF_MD4, 0, "entry-with-a-long-name-that-is-longer-than-32-bytes", 0x29f2917a },
+	{ EXT2_HASH_HALF_MD4, 1, "a", 0xf024c13e },
+	{ EXT2_HASH_HALF_MD4, 1, "entry-with-a-long-name-that-is-longer-than-32-bytes", 0x5883837e },
+	{ EXT2_HASH_HALF_MD4, 1, "caf\xe9-\xff\x80", 0x16a97b5e },
+	{ EXT2_HASH_HALF_MD4_UNSIGNED, 1, "caf\xe9-\xff\x80", 0xceebdb48 },
+	{ EXT2_HASH_TEA, 0, "0123456789abcdef", 0x5a0788b2 },
+	{ EXT2_HASH_TEA, 0, "0123456789abcdef0123456789abcdef", 0xcbe95e3c },
+	{ EXT2_HASH_TEA, 1, "hello", 0xdc68754c },
+	{ EXT2_HASH_TEA, 1, "entry-with-a-long-name-that-is-longer-than-32-bytes", 0x9c49fb04 },
+	{ EXT2_HASH_TEA, 1, "caf\xe9-\xff\x80", 0x9c219f5e },
+	{ EXT2_HASH_TEA_UNSIGNED, 1, "caf\xe9-\xff\x80", 0xdde5e312 },
+};
+
+static u8_t ext4_pattern(int blk, int id)
+{
+	return (blk * 31 + id) % 255 + 1;
+}
+
+static void * ext4_setup(struct wboxtest_t * wbt)
+{
+	struct wboxtest_ramdisk_t * rd;
+	const u8_t * p = ext4_image_bytes;
+	int i;
+
+	rd = wboxtest_ramdisk_alloc("wbt-ext4", EXT4_DISK_SIZE, 0);
+	if(!rd)
+		return NULL;
+	for(i = 0; i < ARRAY_SIZE(ext4_image_runs); i++)
+	{
+		if(ext4_image_runs[i].fill < 0)
+		{
+			memcpy(&rd->rambuf[ext4_image_runs[i].offset], p, ext4_image_runs[i].length);
+			p += ext4_image_runs[i].length;
+		}
+		else
+			memset(&rd->rambuf[ext4_image_runs[i].offset], ext4_image_runs[i].fill, ext4_image_runs[i].length);
+	}
+
+	vfs_mkdir(EXT4_MOUNT_PATH, 0755);
+	if(vfs_mount("wbt-ext4", EXT4_MOUNT_PATH, "ext4", MOUNT_RW) != 0)
+	{
+		vfs_rmdir(EXT4_MOUNT_PATH);
+		wboxtest_ramdisk_free(rd);
+		return NULL;
+	}
+	return rd;
+}
+
+static void ext4_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)data;
+
+	if(rd)
+	{
+		vfs_unmount(EXT4_MOUNT_PATH);
+		vfs_rmdir(EXT4_MOUNT_PATH);
+		wboxtest_ramdisk_free(rd);
+	}
+}
+
+static void ext4_check_file(const char * path, int nblk, int id, int hole, int nhole)
+{
+	struct vfs_stat_t st;
+	u8_t * buf;
+	s64_t off;
+	int fd, len, i;
+
+	buf = malloc(nblk * SZ_1K);
+	if(!buf)
+		return;
+	assert_equal(vfs_stat(path, &st), 0);
+	assert_equal(st.st_size, nblk * SZ_1K);
+	fd = vfs_open(path, O_RDONLY, 0);
+	assert_true(fd >= 0);
+	if(fd >= 0)
+	{
+		assert_equal(vfs_read(fd, buf, nblk * SZ_1K), nblk * SZ_1K);
+		for(i = 0; i < nblk * SZ_1K; i++)
+		{
+			if(buf[i] != (((i / SZ_1K) >= hole) && ((i / SZ_1K) < hole + nhole) ? 0 : ext4_pattern(i / SZ_1K, id)))
+				break;
+		}
+		assert_equal(i, nblk * SZ_1K);
+
+		/*
+		 * Unaligned reads crossing extent boundaries
+		 */
+		for(i = 0; i < 64; i++)
+		{
+			off = wboxtest_random_int(0, nblk * SZ_1K - 1);
+			len = wboxtest_random_int(1, nblk * SZ_1K - off);
+			memset(buf, 0x5a, len);
+			assert_equal(vfs_pread(fd, buf, len, off), len);
+			assert_equal(buf[0], ((off / SZ_1K) >= hole) && ((off / SZ_1K) < hole + nhole) ? 0 : ext4_pattern(off / SZ_1K, id));
+			assert_equal(buf[len - 1], (((off + len - 1) / SZ_1K) >= hole) && (((off + len - 1) / SZ_1K) < hole + nhole) ? 0 : ext4_pattern((off + len - 1) / SZ_1K, id));
+		}
+		vfs_close(fd);
+	}
+	free(buf);
+}
+
+static void ext4_run(struct wboxtest_t * wbt, void * data)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)data;
+	struct ext4fs_control_t * ctrl;
+	char path[VFS_MAX_PATH];
+	char buf[SZ_8K];
+	int fd, i;
+
+	if(rd)
+	{
+		ext4_check_file(EXT4_MOUNT_PATH "/big.bin", 32, 1, 0, 0);
+		ext4_check_file(EXT4_MOUNT_PATH "/sparse.bin", 20, 2, 4, 8);
+
+		fd = vfs_open(EXT4_MOUNT_PATH "/prealloc", O_RDONLY, 0);
+		assert_true(fd >= 0);
+		if(fd >= 0)
+		{
+			memset(buf, 0x5a, SZ_8K);
+			assert_equal(vfs_read(fd, buf, SZ_8K), SZ_8K);
+			for(i = 0; (i < SZ_8K) && (buf[i] == 0); i++);
+			assert_equal(i, SZ_8K);
+			vfs_close(fd);
+		}
+
+		fd = vfs_open(EXT4_MOUNT_PATH "/small.txt", O_RDONLY, 0);
+		assert_true(fd >= 0);
+		if(fd >= 0)
+		{
+			memset(buf, 0, 32);
+			assert_equal(vfs_read(fd, buf, 32), 11);
+			assert_string_equal(buf, "hello ext4\n");
+			vfs_close(fd);
+		}
+
+		for(i = 0; i < 64; i++)
+		{
+			snprintf(path, sizeof(path), EXT4_MOUNT_PATH "/dir/entry-with-a-long-name-%d", i);
+			assert_equal(vfs_access(path, R_OK), 0);
+		}
+		assert_not_equal(vfs_access(EXT4_MOUNT_PATH "/dir/entry-with-a-long-name-64", R_OK), 0);
+
+		ctrl = malloc(sizeof(struct ext4fs_control_t));
+		if(ctrl)
+		{
+			for(i = 0; i < ARRAY_SIZE(ext4_dx_hashes); i++)
+			{
+				memset(ctrl, 0, sizeof(struct ext4fs_control_t));
+				if(ext4_dx_hashes[i].seeded)
+					memcpy(ctrl->sblock.hash_seed, ext4_dx_seed, sizeof(ext4_dx_seed));
+				assert_equal(ext4fs_dx_hash(ctrl, ext4_dx_hashes[i].version, ext4_dx_hashes[i].name, strlen(ext4_dx_hashes[i].name)), ext4_dx_hashes[i].hash);
+			}
+			free(ctrl);
+		}
+
+		/*
+		 * Checksummed volumes fall back to read only
+		 */
+		assert_true(vfs_open(EXT4_MOUNT_PATH "/small.txt", O_WRONLY, 0) < 0);
+		assert_not_equal(vfs_mkdir(EXT4_MOUNT_PATH "/new", 0755), 0);
+	}
+}
+
+static struct wboxtest_t wbt_ext4 = {
+	.group	= "vfs",
+	.name	= "ext4",
+	.setup	= ext4_setup,
+	.clean	= ext4_clean,
+	.run	= ext4_run,
+};
+
+static __init void ext4_wbt_init(void)
+{
+	register_wboxtest(&wbt_ext4);
+}
+
+static __exit void ext4_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_ext4);
+}
+
+wboxtest_initcall(ext4_wbt_init);
+wboxtest_exitcall(ext4_wbt_exit);
@@ -0,0 +1,84 @@
+/*
+ * wboxtest/vfs/romdisk.c
+ */
+
+#include <wboxtest.h>
+
+extern unsigned char __romdisk_start;
+extern unsigned char __romdisk_end;
+
+/*
+ * Packed uncompressed by 'ROMDISK_RAW' in the Makefile
+ */
+static const char * romdisk_raw_files[] = {
+	"/framework/assets/fonts/Roboto-Regular.ttf",
+	"/framework/assets/fonts/Roboto-Bold.ttf",
+	"/framework/assets/fonts/Roboto-Italic.ttf",
+	"/framework/assets/fonts/Roboto-BoldItalic.ttf",
+};
+
+static void * romdisk_setup(struct wboxtest_t * wbt)
+{
+	return NULL;
+}
+
+static void romdisk_clean(struct wboxtest_t * wbt, void * data)
+{
+}
+
+static void romdisk_run(struct wboxtest_t * wbt, void * data)
+{
+	struct vfs_stat_t st;
+	unsigned char * addr, * buf;
+	int fd, i;
+
+	for(i = 0; i < ARRAY_SIZE(romdisk_raw_files); i++)
+	{
+		fd = vfs_open(romdisk_raw_files[i], O_RDONLY, 0);
+		assert_true(fd >= 0);
+		if(fd < 0)
+			continue;
+		assert_equal(vfs_fstat(fd, &st), 0);
+		assert_true(st.st_size > SZ_32K);
+
+		/*
+		 * The whole file, over several chunks, is addressed in the image itself
+		 */
+		addr = vfs_mmap_direct(fd, 0, st.st_size);
+		assert_not_null(addr);
+		if(addr)
+		{
+			assert_true((addr >= &__romdisk_start) && (addr + st.st_size <= &__romdisk_end));
+			buf = malloc(st.st_size);
+			if(buf)
+			{
+				assert_equal(vfs_read(fd, buf, st.st_size), st.st_size);
+				assert_memory_equal(addr, buf, st.st_size);
+				free(buf);
+			}
+			vfs_munmap(addr);
+		}
+		vfs_close(fd);
+	}
+}
+
+static struct wboxtest_t wbt_romdisk = {
+	.group	= "vfs",
+	.name	= "romdisk",
+	.setup	= romdisk_setup,
+	.clean	= romdisk_clean,
+	.run	= romdisk_run,
+};
+
+static __init void romdisk_wbt_init(void)
+{
+	register_wboxtest(&wbt_romdisk);
+}
+
+static __exit void romdisk_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_romdisk);
+}
+
+wboxtest_initcall(romdisk_wbt_init);
+wboxtest_exitcall(romdisk_wbt_exit);
@@ -0,0 +1,291 @@
+/*
+ * wboxtest/vfs/rw.c
+ */
+
+#include <wboxtest.h>
+
+#define RW_PATH			"/tmp/wbt-rw"
+#define RW_MOUNT_PATH	"/tmp/wbt-rw/mnt"
+#define RW_SIZE			(10000)
+
+static inline u8_t rw_data(s64_t i)
+{
+	return (i * 7 + i / 251) & 0xff;
+}
+
+static int rw_match(const u8_t * buf, s64_t off, s64_t len)
+{
+	s64_t i;
+
+	for(i = 0; i < len; i++)
+	{
+		if(buf[i] != rw_data(off + i))
+			return 0;
+	}
+	return 1;
+}
+
+static int rw_zero(const u8_t * buf, s64_t len)
+{
+	s64_t i;
+
+	for(i = 0; i < len; i++)
+	{
+		if(buf[i] != 0)
+			return 0;
+	}
+	return 1;
+}
+
+static s64_t rw_size(int fd)
+{
+	struct vfs_stat_t st;
+
+	if(vfs_fstat(fd, &st) < 0)
+		return -1;
+	return st.st_size;
+}
+
+/*
+ * A file of RW_SIZE bytes, with a hole from 4000 to 6000
+ */
+static int rw_make(const char * path, u8_t * buf)
+{
+	s64_t i;
+	int fd, ok;
+
+	for(i = 0; i < RW_SIZE; i++)
+		buf[i] = rw_data(i);
+	fd = vfs_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		return 0;
+	ok = (vfs_pwrite(fd, &buf[0], 4000, 0) == 4000) && (vfs_pwrite(fd, &buf[6000], RW_SIZE - 6000, 6000) == RW_SIZE - 6000);
+	vfs_close(fd);
+	return ok;
+}
+
+static void * rw_setup(struct wboxtest_t * wbt)
+{
+	if(vfs_mkdir(RW_PATH, 0755) != 0)
+		return NULL;
+	vfs_mkdir(RW_MOUNT_PATH, 0755);
+	if(vfs_mount(NULL, RW_MOUNT_PATH, "ram", MOUNT_RW) != 0)
+	{
+		vfs_rmdir(RW_MOUNT_PATH);
+		vfs_rmdir(RW_PATH);
+		return NULL;
+	}
+	return (void *)1;
+}
+
+static void rw_clean(struct wboxtest_t * wbt, void * data)
+{
+	if(data)
+	{
+		vfs_unlink(RW_MOUNT_PATH "/dst");
+		vfs_unmount(RW_MOUNT_PATH);
+		vfs_rmdir(RW_MOUNT_PATH);
+		vfs_unlink(RW_PATH "/src");
+		vfs_unlink(RW_PATH "/dst");
+		vfs_rmdir(RW_PATH);
+	}
+}
+
+static void rw_run(struct wboxtest_t * wbt, void * data)
+{
+	struct vfs_iovec_t iov[3];
+	u8_t * buf, * tmp;
+	s64_t offin, offout;
+	int fd, fi, fo;
+
+	if(!data)
+		return;
+	buf = malloc(RW_SIZE * 2);
+	if(!buf)
+		return;
+	tmp = &buf[RW_SIZE];
+	assert_true(rw_make(RW_PATH "/src", buf));
+
+	/*
+	 * pread and pwrite leave the file offset alone, also past the end
+	 */
+	fd = vfs_open(RW_PATH "/src", O_RDWR, 0);
+	assert_true(fd >= 0);
+	if(fd >= 0)
+	{
+		assert_equal(rw_size(fd), RW_SIZE);
+		assert_equal(vfs_lseek(fd, 10, VFS_SEEK_SET), 10);
+		assert_equal(vfs_pread(fd, tmp, 100, 3000), 100);
+		assert_true(rw_match(tmp, 3000, 100));
+		assert_equal(vfs_pread(fd, tmp, 100, 4500), 100);
+		assert_true(rw_zero(tmp, 100));
+		assert_equal(vfs_pread(fd, tmp, 100, RW_SIZE - 40), 40);
+		assert_equal(vfs_pread(fd, tmp, 100, RW_SIZE), 0);
+		assert_equal(vfs_lseek(fd, 0, VFS_SEEK_CUR), 10);
+		assert_equal(vfs_pwrite(fd, &buf[RW_SIZE - 200], 200, RW_SIZE + 100), 200);
+		assert_equal(rw_size(fd), RW_SIZE + 300);
+		assert_equal(vfs_lseek(fd, 0, VFS_SEEK_CUR), 10);
+		assert_equal(vfs_read(fd, tmp, 20), 20);
+		assert_true(rw_match(tmp, 10, 20));
+		assert_equal(vfs_lseek(fd, 0, VFS_SEEK_CUR), 30);
+		vfs_close(fd);
+	}
+	assert_true(rw_make(RW_PATH "/src", buf));
+
+	/*
+	 * readv fills the vectors in turn and stops at the short one
+	 */
+	fd = vfs_open(RW_PATH "/src", O_RDONLY, 0);
+	assert_true(fd >= 0);
+	if(fd >= 0)
+	{
+		assert_equal(vfs_lseek(fd, RW_SIZE - 100, VFS_SEEK_SET), RW_SIZE - 100);
+		memset(tmp, 0xa5, 200);
+		iov[0].iov_base = &tmp[0];
+		iov[0].iov_len = 60;
+		iov[1].iov_base = &tmp[60];
+		iov[1].iov_len = 60;
+		iov[2].iov_base = &tmp[120];
+		iov[2].iov_len = 10;
+		assert_equal(vfs_readv(fd, iov, 3), 100);
+		assert_true(rw_match(tmp, RW_SIZE - 100, 100));
+		assert_equal(tmp[100], 0xa5);
+		assert_equal(tmp[120], 0xa5);
+		assert_equal(vfs_lseek(fd, 0, VFS_SEEK_CUR), RW_SIZE);
+		assert_equal(vfs_readv(fd, iov, 3), 0);
+		vfs_close(fd);
+	}
+
+	/*
+	 * writev lays the vectors out back to back, over the end of the file
+	 */
+	fd = vfs_open(RW_PATH "/src", O_RDWR, 0);
+	assert_true(fd >= 0);
+	if(fd >= 0)
+	{
+		assert_equal(vfs_lseek(fd, RW_SIZE - 50, VFS_SEEK_SET), RW_SIZE - 50);
+		iov[0].iov_base = &buf[100];
+		iov[0].iov_len = 30;
+		iov[1].iov_base = NULL;
+		iov[1].iov_len = 0;
+		iov[2].iov_base = &buf[130];
+		iov[2].iov_len = 70;
+		assert_equal(vfs_writev(fd, iov, 3), 100);
+		assert_equal(vfs_lseek(fd, 0, VFS_SEEK_CUR), RW_SIZE + 50);
+		assert_equal(rw_size(fd), RW_SIZE + 50);
+		assert_equal(vfs_pread(fd, tmp, 100, RW_SIZE - 50), 100);
+		assert_true(rw_match(tmp, 100, 100));
+		vfs_close(fd);
+	}
+	assert_true(rw_make(RW_PATH "/src", buf));
+
+	/*
+	 * Within one ram mount the copy hook moves the data, the hole included,
+	 * and the offsets passed in are updated instead of the file offsets
+	 */
+	fi = vfs_open(RW_PATH "/src", O_RDONLY, 0);
+	fo = vfs_open(RW_PATH "/dst", O_RDWR | O_CREAT | O_TRUNC, 0644);
+	assert_true((fi >= 0) && (fo >= 0));
+	if((fi >= 0) && (fo >= 0))
+	{
+		offin = 3500;
+		offout = 10;
+		assert_equal(vfs_copy_file_range(fi, &offin, fo, &offout, 3000), 3000);
+		assert_equal(offin, 6500);
+		assert_equal(offout, 3010);
+		assert_equal(vfs_lseek(fi, 0, VFS_SEEK_CUR), 0);
+		assert_equal(vfs_lseek(fo, 0, VFS_SEEK_CUR), 0);
+		assert_equal(vfs_pread(fo, tmp, 3000, 10), 3000);
+		assert_true(rw_match(&tmp[0], 3500, 500));
+		assert_true(rw_zero(&tmp[500], 2000));
+		assert_true(rw_match(&tmp[2500], 6000, 500));
+		assert_equal(vfs_pread(fo, tmp, 10, 0), 10);
+		assert_true(rw_zero(tmp, 10));
+
+		/*
+		 * Without offsets the file offsets advance, the source end cuts it short
+		 */
+		assert_equal(vfs_lseek(fi, RW_SIZE - 300, VFS_SEEK_SET), RW_SIZE - 300);
+		assert_equal(vfs_lseek(fo, 0, VFS_SEEK_SET), 0);
+		assert_equal(vfs_copy_file_range(fi, NULL, fo, NULL, 1000), 300);
+		assert_equal(vfs_lseek(fi, 0, VFS_SEEK_CUR), RW_SIZE);
+		assert_equal(vfs_lseek(fo, 0, VFS_SEEK_CUR), 300);
+		assert_equal(vfs_pread(fo, tmp, 300, 0), 300);
+		assert_true(rw_match(tmp, RW_SIZE - 300, 300));
+		assert_equal(vfs_copy_file_range(fi, NULL, fo, NULL, 1000), 0);
+		vfs_close(fo);
+
+		/*
+		 * Overlapping ranges of the same file are refused
+		 */
+		fo = vfs_open(RW_PATH "/src", O_RDWR, 0);
+		assert_true(fo >= 0);
+		if(fo >= 0)
+		{
+			offin = 0;
+			offout = 100;
+			assert_equal(vfs_copy_file_range(fi, &offin, fo, &offout, 200), 0);
+			offout = 200;
+			assert_equal(vfs_copy_file_range(fi, &offin, fo, &offout, 200), 200);
+			assert_equal(vfs_pread(fo, tmp, 200, 200), 200);
+			assert_true(rw_match(tmp, 0, 200));
+		}
+	}
+	if(fi >= 0)
+		vfs_close(fi);
+	if(fo >= 0)
+		vfs_close(fo);
+	assert_true(rw_make(RW_PATH "/src", buf));
+
+	/*
+	 * Across mounts it falls back to reading and writing through a buffer
+	 */
+	fi = vfs_open(RW_PATH "/src", O_RDONLY, 0);
+	fo = vfs_open(RW_MOUNT_PATH "/dst", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	assert_true((fi >= 0) && (fo >= 0));
+	if((fi >= 0) && (fo >= 0))
+	{
+		offin = 100;
+		assert_equal(vfs_copy_file_range(fi, &offin, fo, NULL, RW_SIZE), RW_SIZE - 100);
+		assert_equal(offin, RW_SIZE);
+		assert_equal(vfs_lseek(fi, 0, VFS_SEEK_CUR), 0);
+		assert_equal(vfs_lseek(fo, 0, VFS_SEEK_CUR), RW_SIZE - 100);
+		assert_equal(rw_size(fo), RW_SIZE - 100);
+	}
+	if(fi >= 0)
+		vfs_close(fi);
+	if(fo >= 0)
+		vfs_close(fo);
+	fd = vfs_open(RW_MOUNT_PATH "/dst", O_RDONLY, 0);
+	assert_true(fd >= 0);
+	if(fd >= 0)
+	{
+		assert_equal(vfs_read(fd, tmp, RW_SIZE), RW_SIZE - 100);
+		assert_true(rw_match(&tmp[0], 100, 3900));
+		assert_true(rw_zero(&tmp[3900], 2000));
+		assert_true(rw_match(&tmp[5900], 6000, RW_SIZE - 6000));
+		vfs_close(fd);
+	}
+	free(buf);
+}
+
+static struct wboxtest_t wbt_rw = {
+	.group	= "vfs",
+	.name	= "rw",
+	.setup	= rw_setup,
+	.clean	= rw_clean,
+	.run	= rw_run,
+};
+
+static __init void rw_wbt_init(void)
+{
+	register_wboxtest(&wbt_rw);
+}
+
+static __exit void rw_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_rw);
+}
+
+wboxtest_initcall(rw_wbt_init);
+wboxtest_exitcall(rw_wbt_exit);
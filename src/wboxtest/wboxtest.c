@@ -248,6 +248,86 @@ void wboxtest_assert(int cond, char * expr, const char * file, int line)
 	wboxtest_print("%*s\r\n", 80 + 12 - 6 - len, cond ? "\033[42;37m[OKAY]\033[0m" : "\033[41;37m[FAIL]\033[0m");
 }
 
+static u64_t wboxtest_ramdisk_read(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)(blk->priv);
+
+	rd->reads++;
+	if(rd->latency > 0)
+		udelay(rd->latency);
+	memcpy(buf, &rd->rambuf[block_offset(blk, blkno)], block_size(blk) * blkcnt);
+	return blkcnt;
+}
+
+static u64_t wboxtest_ramdisk_write(struct block_t * blk, u8_t * buf, u64_t blkno, u64_t blkcnt)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)(blk->priv);
+
+	rd->writes++;
+	if(rd->latency > 0)
+		udelay(rd->latency);
+	memcpy(&rd->rambuf[block_offset(blk, blkno)], buf, block_size(blk) * blkcnt);
+	return blkcnt;
+}
+
+static void wboxtest_ramdisk_sync(struct block_t * blk)
+{
+	struct wboxtest_ramdisk_t * rd = (struct wboxtest_ramdisk_t *)(blk->priv);
+
+	rd->syncs++;
+}
+
+/*
+ * A zero filled ramdisk that counts its driver calls, each call can cost a fixed
+ * latency in microseconds, like the command overhead of sdcard and spinor
+ */
+struct wboxtest_ramdisk_t * wboxtest_ramdisk_alloc(const char * name, u64_t size, int latency)
+{
+	struct wboxtest_ramdisk_t * rd;
+
+	rd = malloc(sizeof(struct wboxtest_ramdisk_t));
+	if(!rd)
+		return NULL;
+
+	rd->rambuf = malloc(size);
+	if(!rd->rambuf)
+	{
+		free(rd);
+		return NULL;
+	}
+	memset(rd->rambuf, 0, size);
+	rd->latency = latency;
+	rd->reads = 0;
+	rd->writes = 0;
+	rd->syncs = 0;
+
+	memset(&rd->blk, 0, sizeof(struct block_t));
+	rd->blk.name = (char *)name;
+	rd->blk.blksz = 512;
+	rd->blk.blkcnt = size / 512;
+	rd->blk.read = wboxtest_ramdisk_read;
+	rd->blk.write = wboxtest_ramdisk_write;
+	rd->blk.sync = wboxtest_ramdisk_sync;
+	rd->blk.priv = rd;
+	if(!register_block(&rd->blk, NULL))
+	{
+		free(rd->rambuf);
+		free(rd);
+		return NULL;
+	}
+	return rd;
+}
+
+void wboxtest_ramdisk_free(struct wboxtest_ramdisk_t * rd)
+{
+	if(rd)
+	{
+		unregister_block(&rd->blk);
+		free(rd->rambuf);
+		free(rd);
+	}
+}
+
 static __init void wboxtest_pure_init(void)
 {
 	int i;
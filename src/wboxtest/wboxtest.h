@@ -47,6 +47,19 @@ char * wboxtest_random_buffer(char * buf, int len);
 int wboxtest_print(const char * fmt, ...);
 void wboxtest_assert(int cond, char * expr, const char * file, int line);
 
+struct wboxtest_ramdisk_t
+{
+	struct block_t blk;
+	unsigned char * rambuf;
+	int latency;
+	int reads;
+	int writes;
+	int syncs;
+};
+
+struct wboxtest_ramdisk_t * wboxtest_ramdisk_alloc(const char * name, u64_t size, int latency);
+void wboxtest_ramdisk_free(struct wboxtest_ramdisk_t * rd);
+
 #ifdef __cplusplus
 }
 #endif
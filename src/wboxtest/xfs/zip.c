@@ -0,0 +1,317 @@
+/*
+ * wboxtest/xfs/zip.c
+ */
+
+#include <wboxtest.h>
+#include <zlib.h>
+
+#define ZIP_PATH		"/tmp/wbt-zip.zip"
+
+/*
+ * The archive is made at setup, with no entry for 'dir' and 'dir/sub'. The
+ * deflated entry is long enough for restart points to be recorded, its data
+ * takes 16 values so it shrinks to about half.
+ */
+static const struct {
+	const char * name;
+	int method;
+	int seed;
+	s64_t size;
+} zip_entries[] = {
+	{ "stored.txt",				0, 1, 3000 },
+	{ "dir/sub/deflated.bin",	8, 2, SZ_512K + 1000 },
+	{ "dir/other.txt",			8, 3, 100 },
+	{ "empty/",					0, 0, 0 },
+};
+
+static inline u8_t zip_data(int seed, s64_t i)
+{
+	u32_t x = (u32_t)i * 2654435761U + seed;
+
+	x ^= x >> 15;
+	x *= 2246822519U;
+	x ^= x >> 13;
+	return 'a' + (x & 0xf);
+}
+
+static int zip_match(int seed, s64_t off, const u8_t * buf, s64_t len)
+{
+	s64_t i;
+
+	for(i = 0; i < len; i++)
+	{
+		if(buf[i] != zip_data(seed, off + i))
+			return 0;
+	}
+	return 1;
+}
+
+static void zip_put(u8_t * p, u32_t v, int n)
+{
+	int i;
+
+	for(i = 0; i < n; i++)
+		p[i] = (v >> (i * 8)) & 0xff;
+}
+
+static void zip_header(u8_t * p, int central, int method, u32_t crc, u32_t csize, u32_t size, int nlen, u32_t local)
+{
+	int o = central ? 16 : 14;
+
+	memset(p, 0, central ? 46 : 30);
+	zip_put(&p[0], central ? 0x02014b50 : 0x04034b50, 4);
+	zip_put(&p[central ? 6 : 4], 20, 2);
+	if(central)
+		zip_put(&p[4], 20, 2);
+	zip_put(&p[o - 6], method, 2);
+	zip_put(&p[o], crc, 4);
+	zip_put(&p[o + 4], csize, 4);
+	zip_put(&p[o + 8], size, 4);
+	zip_put(&p[o + 12], nlen, 2);
+	if(central)
+		zip_put(&p[42], local, 4);
+}
+
+static int zip_make(const char * path)
+{
+	u32_t crc[ARRAY_SIZE(zip_entries)];
+	u32_t csize[ARRAY_SIZE(zip_entries)];
+	u32_t local[ARRAY_SIZE(zip_entries)];
+	u8_t hdr[46];
+	u8_t * data, * cdata;
+	u32_t pos = 0, cdoff;
+	uLong bound;
+	z_stream z;
+	int fd, nlen, ret, i, j;
+
+	fd = vfs_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		return 0;
+	for(i = 0; i < ARRAY_SIZE(zip_entries); i++)
+	{
+		data = malloc(zip_entries[i].size + 1);
+		bound = compressBound(zip_entries[i].size);
+		cdata = (zip_entries[i].method == 8) ? malloc(bound) : data;
+		if(!data || !cdata)
+		{
+			free(data);
+			vfs_close(fd);
+			return 0;
+		}
+		for(j = 0; j < zip_entries[i].size; j++)
+			data[j] = zip_data(zip_entries[i].seed, j);
+		crc[i] = crc32(0, data, zip_entries[i].size);
+		csize[i] = zip_entries[i].size;
+		if(zip_entries[i].method == 8)
+		{
+			memset(&z, 0, sizeof(z_stream));
+			ret = deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+			if(ret == Z_OK)
+			{
+				z.next_in = data;
+				z.avail_in = zip_entries[i].size;
+				z.next_out = cdata;
+				z.avail_out = bound;
+				ret = deflate(&z, Z_FINISH);
+				csize[i] = z.total_out;
+				deflateEnd(&z);
+			}
+			if(ret != Z_STREAM_END)
+			{
+				free(cdata);
+				free(data);
+				vfs_close(fd);
+				return 0;
+			}
+		}
+		nlen = strlen(zip_entries[i].name);
+		local[i] = pos;
+		zip_header(hdr, 0, zip_entries[i].method, crc[i], csize[i], zip_entries[i].size, nlen, 0);
+		vfs_write(fd, hdr, 30);
+		vfs_write(fd, (void *)zip_entries[i].name, nlen);
+		vfs_write(fd, cdata, csize[i]);
+		pos += 30 + nlen + csize[i];
+		if(cdata != data)
+			free(cdata);
+		free(data);
+	}
+
+	cdoff = pos;
+	for(i = 0; i < ARRAY_SIZE(zip_entries); i++)
+	{
+		nlen = strlen(zip_entries[i].name);
+		zip_header(hdr, 1, zip_entries[i].method, crc[i], csize[i], zip_entries[i].size, nlen, local[i]);
+		vfs_write(fd, hdr, 46);
+		vfs_write(fd, (void *)zip_entries[i].name, nlen);
+		pos += 46 + nlen;
+	}
+	memset(hdr, 0, 22);
+	zip_put(&hdr[0], 0x06054b50, 4);
+	zip_put(&hdr[8], ARRAY_SIZE(zip_entries), 2);
+	zip_put(&hdr[10], ARRAY_SIZE(zip_entries), 2);
+	zip_put(&hdr[12], pos - cdoff, 4);
+	zip_put(&hdr[16], cdoff, 4);
+	ret = (vfs_write(fd, hdr, 22) == 22) ? 1 : 0;
+	vfs_close(fd);
+	return ret;
+}
+
+static void zip_walk_callback(const char * dir, const char * name, void * data)
+{
+	char * names = (char *)data;
+
+	strlcat(names, name, 256);
+	strlcat(names, ";", 256);
+}
+
+/*
+ * Read len bytes at off, by a seek unless off is negative
+ */
+static int zip_read_at(struct xfs_file_t * f, int seed, s64_t off, s64_t len, u8_t * buf)
+{
+	if(off >= 0)
+	{
+		if(xfs_seek(f, off) != off)
+			return 0;
+	}
+	else
+		off = xfs_tell(f);
+	if(xfs_read(f, buf, len) != len)
+		return 0;
+	return zip_match(seed, off, buf, len);
+}
+
+static void * zip_setup(struct wboxtest_t * wbt)
+{
+	if(!zip_make(ZIP_PATH))
+	{
+		vfs_unlink(ZIP_PATH);
+		return NULL;
+	}
+	return xfs_alloc(ZIP_PATH, 0);
+}
+
+static void zip_clean(struct wboxtest_t * wbt, void * data)
+{
+	struct xfs_context_t * ctx = (struct xfs_context_t *)data;
+
+	if(ctx)
+		xfs_free(ctx);
+	vfs_unlink(ZIP_PATH);
+}
+
+static void zip_run(struct wboxtest_t * wbt, void * data)
+{
+	struct xfs_context_t * ctx = (struct xfs_context_t *)data;
+	struct xfs_file_t * f, * g;
+	s64_t size = zip_entries[1].size;
+	char names[256];
+	u8_t * buf;
+	s64_t off;
+
+	if(ctx)
+	{
+		buf = malloc(SZ_16K);
+		if(!buf)
+			return;
+
+		/*
+		 * Parents that only show up in member names are directories
+		 */
+		assert_true(xfs_isdir(ctx, "dir"));
+		assert_true(xfs_isdir(ctx, "dir/sub"));
+		assert_true(xfs_isdir(ctx, "empty"));
+		assert_false(xfs_isfile(ctx, "dir"));
+		assert_true(xfs_isfile(ctx, "dir/sub/deflated.bin"));
+		assert_false(xfs_isdir(ctx, "dir/sub/deflated.bin"));
+		names[0] = '\0';
+		xfs_walk(ctx, "dir", zip_walk_callback, names);
+		assert_string_equal(names, "sub;other.txt;");
+		names[0] = '\0';
+		xfs_walk(ctx, "dir/sub", zip_walk_callback, names);
+		assert_string_equal(names, "deflated.bin;");
+
+		/*
+		 * Stored entry
+		 */
+		f = xfs_open_read(ctx, "stored.txt");
+		assert_not_null(f);
+		if(f)
+		{
+			assert_equal(xfs_length(f), zip_entries[0].size);
+			assert_true(zip_read_at(f, 1, -1, zip_entries[0].size, buf));
+			assert_equal(xfs_read(f, buf, 1), 0);
+			assert_true(zip_read_at(f, 1, 1234, 100, buf));
+			assert_true(zip_read_at(f, 1, 7, 10, buf));
+			xfs_close(f);
+		}
+		f = xfs_open_read(ctx, "dir/other.txt");
+		assert_not_null(f);
+		if(f)
+		{
+			assert_true(zip_read_at(f, 3, -1, zip_entries[2].size, buf));
+			xfs_close(f);
+		}
+
+		/*
+		 * Seeking in an inflated stream, first forward with no restart point
+		 * yet, then all over once a full pass has recorded some
+		 */
+		f = xfs_open_read(ctx, "dir/sub/deflated.bin");
+		assert_not_null(f);
+		if(f)
+		{
+			assert_equal(xfs_length(f), size);
+			assert_true(zip_read_at(f, 2, 400000, 1000, buf));
+			assert_true(zip_read_at(f, 2, 0, SZ_16K, buf));
+			for(off = SZ_16K; off < size; off += SZ_16K)
+				assert_true(zip_read_at(f, 2, -1, min(size - off, (s64_t)SZ_16K), buf));
+			assert_equal(xfs_read(f, buf, 1), 0);
+			assert_true(zip_read_at(f, 2, size - 1000, 1000, buf));
+			assert_true(zip_read_at(f, 2, 100, 1000, buf));
+			assert_true(zip_read_at(f, 2, 300001, 5000, buf));
+			assert_true(zip_read_at(f, 2, 262143, 3, buf));
+			assert_true(zip_read_at(f, 2, 450000, 2000, buf));
+			assert_true(zip_read_at(f, 2, 50, 50, buf));
+			assert_equal(xfs_seek(f, size + 10), size);
+			assert_equal(xfs_read(f, buf, 1), 0);
+
+			/*
+			 * Two handles on the archive read in turn do not disturb each other
+			 */
+			g = xfs_open_read(ctx, "stored.txt");
+			assert_not_null(g);
+			if(g)
+			{
+				assert_true(zip_read_at(f, 2, 200000, 100, buf));
+				assert_true(zip_read_at(g, 1, 0, 100, buf));
+				assert_true(zip_read_at(f, 2, -1, 100, buf));
+				assert_true(zip_read_at(g, 1, -1, 100, buf));
+				xfs_close(g);
+			}
+			xfs_close(f);
+		}
+		free(buf);
+	}
+}
+
+static struct wboxtest_t wbt_zip = {
+	.group	= "xfs",
+	.name	= "zip",
+	.setup	= zip_setup,
+	.clean	= zip_clean,
+	.run	= zip_run,
+};
+
+static __init void zip_wbt_init(void)
+{
+	register_wboxtest(&wbt_zip);
+}
+
+static __exit void zip_wbt_exit(void)
+{
+	unregister_wboxtest(&wbt_zip);
+}
+
+wboxtest_initcall(zip_wbt_init);
+wboxtest_exitcall(zip_wbt_exit);